@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "science/synapse/dsp/spectral_filter_engine.h"
+#include "science/synapse/dsp/spike_detector_engine.h"
+#include "science/synapse/dsp/work_stealing_pool.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Seconds of data filtered and thresholded per second of wall time
+auto run(size_t num_channels, size_t num_threads, const synapse::SampleBlock& input, double seconds) -> double {
+  synapse::SpectralFilter filter(synapse::SpectralFilterMethod::kBandPass, 300, 6000);
+  auto detector = synapse::SpikeDetector::create_thresholder(300, 30);
+
+  std::unique_ptr<synapse::SpectralFilterEngine> filter_engine;
+  std::unique_ptr<synapse::SpikeDetectorEngine> detector_engine;
+  if (!synapse::SpectralFilterEngine::create(filter, input.sample_rate_hz, num_channels, &filter_engine).ok() ||
+      !synapse::SpikeDetectorEngine::create(*detector, num_channels, &detector_engine).ok()) {
+    std::cerr << "Failed to create engines" << std::endl;
+    std::exit(1);
+  }
+
+  // The calling thread helps, so N cores means N - 1 pool threads
+  std::unique_ptr<synapse::WorkStealingPool> pool;
+  if (num_threads > 1) {
+    pool = std::make_unique<synapse::WorkStealingPool>(num_threads - 1, true);
+  }
+
+  synapse::SampleBlock block;
+  std::vector<synapse::SpikeEvent> events;
+  const auto num_blocks = static_cast<size_t>(seconds * input.sample_rate_hz / input.num_samples);
+  auto start = Clock::now();
+  for (size_t i = 0; i < num_blocks; ++i) {
+    block = input;
+    events.clear();
+    auto s = filter_engine->process(&block, pool.get());
+    if (s.ok()) {
+      s = detector_engine->process(block, &events, pool.get());
+    }
+    if (!s.ok()) {
+      std::cerr << "Failed to process block: " << s.message() << std::endl;
+      std::exit(1);
+    }
+  }
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  return (num_blocks * input.num_samples / input.sample_rate_hz) / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+  size_t num_channels = 4096;
+  size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  if (argc > 1) {
+    num_channels = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    max_threads = std::strtoul(argv[2], nullptr, 10);
+  }
+
+  synapse::SampleBlock input;
+  input.resize(num_channels, 300);
+  input.sample_rate_hz = 30000;
+  for (size_t i = 0; i < input.samples.size(); ++i) {
+    input.samples[i] = static_cast<float>((i * 7919) % 2001) - 1000.0f;
+  }
+
+  std::cout << "Band-pass filter + threshold detection, " << num_channels << " channels at " << input.sample_rate_hz
+            << " Hz" << std::endl;
+
+  // Powers of two, then the full core count
+  std::vector<size_t> thread_counts;
+  for (size_t threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  double baseline = 0;
+  for (auto threads : thread_counts) {
+    auto realtime = run(num_channels, threads, input, 3.0);
+    if (threads == 1) {
+      baseline = realtime;
+    }
+    std::cout << "  " << threads << " cores: " << realtime << "x real time (speedup " << realtime / baseline << "x)"
+              << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "science/synapse/dsp/channel_stats_engine.h"
+
+using Clock = std::chrono::steady_clock;
+
+auto run(synapse::SimdLevel level, const synapse::SampleBlock& block, double seconds) -> double {
+  std::unique_ptr<synapse::ChannelStatsEngine> engine;
+  auto s = synapse::ChannelStatsEngine::create(block.num_channels, &engine);
+  if (!s.ok()) {
+    std::cerr << "Failed to create engine: " << s.message() << std::endl;
+    std::exit(1);
+  }
+  engine->set_simd_level(level);
+
+  const auto num_blocks = static_cast<size_t>(seconds * block.sample_rate_hz / block.num_samples);
+  auto start = Clock::now();
+  for (size_t i = 0; i < num_blocks; ++i) {
+    (void)engine->process(block);
+  }
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  return num_blocks * block.num_samples * block.num_channels / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+  size_t num_channels = 1024;
+  if (argc > 1) {
+    num_channels = std::strtoul(argv[1], nullptr, 10);
+  }
+
+  const size_t block_samples = 300;
+  const double seconds = 5.0;
+
+  synapse::SampleBlock block;
+  block.resize(num_channels, block_samples);
+  block.sample_rate_hz = 30000;
+  for (size_t i = 0; i < block.samples.size(); ++i) {
+    block.samples[i] = static_cast<float>((i * 7919) % 201) - 100.0f;
+  }
+
+  std::cout << num_channels << " channels at " << block.sample_rate_hz << " Hz, one core" << std::endl;
+  for (auto level : { synapse::SimdLevel::kScalar, synapse::SimdLevel::kAvx2 }) {
+    if (level == synapse::SimdLevel::kAvx2 && synapse::detect_simd_level() != synapse::SimdLevel::kAvx2) {
+      std::cout << "  avx2: not supported on this CPU" << std::endl;
+      continue;
+    }
+    auto rate = run(level, block, seconds);
+    std::cout << (level == synapse::SimdLevel::kAvx2 ? "  avx2:   " : "  scalar: ") << rate / 1e6
+              << " M channel-samples/s (" << rate / (block.sample_rate_hz * num_channels) << "x real time)"
+              << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zmq.hpp>
+
+#include "science/synapse/closed_loop.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Events carry their publish time, and the loop echoes it back as the command, so the sink can
+// measure publish-to-command latency across both sockets as well as the loop's own turnaround
+auto now_ns() -> int64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+auto connection(const std::string& endpoint, synapse::TapType type) -> synapse::TapConnection {
+  synapse::TapConnection tap;
+  tap.set_name(type == synapse::TapType::TAP_TYPE_CONSUMER ? "stimulation" : "events");
+  tap.set_endpoint(endpoint);
+  tap.set_tap_type(type);
+  return tap;
+}
+
+int main(int argc, char* argv[]) {
+  int cpu = -1;
+  double seconds = 5;
+  int rate_hz = 1000;
+  if (argc > 1) {
+    cpu = std::atoi(argv[1]);
+  }
+  if (argc > 2) {
+    seconds = std::strtod(argv[2], nullptr);
+  }
+  if (argc > 3) {
+    rate_hz = std::atoi(argv[3]);
+  }
+
+  // Stand-ins for the device's producer and consumer taps
+  zmq::context_t context(1);
+  zmq::socket_t events(context, zmq::socket_type::pub);
+  events.bind("tcp://127.0.0.1:*");
+  zmq::socket_t commands(context, zmq::socket_type::sub);
+  commands.set(zmq::sockopt::subscribe, "");
+  commands.set(zmq::sockopt::rcvtimeo, 100);
+  commands.bind("tcp://127.0.0.1:*");
+
+  synapse::Tap input("127.0.0.1");
+  synapse::Tap output("127.0.0.1");
+  auto s = input.connect(connection(events.get(zmq::sockopt::last_endpoint), synapse::TapType::TAP_TYPE_PRODUCER));
+  if (s.ok()) {
+    s = output.connect(connection(commands.get(zmq::sockopt::last_endpoint), synapse::TapType::TAP_TYPE_CONSUMER));
+  }
+  if (!s.ok()) {
+    std::cerr << "Failed to connect: " << s.message() << std::endl;
+    return 1;
+  }
+
+  auto echo = [](const uint8_t* data, size_t size, std::vector<uint8_t>* command) {
+    command->assign(data, data + size);
+    return true;
+  };
+  synapse::ClosedLoopOptions options;
+  options.cpu = cpu;
+  std::unique_ptr<synapse::ClosedLoop> loop;
+  s = synapse::ClosedLoop::create(&input, &output, echo, &loop, options);
+  if (s.ok()) {
+    s = loop->start();
+  }
+  if (!s.ok()) {
+    std::cerr << "Failed to start loop: " << s.message() << std::endl;
+    return 1;
+  }
+
+  synapse::LatencyHistogram end_to_end;
+  std::atomic<bool> running(true);
+  std::thread sink([&]() {
+    while (running) {
+      zmq::message_t message;
+      if (commands.recv(message) && message.size() == sizeof(int64_t)) {
+        int64_t sent_ns;
+        std::memcpy(&sent_ns, message.data(), sizeof(sent_ns));
+        end_to_end.record(std::chrono::nanoseconds(now_ns() - sent_ns));
+      }
+    }
+  });
+
+  // Let both subscriptions settle; events published before then would be dropped
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  const auto period = std::chrono::nanoseconds(1000000000 / rate_hz);
+  auto next = Clock::now();
+  const auto end = next + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+  while (next < end) {
+    std::this_thread::sleep_until(next);
+    const int64_t sent_ns = now_ns();
+    zmq::message_t message(&sent_ns, sizeof(sent_ns));
+    events.send(message, zmq::send_flags::none);
+    next += period;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  loop->stop();
+  running = false;
+  sink.join();
+
+  auto stats = loop->stats();
+  std::cout << rate_hz << " events/s for " << seconds << " s, loop thread "
+            << (cpu >= 0 ? "pinned to cpu " + std::to_string(cpu) : std::string("unpinned")) << std::endl;
+  std::cout << "  received " << stats.messages_received << ", sent " << stats.commands_sent << ", send errors "
+            << stats.send_errors << std::endl;
+  std::cout << "  loop turnaround: " << loop->latency().summary() << std::endl;
+  std::cout << "  publish to command: " << end_to_end.summary() << std::endl;
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "science/synapse/config.h"
+#include "science/synapse/nodes/spike_binner.h"
+
+using Clock = std::chrono::steady_clock;
+
+auto elapsed_ms(Clock::time_point start) -> double {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  size_t num_nodes = 10000;
+  if (argc > 1) {
+    num_nodes = std::strtoul(argv[1], nullptr, 10);
+  }
+
+  std::vector<std::shared_ptr<synapse::Node>> nodes;
+  nodes.reserve(num_nodes);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    nodes.push_back(std::make_shared<synapse::SpikeBinner>(10));
+  }
+
+  synapse::Config config;
+
+  auto start = Clock::now();
+  auto s = config.add(nodes);
+  if (!s.ok()) {
+    std::cerr << "Failed to add nodes: " << s.message() << std::endl;
+    return 1;
+  }
+  auto add_ms = elapsed_ms(start);
+
+  // A chain plus a skip edge per node, so the graph has ~2 edges per node
+  start = Clock::now();
+  size_t num_connections = 0;
+  for (size_t i = 0; i + 1 < num_nodes; ++i) {
+    s = config.connect(nodes[i], nodes[i + 1]);
+    if (s.ok() && i + 2 < num_nodes) {
+      s = config.connect(nodes[i], nodes[i + 2]);
+      num_connections++;
+    }
+    if (!s.ok()) {
+      std::cerr << "Failed to connect nodes: " << s.message() << std::endl;
+      return 1;
+    }
+    num_connections++;
+  }
+  auto connect_ms = elapsed_ms(start);
+
+  std::shared_ptr<const std::string> bytes;
+  start = Clock::now();
+  s = config.serialize(&bytes);
+  if (!s.ok()) {
+    std::cerr << "Failed to serialize config: " << s.message() << std::endl;
+    return 1;
+  }
+  auto serialize_ms = elapsed_ms(start);
+
+  start = Clock::now();
+  s = config.serialize(&bytes);
+  auto cached_serialize_ms = elapsed_ms(start);
+
+  auto proto = config.to_proto();
+
+  synapse::Config parsed;
+  start = Clock::now();
+  s = synapse::Config::from_proto(proto, &parsed);
+  if (!s.ok()) {
+    std::cerr << "Failed to parse config: " << s.message() << std::endl;
+    return 1;
+  }
+  auto from_proto_ms = elapsed_ms(start);
+
+  std::cout << "Config with " << num_nodes << " nodes, " << num_connections << " connections" << std::endl;
+  std::cout << "  add:        " << add_ms << " ms" << std::endl;
+  std::cout << "  connect:    " << connect_ms << " ms" << std::endl;
+  std::cout << "  serialize:  " << serialize_ms << " ms (cached: " << cached_serialize_ms << " ms, "
+            << bytes->size() << " bytes)" << std::endl;
+  std::cout << "  from_proto: " << from_proto_ms << " ms" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "science/synapse/dsp/envelope_pyramid.h"
+
+using Clock = std::chrono::steady_clock;
+
+auto create(size_t num_channels, float sample_rate_hz) -> std::unique_ptr<synapse::EnvelopePyramid> {
+  std::unique_ptr<synapse::EnvelopePyramid> pyramid;
+  auto s = synapse::EnvelopePyramid::create(num_channels, sample_rate_hz, &pyramid);
+  if (!s.ok()) {
+    std::cerr << "Failed to create pyramid: " << s.message() << std::endl;
+    std::exit(1);
+  }
+  return pyramid;
+}
+
+int main(int argc, char* argv[]) {
+  size_t num_channels = 1024;
+  if (argc > 1) {
+    num_channels = std::strtoul(argv[1], nullptr, 10);
+  }
+  size_t pixels = 1920;
+  if (argc > 2) {
+    pixels = std::strtoul(argv[2], nullptr, 10);
+  }
+
+  const size_t block_samples = 300;
+  const double seconds = 10.0;
+
+  synapse::SampleBlock block;
+  block.resize(num_channels, block_samples);
+  block.sample_rate_hz = 30000;
+  for (size_t i = 0; i < block.samples.size(); ++i) {
+    block.samples[i] = static_cast<float>((i * 7919) % 201) - 100.0f;
+  }
+  const auto num_blocks = static_cast<size_t>(seconds * block.sample_rate_hz / block_samples);
+
+  std::cout << num_channels << " channels at " << block.sample_rate_hz << " Hz, " << seconds << " s of history"
+            << std::endl;
+
+  std::unique_ptr<synapse::EnvelopePyramid> pyramid;
+  for (auto level : { synapse::SimdLevel::kScalar, synapse::SimdLevel::kAvx2 }) {
+    if (level == synapse::SimdLevel::kAvx2 && synapse::detect_simd_level() != synapse::SimdLevel::kAvx2) {
+      std::cout << "  update avx2: not supported on this CPU" << std::endl;
+      continue;
+    }
+    pyramid = create(num_channels, block.sample_rate_hz);
+    pyramid->set_simd_level(level);
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < num_blocks; ++i) {
+      (void)pyramid->process(block);
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "  update " << (level == synapse::SimdLevel::kAvx2 ? "avx2:   " : "scalar: ")
+              << seconds / elapsed << "x real time" << std::endl;
+  }
+  std::cout << "  " << pyramid->num_levels() << " levels, " << pyramid->memory_bytes() / (1 << 20) << " MiB"
+            << std::endl;
+
+  // Redraw every channel over a range at a screen's width, from the last 10 ms to the whole history
+  std::vector<synapse::EnvelopeBin> out;
+  const uint64_t end = pyramid->position();
+  for (double range_s : { 0.01, 1.0, seconds }) {
+    const auto begin = end - static_cast<uint64_t>(range_s * block.sample_rate_hz);
+    auto start = Clock::now();
+    for (size_t channel = 0; channel < num_channels; ++channel) {
+      (void)pyramid->query(channel, begin, end, pixels, &out);
+    }
+    auto one_by_one = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<synapse::EnvelopeBin> all;
+    (void)pyramid->query(begin, end, pixels, &all);  // size the output
+    start = Clock::now();
+    (void)pyramid->query(begin, end, pixels, &all);
+    auto all_at_once = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << "  redraw " << range_s << " s at " << pixels << " px: " << one_by_one * 1e3
+              << " ms one channel at a time, " << all_at_once * 1e3 << " ms all channels at once" << std::endl;
+  }
+
+  return 0;
+}
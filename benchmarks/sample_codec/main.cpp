@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "science/synapse/recording/chunked_recording.h"
+#include "science/synapse/recording/sample_codec.h"
+
+using Clock = std::chrono::steady_clock;
+
+// A block of channel-major samples, as a recorder or re-publisher would hand to the codec
+struct Block {
+  size_t num_channels = 0;
+  size_t num_samples = 0;
+  std::vector<int32_t> samples;
+
+  auto channels() const -> std::vector<const int32_t*> {
+    std::vector<const int32_t*> result;
+    for (size_t c = 0; c < num_channels; ++c) {
+      result.push_back(samples.data() + c * num_samples);
+    }
+    return result;
+  }
+};
+
+// Background LFP, noise and occasional spikes at int16 resolution, 0.195 uV per count
+auto synthetic_block(size_t num_channels, size_t num_samples) -> Block {
+  std::mt19937 rng(1);
+  std::normal_distribution<double> noise(0, 30);
+  std::uniform_real_distribution<double> phase(0, 2 * M_PI);
+  const std::vector<double> spike = { -100, -400, -900, -600, -100, 200, 300, 250, 150, 50 };
+
+  Block block{ num_channels, num_samples, std::vector<int32_t>(num_channels * num_samples) };
+  for (size_t c = 0; c < num_channels; ++c) {
+    const double offset = phase(rng);
+    for (size_t t = 0; t < num_samples; ++t) {
+      double value = 800 * std::sin(2 * M_PI * 8 * t / 30000.0 + offset) + noise(rng);
+      const size_t since_spike = (t + c * 37) % 1500;
+      if (since_spike < spike.size()) {
+        value += spike[since_spike];
+      }
+      block.samples[c * num_samples + t] = static_cast<int32_t>(std::lround(value));
+    }
+  }
+  return block;
+}
+
+// The first chunks of an indexed recording, up to num_samples per channel
+auto recorded_block(const std::string& path, size_t num_samples) -> Block {
+  std::unique_ptr<synapse::RecordingReader> reader;
+  auto s = synapse::RecordingReader::open(path, &reader);
+  if (!s.ok()) {
+    std::cerr << "Failed to open " << path << ": " << s.message() << std::endl;
+    std::exit(1);
+  }
+
+  Block block;
+  block.num_channels = reader->num_channels();
+  block.num_samples = std::min<size_t>(num_samples, reader->num_samples());
+  block.samples.resize(block.num_channels * block.num_samples);
+  size_t t0 = 0;
+  for (size_t i = 0; i < reader->chunk_index().size() && t0 < block.num_samples; ++i) {
+    synapse::ChunkView view;
+    s = reader->chunk(i, {}, &view);
+    if (!s.ok()) {
+      std::cerr << "Failed to read chunk " << i << ": " << s.message() << std::endl;
+      std::exit(1);
+    }
+    const size_t count = std::min(view.num_samples, block.num_samples - t0);
+    for (size_t c = 0; c < block.num_channels; ++c) {
+      std::copy(view.channels[c], view.channels[c] + count, block.samples.begin() + c * block.num_samples + t0);
+    }
+    t0 += count;
+  }
+  return block;
+}
+
+// Bytes of the same samples sent as BroadbandFrames, one per time step
+auto protobuf_size(const Block& block) -> size_t {
+  size_t size = 0;
+  synapse::BroadbandFrame frame;
+  for (size_t t = 0; t < block.num_samples; ++t) {
+    frame.Clear();
+    frame.set_timestamp_ns(1700000000000000000ull + t * 33333);
+    frame.set_sequence_number(t);
+    frame.set_sample_rate_hz(30000);
+    for (size_t c = 0; c < block.num_channels; ++c) {
+      frame.add_frame_data(block.samples[c * block.num_samples + t]);
+    }
+    size += frame.ByteSizeLong();
+  }
+  return size;
+}
+
+auto run(const std::string& name, const Block& block, double seconds) -> void {
+  const double raw_bytes = block.samples.size() * sizeof(int32_t);
+  std::cout << name << ": " << block.num_channels << " channels x " << block.num_samples << " samples, protobuf "
+            << protobuf_size(block) * 8.0 / block.samples.size() << " bits/sample" << std::endl;
+
+  const auto channels = block.channels();
+  for (auto predictor : { synapse::SamplePredictor::kDelta, synapse::SamplePredictor::kLinear }) {
+    for (auto level : { synapse::SimdLevel::kScalar, synapse::SimdLevel::kAvx2 }) {
+      const std::string label = std::string(predictor == synapse::SamplePredictor::kDelta ? "delta" : "linear") +
+                                (level == synapse::SimdLevel::kAvx2 ? " avx2:   " : " scalar: ");
+      if (level == synapse::SimdLevel::kAvx2 && synapse::detect_simd_level() != synapse::SimdLevel::kAvx2) {
+        std::cout << "  " << label << "not supported on this CPU" << std::endl;
+        continue;
+      }
+
+      synapse::SampleCodec codec(predictor);
+      codec.set_simd_level(level);
+      std::vector<uint8_t> encoded;
+      size_t iterations = 0;
+      auto start = Clock::now();
+      while (std::chrono::duration<double>(Clock::now() - start).count() < seconds) {
+        (void)codec.encode(channels, block.num_samples, &encoded);
+        iterations++;
+      }
+      const double encode_seconds = std::chrono::duration<double>(Clock::now() - start).count() / iterations;
+
+      std::vector<int32_t> decoded;
+      size_t num_channels = 0;
+      size_t num_samples = 0;
+      iterations = 0;
+      start = Clock::now();
+      while (std::chrono::duration<double>(Clock::now() - start).count() < seconds) {
+        (void)codec.decode(encoded.data(), encoded.size(), &decoded, &num_channels, &num_samples);
+        iterations++;
+      }
+      const double decode_seconds = std::chrono::duration<double>(Clock::now() - start).count() / iterations;
+
+      if (decoded != block.samples) {
+        std::cerr << "Round trip mismatch" << std::endl;
+        std::exit(1);
+      }
+      std::cout << "  " << label << encoded.size() * 8.0 / block.samples.size() << " bits/sample ("
+                << raw_bytes / encoded.size() << "x vs int32, " << raw_bytes / 2 / encoded.size()
+                << "x vs int16), encode " << raw_bytes / encode_seconds / 1e9 << " GB/s, decode "
+                << raw_bytes / decode_seconds / 1e9 << " GB/s" << std::endl;
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  size_t num_channels = 1024;
+  size_t num_samples = 2048;
+  if (argc > 1) {
+    num_channels = std::strtoul(argv[1], nullptr, 10);
+  }
+
+  const double seconds = 1.0;
+  std::cout << "GB/s are of int32 samples, one core" << std::endl;
+  run("synthetic", synthetic_block(num_channels, num_samples), seconds);
+  if (argc > 2) {
+    run(argv[2], recorded_block(argv[2], 30000), seconds);
+  }
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include "science/synapse/dsp/spectral_filter_engine.h"
+
+using Clock = std::chrono::steady_clock;
+
+auto run(synapse::SimdLevel level, size_t num_channels, float sample_rate_hz, size_t block_samples, double seconds)
+    -> double {
+  synapse::SpectralFilter filter(synapse::SpectralFilterMethod::kBandPass, 300, 6000);
+  std::unique_ptr<synapse::SpectralFilterEngine> engine;
+  auto s = synapse::SpectralFilterEngine::create(filter, sample_rate_hz, num_channels, &engine);
+  if (!s.ok()) {
+    std::cerr << "Failed to create filter: " << s.message() << std::endl;
+    std::exit(1);
+  }
+  engine->set_simd_level(level);
+
+  synapse::SampleBlock block;
+  block.resize(num_channels, block_samples);
+  for (size_t i = 0; i < block.samples.size(); ++i) {
+    block.samples[i] = static_cast<float>((i * 7919) % 2001) - 1000.0f;
+  }
+
+  const auto num_blocks = static_cast<size_t>(seconds * sample_rate_hz / block_samples);
+  auto start = Clock::now();
+  for (size_t i = 0; i < num_blocks; ++i) {
+    s = engine->process(&block);
+  }
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  // Real-time factor: seconds of data filtered per second of wall time
+  return (num_blocks * block_samples / sample_rate_hz) / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+  size_t num_channels = 1024;
+  float sample_rate_hz = 30000;
+  if (argc > 1) {
+    num_channels = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    sample_rate_hz = std::strtof(argv[2], nullptr);
+  }
+
+  const size_t block_samples = 300;
+  const double seconds = 5.0;
+
+  std::cout << "Band-pass 300-6000 Hz (order 4 per edge), " << num_channels << " channels at " << sample_rate_hz
+            << " Hz, one core" << std::endl;
+
+  for (auto level : {synapse::SimdLevel::kScalar, synapse::SimdLevel::kAvx2}) {
+    if (level == synapse::SimdLevel::kAvx2 && synapse::detect_simd_level() != synapse::SimdLevel::kAvx2) {
+      std::cout << "  avx2:   not supported on this CPU" << std::endl;
+      continue;
+    }
+    auto realtime = run(level, num_channels, sample_rate_hz, block_samples, seconds);
+    double msamples = realtime * sample_rate_hz * num_channels / 1e6;
+    std::cout << "  " << (level == synapse::SimdLevel::kAvx2 ? "avx2:   " : "scalar: ") << realtime << "x real time ("
+              << msamples << " Msamples/s)" << std::endl;
+  }
+
+  return 0;
+}
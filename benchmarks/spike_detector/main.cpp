@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "science/synapse/dsp/spike_detector_engine.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  double channel_samples_per_second;
+  size_t num_spikes;
+};
+
+auto run(const synapse::SpikeDetector& detector, synapse::SimdLevel level, const synapse::SampleBlock& block,
+         double seconds) -> Result {
+  std::unique_ptr<synapse::SpikeDetectorEngine> engine;
+  auto s = synapse::SpikeDetectorEngine::create(detector, block.num_channels, &engine);
+  if (!s.ok()) {
+    std::cerr << "Failed to create detector: " << s.message() << std::endl;
+    std::exit(1);
+  }
+  engine->set_simd_level(level);
+
+  std::vector<synapse::SpikeEvent> events;
+  const auto num_blocks = static_cast<size_t>(seconds * block.sample_rate_hz / block.num_samples);
+  size_t num_spikes = 0;
+  auto start = Clock::now();
+  for (size_t i = 0; i < num_blocks; ++i) {
+    events.clear();
+    s = engine->process(block, &events);
+    num_spikes += events.size();
+  }
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  return { num_blocks * block.num_samples * block.num_channels / elapsed, num_spikes };
+}
+
+int main(int argc, char* argv[]) {
+  size_t num_channels = 1024;
+  if (argc > 1) {
+    num_channels = std::strtoul(argv[1], nullptr, 10);
+  }
+
+  const size_t block_samples = 300;
+  const double seconds = 5.0;
+
+  // Noise with an occasional large deflection, so a few percent of samples are near threshold
+  synapse::SampleBlock block;
+  block.resize(num_channels, block_samples);
+  block.sample_rate_hz = 30000;
+  for (size_t i = 0; i < block.samples.size(); ++i) {
+    block.samples[i] = static_cast<float>((i * 7919) % 201) - 100.0f;
+    if ((i * 104729) % 997 == 0) {
+      block.samples[i] = -400.0f;
+    }
+  }
+
+  auto thresholder = synapse::SpikeDetector::create_thresholder(300, 30);
+  auto matcher = synapse::SpikeDetector::create_template_matcher(
+    { 0, 0, 100, 300, 600, 400, 200, 150, 100, 80, 60, 40, 30, 20, 10, 0 }, 30
+  );
+
+  std::cout << num_channels << " channels at " << block.sample_rate_hz << " Hz, one core" << std::endl;
+  for (const auto& [name, detector] : { std::make_pair("threshold", thresholder),
+                                        std::make_pair("template (16 taps)", matcher) }) {
+    for (auto level : { synapse::SimdLevel::kScalar, synapse::SimdLevel::kAvx2 }) {
+      if (level == synapse::SimdLevel::kAvx2 && synapse::detect_simd_level() != synapse::SimdLevel::kAvx2) {
+        std::cout << "  " << name << " avx2: not supported on this CPU" << std::endl;
+        continue;
+      }
+      auto result = run(*detector, level, block, seconds);
+      std::cout << "  " << name << (level == synapse::SimdLevel::kAvx2 ? " avx2:   " : " scalar: ")
+                << result.channel_samples_per_second / 1e6 << " M channel-samples/s ("
+                << result.channel_samples_per_second / (block.sample_rate_hz * num_channels) << "x real time, "
+                << result.num_spikes << " spikes)" << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "science/synapse/api/datatype.pb.h"
+#include "science/synapse/stimulation_command.h"
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char* argv[]) {
+  size_t num_channels = 64;
+  size_t iterations = 1000000;
+  if (argc > 1) {
+    num_channels = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    iterations = std::strtoul(argv[2], nullptr, 10);
+  }
+
+  std::vector<synapse::Ch> channels;
+  for (size_t i = 0; i < num_channels; ++i) {
+    channels.push_back({ i, i, 0 });
+  }
+  synapse::ElectricalStimulation node(1, channels, 16, 30000, 1);
+
+  std::unique_ptr<synapse::StimulationCommandBuilder> builder;
+  size_t pattern;
+  std::vector<int32_t> codes(num_channels, 100);
+  if (!synapse::StimulationCommandBuilder::create(node, &builder).ok() || !builder->add_pattern(codes, &pattern).ok()) {
+    std::cerr << "Failed to create builder" << std::endl;
+    return 1;
+  }
+
+  // Each update changes the timestamp, sequence number and one channel's amplitude
+  uint64_t checksum = 0;
+  auto start = Clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    synapse::BroadbandFrame frame;
+    frame.set_timestamp_ns(1700000000000000000ull + i * 1000);
+    frame.set_sequence_number(i);
+    frame.set_sample_rate_hz(30000);
+    for (size_t c = 0; c < num_channels; ++c) {
+      frame.add_frame_data(c == i % num_channels ? -100 : codes[c]);
+    }
+    std::vector<uint8_t> bytes(frame.ByteSizeLong());
+    frame.SerializeToArray(bytes.data(), static_cast<int>(bytes.size()));
+    checksum += bytes.size();
+  }
+  const double serialize_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+
+  start = Clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    synapse::StimulationCommandBuilder::CommandPtr command;
+    if (!builder->acquire(pattern, &command).ok()) {
+      return 1;
+    }
+    command->set_timestamp_ns(1700000000000000000ull + i * 1000);
+    command->set_sequence_number(i);
+    command->set_amplitude(i % num_channels, -100);
+    checksum += command->size();
+  }
+  const double patch_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+
+  std::cout << num_channels << " channels, " << iterations << " updates (checksum " << checksum << ")" << std::endl;
+  std::cout << "  build + serialize: " << serialize_ns << " ns/update" << std::endl;
+  std::cout << "  pooled + patched:  " << patch_ns << " ns/update (" << serialize_ns / patch_ns << "x)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zmq.hpp>
+
+#include "science/synapse/stimulation_sequencer.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Compares dispatch jitter of a sleep-between-sends loop, as in user code, with the sequencer
+int main(int argc, char* argv[]) {
+  int cpu = -1;
+  int priority = 0;
+  size_t count = 1000;
+  int period_us = 1000;
+  if (argc > 1) {
+    cpu = std::atoi(argv[1]);
+  }
+  if (argc > 2) {
+    priority = std::atoi(argv[2]);
+  }
+  if (argc > 3) {
+    count = std::strtoul(argv[3], nullptr, 10);
+  }
+  if (argc > 4) {
+    period_us = std::atoi(argv[4]);
+  }
+
+  // Stand-in for the device's consumer tap
+  zmq::context_t context(1);
+  zmq::socket_t commands(context, zmq::socket_type::sub);
+  commands.set(zmq::sockopt::subscribe, "");
+  commands.bind("tcp://127.0.0.1:*");
+
+  synapse::TapConnection connection;
+  connection.set_name("stimulation");
+  connection.set_endpoint(commands.get(zmq::sockopt::last_endpoint));
+  connection.set_tap_type(synapse::TapType::TAP_TYPE_CONSUMER);
+  synapse::Tap tap("127.0.0.1");
+  if (!tap.connect(connection).ok()) {
+    std::cerr << "Failed to connect" << std::endl;
+    return 1;
+  }
+
+  synapse::ElectricalStimulation node(1, { { 0, 1, 0 }, { 1, 2, 0 } }, 12, 20000, 1);
+  std::unique_ptr<synapse::StimulationCommandBuilder> builder;
+  size_t pulse;
+  if (!synapse::StimulationCommandBuilder::create(node, &builder, count + 1).ok() ||
+      !builder->add_pattern({ 100, -100 }, &pulse).ok()) {
+    std::cerr << "Failed to create builder" << std::endl;
+    return 1;
+  }
+  const auto period = std::chrono::microseconds(period_us);
+
+  synapse::LatencyHistogram sleep_jitter;
+  {
+    synapse::StimulationCommandBuilder::CommandPtr command;
+    (void)builder->acquire(pulse, &command);
+    const auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+      const auto deadline = start + static_cast<int64_t>(i) * period;
+      std::this_thread::sleep_for(deadline - Clock::now());
+      sleep_jitter.record(Clock::now() - deadline);
+      (void)tap.send(command->data(), command->size());
+    }
+  }
+
+  synapse::StimulationSequencerOptions options;
+  options.cpu = cpu;
+  options.realtime_priority = priority;
+  std::unique_ptr<synapse::StimulationSequencer> sequencer;
+  auto s = synapse::StimulationSequencer::create(&tap, &sequencer, options);
+  for (size_t i = 0; s.ok() && i < count; ++i) {
+    synapse::StimulationCommandBuilder::CommandPtr command;
+    s = builder->acquire(pulse, &command);
+    if (s.ok()) {
+      s = sequencer->add(static_cast<int64_t>(i) * period, std::move(command));
+    }
+  }
+  if (s.ok()) {
+    s = sequencer->start();
+  }
+  if (!s.ok()) {
+    std::cerr << "Failed to run sequencer: " << s.message() << std::endl;
+    return 1;
+  }
+  sequencer->wait();
+
+  std::cout << count << " commands every " << period_us << " us, sequencer thread "
+            << (cpu >= 0 ? "pinned to cpu " + std::to_string(cpu) : std::string("unpinned"))
+            << (priority > 0 ? " at SCHED_FIFO " + std::to_string(priority) : std::string()) << std::endl;
+  std::cout << "  sleep_for loop: " << sleep_jitter.summary() << std::endl;
+  std::cout << "  sequencer:      " << sequencer->jitter().summary() << std::endl;
+  return 0;
+}
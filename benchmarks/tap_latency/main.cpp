@@ -0,0 +1,105 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zmq.hpp>
+
+#include "science/synapse/latency_histogram.h"
+#include "science/synapse/tap.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Messages carry their publish time, so the reader measures publish-to-read latency
+auto now_ns() -> int64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+auto measure(const synapse::TapReceiveOptions& options, double seconds, int rate_hz, synapse::LatencyHistogram* latency)
+  -> bool {
+  zmq::context_t context(1);
+  zmq::socket_t publisher(context, zmq::socket_type::pub);
+  publisher.bind("tcp://127.0.0.1:*");
+
+  synapse::TapConnection connection;
+  connection.set_name("broadband");
+  connection.set_endpoint(publisher.get(zmq::sockopt::last_endpoint));
+  connection.set_tap_type(synapse::TapType::TAP_TYPE_PRODUCER);
+
+  synapse::Tap tap("127.0.0.1");
+  auto s = tap.set_receive_options(options);
+  if (s.ok()) {
+    s = tap.connect(connection);
+  }
+  if (!s.ok()) {
+    std::cerr << "Failed to connect: " << s.message() << std::endl;
+    return false;
+  }
+
+  std::atomic<bool> running(true);
+  std::thread reader([&]() {
+    std::vector<uint8_t> data;
+    while (running) {
+      if (tap.read(&data, 100).ok() && data.size() == sizeof(int64_t)) {
+        int64_t sent_ns;
+        std::memcpy(&sent_ns, data.data(), sizeof(sent_ns));
+        latency->record(std::chrono::nanoseconds(now_ns() - sent_ns));
+      }
+    }
+  });
+
+  // Let the subscription settle; messages published before then would be dropped
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  const auto period = std::chrono::nanoseconds(1000000000 / rate_hz);
+  auto next = Clock::now();
+  const auto end = next + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+  while (next < end) {
+    std::this_thread::sleep_until(next);
+    const int64_t sent_ns = now_ns();
+    zmq::message_t message(&sent_ns, sizeof(sent_ns));
+    publisher.send(message, zmq::send_flags::none);
+    next += period;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  running = false;
+  reader.join();
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  double seconds = 5;
+  int rate_hz = 1000;
+  int spin_budget_us = 1000;
+  if (argc > 1) {
+    seconds = std::strtod(argv[1], nullptr);
+  }
+  if (argc > 2) {
+    rate_hz = std::atoi(argv[2]);
+  }
+  if (argc > 3) {
+    spin_budget_us = std::atoi(argv[3]);
+  }
+
+  // With messages every 1 ms and a 1 ms budget, busy-poll mode mostly never blocks
+  synapse::TapReceiveOptions blocking;
+  synapse::TapReceiveOptions busy_poll;
+  busy_poll.busy_poll = true;
+  busy_poll.spin_budget = std::chrono::microseconds(spin_budget_us);
+
+  std::cout << rate_hz << " messages/s for " << seconds << " s per mode, spin budget " << spin_budget_us << " us"
+            << std::endl;
+  for (const auto& [name, options] : { std::make_pair("blocking", blocking), std::make_pair("busy poll", busy_poll) }) {
+    synapse::LatencyHistogram latency;
+    if (!measure(options, seconds, rate_hz, &latency)) {
+      return 1;
+    }
+    std::cout << "  " << name << ": " << latency.summary() << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "science/synapse/recording/tap_recorder.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Records frames as fast as they can be produced, as if a tap were delivering them back to back
+auto run(const std::string& path, bool direct_io, size_t frame_size, uint64_t total_bytes) -> void {
+  synapse::TapRecorderOptions options;
+  options.direct_io = direct_io;
+
+  std::unique_ptr<synapse::TapRecorder> recorder;
+  auto s = synapse::TapRecorder::create(path, &recorder, options);
+  if (!s.ok()) {
+    std::cerr << "Failed to create recorder: " << s.message() << std::endl;
+    std::exit(1);
+  }
+
+  std::vector<uint8_t> frame(frame_size, 0x5a);
+  const auto num_frames = total_bytes / frame_size;
+  auto start = Clock::now();
+  for (uint64_t i = 0; i < num_frames; ++i) {
+    (void)recorder->record(frame.data(), frame.size(), i);
+  }
+  auto receive_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  s = recorder->stop();
+  auto total_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  if (!s.ok()) {
+    std::cerr << "Recording failed: " << s.message() << std::endl;
+    std::exit(1);
+  }
+
+  auto stats = recorder->stats();
+  std::cout << "  " << (stats.direct_io ? "O_DIRECT" : "buffered") << ": " << stats.bytes_written / total_seconds / 1e9
+            << " GB/s end to end, disk " << stats.write_throughput() / 1e9 << " GB/s, receive side "
+            << receive_seconds * 1e9 / num_frames << " ns/frame, max backlog " << stats.max_backlog_bytes / 1e6
+            << " MB, dropped " << stats.frames_dropped << " of " << num_frames << std::endl;
+
+  std::remove(path.c_str());
+}
+
+int main(int argc, char* argv[]) {
+  std::string path = "tap_recorder_benchmark.rec";
+  double gigabytes = 4;
+  size_t frame_size = 4096;
+  if (argc > 1) {
+    path = argv[1];
+  }
+  if (argc > 2) {
+    gigabytes = std::strtod(argv[2], nullptr);
+  }
+  if (argc > 3) {
+    frame_size = std::strtoul(argv[3], nullptr, 10);
+  }
+
+  std::cout << "Recording " << gigabytes << " GB of " << frame_size << " byte frames to " << path << std::endl;
+  for (bool direct_io : { true, false }) {
+    run(path, direct_io, frame_size, static_cast<uint64_t>(gigabytes * 1e9));
+  }
+
+  return 0;
+}
@@ -0,0 +1,100 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "science/synapse/recording/replayer.h"
+
+namespace {
+
+std::atomic<bool> interrupted(false);
+
+void handle_signal(int) {
+  interrupted = true;
+}
+
+}  // namespace
+
+void print_usage(const char* program_name) {
+  std::cout << "Usage: " << program_name << " <recording> [options]" << std::endl;
+  std::cout << "  recording: A file written by synapse::TapRecorder" << std::endl;
+  std::cout << "  --endpoint <endpoint>: Where to publish (default tcp://127.0.0.1:*)" << std::endl;
+  std::cout << "  --speed <x>: Playback rate relative to the recording (default 1)" << std::endl;
+  std::cout << "  --max: Send as fast as possible" << std::endl;
+  std::cout << "  --loop: Start again from the beginning after the last frame" << std::endl;
+  std::cout << "  --seek <seconds>: Start this far into the recording" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  std::string path = argv[1];
+  synapse::ReplayOptions options;
+  double seek_seconds = 0;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--endpoint" && i + 1 < argc) {
+      options.endpoint = argv[++i];
+    } else if (arg == "--speed" && i + 1 < argc) {
+      options.speed = std::strtod(argv[++i], nullptr);
+    } else if (arg == "--max") {
+      options.speed = 0;
+    } else if (arg == "--loop") {
+      options.loop = true;
+    } else if (arg == "--seek" && i + 1 < argc) {
+      seek_seconds = std::strtod(argv[++i], nullptr);
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::unique_ptr<synapse::Replayer> replayer;
+  auto status = synapse::Replayer::create(path, &replayer, options);
+  if (!status.ok()) {
+    std::cerr << "Failed to open recording: " << status.message() << std::endl;
+    return 1;
+  }
+
+  if (seek_seconds > 0) {
+    status = replayer->seek(replayer->start_timestamp_ns() + static_cast<uint64_t>(seek_seconds * 1e9));
+    if (!status.ok()) {
+      std::cerr << "Failed to seek: " << status.message() << std::endl;
+      return 1;
+    }
+  }
+
+  auto connection = replayer->connection();
+  auto duration = (replayer->end_timestamp_ns() - replayer->start_timestamp_ns()) / 1e9;
+  std::cout << "Replaying " << replayer->num_frames() << " frames (" << duration << " s) of "
+            << connection.message_type() << std::endl;
+  std::cout << "Publishing tap '" << connection.name() << "' on " << connection.endpoint() << std::endl;
+
+  std::signal(SIGINT, handle_signal);
+  status = replayer->start();
+  if (!status.ok()) {
+    std::cerr << "Failed to start: " << status.message() << std::endl;
+    return 1;
+  }
+
+  while (!interrupted && !replayer->wait(std::chrono::seconds(1))) {
+    auto stats = replayer->stats();
+    std::cout << "Sent " << stats.frames_sent << " frames (" << stats.bytes_sent / 1e6 << " MB), "
+              << stats.loops << " loops, lateness mean " << stats.mean_lateness.count() / 1e3 << " us, max "
+              << stats.max_lateness.count() / 1e3 << " us" << std::endl;
+  }
+  replayer->stop();
+
+  if (!replayer->status().ok()) {
+    std::cerr << "Replay failed: " << replayer->status().message() << std::endl;
+    return 1;
+  }
+  std::cout << "Done. Total frames: " << replayer->stats().frames_sent << std::endl;
+  return 0;
+}
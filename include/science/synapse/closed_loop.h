@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "science/synapse/latency_histogram.h"
+#include "science/synapse/status.h"
+#include "science/synapse/tap.h"
+
+namespace synapse {
+
+/**
+ * Options for a ClosedLoop.
+ */
+struct ClosedLoopOptions {
+  // CPU to pin the loop thread to; -1 leaves it unpinned
+  int cpu = -1;
+
+  // SCHED_FIFO priority for the loop thread (Linux); 0 keeps the default scheduler
+  int realtime_priority = 0;
+
+  // Bytes to reserve for commands, so the decision callback doesn't allocate
+  size_t command_capacity = 64 * 1024;
+};
+
+/**
+ * What a ClosedLoop has done so far.
+ */
+struct ClosedLoopStats {
+  uint64_t messages_received = 0;
+  uint64_t commands_sent = 0;
+  uint64_t send_errors = 0;
+
+  // Polls that found nothing waiting; the loop's idle time, in units of one poll
+  uint64_t empty_polls = 0;
+};
+
+/**
+ * Connects a producer tap to a consumer tap through a decision callback, on one busy-polling thread.
+ *
+ * The loop thread never sleeps or blocks: it polls the input for the next message, hands it to the
+ * decision callback without copying, and sends whatever command the callback writes. Pin it to an
+ * isolated core for the lowest latency; it keeps that core fully busy while running.
+ *
+ * The time from each message's arrival to its command being sent is recorded in latency(). The taps
+ * belong to the loop thread while it runs and must not be used elsewhere.
+ */
+class ClosedLoop {
+ public:
+  /**
+   * Called on the loop thread for each input message.
+   *
+   * Write a command into `command` (cleared before each call) and return true to send it.
+   */
+  using Decision = std::function<bool(const uint8_t* data, size_t size, std::vector<uint8_t>* command)>;
+
+  /**
+   * @param input A connected producer tap, e.g. broadband or spikes.
+   * @param output A connected consumer tap, e.g. an ElectricalStimulation or OpticalStimulation node's.
+   * @param decision The decision callback.
+   * @param loop Output parameter for the loop.
+   * @param options Thread placement options.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto create(
+    Tap* input,
+    Tap* output,
+    Decision decision,
+    std::unique_ptr<ClosedLoop>* loop,
+    const ClosedLoopOptions& options = {}
+  ) -> science::Status;
+
+  ~ClosedLoop();
+
+  ClosedLoop(const ClosedLoop&) = delete;
+  ClosedLoop& operator=(const ClosedLoop&) = delete;
+
+  /**
+   * Start the loop thread, once it's pinned and scheduled as requested.
+   *
+   * @return science::Status The error if the thread couldn't be placed; it doesn't start then.
+   */
+  [[nodiscard]] auto start() -> science::Status;
+
+  void stop();
+
+  [[nodiscard]] auto is_running() const -> bool { return running_; }
+
+  /**
+   * @return The first error the loop thread hit, if any; the loop stops on receive errors.
+   */
+  [[nodiscard]] auto status() const -> science::Status;
+
+  [[nodiscard]] auto stats() const -> ClosedLoopStats;
+
+  /**
+   * @return Input-to-output latency of every sent command, from receipt of the message to the send returning.
+   */
+  [[nodiscard]] auto latency() const -> const LatencyHistogram& { return latency_; }
+
+ private:
+  ClosedLoop(Tap* input, Tap* output, Decision decision, const ClosedLoopOptions& options);
+
+  auto place_thread() -> science::Status;
+  void run();
+
+  Tap* input_;
+  Tap* output_;
+  Decision decision_;
+  ClosedLoopOptions options_;
+
+  std::atomic<bool> running_{ false };
+  std::thread thread_;
+
+  mutable std::mutex mutex_;
+  science::Status status_;
+
+  std::atomic<uint64_t> messages_received_{ 0 };
+  std::atomic<uint64_t> commands_sent_{ 0 };
+  std::atomic<uint64_t> send_errors_{ 0 };
+  std::atomic<uint64_t> empty_polls_{ 0 };
+  LatencyHistogram latency_;
+};
+
+}  // namespace synapse
@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <utility>
 
@@ -14,6 +16,22 @@ namespace synapse {
 
 class IDevice;
 
+/**
+ * Structural difference between two device configurations.
+ *
+ * Nodes are matched by ID; a node is "changed" if it exists in both configurations
+ * with a different type or parameters.
+ */
+struct ConfigDiff {
+  std::vector<uint32_t> added_nodes;
+  std::vector<uint32_t> removed_nodes;
+  std::vector<uint32_t> changed_nodes;
+  std::vector<std::pair<uint32_t, uint32_t>> added_connections;
+  std::vector<std::pair<uint32_t, uint32_t>> removed_connections;
+
+  [[nodiscard]] auto empty() const -> bool;
+};
+
 /**
  * Configuration for a Synapse device.
  *
@@ -67,6 +85,33 @@ class Config {
    */
   [[nodiscard]] auto nodes() const -> const std::vector<std::shared_ptr<Node>>&;
 
+  /**
+   * Look up a node in the configuration by ID.
+   *
+   * @param id The node ID.
+   * @return std::shared_ptr<Node> The node, or nullptr if no node has the given ID.
+   */
+  [[nodiscard]] auto node(uint32_t id) const -> std::shared_ptr<Node>;
+
+  /**
+   * Sort the node graph so that every node comes after all of its inputs.
+   *
+   * @param order Output parameter for the sorted node IDs.
+   * @return science::Status kInvalidArgument if the graph contains a cycle.
+   */
+  [[nodiscard]] auto topological_sort(std::vector<uint32_t>* order) const -> science::Status;
+
+  /**
+   * Check the node graph for problems the device would reject, without a round trip to the device.
+   *
+   * Detects cycles, sources without consumers, nodes missing required inputs, sources with inputs,
+   * sinks with outputs, and connections between nodes whose signal types don't match
+   * (e.g. a SpikeBinner fed by broadband data).
+   *
+   * @return science::Status kInvalidArgument describing every problem found.
+   */
+  [[nodiscard]] auto validate() const -> science::Status;
+
   /**
    * Set the device object.
    * 
@@ -78,10 +123,57 @@ class Config {
   /**
    * Convert the configuration to its corresponding DeviceConfiguration proto message.
    *
+   * Node serialization errors are dropped; prefer the overloads returning science::Status.
+   *
    * @return synapse::DeviceConfiguration
    */
   auto to_proto() -> synapse::DeviceConfiguration;
 
+  /**
+   * Convert the configuration to its corresponding DeviceConfiguration proto message.
+   *
+   * The message is cached and only rebuilt after nodes or connections change, so
+   * the returned pointer may be shared between calls.
+   *
+   * @param proto Output parameter for the cached DeviceConfiguration.
+   * @return science::Status The first node serialization error, if any.
+   */
+  [[nodiscard]] auto to_proto(std::shared_ptr<const synapse::DeviceConfiguration>* proto) -> science::Status;
+
+  /**
+   * Serialize the configuration to DeviceConfiguration wire format.
+   *
+   * The bytes are cached alongside the proto message, so configuring many devices
+   * with the same Config reuses a single buffer.
+   *
+   * @param bytes Output parameter for the cached serialized configuration.
+   * @return science::Status The first node serialization error, if any.
+   */
+  [[nodiscard]] auto serialize(std::shared_ptr<const std::string>* bytes) -> science::Status;
+
+  /**
+   * Compute the structural difference from this configuration to another.
+   *
+   * @param to The configuration to compare against.
+   * @param diff Output parameter for the difference.
+   * @return science::Status
+   */
+  [[nodiscard]] auto diff(Config* to, ConfigDiff* diff) -> science::Status;
+
+  /**
+   * Compute the structural difference between two DeviceConfiguration proto messages.
+   *
+   * @param from The original configuration.
+   * @param to The updated configuration.
+   * @param diff Output parameter for the difference.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto diff(
+    const synapse::DeviceConfiguration& from,
+    const synapse::DeviceConfiguration& to,
+    ConfigDiff* diff
+  ) -> science::Status;
+
   /**
    * Convert the given DeviceConfiguration proto to its corresponding Config instance, with nodes and connections.
    *
@@ -98,7 +190,21 @@ class Config {
   std::vector<std::shared_ptr<Node>> nodes_;
   std::vector<std::pair<uint32_t, uint32_t>> connections_;
 
+  // Indexes over nodes_ and connections_ so lookups don't scan the graph
+  std::unordered_map<uint32_t, std::shared_ptr<Node>> node_index_;
+  std::unordered_set<uint64_t> connection_index_;
+
+  // Serialized configuration, rebuilt when revision() moves past cached_revision_
+  uint64_t structure_revision_ = 0;
+  uint64_t cached_revision_ = 0;
+  std::shared_ptr<const synapse::DeviceConfiguration> cached_proto_;
+  std::shared_ptr<const std::string> cached_bytes_;
+
   [[nodiscard]] auto gen_node_id() -> uint32_t;
+  [[nodiscard]] auto insert_node(std::shared_ptr<Node> node, uint32_t id) -> science::Status;
+  [[nodiscard]] auto insert_connection(uint32_t src, uint32_t dst) -> science::Status;
+  [[nodiscard]] auto revision() const -> uint64_t;
+  [[nodiscard]] auto refresh_cache() -> science::Status;
 };
 
 }  // namespace synapse
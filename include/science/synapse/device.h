@@ -41,9 +41,42 @@ class Device : public IDevice {
   explicit Device(const std::string& uri);
 
   /**
+   * Establish the underlying gRPC channel to the device.
+   *
+   * Channels connect lazily on the first RPC; calling this ahead of time moves the
+   * connection setup cost off of the first call.
+   *
+   * @param timeout Optional timeout to wait for the channel to become ready.
+   * @return Status indicating success, or kDeadlineExceeded if the channel did not become ready in time.
+   */
+  [[nodiscard]] auto connect(std::optional<std::chrono::milliseconds> timeout = std::nullopt) -> science::Status;
+
+  /**
+   * The configuration is checked with Config::validate() first, and not sent if it is invalid.
+   *
    * @see synapse::SynapseDevice::Stub#Configure
    */
   [[nodiscard]] auto configure(Config* config, std::optional<std::chrono::milliseconds> timeout = std::nullopt) -> science::Status;
+
+  /**
+   * Configure the device, skipping the RPC if nothing has changed.
+   *
+   * Compares the given configuration against the last configuration this client
+   * successfully applied. If they are identical, no request is sent. Otherwise the
+   * configuration is sent as with `configure`; the device only accepts complete
+   * configurations, so that is the smallest update it supports.
+   *
+   * @param config The configuration to apply.
+   * @param diff Optional output parameter for the difference from the last applied configuration.
+   *             If nothing has been applied yet, every node and connection is reported as added.
+   * @param timeout Optional timeout for the configure call.
+   * @return Status indicating success or failure; kInvalidArgument, without a request, if
+   *         Config::validate() rejects the configuration.
+   */
+  [[nodiscard]] auto reconfigure(Config* config,
+                                 ConfigDiff* diff = nullptr,
+                                 std::optional<std::chrono::milliseconds> timeout = std::nullopt) -> science::Status;
+
   /**
    * @see synapse::SynapseDevice::Stub#info
    */
@@ -114,7 +147,11 @@ class Device : public IDevice {
   std::string uri_;
   std::shared_ptr<grpc::Channel> channel_;
   std::unique_ptr<synapse::SynapseDevice::Stub> rpc_;
+  std::shared_ptr<const synapse::DeviceConfiguration> applied_config_;
+  std::shared_ptr<const std::string> applied_bytes_;
 
+  [[nodiscard]] auto send_configuration(Config* config,
+                                        std::optional<std::chrono::milliseconds> timeout) -> science::Status;
   [[nodiscard]] auto handle_status_response(const synapse::Status& status) -> science::Status;
 };
 
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/dsp/sample_block.h"
+#include "science/synapse/dsp/simd.h"
+#include "science/synapse/dsp/work_stealing_pool.h"
+
+namespace synapse {
+
+/**
+ * A snapshot of one channel's statistics.
+ */
+struct ChannelStats {
+  uint64_t count = 0;
+  float mean = 0;
+  float variance = 0;
+  float rms = 0;
+  float median = 0;
+
+  // Median absolute deviation from the median
+  float mad = 0;
+
+  /**
+   * @return The robust noise estimate, MAD / 0.6745: the standard deviation if the noise is
+   *         Gaussian, but barely moved by spikes.
+   */
+  [[nodiscard]] auto noise() const -> float { return 1.4826f * mad; }
+};
+
+/**
+ * Options for a ChannelStatsEngine.
+ */
+struct ChannelStatsOptions {
+  // Time constant of the exponential forgetting applied to the mean and variance, in seconds;
+  // 0 keeps them over everything since the last reset
+  double time_constant_s = 0;
+
+  // Per-sample relative step of the median and MAD estimators. Larger tracks changes faster,
+  // smaller is steadier: on Gaussian noise the MAD is off by about 0.8 * sqrt(rate) relative
+  // (2.4% at the default)
+  float quantile_rate = 1e-3f;
+};
+
+/**
+ * Streaming per-channel statistics of decoded broadband data, for setting spike thresholds.
+ *
+ * Keeps each channel's running mean and variance, and estimates its median and median
+ * absolute deviation with frugal streaming quantile estimators: each sample nudges the
+ * median toward itself, and scales the MAD up or down by whether it lies outside or inside,
+ * so both settle where half the samples fall on either side. They are seeded with the exact
+ * median and MAD of each channel's first block, and take steps relative to the MAD, so they
+ * track any scale of signal. Every statistic is updated eight channels at a time with AVX2
+ * when the CPU supports it.
+ *
+ * Samples are taken to be in microvolts, band-pass filtered for spike detection.
+ */
+class ChannelStatsEngine {
+ public:
+  /**
+   * @param num_channels The number of channels in each sample row.
+   * @param engine Output parameter for the engine.
+   * @param options Forgetting and estimator rates.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto create(
+    size_t num_channels,
+    std::unique_ptr<ChannelStatsEngine>* engine,
+    const ChannelStatsOptions& options = {}
+  ) -> science::Status;
+
+  /**
+   * Update the statistics with a block.
+   *
+   * @param block The block to add.
+   * @param pool Optional pool to update groups of channels in parallel.
+   * @return science::Status kInvalidArgument if the block's channel count doesn't match.
+   */
+  [[nodiscard]] auto process(const SampleBlock& block, WorkStealingPool* pool = nullptr) -> science::Status;
+
+  /**
+   * @return One channel's statistics.
+   */
+  [[nodiscard]] auto stats(size_t channel) const -> ChannelStats;
+
+  /**
+   * @param stats Output parameter, resized to one entry per channel.
+   */
+  void all_stats(std::vector<ChannelStats>* stats) const;
+
+  /**
+   * Per-channel spike thresholds: `multiplier` times each channel's noise().
+   *
+   * @param thresholds_uv Output parameter, resized to one threshold per channel; 0 for
+   *                      channels with no data yet.
+   * @param multiplier Noise multiples above zero to detect at; 4 to 5 is typical.
+   */
+  void channel_thresholds_uv(std::vector<float>* thresholds_uv, float multiplier = 4.0f) const;
+
+  /**
+   * Suggest one threshold for a whole SpikeDetector or SpikeSource: the median across channels
+   * of their thresholds, so dead or unusually noisy channels don't skew it.
+   *
+   * Apply it with SpikeDetector::set_threshold_uv() or SpikeSource::set_threshold_uV().
+   *
+   * @param threshold_uv Output parameter for the threshold.
+   * @param multiplier Noise multiples above zero to detect at; 4 to 5 is typical.
+   * @return science::Status kUnavailable until some data has been processed.
+   */
+  [[nodiscard]] auto suggest_threshold_uv(float* threshold_uv, float multiplier = 4.0f) const -> science::Status;
+
+  /**
+   * Forget all statistics.
+   */
+  void reset();
+
+  /**
+   * Select the instruction set used by process(). Levels the CPU doesn't support fall back to scalar.
+   */
+  void set_simd_level(SimdLevel level);
+
+  [[nodiscard]] auto num_channels() const -> size_t;
+
+ private:
+  ChannelStatsEngine(size_t num_channels, const ChannelStatsOptions& options);
+
+  void process_channels(const SampleBlock& block, size_t channel_begin, size_t channel_end, double decay);
+  void seed_channels(const SampleBlock& block, size_t channel_begin, size_t channel_end);
+
+  size_t num_channels_;
+  ChannelStatsOptions options_;
+  SimdLevel simd_level_;
+
+  // Samples seen, and the exponentially weighted count, mean and sum of squared deviations
+  std::vector<uint64_t> count_;
+  std::vector<double> weight_;
+  std::vector<double> mean_;
+  std::vector<double> m2_;
+
+  // Frugal estimators
+  std::vector<float> median_;
+  std::vector<float> mad_;
+
+  // Per-block sums, offset by each channel's mean so they stay exact in float
+  std::vector<float> shift_;
+  std::vector<float> block_sum_;
+  std::vector<float> block_sum_sq_;
+};
+
+}  // namespace synapse
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/dsp/sample_block.h"
+#include "science/synapse/dsp/simd.h"
+
+namespace synapse {
+
+/**
+ * The range and mean of the samples under one bin or pixel. Empty where there's no data:
+ * min and max are NaN.
+ */
+struct EnvelopeBin {
+  float min;
+  float max;
+  float mean;
+};
+
+/**
+ * Options for an EnvelopePyramid.
+ */
+struct EnvelopePyramidOptions {
+  // How much history to keep, in seconds
+  double history_s = 10.0;
+
+  // Samples per bin at the finest level; zooming in further shows one bin per pixel
+  size_t base_bin_samples = 16;
+
+  // Bins of one level merged into each bin of the next
+  size_t fanout = 4;
+};
+
+/**
+ * A multi-resolution min/max/mean envelope of every channel, for drawing live traces.
+ *
+ * The finest level holds one bin per `base_bin_samples` samples; each level above merges
+ * `fanout` bins of the one below, up to a level with only a handful of bins over the whole
+ * history. Every level is a ring covering at least `history_s` seconds, so memory is bounded:
+ * roughly 12 bytes per channel per base bin of history, times fanout / (fanout - 1).
+ *
+ * process() updates the levels as blocks arrive, eight channels at a time with AVX2 when the
+ * CPU supports it. query() draws any range of the history at a given width by reading the
+ * coarsest level with at least one bin per pixel, so it costs O(pixels) per channel however
+ * long the range. The newest samples, not yet in a completed bin at that level, are filled in
+ * from finer levels; only the current partial base bin is left out.
+ *
+ * Not thread-safe: guard it with a mutex if processing and drawing on different threads.
+ */
+class EnvelopePyramid {
+ public:
+  /**
+   * @param num_channels The number of channels in each sample row.
+   * @param sample_rate_hz The sample rate, to size the history.
+   * @param pyramid Output parameter for the pyramid.
+   * @param options History length and bin sizes.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto create(
+    size_t num_channels,
+    float sample_rate_hz,
+    std::unique_ptr<EnvelopePyramid>* pyramid,
+    const EnvelopePyramidOptions& options = {}
+  ) -> science::Status;
+
+  /**
+   * Add a block's samples, continuing from the previous block.
+   *
+   * @return science::Status kInvalidArgument if the block's channel count doesn't match.
+   */
+  [[nodiscard]] auto process(const SampleBlock& block) -> science::Status;
+
+  /**
+   * Draw one channel's envelope over a range of samples.
+   *
+   * @param channel The channel to draw.
+   * @param begin_sample The first sample of the range.
+   * @param end_sample One past the last sample of the range.
+   * @param pixels The number of pixels to draw the range into.
+   * @param out Output parameter, resized to one bin per pixel. Pixels outside the history are empty.
+   * @return science::Status kOutOfRange for an unknown channel.
+   */
+  [[nodiscard]] auto query(
+    size_t channel,
+    uint64_t begin_sample,
+    uint64_t end_sample,
+    size_t pixels,
+    std::vector<EnvelopeBin>* out
+  ) const -> science::Status;
+
+  /**
+   * Draw every channel's envelope over a range of samples.
+   *
+   * Reads each level's bins a row of channels at a time, so redrawing all channels this way is
+   * much faster than querying them one by one.
+   *
+   * @param begin_sample The first sample of the range.
+   * @param end_sample One past the last sample of the range.
+   * @param pixels The number of pixels to draw the range into.
+   * @param out Output parameter, resized to `pixels` bins per channel, channel-major: channel c's
+   *            pixels start at c * pixels.
+   * @return science::Status
+   */
+  [[nodiscard]] auto query(
+    uint64_t begin_sample,
+    uint64_t end_sample,
+    size_t pixels,
+    std::vector<EnvelopeBin>* out
+  ) const -> science::Status;
+
+  /**
+   * Clear the history and stream position.
+   */
+  void reset();
+
+  /**
+   * Select the instruction set used by process() and query(). Levels the CPU doesn't support fall back to scalar.
+   */
+  void set_simd_level(SimdLevel level);
+
+  /**
+   * @return The sample at a timestamp, from the first block's timestamp and the sample rate.
+   */
+  [[nodiscard]] auto sample_at(uint64_t timestamp_ns) const -> uint64_t;
+
+  /**
+   * @return The number of samples processed; the end of the history.
+   */
+  [[nodiscard]] auto position() const -> uint64_t { return position_; }
+
+  [[nodiscard]] auto num_channels() const -> size_t { return num_channels_; }
+  [[nodiscard]] auto num_levels() const -> size_t { return levels_.size(); }
+  [[nodiscard]] auto bin_samples(size_t level) const -> uint64_t { return levels_[level].bin_samples; }
+  [[nodiscard]] auto memory_bytes() const -> size_t;
+
+ private:
+  struct Level {
+    uint64_t bin_samples;
+    size_t capacity;
+
+    // Completed bins; bin i is in slot i % capacity, channel-interleaved like a SampleBlock
+    uint64_t written = 0;
+    std::vector<float> min;
+    std::vector<float> max;
+    std::vector<float> mean;
+
+    // The bin being filled, from samples (level 0) or the level below's bins
+    size_t pending_count = 0;
+    std::vector<float> pending_min;
+    std::vector<float> pending_max;
+    std::vector<float> pending_sum;
+  };
+
+  struct Accumulator;
+  struct RowAccumulator;
+
+  EnvelopePyramid(size_t num_channels, float sample_rate_hz);
+
+  void finish_bin(size_t level);
+  auto query_level(uint64_t begin_sample, uint64_t end_sample, size_t pixels) const -> size_t;
+  void accumulate(size_t level, size_t channel, uint64_t begin, uint64_t end, Accumulator* acc) const;
+  void accumulate(size_t level, uint64_t begin, uint64_t end, RowAccumulator* acc) const;
+
+  size_t num_channels_;
+  float sample_rate_hz_;
+  SimdLevel simd_level_;
+  uint64_t position_;
+  uint64_t start_timestamp_ns_;
+  std::vector<Level> levels_;
+};
+
+}  // namespace synapse
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/config.h"
+#include "science/synapse/dsp/sample_block.h"
+#include "science/synapse/dsp/spike_binner_engine.h"
+#include "science/synapse/dsp/spike_event.h"
+#include "science/synapse/dsp/work_stealing_pool.h"
+
+namespace synapse {
+
+/**
+ * Spikes detected over a span of time.
+ *
+ * The span is carried even when there are no events, so downstream binning knows
+ * which bins are complete.
+ */
+struct SpikeBatch {
+  // Channels the events may refer to
+  size_t num_channels = 0;
+  uint64_t start_timestamp_ns = 0;
+  uint64_t end_timestamp_ns = 0;
+  std::vector<SpikeEvent> events;
+};
+
+/**
+ * Data passed between pipeline stages: broadband samples, spikes, or binned spike counts (one matrix per bin width).
+ */
+using PipelineData = std::variant<SampleBlock, SpikeBatch, std::vector<SpikeCounts>>;
+
+/**
+ * A snapshot of one stage's counters.
+ */
+struct StageMetrics {
+  uint32_t node_id = 0;
+  synapse::NodeType type = synapse::NodeType::kNodeTypeUnknown;
+
+  // Packets processed, and the samples (broadband) or spikes (spikes) they held
+  uint64_t packets = 0;
+  uint64_t items = 0;
+  uint64_t errors = 0;
+
+  // Time spent processing, and from enqueue to processed (queueing included)
+  std::chrono::nanoseconds busy{0};
+  std::chrono::nanoseconds total_latency{0};
+  std::chrono::nanoseconds max_latency{0};
+
+  size_t queue_depth = 0;
+  size_t max_queue_depth = 0;
+
+  [[nodiscard]] auto mean_latency() const -> std::chrono::nanoseconds {
+    return packets == 0 ? std::chrono::nanoseconds(0) : total_latency / static_cast<int64_t>(packets);
+  }
+
+  // Items processed per second of processing time
+  [[nodiscard]] auto throughput() const -> double {
+    return busy.count() == 0 ? 0.0 : items * 1e9 / busy.count();
+  }
+};
+
+/**
+ * Runs the processing nodes of a Config on the host.
+ *
+ * Each SpectralFilter, SpikeDetector and SpikeBinner node becomes a stage backed by
+ * the matching host engine; BroadbandSource and SpikeSource nodes are inputs, fed
+ * with push(). Sinks with no host equivalent (disk writers, stimulation) are skipped.
+ *
+ * Stages run on a shared pool of worker threads, each stage on at most one worker at
+ * a time so its packets are processed in order. Every stage has a bounded input
+ * queue; a stage is only scheduled when there is room downstream, and push() blocks
+ * while the queues after an input are full.
+ */
+class Pipeline {
+ public:
+  using OutputCallback = std::function<void(uint32_t node_id, const PipelineData& data)>;
+
+  /**
+   * Build a pipeline from a configuration.
+   *
+   * Engines are created from each node's parameters when its stage sees its first block.
+   *
+   * @param config The configuration to mirror.
+   * @param pipeline Output parameter for the pipeline.
+   * @param num_workers Number of worker threads (default: one per core).
+   * @param queue_capacity Maximum number of packets waiting at each stage.
+   * @return science::Status kInvalidArgument if the graph contains a cycle.
+   */
+  [[nodiscard]] static auto create(
+    const Config& config,
+    std::unique_ptr<Pipeline>* pipeline,
+    size_t num_workers = 0,
+    size_t queue_capacity = 8
+  ) -> science::Status;
+
+  ~Pipeline();
+
+  /**
+   * Receive the output of a node. Must be called before start().
+   *
+   * The callback runs on a worker thread, and is called in order for each node.
+   *
+   * @param node_id The node whose output to receive.
+   * @param callback Called with each packet the node produces.
+   * @return science::Status kNotFound if the node has no stage.
+   */
+  [[nodiscard]] auto on_output(uint32_t node_id, OutputCallback callback) -> science::Status;
+
+  /**
+   * Split filter and detector stages across channel groups on a pool. Must be called before start().
+   *
+   * The pool may be shared with other pipelines.
+   *
+   * @param pool The pool, or nullptr to process each block on one worker.
+   * @return science::Status
+   */
+  [[nodiscard]] auto set_channel_pool(std::shared_ptr<WorkStealingPool> pool) -> science::Status;
+
+  /**
+   * Start the worker threads.
+   */
+  [[nodiscard]] auto start() -> science::Status;
+
+  /**
+   * Wait for all queued packets to be processed, then stop the worker threads.
+   */
+  void stop();
+
+  /**
+   * Feed broadband samples into a BroadbandSource node, blocking while downstream queues are full.
+   *
+   * @param source_id The BroadbandSource node ID.
+   * @param block The samples.
+   * @return science::Status kNotFound if there is no such source, kFailedPrecondition if not running.
+   */
+  [[nodiscard]] auto push(uint32_t source_id, SampleBlock block) -> science::Status;
+
+  /**
+   * Feed spikes into a SpikeSource node, blocking while downstream queues are full.
+   *
+   * @param source_id The SpikeSource node ID.
+   * @param spikes The spikes.
+   * @return science::Status kNotFound if there is no such source, kFailedPrecondition if not running.
+   */
+  [[nodiscard]] auto push(uint32_t source_id, SpikeBatch spikes) -> science::Status;
+
+  /**
+   * Wait until every packet pushed so far has been processed.
+   */
+  void drain();
+
+  /**
+   * The first error any stage has hit, if any.
+   */
+  [[nodiscard]] auto status() const -> science::Status;
+
+  /**
+   * Snapshot the metrics of every stage, in topological order.
+   */
+  void metrics(std::vector<StageMetrics>* metrics) const;
+
+ private:
+  struct Stage;
+  struct Packet;
+
+  Pipeline(size_t num_workers, size_t queue_capacity);
+
+  [[nodiscard]] auto push(uint32_t source_id, synapse::NodeType source_type, PipelineData data)
+    -> science::Status;
+  void run_worker();
+  [[nodiscard]] auto next_runnable() -> Stage*;
+  [[nodiscard]] auto has_room(const std::vector<Stage*>& consumers) const -> bool;
+  void deliver(const std::vector<Stage*>& consumers, const std::shared_ptr<const PipelineData>& data);
+
+  size_t num_workers_;
+  size_t queue_capacity_;
+  std::shared_ptr<WorkStealingPool> channel_pool_;
+
+  // Stages in topological order; sources are not stages but have consumer lists
+  std::vector<std::unique_ptr<Stage>> stages_;
+  std::unordered_map<uint32_t, Stage*> stage_index_;
+  std::unordered_map<uint32_t, std::pair<synapse::NodeType, std::vector<Stage*>>> sources_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::thread> workers_;
+  size_t in_flight_ = 0;
+  bool running_ = false;
+  bool stopping_ = false;
+  science::Status status_;
+};
+
+}  // namespace synapse
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/api/datatype.pb.h"
+
+namespace synapse {
+
+/**
+ * A block of decoded broadband samples.
+ *
+ * Samples are stored channel-interleaved, one row of `num_channels` values per time
+ * step, the same order as consecutive BroadbandFrame messages. Host-side DSP kernels
+ * map SIMD lanes to adjacent channels, so a row is processed a vector at a time.
+ */
+struct SampleBlock {
+  size_t num_channels = 0;
+  size_t num_samples = 0;
+  float sample_rate_hz = 0;
+  uint64_t start_timestamp_ns = 0;
+  uint64_t start_sequence_number = 0;
+  std::vector<float> samples;
+
+  /**
+   * Resize the block, keeping its allocation when shrinking.
+   */
+  void resize(size_t channels, size_t samples_per_channel);
+
+  [[nodiscard]] auto row(size_t sample) -> float* { return samples.data() + sample * num_channels; }
+  [[nodiscard]] auto row(size_t sample) const -> const float* { return samples.data() + sample * num_channels; }
+  [[nodiscard]] auto at(size_t sample, size_t channel) const -> float {
+    return samples[sample * num_channels + channel];
+  }
+
+  /**
+   * Append one frame as the next row of the block.
+   *
+   * The first frame appended to an empty block sets the channel count, timestamp,
+   * sequence number and sample rate.
+   *
+   * @param frame The frame to append.
+   * @return science::Status kInvalidArgument if the frame's channel count doesn't match the block.
+   */
+  [[nodiscard]] auto append(const synapse::BroadbandFrame& frame) -> science::Status;
+
+  /**
+   * Decode consecutive frames into a block, replacing its contents.
+   *
+   * @param frames The frames to decode, in sequence order.
+   * @param block The block to populate.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto from_frames(
+    const std::vector<synapse::BroadbandFrame>& frames,
+    SampleBlock* block
+  ) -> science::Status;
+};
+
+}  // namespace synapse
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace synapse {
+
+/**
+ * Instruction sets the host-side DSP kernels can use.
+ */
+enum class SimdLevel {
+  kScalar,
+  kAvx2,
+};
+
+/**
+ * The best SIMD level supported by the CPU we're running on.
+ *
+ * @return SimdLevel
+ */
+auto detect_simd_level() -> SimdLevel;
+
+}  // namespace synapse
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/dsp/sample_block.h"
+#include "science/synapse/dsp/simd.h"
+#include "science/synapse/dsp/work_stealing_pool.h"
+#include "science/synapse/nodes/spectral_filter.h"
+
+namespace synapse {
+
+/**
+ * Host-side implementation of a SpectralFilter node.
+ *
+ * Applies the node's low-pass, high-pass, band-pass or band-stop response to decoded
+ * broadband samples as a cascade of Butterworth biquads (transposed direct form II),
+ * with independent state per channel. The cutoff used by a low-pass filter is the
+ * node's `high_cutoff_hz`; a high-pass filter uses `low_cutoff_hz`.
+ *
+ * Channels are filtered eight at a time with AVX2 when the CPU supports it.
+ */
+class SpectralFilterEngine {
+ public:
+  // Normalized second-order section coefficients (a0 == 1)
+  struct Biquad {
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+  };
+
+  /**
+   * Design a filter engine matching a SpectralFilter node.
+   *
+   * @param filter The node configuration to match.
+   * @param sample_rate_hz The sample rate of the data to be filtered.
+   * @param num_channels The number of channels in each sample row.
+   * @param engine Output parameter for the engine.
+   * @param order Butterworth order of each filter edge; must be even (default: 4).
+   * @return science::Status kInvalidArgument if the cutoffs are not realizable at this sample rate.
+   */
+  [[nodiscard]] static auto create(
+    const SpectralFilter& filter,
+    float sample_rate_hz,
+    size_t num_channels,
+    std::unique_ptr<SpectralFilterEngine>* engine,
+    uint32_t order = 4
+  ) -> science::Status;
+
+  /**
+   * Filter a block in place, continuing from the state left by the previous block.
+   *
+   * Channels are independent, so splitting them across a pool gives exactly the
+   * single-threaded result.
+   *
+   * @param block The block to filter.
+   * @param pool Optional pool to filter groups of channels in parallel.
+   * @return science::Status kInvalidArgument if the block's channel count doesn't match.
+   */
+  [[nodiscard]] auto process(SampleBlock* block, WorkStealingPool* pool = nullptr) -> science::Status;
+
+  /**
+   * Filter a range of channels in place.
+   *
+   * Channels outside [channel_begin, channel_end) are left untouched, so disjoint
+   * ranges may be processed concurrently from different threads.
+   *
+   * @param samples Channel-interleaved samples, `stride` values per row.
+   * @param stride The number of values per row (normally num_channels()).
+   * @param num_samples The number of rows.
+   * @param channel_begin The first channel to filter.
+   * @param channel_end One past the last channel to filter.
+   */
+  void process_channels(float* samples, size_t stride, size_t num_samples, size_t channel_begin, size_t channel_end);
+
+  /**
+   * Clear the filter state for all channels.
+   */
+  void reset();
+
+  /**
+   * Select the instruction set used by process(). Levels the CPU doesn't support fall back to scalar.
+   */
+  void set_simd_level(SimdLevel level);
+
+  [[nodiscard]] auto num_channels() const -> size_t;
+  [[nodiscard]] auto num_sections() const -> size_t;
+
+ private:
+  SpectralFilterEngine(std::vector<Biquad> sections, size_t num_channels);
+
+  std::vector<Biquad> sections_;
+  size_t num_channels_;
+  SimdLevel simd_level_;
+
+  // Per-section, per-channel filter state: z1_[section * num_channels_ + channel]
+  std::vector<float> z1_;
+  std::vector<float> z2_;
+};
+
+}  // namespace synapse
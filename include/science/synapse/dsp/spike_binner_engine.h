@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/dsp/spike_event.h"
+#include "science/synapse/nodes/spike_binner.h"
+
+namespace synapse {
+
+/**
+ * Spike counts for consecutive bins of one width.
+ *
+ * Counts are stored channel-major, one row of `num_bins` counts per channel.
+ */
+struct SpikeCounts {
+  size_t num_channels = 0;
+  size_t num_bins = 0;
+  uint32_t bin_size_ms = 0;
+  uint64_t start_timestamp_ns = 0;
+  std::vector<uint32_t> counts;
+
+  /**
+   * Resize the matrix, keeping its allocation when shrinking.
+   */
+  void resize(size_t channels, size_t bins);
+
+  [[nodiscard]] auto at(size_t channel, size_t bin) const -> uint32_t { return counts[channel * num_bins + bin]; }
+};
+
+/**
+ * Host-side implementation of a SpikeBinner node.
+ *
+ * Counts spike events into bins of the node's width, and optionally of other widths
+ * in the same pass. Bins are aligned to multiples of their width since the epoch of
+ * the events' timestamps. Each width keeps a ring of bins covering at least one
+ * second past the oldest bin not yet taken; events beyond that, or in bins already
+ * taken, are dropped and counted.
+ *
+ * An engine created with `concurrent` set may be fed from several threads at once;
+ * counters are then updated with atomic increments. take() may run alongside them,
+ * as long as the producers have moved past the bins being taken.
+ */
+class SpikeBinnerEngine {
+ public:
+  /**
+   * Create a binner engine matching a SpikeBinner node.
+   *
+   * @param binner The node configuration to match.
+   * @param num_channels The number of channels events may refer to.
+   * @param engine Output parameter for the engine.
+   * @param extra_bin_sizes_ms Additional bin widths to count at the same time.
+   * @param concurrent Whether add() may be called from several threads at once.
+   * @return science::Status kInvalidArgument if any bin width is zero.
+   */
+  [[nodiscard]] static auto create(
+    const SpikeBinner& binner,
+    size_t num_channels,
+    std::unique_ptr<SpikeBinnerEngine>* engine,
+    const std::vector<uint32_t>& extra_bin_sizes_ms = {},
+    bool concurrent = false
+  ) -> science::Status;
+
+  ~SpikeBinnerEngine();
+
+  /**
+   * Count a spike into every bin width.
+   */
+  void add(const SpikeEvent& event);
+
+  /**
+   * Count a batch of spikes into every bin width.
+   */
+  void add(const std::vector<SpikeEvent>& events);
+
+  /**
+   * Take the counts of every bin that ended at or before `until_ns`, clearing them.
+   *
+   * `counts` gets one matrix per bin width, in the order of bin_sizes_ms(), starting
+   * at the oldest bin not yet taken. The matrices are resized in place, so passing
+   * the same vector each time avoids reallocating. At most one ring of bins is taken
+   * per call.
+   *
+   * @param until_ns Only bins ending at or before this time are taken.
+   * @param counts Output parameter for the counts.
+   * @return science::Status
+   */
+  [[nodiscard]] auto take(uint64_t until_ns, std::vector<SpikeCounts>* counts) -> science::Status;
+
+  /**
+   * Bin widths, the node's first.
+   */
+  [[nodiscard]] auto bin_sizes_ms() const -> const std::vector<uint32_t>&;
+  [[nodiscard]] auto num_channels() const -> size_t;
+
+  /**
+   * Number of event counts dropped because their bin was already taken.
+   */
+  [[nodiscard]] auto late() const -> uint64_t;
+
+  /**
+   * Number of event counts dropped because their bin was too far ahead, or their channel out of range.
+   */
+  [[nodiscard]] auto dropped() const -> uint64_t;
+
+ private:
+  struct Ring;
+
+  SpikeBinnerEngine(const std::vector<uint32_t>& bin_sizes_ms, size_t num_channels, bool concurrent);
+
+  std::vector<uint32_t> bin_sizes_ms_;
+  size_t num_channels_;
+  bool concurrent_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+  std::atomic<uint64_t> late_;
+  std::atomic<uint64_t> dropped_;
+};
+
+}  // namespace synapse
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/dsp/sample_block.h"
+#include "science/synapse/dsp/simd.h"
+#include "science/synapse/dsp/spike_event.h"
+#include "science/synapse/dsp/work_stealing_pool.h"
+#include "science/synapse/nodes/spike_detector.h"
+
+namespace synapse {
+
+/**
+ * Host-side implementation of a SpikeDetector node.
+ *
+ * A thresholder emits a spike when a channel's magnitude rises to `threshold_uv`. A
+ * template matcher emits a spike when the normalized correlation between the template
+ * and the most recent window of samples rises to `min_correlation`. Either way a
+ * channel then stays refractory for `samples_per_spike` samples.
+ *
+ * Samples are taken to be in microvolts. Both detectors scan eight channels at a time
+ * with AVX2 when the CPU supports it; the threshold and correlation can be changed
+ * between blocks to rerun detection without reconfiguring the device.
+ */
+class SpikeDetectorEngine {
+ public:
+  /**
+   * Create a detector engine matching a SpikeDetector node.
+   *
+   * @param detector The node configuration to match.
+   * @param num_channels The number of channels in each sample row.
+   * @param engine Output parameter for the engine.
+   * @return science::Status kInvalidArgument if the template can't be correlated against.
+   */
+  [[nodiscard]] static auto create(
+    const SpikeDetector& detector,
+    size_t num_channels,
+    std::unique_ptr<SpikeDetectorEngine>* engine
+  ) -> science::Status;
+
+  /**
+   * Detect spikes in a block, continuing from the state left by the previous block.
+   *
+   * Events are appended to `events` in sample order, and by channel within a sample,
+   * whether or not a pool is used.
+   *
+   * @param block The block to scan.
+   * @param events Output parameter the detected spikes are appended to.
+   * @param pool Optional pool to scan groups of channels in parallel.
+   * @return science::Status kInvalidArgument if the block's channel count doesn't match.
+   */
+  [[nodiscard]] auto process(
+    const SampleBlock& block,
+    std::vector<SpikeEvent>* events,
+    WorkStealingPool* pool = nullptr
+  ) -> science::Status;
+
+  /**
+   * Detect spikes in a range of channels of a block.
+   *
+   * Only state for channels in [channel_begin, channel_end) is touched, so disjoint
+   * ranges may be processed concurrently from different threads, each with its own
+   * event vector. Once every range of a block is done, call advance() once.
+   *
+   * @param block The block to scan.
+   * @param channel_begin The first channel to scan.
+   * @param channel_end One past the last channel to scan.
+   * @param events Output parameter the detected spikes are appended to.
+   */
+  void process_channels(
+    const SampleBlock& block,
+    size_t channel_begin,
+    size_t channel_end,
+    std::vector<SpikeEvent>* events
+  );
+
+  /**
+   * Move the stream position past a block scanned with process_channels().
+   */
+  void advance(const SampleBlock& block);
+
+  /**
+   * Clear the detector state and stream position for all channels.
+   */
+  void reset();
+
+  /**
+   * Override the node's threshold. Only used by thresholders.
+   */
+  void set_threshold_uv(float threshold_uv);
+
+  /**
+   * Set the normalized correlation, in (0, 1], a template match must reach (default: 0.9).
+   * Only used by template matchers.
+   */
+  void set_min_correlation(float min_correlation);
+
+  /**
+   * Select the instruction set used by process(). Levels the CPU doesn't support fall back to scalar.
+   */
+  void set_simd_level(SimdLevel level);
+
+  [[nodiscard]] auto mode() const -> SpikeDetector::Mode;
+  [[nodiscard]] auto threshold_uv() const -> float;
+  [[nodiscard]] auto min_correlation() const -> float;
+  [[nodiscard]] auto num_channels() const -> size_t;
+  [[nodiscard]] auto position() const -> uint64_t;
+
+ private:
+  SpikeDetectorEngine(const SpikeDetector& detector, size_t num_channels);
+
+  void threshold_channels(const SampleBlock& block, size_t channel_begin, size_t channel_end,
+                          std::vector<SpikeEvent>* events);
+  void match_channels(const SampleBlock& block, size_t channel_begin, size_t channel_end,
+                      std::vector<SpikeEvent>* events);
+
+  SpikeDetector::Mode mode_;
+  size_t num_channels_;
+  SimdLevel simd_level_;
+  float threshold_uv_;
+  float min_correlation_;
+  uint32_t refractory_samples_;
+  uint64_t position_;
+
+  // Zero-mean template and its L2 norm
+  std::vector<float> template_;
+  float template_norm_;
+
+  // First sample each channel may spike at again
+  std::vector<uint64_t> next_allowed_;
+
+  // Each channel's previous magnitude (thresholder) or correlation (template matcher)
+  std::vector<float> last_score_;
+
+  // The last template_.size() - 1 rows seen, channel-interleaved like a SampleBlock
+  std::vector<float> history_;
+
+  // Per-chunk events when scanning on a pool, kept to reuse their allocations
+  std::vector<std::vector<SpikeEvent>> chunk_events_;
+};
+
+}  // namespace synapse
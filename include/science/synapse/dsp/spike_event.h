@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+namespace synapse {
+
+/**
+ * A single detected spike.
+ */
+struct SpikeEvent {
+  // Channel index within the block the spike was detected in
+  uint32_t channel = 0;
+
+  // Sample index since the detector was created or reset
+  uint64_t sample = 0;
+
+  // Time of the detecting sample, derived from the block's start timestamp and sample rate
+  uint64_t timestamp_ns = 0;
+
+  // The detecting sample value for thresholding, or the template correlation for template matching
+  float score = 0;
+};
+
+}  // namespace synapse
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * A thread pool for splitting a range of channels across cores.
+ *
+ * parallel_for() cuts the range into chunks and deals them out as contiguous runs,
+ * the same run to the same worker every call, so per-channel state (filter history,
+ * refractory counters) stays in that worker's cache from block to block. A worker
+ * that runs out steals from the far end of another worker's run, trying workers on
+ * its own NUMA node first. The calling thread helps until its range is done.
+ *
+ * parallel_for() may be called from several threads at once.
+ */
+class WorkStealingPool {
+ public:
+  /**
+   * @param num_threads Number of worker threads (default: one per core).
+   * @param pin_threads Whether to pin each worker to a core, grouped by NUMA node (Linux only).
+   */
+  explicit WorkStealingPool(size_t num_threads = 0, bool pin_threads = false);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  /**
+   * Run `fn` over [begin, end) in chunks of `grain` items, returning once every chunk is done.
+   *
+   * @param begin The first item.
+   * @param end One past the last item.
+   * @param grain The number of items per chunk; the last chunk may be smaller.
+   * @param fn Called with the [begin, end) of each chunk.
+   */
+  void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+  /**
+   * A chunk size for splitting `num_channels` channels of float samples across this pool.
+   *
+   * Chunks are a multiple of 16 channels (one cache line of floats, two AVX2 vectors),
+   * with a few chunks per worker so stealing has something to balance.
+   */
+  [[nodiscard]] auto channel_grain(size_t num_channels) const -> size_t;
+
+  [[nodiscard]] auto num_threads() const -> size_t;
+
+  /**
+   * The NUMA node a worker was placed on, or 0 if unknown.
+   */
+  [[nodiscard]] auto numa_node(size_t worker) const -> int;
+
+ private:
+  struct Job;
+  struct Task;
+  struct Worker;
+
+  void run_worker(size_t index);
+  [[nodiscard]] auto try_pop(size_t index, Task* task) -> bool;
+  [[nodiscard]] auto try_steal(size_t thief, Task* task) -> bool;
+  void run_task(const Task& task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // Victims to steal from, per worker: same NUMA node first, then the rest
+  std::vector<std::vector<size_t>> steal_order_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<size_t> queued_;
+  bool stopping_;
+};
+
+}  // namespace synapse
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace synapse {
+
+/**
+ * A histogram of latencies from nanoseconds to hours, for percentiles of timing-critical paths.
+ *
+ * Buckets are exact up to 32 ns, then 16 per power of two, so any percentile is within about
+ * 6% of the true value. Recording is a few relaxed atomic adds and never allocates or blocks,
+ * so it can sit on a real-time thread while other threads read percentiles.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void record(std::chrono::nanoseconds latency);
+
+  /**
+   * Clear all samples. Not atomic with respect to concurrent record() calls.
+   */
+  void reset();
+
+  [[nodiscard]] auto count() const -> uint64_t;
+  [[nodiscard]] auto min() const -> std::chrono::nanoseconds;
+  [[nodiscard]] auto max() const -> std::chrono::nanoseconds;
+  [[nodiscard]] auto mean() const -> std::chrono::nanoseconds;
+
+  /**
+   * @param percentile 0 to 100, e.g. 99.9.
+   * @return The upper bound of the bucket holding that percentile, or 0 if empty.
+   */
+  [[nodiscard]] auto percentile(double percentile) const -> std::chrono::nanoseconds;
+
+  /**
+   * @return A one-line summary: count, mean, p50, p99, p99.9 and max in microseconds.
+   */
+  [[nodiscard]] auto summary() const -> std::string;
+
+ private:
+  static constexpr size_t kSubBuckets = 16;
+  static constexpr size_t kNumBuckets = (64 - 4) * kSubBuckets + 2 * kSubBuckets;
+
+  static auto bucket(uint64_t value) -> size_t;
+  static auto bucket_upper_bound(size_t bucket) -> uint64_t;
+
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_;
+  std::atomic<uint64_t> count_{ 0 };
+  std::atomic<uint64_t> total_ns_{ 0 };
+  std::atomic<uint64_t> min_ns_;
+  std::atomic<uint64_t> max_ns_{ 0 };
+};
+
+}  // namespace synapse
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "science/synapse/api/datatype.pb.h"
+#include "science/synapse/status.h"
+
+namespace synapse {
+
+/**
+ * Holds only the most recent message from a tap, for consumers that want the latest data
+ * rather than every message, such as live displays.
+ *
+ * One writer publishes; any number of readers copy out the latest message at whatever rate
+ * they like. Publishing never blocks or allocates, whatever the readers are doing, and a reader
+ * never waits for the writer: messages rotate through a few slots, each guarded by a sequence
+ * number, so a reader copies the last complete message while the next is written to another
+ * slot. A read only retries if the writer laps every slot during its copy.
+ *
+ * Feed it from any read loop with publish(), or from a TapHub with subscribe_latest().
+ */
+class LatestFrame {
+ public:
+  /**
+   * @param max_size The largest message that can be published, in bytes.
+   */
+  explicit LatestFrame(size_t max_size = 1 << 16);
+
+  LatestFrame(const LatestFrame&) = delete;
+  LatestFrame& operator=(const LatestFrame&) = delete;
+
+  /**
+   * Replace the latest message. Only one thread may publish.
+   *
+   * @return science::Status kInvalidArgument if the message is larger than max_size.
+   */
+  [[nodiscard]] auto publish(const uint8_t* data, size_t size) -> science::Status;
+
+  /**
+   * Copy out the latest message.
+   *
+   * @param data Output parameter for the message bytes.
+   * @param generation Optional output parameter for the message's generation.
+   * @return science::Status kUnavailable if nothing has been published yet.
+   */
+  [[nodiscard]] auto read(std::vector<uint8_t>* data, uint64_t* generation = nullptr) const -> science::Status;
+
+  /**
+   * Copy out the latest message and parse it as a BroadbandFrame.
+   *
+   * @param frame Output parameter for the frame.
+   * @param generation Optional output parameter for the message's generation.
+   * @return science::Status kUnavailable if nothing has been published yet.
+   */
+  [[nodiscard]] auto read(synapse::BroadbandFrame* frame, uint64_t* generation = nullptr) const -> science::Status;
+
+  /**
+   * @return The number of messages published; compare with a read's generation to skip
+   *         copying a message already seen.
+   */
+  [[nodiscard]] auto generation() const -> uint64_t { return generation_.load(std::memory_order_acquire); }
+
+  [[nodiscard]] auto max_size() const -> size_t { return max_size_; }
+
+  /**
+   * @return How many reads had to retry because the writer overtook them.
+   */
+  [[nodiscard]] auto read_retries() const -> uint64_t { return read_retries_.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr size_t kSlots = 4;
+
+  // The payload is held as atomic words so readers racing the writer are well-defined;
+  // relaxed word loads and stores compile to plain moves
+  struct Slot {
+    // 2g - 1 while generation g is written, 2g once it's complete
+    std::atomic<uint64_t> sequence{ 0 };
+    std::atomic<size_t> size{ 0 };
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+  };
+
+  size_t max_size_;
+  std::array<Slot, kSlots> slots_;
+  std::atomic<uint64_t> generation_{ 0 };
+  mutable std::atomic<uint64_t> read_retries_{ 0 };
+};
+
+}  // namespace synapse
@@ -24,6 +24,13 @@ class Node {
   virtual ~Node() = default;
 
   [[nodiscard]] auto id() const -> uint32_t;
+  [[nodiscard]] auto type() const -> synapse::NodeType;
+
+  /**
+   * A counter that increases whenever the node's configuration changes.
+   * Used by Config to tell when its cached serialization is stale.
+   */
+  [[nodiscard]] auto revision() const -> uint64_t;
   [[nodiscard]] auto set_device(const IDevice* device) -> science::Status;
   [[nodiscard]] auto to_proto(synapse::NodeConfig* proto) -> science::Status;
 
@@ -31,9 +38,16 @@ class Node {
   uint32_t id_;
   synapse::NodeType type_;
   const IDevice* device_;
+  uint64_t revision_;
 
   virtual auto p_to_proto(synapse::NodeConfig* proto) -> science::Status = 0;
 
+  /**
+   * Mark the node's configuration as changed.
+   * Subclasses must call this from anything that changes what p_to_proto produces.
+   */
+  void mark_dirty();
+
   friend class Config;
 };
 
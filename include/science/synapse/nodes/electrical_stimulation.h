@@ -25,6 +25,12 @@ class ElectricalStimulation : public Node {
     std::shared_ptr<Node>* node
   ) -> science::Status;
 
+  [[nodiscard]] auto peripheral_id() const -> uint32_t;
+  [[nodiscard]] auto channels() const -> const std::vector<Ch>&;
+  [[nodiscard]] auto bit_width() const -> uint32_t;
+  [[nodiscard]] auto sample_rate() const -> uint32_t;
+  [[nodiscard]] auto lsb() const -> uint32_t;
+
  protected:
   auto p_to_proto(synapse::NodeConfig* proto) -> science::Status override;
 
@@ -24,6 +24,12 @@ class OpticalStimulation : public Node {
     std::shared_ptr<Node>* node
   ) -> science::Status;
 
+  [[nodiscard]] auto peripheral_id() const -> uint32_t;
+  [[nodiscard]] auto pixel_mask() const -> const std::optional<ChannelMask>&;
+  [[nodiscard]] auto bit_width() const -> uint32_t;
+  [[nodiscard]] auto frame_rate() const -> uint32_t;
+  [[nodiscard]] auto gain() const -> uint32_t;
+
  protected:
   auto p_to_proto(synapse::NodeConfig* proto) -> science::Status override;
 
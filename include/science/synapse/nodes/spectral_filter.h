@@ -20,6 +20,9 @@ class SpectralFilter : public Node {
     std::shared_ptr<Node>* node
   ) -> science::Status;
 
+  [[nodiscard]] auto method() const -> synapse::SpectralFilterMethod;
+  [[nodiscard]] auto low_cutoff_hz() const -> uint32_t;
+  [[nodiscard]] auto high_cutoff_hz() const -> uint32_t;
 
  protected:
   auto p_to_proto(synapse::NodeConfig* proto) -> science::Status override;
@@ -16,6 +16,8 @@ class SpikeBinner : public Node {
     std::shared_ptr<Node>* node
   ) -> science::Status;
 
+  [[nodiscard]] auto bin_size_ms() const -> uint32_t;
+
  protected:
   auto p_to_proto(synapse::NodeConfig* proto) -> science::Status override;
 
@@ -10,6 +10,8 @@ namespace synapse {
 
 class SpikeDetector : public Node {
  public:
+  enum class Mode { Thresholder, TemplateMatcher };
+
   // Create a thresholder-based spike detector
   static auto create_thresholder(uint32_t threshold_uv, uint32_t samples_per_spike)
     -> std::shared_ptr<SpikeDetector>;
@@ -23,13 +25,20 @@ class SpikeDetector : public Node {
     std::shared_ptr<Node>* node
   ) -> science::Status;
 
+  [[nodiscard]] auto mode() const -> Mode;
+  [[nodiscard]] auto threshold_uv() const -> uint32_t;
+  [[nodiscard]] auto template_uv() const -> const std::vector<uint32_t>&;
+  [[nodiscard]] auto samples_per_spike() const -> uint32_t;
+
+  // Change a thresholder's threshold; kFailedPrecondition for a template matcher
+  [[nodiscard]] auto set_threshold_uv(uint32_t threshold_uv) -> science::Status;
+
  protected:
   auto p_to_proto(synapse::NodeConfig* proto) -> science::Status override;
 
  private:
   SpikeDetector();
 
-  enum class Mode { Thresholder, TemplateMatcher };
   Mode mode_;
   uint32_t threshold_uv_;
   std::vector<uint32_t> template_uv_;
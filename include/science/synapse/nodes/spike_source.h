@@ -26,6 +26,8 @@ class SpikeSource : public Node {
     std::shared_ptr<Node>* node
   ) -> science::Status;
 
+  [[nodiscard]] auto threshold_uV() const -> float;
+  void set_threshold_uV(float threshold_uV);
 
  protected:
   auto p_to_proto(synapse::NodeConfig* proto) -> science::Status override;
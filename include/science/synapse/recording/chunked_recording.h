@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/api/datatype.pb.h"
+#include "science/synapse/dsp/spike_event.h"
+
+namespace synapse {
+
+class AlignedBuffer;
+class FileWriter;
+
+/**
+ * Options for a RecordingWriter.
+ */
+struct RecordingOptions {
+  // Frames per broadband chunk; each chunk is one entry in the sparse index
+  size_t samples_per_chunk = 2048;
+
+  // Spike events per spike chunk
+  size_t spikes_per_chunk = 4096;
+
+  // Bypass the page cache with O_DIRECT where the filesystem supports it
+  bool direct_io = true;
+};
+
+/**
+ * One entry of a recording's sparse index, covering a single chunk.
+ */
+struct ChunkIndexEntry {
+  uint64_t first_timestamp_ns;
+  uint64_t last_timestamp_ns;
+  uint64_t first_sequence_number;
+  uint64_t offset;
+  uint32_t num_items;
+  uint32_t kind;
+};
+
+/**
+ * A read-only view of part of one broadband chunk, pointing into the mapped file.
+ */
+struct ChunkView {
+  size_t num_samples = 0;
+  const uint64_t* timestamps_ns = nullptr;
+  const uint64_t* sequence_numbers = nullptr;
+
+  // One pointer per requested channel, each to num_samples contiguous samples
+  std::vector<const int32_t*> channels;
+};
+
+/**
+ * The chunks covering a time window, restricted to a set of channels.
+ */
+struct RecordingWindow {
+  std::vector<uint32_t> channels;
+  std::vector<ChunkView> chunks;
+
+  [[nodiscard]] auto num_samples() const -> size_t;
+};
+
+/**
+ * Writes broadband frames and spikes to an indexed, chunked recording.
+ *
+ * Frames are transposed into channel-major chunks, so a channel's samples within a chunk are
+ * contiguous. Chunks are 4 KiB aligned, and a sparse index of timestamp and sequence number to
+ * chunk offset is written at the end of the file on close(). A file that was never closed can
+ * still be read; the reader rebuilds the index from the chunk headers.
+ *
+ * Writes happen on the calling thread. To capture a live tap, record it with TapRecorder and
+ * convert the result with import_tap_recording().
+ */
+class RecordingWriter {
+ public:
+  /**
+   * @param path The file to create. Any existing file is replaced.
+   * @param num_channels Channels per broadband frame.
+   * @param sample_rate_hz The broadband sample rate.
+   * @param writer Output parameter for the writer.
+   * @param options Chunk sizes and file options.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto create(
+    const std::string& path,
+    size_t num_channels,
+    float sample_rate_hz,
+    std::unique_ptr<RecordingWriter>* writer,
+    const RecordingOptions& options = {}
+  ) -> science::Status;
+
+  /**
+   * Convert a TapRecorder recording of BroadbandFrames into an indexed recording.
+   *
+   * The channel count and sample rate are taken from the first frame.
+   *
+   * @param tap_recording_path A file written by TapRecorder.
+   * @param path The indexed recording to create.
+   * @param options Chunk sizes and file options.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto import_tap_recording(
+    const std::string& tap_recording_path,
+    const std::string& path,
+    const RecordingOptions& options = {}
+  ) -> science::Status;
+
+  ~RecordingWriter();
+
+  RecordingWriter(const RecordingWriter&) = delete;
+  RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+  /**
+   * Append one frame. Frames must be appended in timestamp order.
+   *
+   * @param frame The frame to append.
+   * @return science::Status kInvalidArgument if the channel count or ordering is wrong.
+   */
+  [[nodiscard]] auto append(const synapse::BroadbandFrame& frame) -> science::Status;
+
+  /**
+   * Append spike events. Events must be appended in timestamp order.
+   *
+   * @param events The events to append.
+   * @return science::Status
+   */
+  [[nodiscard]] auto append_spikes(const std::vector<SpikeEvent>& events) -> science::Status;
+
+  /**
+   * Flush partial chunks, write the index and close the file.
+   *
+   * @return science::Status
+   */
+  [[nodiscard]] auto close() -> science::Status;
+
+ private:
+  RecordingWriter(std::unique_ptr<FileWriter> file, size_t num_channels, const RecordingOptions& options);
+
+  auto flush_samples() -> science::Status;
+  auto flush_spikes() -> science::Status;
+
+  std::unique_ptr<FileWriter> file_;
+  size_t num_channels_;
+  RecordingOptions options_;
+  std::unique_ptr<AlignedBuffer> chunk_;
+  size_t chunk_samples_ = 0;
+  std::vector<SpikeEvent> spikes_;
+  std::vector<ChunkIndexEntry> index_;
+  uint64_t offset_ = 0;
+  uint64_t last_timestamp_ns_ = 0;
+  uint64_t last_spike_timestamp_ns_ = 0;
+  bool closed_ = false;
+};
+
+/**
+ * Reads an indexed recording through a memory map.
+ *
+ * Seeks are binary searches of the sparse index and then of one chunk's timestamps. Sample
+ * data is never copied; views point into the mapping and stay valid while the reader lives.
+ */
+class RecordingReader {
+ public:
+  /**
+   * @param path The recording to open.
+   * @param reader Output parameter for the reader.
+   * @return science::Status kDataLoss if the index or a chunk header doesn't fit the file.
+   */
+  [[nodiscard]] static auto open(const std::string& path, std::unique_ptr<RecordingReader>* reader)
+    -> science::Status;
+
+  ~RecordingReader();
+
+  RecordingReader(const RecordingReader&) = delete;
+  RecordingReader& operator=(const RecordingReader&) = delete;
+
+  [[nodiscard]] auto num_channels() const -> size_t { return num_channels_; }
+  [[nodiscard]] auto sample_rate_hz() const -> float { return sample_rate_hz_; }
+  [[nodiscard]] auto num_samples() const -> uint64_t { return num_samples_; }
+  [[nodiscard]] auto num_spikes() const -> uint64_t { return num_spikes_; }
+
+  /**
+   * @return The broadband chunks in time order.
+   */
+  [[nodiscard]] auto chunk_index() const -> const std::vector<ChunkIndexEntry>& { return sample_index_; }
+
+  /**
+   * @return The index of the first chunk with samples at or after timestamp_ns, or the chunk count if none.
+   */
+  [[nodiscard]] auto seek(uint64_t timestamp_ns) const -> size_t;
+
+  /**
+   * @return The index of the chunk holding sequence_number, or the chunk count if it is past the end.
+   */
+  [[nodiscard]] auto seek_sequence(uint64_t sequence_number) const -> size_t;
+
+  /**
+   * View one whole chunk.
+   *
+   * @param chunk The chunk index.
+   * @param channels The channels to view; all channels when empty.
+   * @param view Output parameter for the view.
+   * @return science::Status
+   */
+  [[nodiscard]] auto chunk(size_t chunk, const std::vector<uint32_t>& channels, ChunkView* view) const
+    -> science::Status;
+
+  /**
+   * View the samples with timestamps in [start_ns, end_ns).
+   *
+   * @param start_ns The start of the window.
+   * @param end_ns The end of the window, exclusive.
+   * @param channels The channels to view; all channels when empty.
+   * @param window Output parameter for the window.
+   * @return science::Status
+   */
+  [[nodiscard]] auto read(
+    uint64_t start_ns,
+    uint64_t end_ns,
+    const std::vector<uint32_t>& channels,
+    RecordingWindow* window
+  ) const -> science::Status;
+
+  /**
+   * Copy the spikes with timestamps in [start_ns, end_ns).
+   *
+   * @param start_ns The start of the window.
+   * @param end_ns The end of the window, exclusive.
+   * @param channels The channels to keep; all channels when empty.
+   * @param events Output parameter the spikes are appended to.
+   * @return science::Status
+   */
+  [[nodiscard]] auto read_spikes(
+    uint64_t start_ns,
+    uint64_t end_ns,
+    const std::vector<uint32_t>& channels,
+    std::vector<SpikeEvent>* events
+  ) const -> science::Status;
+
+ private:
+  RecordingReader(const uint8_t* data, size_t size);
+
+  auto load_index() -> science::Status;
+  auto scan_chunks() -> science::Status;
+  auto view(const ChunkIndexEntry& entry, size_t begin, size_t end, const std::vector<uint32_t>& channels,
+            ChunkView* view) const -> void;
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t num_channels_ = 0;
+  size_t samples_per_chunk_ = 0;
+  float sample_rate_hz_ = 0;
+  uint64_t num_samples_ = 0;
+  uint64_t num_spikes_ = 0;
+  std::vector<ChunkIndexEntry> sample_index_;
+  std::vector<ChunkIndexEntry> spike_index_;
+};
+
+}  // namespace synapse
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zmq.hpp>
+#include "science/synapse/status.h"
+#include "science/synapse/api/tap.pb.h"
+#include "science/synapse/recording/sample_codec.h"
+#include "science/synapse/recording/tap_recorder.h"
+
+namespace synapse {
+
+/**
+ * Options for a Replayer.
+ */
+struct ReplayOptions {
+  // Where to publish; a port of * binds any free port
+  std::string endpoint = "tcp://127.0.0.1:*";
+
+  // Playback rate relative to the recording; 0 sends as fast as possible
+  double speed = 1.0;
+
+  // Start again from the beginning after the last frame
+  bool loop = false;
+
+  // How long before each frame is due to stop sleeping and spin instead
+  std::chrono::microseconds spin_window{ 200 };
+
+  // Frames between entries of the seek index
+  size_t index_interval = 1024;
+
+  // Frames the PUB socket queues per subscriber before dropping
+  int send_hwm = 100000;
+
+  // Publish BroadbandFrames as SampleCodec::encode_frames() batches of this many frames, each sent
+  // when its last frame is due; 0 republishes every frame verbatim
+  size_t codec_batch_frames = 0;
+};
+
+/**
+ * How much has been replayed, and how closely it kept to schedule.
+ */
+struct ReplayStats {
+  uint64_t frames_sent = 0;
+  uint64_t bytes_sent = 0;
+  uint64_t loops = 0;
+
+  // How late frames went out relative to the recording's timing, at the current speed
+  std::chrono::nanoseconds mean_lateness{ 0 };
+  std::chrono::nanoseconds max_lateness{ 0 };
+};
+
+/**
+ * Replays a TapRecorder recording as a producer tap.
+ *
+ * Frames are republished verbatim on a ZMQ PUB socket, so a Tap connected to connection() receives
+ * exactly what was recorded. Frames keep the spacing of their recorded receive times, scaled by the
+ * speed; the replay thread sleeps until shortly before each frame is due and spins for the rest.
+ *
+ * Broadband recordings can instead be published compressed, in SampleCodec batches.
+ */
+class Replayer {
+ public:
+  // Called on the replay thread with each message as it is published: a frame, or an encoded batch
+  // stamped with its last frame's timestamp
+  using FrameCallback = std::function<void(const std::vector<uint8_t>& frame, uint64_t timestamp_ns)>;
+
+  /**
+   * Open a recording and bind its endpoint.
+   *
+   * @param path A file written by TapRecorder.
+   * @param replayer Output parameter for the replayer.
+   * @param options Endpoint and playback options.
+   * @return science::Status kInvalidArgument if batches are requested for a recording of something other than
+   *         BroadbandFrames.
+   */
+  [[nodiscard]] static auto create(
+    const std::string& path,
+    std::unique_ptr<Replayer>* replayer,
+    const ReplayOptions& options = {}
+  ) -> science::Status;
+
+  ~Replayer();
+
+  Replayer(const Replayer&) = delete;
+  Replayer& operator=(const Replayer&) = delete;
+
+  /**
+   * @return A producer tap description for the bound endpoint, to pass to Tap::connect. Its message type is
+   *         kSampleCodecFramesType when publishing encoded batches.
+   */
+  [[nodiscard]] auto connection() const -> synapse::TapConnection;
+
+  /**
+   * Observe frames as they are published. Must be set before start().
+   *
+   * @param callback The callback.
+   */
+  void on_frame(FrameCallback callback);
+
+  /**
+   * Start publishing on a background thread, from the current position.
+   *
+   * @return science::Status
+   */
+  [[nodiscard]] auto start() -> science::Status;
+
+  /**
+   * Stop publishing. The position is kept, so start() resumes.
+   */
+  void stop();
+
+  /**
+   * Block until the last frame has been sent or stop() is called.
+   *
+   * @param timeout How long to wait.
+   * @return true if playback has finished.
+   */
+  auto wait(std::chrono::milliseconds timeout) -> bool;
+
+  /**
+   * Continue from the first frame received at or after timestamp_ns.
+   *
+   * @param timestamp_ns A receive timestamp within the recording.
+   * @return science::Status
+   */
+  [[nodiscard]] auto seek(uint64_t timestamp_ns) -> science::Status;
+
+  /**
+   * Change the playback rate; takes effect from the next frame.
+   *
+   * @param speed Rate relative to the recording; 0 for as fast as possible.
+   * @return science::Status
+   */
+  [[nodiscard]] auto set_speed(double speed) -> science::Status;
+
+  [[nodiscard]] auto is_playing() const -> bool { return playing_; }
+  [[nodiscard]] auto num_frames() const -> uint64_t { return num_frames_; }
+  [[nodiscard]] auto start_timestamp_ns() const -> uint64_t { return start_timestamp_ns_; }
+  [[nodiscard]] auto end_timestamp_ns() const -> uint64_t { return end_timestamp_ns_; }
+
+  /**
+   * @return The first error the replay thread hit, if any.
+   */
+  [[nodiscard]] auto status() const -> science::Status;
+
+  [[nodiscard]] auto stats() const -> ReplayStats;
+
+ private:
+  struct IndexEntry {
+    uint64_t timestamp_ns;
+    uint64_t position;
+  };
+
+  explicit Replayer(const ReplayOptions& options);
+
+  auto build_index() -> science::Status;
+  auto seek_reader(uint64_t timestamp_ns) -> science::Status;
+  auto wait_until(std::chrono::steady_clock::time_point due) -> bool;
+  auto publish(const std::vector<uint8_t>& data, uint64_t timestamp_ns, uint64_t num_frames) -> science::Status;
+  auto flush_batch() -> science::Status;
+  void run();
+
+  ReplayOptions options_;
+  std::unique_ptr<TapRecordingReader> reader_;
+  std::unique_ptr<zmq::context_t> zmq_context_;
+  std::unique_ptr<zmq::socket_t> zmq_socket_;
+  std::string endpoint_;
+  FrameCallback callback_;
+
+  // Frames waiting to be encoded and sent, owned by the replay thread
+  SampleCodec codec_;
+  std::vector<synapse::BroadbandFrame> batch_;
+  uint64_t batch_position_ = 0;
+  uint64_t batch_timestamp_ns_ = 0;
+  std::vector<uint8_t> encoded_;
+
+  std::vector<IndexEntry> index_;
+  uint64_t num_frames_ = 0;
+  uint64_t start_timestamp_ns_ = 0;
+  uint64_t end_timestamp_ns_ = 0;
+
+  std::atomic<bool> running_{ false };
+  std::atomic<bool> playing_{ false };
+  std::atomic<double> speed_;
+
+  // Seeks are handed to the replay thread, which owns the reader while playing
+  mutable std::mutex mutex_;
+  std::condition_variable finished_;
+  bool seek_pending_ = false;
+  uint64_t seek_timestamp_ns_ = 0;
+  science::Status status_;
+
+  std::atomic<uint64_t> frames_sent_{ 0 };
+  std::atomic<uint64_t> bytes_sent_{ 0 };
+  std::atomic<uint64_t> loops_{ 0 };
+  std::atomic<int64_t> total_lateness_ns_{ 0 };
+  std::atomic<uint64_t> paced_frames_{ 0 };
+  std::atomic<int64_t> max_lateness_ns_{ 0 };
+
+  std::thread thread_;
+};
+
+}  // namespace synapse
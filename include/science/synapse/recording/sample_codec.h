@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/api/datatype.pb.h"
+#include "science/synapse/dsp/simd.h"
+
+namespace synapse {
+
+/**
+ * How each sample is predicted from the ones before it; the codec stores only the prediction error.
+ */
+enum class SamplePredictor : uint8_t {
+  // x[t - 1]
+  kDelta = 1,
+  // 2 x[t - 1] - x[t - 2], better for oversampled, smooth signals
+  kLinear = 2,
+};
+
+// TapConnection message type for taps publishing SampleCodec::encode_frames() batches
+constexpr char kSampleCodecFramesType[] = "synapse.SampleCodecFrames";
+
+/**
+ * Lossless compression for channel-major blocks of integer samples.
+ *
+ * Each channel's prediction errors are zigzag encoded and bit-packed in blocks of 256, each block
+ * at the width of its largest error. Packing interleaves eight 32-bit lanes, so AVX2 packs and
+ * unpacks a block eight values at a time; the scalar path writes the same bytes.
+ *
+ * Broadband data at int16 resolution typically packs to 6-10 bits per sample, against 16-24 bits
+ * for the protobuf varints in a BroadbandFrame.
+ */
+class SampleCodec {
+ public:
+  explicit SampleCodec(SamplePredictor predictor = SamplePredictor::kDelta);
+
+  /**
+   * Encode a block of samples.
+   *
+   * @param channels One pointer per channel to num_samples contiguous samples, e.g. ChunkView::channels.
+   * @param num_samples Samples per channel.
+   * @param out Output parameter for the encoded bytes; replaced.
+   * @return science::Status kInvalidArgument if the block holds more than 2^28 samples in all.
+   */
+  [[nodiscard]] auto encode(const std::vector<const int32_t*>& channels, size_t num_samples, std::vector<uint8_t>* out)
+    -> science::Status;
+
+  /**
+   * Decode a block written by encode() or encode_frames().
+   *
+   * @param data The encoded bytes.
+   * @param size The encoded size.
+   * @param samples Output parameter for the samples, channel-major.
+   * @param num_channels Output parameter for the channel count.
+   * @param num_samples Output parameter for the samples per channel.
+   * @return science::Status kDataLoss if the data is corrupt or truncated.
+   */
+  [[nodiscard]] auto decode(
+    const uint8_t* data,
+    size_t size,
+    std::vector<int32_t>* samples,
+    size_t* num_channels,
+    size_t* num_samples
+  ) -> science::Status;
+
+  /**
+   * Encode consecutive frames, including their timestamps, sequence numbers and sample rate.
+   *
+   * Suited to recording or re-publishing a tap in batches.
+   *
+   * @param frames Frames with the same channel count.
+   * @param out Output parameter for the encoded bytes; replaced.
+   * @return science::Status
+   */
+  [[nodiscard]] auto encode_frames(const std::vector<synapse::BroadbandFrame>& frames, std::vector<uint8_t>* out)
+    -> science::Status;
+
+  /**
+   * Decode frames written by encode_frames().
+   *
+   * @param data The encoded bytes.
+   * @param size The encoded size.
+   * @param frames Output parameter for the frames; replaced.
+   * @return science::Status
+   */
+  [[nodiscard]] auto decode_frames(const uint8_t* data, size_t size, std::vector<synapse::BroadbandFrame>* frames)
+    -> science::Status;
+
+  /**
+   * Force a SIMD level, e.g. to compare against the scalar path. Falls back to scalar if unsupported.
+   *
+   * @param level The SIMD level to use.
+   */
+  void set_simd_level(SimdLevel level);
+
+  [[nodiscard]] auto predictor() const -> SamplePredictor { return predictor_; }
+  [[nodiscard]] auto simd_level() const -> SimdLevel { return simd_level_; }
+
+ private:
+  auto decode_block(
+    const uint8_t** data,
+    const uint8_t* end,
+    std::vector<int32_t>* samples,
+    size_t* num_channels,
+    size_t* num_samples,
+    bool* has_frames
+  ) -> science::Status;
+  auto encode_channel(const int32_t* samples, size_t num_samples, SamplePredictor predictor, uint8_t* out)
+    -> uint8_t*;
+  auto decode_channel(
+    const uint8_t** data,
+    const uint8_t* end,
+    size_t num_samples,
+    SamplePredictor predictor,
+    int32_t* samples
+  ) -> bool;
+  auto encode_series(const std::vector<uint64_t>& values, std::vector<uint8_t>* out) -> void;
+  auto decode_series(const uint8_t** data, const uint8_t* end, size_t count, std::vector<uint64_t>* values) -> bool;
+
+  SamplePredictor predictor_;
+  SimdLevel simd_level_;
+
+  // Scratch space reused between calls
+  std::vector<uint32_t> block_;
+  std::vector<int32_t> transposed_;
+};
+
+}  // namespace synapse
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/tap.h"
+
+namespace synapse {
+
+class AlignedBuffer;
+class FileWriter;
+
+/**
+ * Options for a TapRecorder.
+ */
+struct TapRecorderOptions {
+  // Size of each staging buffer; rounded up to the 4 KiB direct I/O alignment
+  size_t buffer_size = 8 * 1024 * 1024;
+
+  // Staging buffers allowed in flight; once all are waiting on disk, new frames are dropped
+  size_t max_buffers = 16;
+
+  // Disk space is reserved in steps of this size ahead of the writes (0 to disable)
+  uint64_t preallocate_bytes = 256ull * 1024 * 1024;
+
+  // Bypass the page cache with O_DIRECT where the filesystem supports it
+  bool direct_io = true;
+
+  // Recorded in the file header; filled from the tap's connection when empty
+  std::string stream_name;
+  std::string message_type;
+};
+
+/**
+ * Write throughput and backlog of a TapRecorder.
+ */
+struct TapRecorderStats {
+  uint64_t frames = 0;
+  uint64_t frames_dropped = 0;
+  uint64_t bytes_received = 0;
+  uint64_t bytes_written = 0;
+
+  // Time the writer thread spent in disk writes
+  std::chrono::nanoseconds write_time{0};
+
+  // Bytes received but not yet on disk, now and at worst
+  uint64_t backlog_bytes = 0;
+  uint64_t max_backlog_bytes = 0;
+
+  // Whether writes bypass the page cache
+  bool direct_io = false;
+
+  [[nodiscard]] auto write_throughput() const -> double {
+    return write_time.count() > 0 ? bytes_written * 1e9 / write_time.count() : 0.0;
+  }
+};
+
+/**
+ * Records raw tap frames to a local file.
+ *
+ * Frames are copied into page-aligned staging buffers on the receiving thread; full buffers are
+ * handed to a writer thread, so the receiving thread never waits on the disk. If the disk falls
+ * more than max_buffers behind, frames are dropped and counted rather than stalling the stream.
+ *
+ * The file is a 4 KiB header followed by records of a 16 byte header
+ * (marker, payload size, receive timestamp) and the frame bytes. Use TapRecordingReader to read it.
+ */
+class TapRecorder {
+ public:
+  /**
+   * Create a recorder writing to a new file.
+   *
+   * @param path The file to record to. Any existing file is replaced.
+   * @param recorder Output parameter for the recorder.
+   * @param options Buffering and file options.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto create(
+    const std::string& path,
+    std::unique_ptr<TapRecorder>* recorder,
+    const TapRecorderOptions& options = {}
+  ) -> science::Status;
+
+  ~TapRecorder();
+
+  TapRecorder(const TapRecorder&) = delete;
+  TapRecorder& operator=(const TapRecorder&) = delete;
+
+  /**
+   * Start recording everything read from a connected producer tap on a background thread.
+   *
+   * The tap must outlive the recording and must not be used elsewhere until stop().
+   *
+   * @param tap The connected producer tap.
+   * @param timeout_ms Read timeout, which bounds how long stop() waits for the receive thread.
+   * @return science::Status
+   */
+  [[nodiscard]] auto start(Tap* tap, int timeout_ms = 100) -> science::Status;
+
+  /**
+   * Record one frame. Called from a single thread, and not while a tap is being recorded.
+   *
+   * @param data The frame bytes.
+   * @param size The frame size.
+   * @param timestamp_ns Receive time in nanoseconds since the epoch.
+   * @return kResourceExhausted if the frame was dropped because the disk is behind.
+   */
+  [[nodiscard]] auto record(const uint8_t* data, size_t size, uint64_t timestamp_ns) -> science::Status;
+
+  /**
+   * Stop the receive thread, flush everything to disk, and close the file.
+   *
+   * @return The first error the writer hit, if any.
+   */
+  [[nodiscard]] auto stop() -> science::Status;
+
+  /**
+   * @return The current counters.
+   */
+  [[nodiscard]] auto stats() const -> TapRecorderStats;
+
+ private:
+  TapRecorder(std::unique_ptr<FileWriter> writer, const TapRecorderOptions& options);
+
+  auto write_header() -> void;
+  auto reserve(size_t size) -> science::Status;
+  auto submit_buffer() -> void;
+  auto append(const uint8_t* data, size_t size) -> void;
+  auto receive_loop(Tap* tap, int timeout_ms) -> void;
+  auto write_loop() -> void;
+
+  TapRecorderOptions options_;
+  std::unique_ptr<FileWriter> writer_;
+
+  // Owned by the recording thread
+  std::unique_ptr<AlignedBuffer> current_;
+  bool header_written_ = false;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::unique_ptr<AlignedBuffer>> free_;
+  std::deque<std::unique_ptr<AlignedBuffer>> full_;
+  size_t allocated_buffers_ = 0;
+  bool stopping_ = false;
+  bool closed_ = false;
+  science::Status status_;
+
+  // Bytes of file written so far, and how far behind the writer has been
+  uint64_t bytes_written_ = 0;
+  uint64_t max_backlog_bytes_ = 0;
+  std::chrono::nanoseconds write_time_{ 0 };
+
+  // Updated per frame, so kept off the mutex
+  std::atomic<uint64_t> frames_{ 0 };
+  std::atomic<uint64_t> frames_dropped_{ 0 };
+  std::atomic<uint64_t> bytes_received_{ 0 };
+  std::atomic<uint64_t> bytes_appended_{ 0 };
+
+  std::atomic<bool> receiving_{ false };
+  std::thread receive_thread_;
+  std::thread write_thread_;
+};
+
+/**
+ * Reads frames back from a file written by TapRecorder.
+ */
+class TapRecordingReader {
+ public:
+  /**
+   * @param path The recording to open.
+   * @param reader Output parameter for the reader.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto open(const std::string& path, std::unique_ptr<TapRecordingReader>* reader)
+    -> science::Status;
+
+  ~TapRecordingReader();
+
+  TapRecordingReader(const TapRecordingReader&) = delete;
+  TapRecordingReader& operator=(const TapRecordingReader&) = delete;
+
+  /**
+   * Read the next frame.
+   *
+   * @param out Output parameter for the frame bytes.
+   * @param timestamp_ns Optional output parameter for the receive timestamp.
+   * @return kOutOfRange at the end of the recording.
+   */
+  [[nodiscard]] auto next(std::vector<uint8_t>* out, uint64_t* timestamp_ns = nullptr) -> science::Status;
+
+  /**
+   * Skip the next frame without reading its bytes.
+   *
+   * @param timestamp_ns Optional output parameter for the skipped frame's receive timestamp.
+   * @return kOutOfRange at the end of the recording.
+   */
+  [[nodiscard]] auto skip(uint64_t* timestamp_ns = nullptr) -> science::Status;
+
+  /**
+   * @return The file offset of the next frame.
+   */
+  [[nodiscard]] auto position() const -> uint64_t;
+
+  /**
+   * Continue reading from an offset returned by position().
+   *
+   * @param position The offset of a frame.
+   * @return science::Status
+   */
+  [[nodiscard]] auto seek(uint64_t position) -> science::Status;
+
+  [[nodiscard]] auto stream_name() const -> const std::string& { return stream_name_; }
+  [[nodiscard]] auto message_type() const -> const std::string& { return message_type_; }
+
+ private:
+  explicit TapRecordingReader(std::FILE* file);
+
+  auto read_record_header(uint32_t* length, uint64_t* timestamp_ns) -> science::Status;
+
+  std::FILE* file_;
+  std::string stream_name_;
+  std::string message_type_;
+};
+
+}  // namespace synapse
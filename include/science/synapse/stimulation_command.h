@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "science/synapse/nodes/electrical_stimulation.h"
+#include "science/synapse/nodes/optical_stimulation.h"
+#include "science/synapse/status.h"
+
+namespace synapse {
+
+class StimulationCommandBuilder;
+
+/**
+ * A stimulation command, serialized as a BroadbandFrame with one value per stimulated channel.
+ *
+ * Every field is encoded at a fixed width (varints are padded to their longest form, which any
+ * protobuf parser accepts), so setting one is a few stores into the serialized bytes; data() is
+ * always ready to hand to Tap::send.
+ *
+ * Commands come from a StimulationCommandBuilder's pool and go back to it when released.
+ */
+class StimulationCommand {
+ public:
+  StimulationCommand(const StimulationCommand&) = delete;
+  StimulationCommand& operator=(const StimulationCommand&) = delete;
+
+  void set_timestamp_ns(uint64_t timestamp_ns);
+  void set_sequence_number(uint64_t sequence_number);
+
+  /**
+   * Set one channel's amplitude, in device codes, clamped to the node's bit width.
+   *
+   * @param index The channel's position in the node's channel list (or pixel mask, for optical);
+   *              must be less than num_channels().
+   */
+  void set_amplitude(size_t index, int32_t code);
+
+  /**
+   * Set every channel's amplitude, as set_amplitude.
+   *
+   * @param codes num_channels() codes.
+   */
+  void set_amplitudes(const int32_t* codes);
+
+  [[nodiscard]] auto num_channels() const -> size_t { return num_channels_; }
+  [[nodiscard]] auto data() const -> const uint8_t* { return buffer_.data(); }
+  [[nodiscard]] auto size() const -> size_t { return buffer_.size(); }
+
+ private:
+  friend class StimulationCommandBuilder;
+
+  StimulationCommand(size_t size, size_t amplitudes_offset, size_t num_channels, int32_t min_code, int32_t max_code);
+
+  std::vector<uint8_t> buffer_;
+  size_t amplitudes_offset_;
+  size_t num_channels_;
+  int32_t min_code_;
+  int32_t max_code_;
+};
+
+/**
+ * Builds stimulation commands for an ElectricalStimulation or OpticalStimulation node.
+ *
+ * Patterns (a code per channel) are serialized once with add_pattern(). acquire() then copies a
+ * pattern into a pooled command, so sending an update costs a copy and a few stores rather than
+ * building and serializing a protobuf, and allocates nothing.
+ *
+ * acquire() and releasing commands are thread-safe. Commands must be released before the builder
+ * is destroyed.
+ */
+class StimulationCommandBuilder {
+ public:
+  struct Release {
+    StimulationCommandBuilder* builder;
+    void operator()(StimulationCommand* command) const;
+  };
+  using CommandPtr = std::unique_ptr<StimulationCommand, Release>;
+
+  /**
+   * @param node The electrical stimulation node; commands carry a code per channel, in its order.
+   * @param builder Output parameter for the builder.
+   * @param pool_size How many commands can be acquired at once.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto create(
+    const ElectricalStimulation& node,
+    std::unique_ptr<StimulationCommandBuilder>* builder,
+    size_t pool_size = 64
+  ) -> science::Status;
+
+  /**
+   * @param node The optical stimulation node; commands carry a code per pixel in its mask, in ascending order.
+   * @param builder Output parameter for the builder.
+   * @param pool_size How many commands can be acquired at once.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto create(
+    const OpticalStimulation& node,
+    std::unique_ptr<StimulationCommandBuilder>* builder,
+    size_t pool_size = 64
+  ) -> science::Status;
+
+  ~StimulationCommandBuilder();
+
+  StimulationCommandBuilder(const StimulationCommandBuilder&) = delete;
+  StimulationCommandBuilder& operator=(const StimulationCommandBuilder&) = delete;
+
+  /**
+   * Serialize a pattern for later acquire() calls.
+   *
+   * @param codes A code per channel, within [min_code(), max_code()].
+   * @param pattern Output parameter for the pattern's id.
+   * @return science::Status
+   */
+  [[nodiscard]] auto add_pattern(const std::vector<int32_t>& codes, size_t* pattern) -> science::Status;
+
+  /**
+   * Take a command from the pool, initialized to a pattern with zero timestamp and sequence number.
+   *
+   * @param pattern A pattern id from add_pattern().
+   * @param command Output parameter for the command.
+   * @return science::Status kResourceExhausted if every pooled command is in use.
+   */
+  [[nodiscard]] auto acquire(size_t pattern, CommandPtr* command) -> science::Status;
+
+  /**
+   * Convert an amplitude to a device code: for electrical stimulation, in the node's lsb units, for
+   * optical, as an intensity in [0, 1] of full scale. Rounded and clamped to the bit width.
+   */
+  [[nodiscard]] auto to_code(double amplitude) const -> int32_t;
+
+  [[nodiscard]] auto num_channels() const -> size_t { return num_channels_; }
+  [[nodiscard]] auto min_code() const -> int32_t { return min_code_; }
+  [[nodiscard]] auto max_code() const -> int32_t { return max_code_; }
+  [[nodiscard]] auto available() const -> size_t;
+
+ private:
+  StimulationCommandBuilder(
+    size_t num_channels,
+    int32_t min_code,
+    int32_t max_code,
+    double code_scale,
+    float sample_rate_hz,
+    size_t pool_size
+  );
+
+  void release(StimulationCommand* command);
+
+  size_t num_channels_;
+  int32_t min_code_;
+  int32_t max_code_;
+  double code_scale_;
+  float sample_rate_hz_;
+
+  std::vector<std::vector<uint8_t>> patterns_;
+  std::vector<std::unique_ptr<StimulationCommand>> pool_;
+
+  mutable std::mutex mutex_;
+  std::vector<StimulationCommand*> free_;
+};
+
+}  // namespace synapse
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "science/synapse/latency_histogram.h"
+#include "science/synapse/status.h"
+#include "science/synapse/stimulation_command.h"
+#include "science/synapse/tap.h"
+
+namespace synapse {
+
+/**
+ * Options for a StimulationSequencer.
+ */
+struct StimulationSequencerOptions {
+  // CPU to pin the dispatch thread to; -1 leaves it unpinned
+  int cpu = -1;
+
+  // SCHED_FIFO priority for the dispatch thread (Linux); 0 keeps the default scheduler
+  int realtime_priority = 0;
+
+  // How long before each deadline to stop sleeping and spin; covers the scheduler's wakeup latency
+  std::chrono::microseconds spin{ 100 };
+};
+
+/**
+ * What a StimulationSequencer has dispatched in its current or last run.
+ */
+struct StimulationSequencerStats {
+  uint64_t commands_sent = 0;
+  uint64_t send_errors = 0;
+};
+
+/**
+ * Sends a timeline of stimulation commands through a consumer tap at precise offsets.
+ *
+ * A dedicated thread sleeps until shortly before each command's deadline (clock_nanosleep with
+ * an absolute deadline, so errors don't accumulate), spins out the rest, and sends. How late each
+ * send started relative to its deadline is recorded in jitter(); pin the thread and give it a
+ * real-time priority to keep that in the microseconds.
+ *
+ * The tap belongs to the dispatch thread while it runs and must not be used elsewhere. Commands
+ * keep their builder's pool entries until the sequencer is destroyed or clear() is called.
+ */
+class StimulationSequencer {
+ public:
+  /**
+   * @param output A connected consumer tap, e.g. an ElectricalStimulation or OpticalStimulation node's.
+   * @param sequencer Output parameter for the sequencer.
+   * @param options Thread placement and timing options.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto create(
+    Tap* output,
+    std::unique_ptr<StimulationSequencer>* sequencer,
+    const StimulationSequencerOptions& options = {}
+  ) -> science::Status;
+
+  ~StimulationSequencer();
+
+  StimulationSequencer(const StimulationSequencer&) = delete;
+  StimulationSequencer& operator=(const StimulationSequencer&) = delete;
+
+  /**
+   * Add a command to the timeline; commands can be added in any order, but not while running.
+   *
+   * @param offset When to send it, relative to start().
+   * @param command The command; sent as is, so set its timestamp beforehand if the device uses it.
+   * @return science::Status
+   */
+  [[nodiscard]] auto add(std::chrono::nanoseconds offset, StimulationCommandBuilder::CommandPtr command)
+    -> science::Status;
+
+  /**
+   * Remove every command from the timeline, returning them to their builders.
+   */
+  [[nodiscard]] auto clear() -> science::Status;
+
+  [[nodiscard]] auto size() const -> size_t { return timeline_.size(); }
+
+  /**
+   * Start the dispatch thread, once it's pinned and scheduled as requested; offsets count from
+   * when it's ready. The timeline can be run again once it's done.
+   *
+   * @return science::Status The error if the thread couldn't be placed; it doesn't start then.
+   */
+  [[nodiscard]] auto start() -> science::Status;
+
+  /**
+   * Block until every command has been sent, or stop() is called. Safe to call from several
+   * threads, and alongside stop().
+   */
+  void wait();
+
+  /**
+   * Stop dispatching; commands not yet sent are skipped.
+   */
+  void stop();
+
+  [[nodiscard]] auto is_running() const -> bool { return running_; }
+
+  /**
+   * @return The first send error of the current or last run, if any; sending continues past errors.
+   */
+  [[nodiscard]] auto status() const -> science::Status;
+
+  [[nodiscard]] auto stats() const -> StimulationSequencerStats;
+
+  /**
+   * @return How late each send started relative to its scheduled time, for the current or last run.
+   */
+  [[nodiscard]] auto jitter() const -> const LatencyHistogram& { return jitter_; }
+
+ private:
+  struct Entry {
+    std::chrono::nanoseconds offset;
+    StimulationCommandBuilder::CommandPtr command;
+  };
+
+  StimulationSequencer(Tap* output, const StimulationSequencerOptions& options);
+
+  auto place_thread() -> science::Status;
+  void run();
+
+  Tap* output_;
+  StimulationSequencerOptions options_;
+  std::vector<Entry> timeline_;
+
+  std::atomic<bool> running_{ false };
+  // Guards thread_ while it starts or is joined, so wait() and stop() on different threads don't both join
+  std::mutex join_mutex_;
+  std::thread thread_;
+
+  mutable std::mutex mutex_;
+  science::Status status_;
+
+  std::atomic<uint64_t> commands_sent_{ 0 };
+  std::atomic<uint64_t> send_errors_{ 0 };
+  LatencyHistogram jitter_;
+};
+
+}  // namespace synapse
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "science/synapse/status.h"
+#include "science/synapse/tap.h"
+
+namespace synapse {
+
+/**
+ * Read a BroadbandFrame's sequence number straight from its serialized bytes, without parsing the samples.
+ *
+ * @return The sequence number, or nullopt if the message isn't a BroadbandFrame with one.
+ */
+auto broadband_sequence_number(const uint8_t* data, size_t size) -> std::optional<uint64_t>;
+
+/**
+ * Options for a SupervisedTap.
+ */
+struct SupervisedTapOptions {
+  // How long without a message before the tap is considered stalled and reconnected. There's no
+  // heartbeat on a tap, so silence is all the watchdog can go on: this must be longer than the
+  // longest normal gap between messages, or a quiet stream (e.g. a sparse spike tap) is
+  // reconnected over and over.
+  std::chrono::milliseconds stall_timeout{ 2000 };
+
+  // Wait between reconnect attempts while stalled, doubling up to max_backoff
+  std::chrono::milliseconds initial_backoff{ 100 };
+  std::chrono::milliseconds max_backoff{ 5000 };
+
+  // Pulls each message's sequence number, for lost-message accounting; return nullopt if it has none
+  std::function<std::optional<uint64_t>(const uint8_t* data, size_t size)> sequence_number = broadband_sequence_number;
+};
+
+/**
+ * A break in a SupervisedTap's stream: a stall it recovered from, or a jump in sequence numbers.
+ */
+struct TapGap {
+  // Time from the last message before the gap to the first one after it
+  std::chrono::nanoseconds duration{ 0 };
+
+  // Reconnect attempts it took to recover; 0 for messages dropped without a stall
+  uint32_t reconnects = 0;
+
+  // Sequence numbers either side of the gap, if the messages have them
+  std::optional<uint64_t> last_sequence_number;
+  std::optional<uint64_t> next_sequence_number;
+
+  /**
+   * @return How many messages were lost, if known; unknown if the sequence restarted, as when the device restarts.
+   */
+  [[nodiscard]] auto lost() const -> std::optional<uint64_t> {
+    if (!last_sequence_number || !next_sequence_number || *next_sequence_number <= *last_sequence_number) {
+      return std::nullopt;
+    }
+    return *next_sequence_number - *last_sequence_number - 1;
+  }
+};
+
+/**
+ * What a SupervisedTap has seen so far.
+ */
+struct SupervisedTapStats {
+  uint64_t messages = 0;
+  uint64_t stalls = 0;
+  uint64_t reconnects = 0;
+  uint64_t gaps = 0;
+
+  // Messages known lost across all gaps
+  uint64_t lost_messages = 0;
+
+  // Whether the tap is currently stalled and being reconnected
+  bool stalled = false;
+};
+
+/**
+ * Reads a producer tap on a background thread and keeps it going through device restarts and network faults.
+ *
+ * A watchdog treats any stretch longer than the stall timeout without a message as a stall, and
+ * reconnects the tap with exponential backoff until messages flow again. Silence is the only signal,
+ * so the stall timeout has to exceed the stream's longest normal gap between messages. Reconnecting
+ * reuses the tap's cached endpoint and ZMQ context, so the device isn't queried. Each stall, and each
+ * jump in sequence numbers, is reported as a TapGap.
+ *
+ * The tap belongs to the supervisor's thread while it runs and must not be used elsewhere.
+ */
+class SupervisedTap {
+ public:
+  /**
+   * Called on the supervisor's thread for each message; the data is only valid during the call.
+   */
+  using MessageCallback = std::function<void(const uint8_t* data, size_t size)>;
+
+  /**
+   * Called on the supervisor's thread when a gap ends, before the first message after it.
+   */
+  using GapCallback = std::function<void(const TapGap& gap)>;
+
+  /**
+   * @param tap A connected producer tap.
+   * @param on_message The message callback.
+   * @param supervised Output parameter for the supervisor.
+   * @param options Watchdog and backoff options.
+   * @param on_gap The gap callback, if any.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto create(
+    Tap* tap,
+    MessageCallback on_message,
+    std::unique_ptr<SupervisedTap>* supervised,
+    const SupervisedTapOptions& options = {},
+    GapCallback on_gap = nullptr
+  ) -> science::Status;
+
+  ~SupervisedTap();
+
+  SupervisedTap(const SupervisedTap&) = delete;
+  SupervisedTap& operator=(const SupervisedTap&) = delete;
+
+  [[nodiscard]] auto start() -> science::Status;
+  void stop();
+
+  [[nodiscard]] auto is_running() const -> bool { return running_; }
+
+  [[nodiscard]] auto stats() const -> SupervisedTapStats;
+
+  /**
+   * @return The most recent gap, if there has been one.
+   */
+  [[nodiscard]] auto last_gap() const -> std::optional<TapGap>;
+
+  /**
+   * @return The most recent error reconnecting, if the last attempt failed.
+   */
+  [[nodiscard]] auto status() const -> science::Status;
+
+ private:
+  SupervisedTap(Tap* tap, MessageCallback on_message, const SupervisedTapOptions& options, GapCallback on_gap);
+
+  void run();
+  void report_gap(const TapGap& gap);
+
+  Tap* tap_;
+  MessageCallback on_message_;
+  SupervisedTapOptions options_;
+  GapCallback on_gap_;
+
+  std::atomic<bool> running_{ false };
+  std::thread thread_;
+
+  mutable std::mutex mutex_;
+  science::Status status_;
+  std::optional<TapGap> last_gap_;
+
+  std::atomic<uint64_t> messages_{ 0 };
+  std::atomic<uint64_t> stalls_{ 0 };
+  std::atomic<uint64_t> reconnects_{ 0 };
+  std::atomic<uint64_t> gaps_{ 0 };
+  std::atomic<uint64_t> lost_messages_{ 0 };
+  std::atomic<bool> stalled_{ false };
+};
+
+}  // namespace synapse
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -11,6 +12,65 @@
 
 namespace synapse {
 
+/**
+ * How a Tap waits for messages.
+ */
+struct TapReceiveOptions {
+  // Spin on non-blocking receives before blocking, trading a busy core for lower wakeup latency
+  bool busy_poll = false;
+
+  // How long a busy-polling read spins before blocking for the rest of its timeout
+  std::chrono::microseconds spin_budget{ 1000 };
+
+  // Have the kernel busy-poll the network device for the socket (SO_BUSY_POLL, Linux), in
+  // microseconds; 0 leaves it off. Needs libzmq and this library built with ZMQ_BUILD_DRAFT_API;
+  // otherwise connect() returns kUnimplemented. Applied on connect.
+  int socket_busy_poll_us = 0;
+
+  // Watch the socket with a ZMQ socket monitor, on a thread of its own, for the event counts and
+  // timings in connection_stats(). Applied on connect.
+  bool monitor_connection = false;
+};
+
+/**
+ * Where a Tap's connection stands. Without a socket monitor, it's kConnecting until the first
+ * message arrives.
+ */
+enum class TapConnectionState {
+  kDisconnected,
+  // connect() was called, or the connection dropped, and ZMQ is (re)trying
+  kConnecting,
+  // A TCP connection is up
+  kConnected,
+};
+
+/**
+ * How a Tap's connection has gone since the last connect().
+ *
+ * ZMQ connects in the background, so connect() returning says nothing about the network. Together
+ * these tell a slow network (no connection, retries) from a quiet device (connected, but no message
+ * yet) and a slow consumer (messages arriving long before the first read).
+ */
+struct TapConnectionStats {
+  TapConnectionState state = TapConnectionState::kDisconnected;
+
+  // ZMQ socket monitor events; zero unless TapReceiveOptions::monitor_connection is set
+  uint64_t connects = 0;
+  uint64_t connect_delays = 0;
+  uint64_t connect_retries = 0;
+  uint64_t disconnects = 0;
+  uint64_t handshakes = 0;
+  uint64_t handshake_failures = 0;
+
+  // From connect() to the first TCP connection and ZMTP handshake (both need the monitor), and to
+  // the first message read
+  std::optional<std::chrono::nanoseconds> time_to_connect;
+  std::optional<std::chrono::nanoseconds> time_to_handshake;
+  std::optional<std::chrono::nanoseconds> time_to_first_message;
+};
+
+class TapMonitor;
+
 /**
  * A client for connecting to Synapse device taps.
  *
@@ -51,6 +111,36 @@ class Tap {
    */
   [[nodiscard]] auto connect(const std::string& tap_name) -> science::Status;
 
+  /**
+   * Connect to a tap at a known endpoint, without querying the device.
+   *
+   * Useful for taps served from the host, such as a Replayer.
+   *
+   * @param tap The tap to connect to; its endpoint is used as-is.
+   * @return Status indicating success or failure.
+   */
+  [[nodiscard]] auto connect(const synapse::TapConnection& tap) -> science::Status;
+
+  /**
+   * Choose how read() waits for messages.
+   *
+   * @param options The receive options.
+   * @return Status kInvalidArgument if the options are out of range.
+   */
+  [[nodiscard]] auto set_receive_options(const TapReceiveOptions& options) -> science::Status;
+
+  [[nodiscard]] auto receive_options() const -> const TapReceiveOptions& { return receive_options_; }
+
+  /**
+   * Rebuild the socket to the current tap, e.g. after the device restarts.
+   *
+   * Reuses the tap's endpoint and the ZMQ context from the last connect, so the device isn't queried
+   * again. If it fails, the tap stays disconnected but remembers its endpoint for another attempt.
+   *
+   * @return Status kFailedPrecondition if connect() was never called.
+   */
+  [[nodiscard]] auto reconnect() -> science::Status;
+
   /**
    * Disconnect from the current tap.
    */
@@ -70,10 +160,20 @@ class Tap {
    */
   [[nodiscard]] auto connected_tap() const -> std::optional<synapse::TapConnection>;
 
+  /**
+   * Get the connection's health since the last connect().
+   *
+   * Event counts and connection times need TapReceiveOptions::monitor_connection.
+   *
+   * @return The connection state, monitor event counts and startup times.
+   */
+  [[nodiscard]] auto connection_stats() const -> TapConnectionStats;
+
   /**
    * Read a single message from the tap (blocking with timeout).
    *
-   * Only valid for producer taps (TAP_TYPE_PRODUCER).
+   * Only valid for producer taps (TAP_TYPE_PRODUCER). In busy-poll mode, spins for up to the
+   * spin budget before blocking.
    *
    * @param out Output buffer for the received data.
    * @param timeout_ms Timeout in milliseconds (default: 1000).
@@ -81,6 +181,25 @@ class Tap {
    */
   [[nodiscard]] auto read(std::vector<uint8_t>* out, int timeout_ms = 1000) -> science::Status;
 
+  /**
+   * Read a single message from the tap without copying it (blocking with timeout).
+   *
+   * @param message Output parameter for the message; it owns the received data.
+   * @param timeout_ms Timeout in milliseconds (default: 1000).
+   * @return Status indicating success, timeout, or error.
+   */
+  [[nodiscard]] auto read(zmq::message_t* message, int timeout_ms = 1000) -> science::Status;
+
+  /**
+   * Receive a message if one is waiting, without blocking or copying.
+   *
+   * For busy-polling loops; makes no socket option calls.
+   *
+   * @param message Output parameter for the message; its data stays valid until it is reused.
+   * @return Status kDeadlineExceeded if nothing is waiting.
+   */
+  [[nodiscard]] auto try_read(zmq::message_t* message) -> science::Status;
+
   /**
    * Send data to the tap.
    *
@@ -91,6 +210,15 @@ class Tap {
    */
   [[nodiscard]] auto send(const std::vector<uint8_t>& data) -> science::Status;
 
+  /**
+   * Send data to the tap from any buffer.
+   *
+   * @param data The data to send.
+   * @param size The number of bytes.
+   * @return Status indicating success or failure.
+   */
+  [[nodiscard]] auto send(const uint8_t* data, size_t size) -> science::Status;
+
   /**
    * Read multiple messages in a batch (non-blocking).
    *
@@ -108,7 +236,17 @@ class Tap {
   std::unique_ptr<zmq::context_t> zmq_context_;
   std::unique_ptr<zmq::socket_t> zmq_socket_;
   std::optional<synapse::TapConnection> connected_tap_;
+  std::string connected_endpoint_;
+  TapReceiveOptions receive_options_;
+  std::unique_ptr<TapMonitor> monitor_;
+
+  // The socket's current rcvtimeo, so it's only set when it changes
+  std::optional<int> receive_timeout_ms_;
 
+  auto connect_endpoint(const synapse::TapConnection& tap, const std::string& endpoint) -> science::Status;
+  auto open_socket(const synapse::TapConnection& tap, const std::string& endpoint) -> science::Status;
+  auto receive(zmq::message_t* message, int timeout_ms) -> science::Status;
+  void set_receive_timeout(int timeout_ms);
   void cleanup();
 };
 
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <zmq.hpp>
+#include "science/synapse/latest_frame.h"
+#include "science/synapse/status.h"
+#include "science/synapse/tap.h"
+
+namespace synapse {
+
+/**
+ * A message from a TapHub, shared by every subscriber that received it; freed when the last one lets go.
+ */
+using TapMessage = std::shared_ptr<const zmq::message_t>;
+
+/**
+ * What a subscriber's queue does with a new message when it's full.
+ */
+enum class DropPolicy {
+  // Make room by discarding the oldest queued message; suits displays, which want the latest data
+  kDropOldest,
+  // Discard the new message; suits consumers that need contiguous runs, such as decoders
+  kDropNewest,
+};
+
+/**
+ * Options for a TapHub subscriber.
+ */
+struct TapSubscriberOptions {
+  // Messages the subscriber's queue holds before dropping
+  size_t capacity = 1024;
+
+  DropPolicy drop_policy = DropPolicy::kDropOldest;
+};
+
+/**
+ * A snapshot of one subscriber's counters.
+ */
+struct TapSubscriberStats {
+  uint64_t received = 0;
+  uint64_t dropped = 0;
+  size_t queue_depth = 0;
+  size_t max_queue_depth = 0;
+};
+
+/**
+ * One consumer's view of a TapHub: a bounded queue of the hub's messages.
+ *
+ * Thread-safe; typically one thread pops while the hub's thread pushes.
+ */
+class TapSubscriber {
+ public:
+  explicit TapSubscriber(const TapSubscriberOptions& options);
+
+  TapSubscriber(const TapSubscriber&) = delete;
+  TapSubscriber& operator=(const TapSubscriber&) = delete;
+
+  /**
+   * Take the next message, waiting up to timeout for one.
+   *
+   * @param message Output parameter for the message.
+   * @param timeout How long to wait.
+   * @return science::Status kDeadlineExceeded on timeout, kCancelled once closed and drained.
+   */
+  [[nodiscard]] auto pop(TapMessage* message, std::chrono::milliseconds timeout) -> science::Status;
+
+  /**
+   * Take the next message if one is queued.
+   *
+   * @return science::Status kDeadlineExceeded if none is, kCancelled once closed and drained.
+   */
+  [[nodiscard]] auto try_pop(TapMessage* message) -> science::Status;
+
+  /**
+   * Stop receiving messages; the hub drops the subscriber, and queued messages can still be popped.
+   */
+  void close();
+
+  /**
+   * Queue a message, dropping per the subscriber's policy if the queue is full. Called by the hub.
+   *
+   * @return false once the subscriber is closed.
+   */
+  auto push(const TapMessage& message) -> bool;
+
+  [[nodiscard]] auto is_closed() const -> bool;
+  [[nodiscard]] auto stats() const -> TapSubscriberStats;
+
+ private:
+  TapSubscriberOptions options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<TapMessage> queue_;
+  bool closed_ = false;
+  TapSubscriberStats stats_;
+};
+
+/**
+ * Shares one producer tap between any number of in-process consumers.
+ *
+ * The hub's thread reads each message once, without copying, and hands a reference to every
+ * subscriber's queue. Subscribers can come and go while it runs; each has its own capacity and
+ * drop policy, so a slow subscriber only ever drops its own messages.
+ *
+ * The tap belongs to the hub's thread while it runs and must not be used elsewhere.
+ */
+class TapHub {
+ public:
+  /**
+   * @param tap A connected producer tap.
+   * @param hub Output parameter for the hub.
+   * @return science::Status
+   */
+  [[nodiscard]] static auto create(Tap* tap, std::unique_ptr<TapHub>* hub) -> science::Status;
+
+  ~TapHub();
+
+  TapHub(const TapHub&) = delete;
+  TapHub& operator=(const TapHub&) = delete;
+
+  /**
+   * Add a subscriber; it receives every message read from now on.
+   *
+   * @param subscriber Output parameter for the subscriber.
+   * @param options Queue capacity and drop policy.
+   * @return science::Status
+   */
+  [[nodiscard]] auto subscribe(std::shared_ptr<TapSubscriber>* subscriber, const TapSubscriberOptions& options = {})
+    -> science::Status;
+
+  /**
+   * Add a conflated subscriber that only keeps the latest message, for displays. The hub
+   * publishes to it without locking or queueing, and drops it once the caller lets go of it.
+   *
+   * @param latest Output parameter for the latest-message view.
+   * @param max_size The largest message it holds, in bytes; larger messages are skipped.
+   * @return science::Status
+   */
+  [[nodiscard]] auto subscribe_latest(std::shared_ptr<LatestFrame>* latest, size_t max_size = 1 << 16)
+    -> science::Status;
+
+  [[nodiscard]] auto num_subscribers() const -> size_t;
+
+  [[nodiscard]] auto start() -> science::Status;
+
+  /**
+   * Stop reading. Subscribers stay subscribed, for a later start().
+   */
+  void stop();
+
+  [[nodiscard]] auto is_running() const -> bool { return running_; }
+
+  /**
+   * @return The error that stopped the hub's thread, if any.
+   */
+  [[nodiscard]] auto status() const -> science::Status;
+
+  [[nodiscard]] auto messages_received() const -> uint64_t { return messages_received_; }
+
+ private:
+  explicit TapHub(Tap* tap);
+
+  void run();
+
+  Tap* tap_;
+
+  std::atomic<bool> running_{ false };
+  std::thread thread_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::shared_ptr<TapSubscriber>> subscribers_;
+  std::vector<std::shared_ptr<LatestFrame>> latest_;
+  science::Status status_;
+
+  std::atomic<uint64_t> messages_received_{ 0 };
+};
+
+}  // namespace synapse
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "science/synapse/status.h"
+#include "science/synapse/device.h"
+#include "science/synapse/device_advertisement.h"
+
+namespace synapse {
+
+/**
+ * A discovered device with a warmed-up client.
+ *
+ * `device` is connected and `info` is populated when `status` is ok.
+ * On failure, `device` is still set so the caller may retry.
+ */
+struct ConnectedDevice {
+  DeviceAdvertisement advertisement;
+  std::shared_ptr<Device> device;
+  synapse::DeviceInfo info;
+  science::Status status;
+};
+
+/**
+ * Discover devices and connect to each one as soon as it is found.
+ *
+ * Connection setup and the initial `info` call for each device run on their own
+ * thread while discovery keeps listening, so a multi-device rig overlaps discovery
+ * with connection setup instead of running them back to back.
+ *
+ * The callback is invoked once per device, from a connection thread, as soon as that
+ * device is ready (or has failed to connect). Calls are serialized. Return false to
+ * stop discovery; devices already being connected are still delivered.
+ *
+ * This call returns once discovery has finished and every pending connection has
+ * been delivered.
+ *
+ * @param callback Called for each connected device. Return false to stop discovery.
+ * @param timeout_ms The discovery timeout in milliseconds (default: 10000ms).
+ * @param connect_timeout Timeout for each device's connection and info call.
+ *                        Defaults to the discovery timeout; a device that can't be reached
+ *                        in time is delivered with kDeadlineExceeded.
+ * @return science::Status indicating success or failure of discovery.
+ */
+auto discover_connect(std::function<bool(const ConnectedDevice&)> callback,
+                      unsigned int timeout_ms = 10000,
+                      std::optional<std::chrono::milliseconds> connect_timeout = std::nullopt) -> science::Status;
+
+/**
+ * Discover devices and connect to each one as soon as it is found.
+ *
+ * @see discover_connect
+ *
+ * @param timeout_ms The discovery timeout in milliseconds (default: 10000ms).
+ * @param connected A vector to populate with connected devices, in the order they became ready.
+ * @param connect_timeout Timeout for each device's connection and info call (default: timeout_ms).
+ * @return science::Status indicating success or failure of discovery.
+ */
+auto discover_connect(unsigned int timeout_ms,
+                      std::vector<ConnectedDevice>* connected,
+                      std::optional<std::chrono::milliseconds> connect_timeout = std::nullopt) -> science::Status;
+
+}  // namespace synapse
@@ -1,16 +1,305 @@
 #include "science/synapse/channel_mask.h"
 
+#include <algorithm>
+
+#include "science/synapse/dsp/simd.h"
+#include "science/synapse/dsp/simd_internal.h"
+
 namespace synapse {
 
-ChannelMask::ChannelMask(size_t size) : channels_(size, true) {}
+namespace {
+
+auto words_for(size_t size) -> size_t {
+  return (size + 63) / 64;
+}
+
+auto popcount(uint64_t word) -> size_t {
+#ifdef _MSC_VER
+  return static_cast<size_t>(__popcnt64(word));
+#else
+  return static_cast<size_t>(__builtin_popcountll(word));
+#endif
+}
+
+// The positions of the set bits of every byte value, for expanding a byte at a time
+struct ByteTable {
+  uint8_t positions[256][8];
+  uint8_t counts[256];
+};
+
+constexpr auto make_byte_table() -> ByteTable {
+  ByteTable table{};
+  for (int byte = 0; byte < 256; ++byte) {
+    uint8_t count = 0;
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      if (byte & (1 << bit)) {
+        table.positions[byte][count++] = bit;
+      }
+    }
+    table.counts[byte] = count;
+  }
+  return table;
+}
+
+constexpr ByteTable kByteTable = make_byte_table();
+
+auto count_scalar(const uint64_t* words, size_t num_words) -> size_t {
+  size_t count = 0;
+  for (size_t i = 0; i < num_words; ++i) {
+    count += popcount(words[i]);
+  }
+  return count;
+}
+
+// Writes the indices of the set bits, starting at base; returns the end of the output
+auto indices_scalar(const uint64_t* words, size_t num_words, uint32_t base, uint32_t* out) -> uint32_t* {
+  for (size_t i = 0; i < num_words; ++i) {
+    uint64_t bits = words[i];
+    while (bits != 0) {
+      *out++ = base + static_cast<uint32_t>(i * 64 + detail::count_trailing_zeros(bits));
+      bits &= bits - 1;
+    }
+  }
+  return out;
+}
+
+#if SYNAPSE_HAS_X86_SIMD
+// Nibble lookup popcount: count each nibble with a shuffle, then sum bytes per 64-bit lane
+SYNAPSE_TARGET_AVX2
+auto count_avx2(const uint64_t* words, size_t num_words) -> size_t {
+  const __m256i lookup = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+  );
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  __m256i total = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for (; i + 4 <= num_words; i += 4) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+    const __m256i low = _mm256_and_si256(v, low_mask);
+    const __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    const __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+    total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+  }
+
+  alignas(32) uint64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), total);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + count_scalar(words + i, num_words - i);
+}
+
+// Skips empty 256-bit runs, then expands each byte's set bits eight indices at a time.
+// Writes up to 7 indices past the returned end.
+SYNAPSE_TARGET_AVX2
+auto indices_avx2(const uint64_t* words, size_t num_words, uint32_t base, uint32_t* out) -> uint32_t* {
+  size_t i = 0;
+  for (; i + 4 <= num_words; i += 4) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+    if (_mm256_testz_si256(v, v)) {
+      continue;
+    }
+    for (size_t w = i; w < i + 4; ++w) {
+      uint64_t bits = words[w];
+      for (uint32_t offset = base + static_cast<uint32_t>(w * 64); bits != 0; bits >>= 8, offset += 8) {
+        const auto byte = static_cast<uint8_t>(bits);
+        if (byte == 0) {
+          continue;
+        }
+        const __m128i positions = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(kByteTable.positions[byte]));
+        const __m256i indices = _mm256_add_epi32(_mm256_cvtepu8_epi32(positions), _mm256_set1_epi32(offset));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), indices);
+        out += kByteTable.counts[byte];
+      }
+    }
+  }
+  return indices_scalar(words + i, num_words - i, base + static_cast<uint32_t>(i * 64), out);
+}
+#endif
+
+auto simd_level() -> SimdLevel {
+  static const SimdLevel level = detect_simd_level();
+  return level;
+}
+
+}  // namespace
+
+auto ChannelMaskView::count() const -> size_t {
+  if (size_ < 64) {
+    return size_ == 0 ? 0 : popcount(word(0));
+  }
+  const size_t full_words = size_ / 64;
+  size_t count = popcount(size_ % 64 == 0 ? 0 : word(full_words));
+#if SYNAPSE_HAS_X86_SIMD
+  if (simd_level() == SimdLevel::kAvx2) {
+    return count + count_avx2(words_, full_words);
+  }
+#endif
+  return count + count_scalar(words_, full_words);
+}
+
+auto ChannelMaskView::any() const -> bool {
+  for (size_t i = 0; i < num_words(); ++i) {
+    if (word(i) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto ChannelMaskView::intersects(ChannelMaskView other) const -> bool {
+  const size_t n = std::min(num_words(), other.num_words());
+  for (size_t i = 0; i < n; ++i) {
+    if ((word(i) & other.word(i)) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto ChannelMaskView::is_subset_of(ChannelMaskView other) const -> bool {
+  for (size_t i = 0; i < num_words(); ++i) {
+    const uint64_t others = i < other.num_words() ? other.word(i) : 0;
+    if ((word(i) & ~others) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ChannelMaskView::channels(std::vector<uint32_t>* channels) const {
+  // Slack for the vector kernel's overhanging stores
+  channels->resize(count() + 8);
+  const size_t full_words = size_ / 64;
+  uint32_t* end = channels->data();
+#if SYNAPSE_HAS_X86_SIMD
+  if (simd_level() == SimdLevel::kAvx2) {
+    end = indices_avx2(words_, full_words, 0, end);
+  } else {
+    end = indices_scalar(words_, full_words, 0, end);
+  }
+#else
+  end = indices_scalar(words_, full_words, 0, end);
+#endif
+  if (size_ % 64 != 0) {
+    const uint64_t tail = word(full_words);
+    end = indices_scalar(&tail, 1, static_cast<uint32_t>(full_words * 64), end);
+  }
+  channels->resize(end - channels->data());
+}
+
+void ChannelMaskView::to_proto(google::protobuf::RepeatedField<uint32_t>* channels) const {
+  channels->Clear();
+  channels->Reserve(static_cast<int>(count()));
+  for_each([channels](uint32_t channel) { channels->AddAlreadyReserved(channel); });
+}
+
+ChannelMask::ChannelMask(size_t size, bool selected)
+  : words_(words_for(size), selected ? ~uint64_t{ 0 } : 0), size_(size) {
+  resize(size);
+}
 
-ChannelMask::ChannelMask(const std::vector<uint32_t>& channels) : channels_(channels) {}
+ChannelMask::ChannelMask(const std::vector<uint32_t>& channels) : ChannelMask(channels.begin(), channels.end()) {}
 
-ChannelMask::ChannelMask(std::vector<uint32_t>::const_iterator begin, std::vector<uint32_t>::const_iterator end)
-  : channels_(begin, end) {}
+ChannelMask::ChannelMask(std::vector<uint32_t>::const_iterator begin, std::vector<uint32_t>::const_iterator end) {
+  if (begin == end) {
+    return;
+  }
+  resize(static_cast<size_t>(*std::max_element(begin, end)) + 1);
+  for (auto it = begin; it != end; ++it) {
+    words_[*it / 64] |= uint64_t{ 1 } << (*it % 64);
+  }
+}
+
+ChannelMask::ChannelMask(ChannelMaskView view) : words_(view.num_words()), size_(view.size()) {
+  for (size_t i = 0; i < words_.size(); ++i) {
+    words_[i] = view.word(i);
+  }
+}
+
+auto ChannelMask::from_proto(const google::protobuf::RepeatedField<uint32_t>& channels) -> ChannelMask {
+  ChannelMask mask;
+  if (channels.empty()) {
+    return mask;
+  }
+  mask.resize(static_cast<size_t>(*std::max_element(channels.begin(), channels.end())) + 1);
+  for (uint32_t channel : channels) {
+    mask.words_[channel / 64] |= uint64_t{ 1 } << (channel % 64);
+  }
+  return mask;
+}
+
+void ChannelMask::resize(size_t size) {
+  words_.resize(words_for(size), 0);
+  size_ = size;
+  // Keep bits past the end clear, so growing again doesn't revive them
+  if (size_ % 64 != 0) {
+    words_.back() &= (uint64_t{ 1 } << (size_ % 64)) - 1;
+  }
+}
+
+void ChannelMask::set(size_t channel, bool selected) {
+  if (!selected) {
+    reset(channel);
+    return;
+  }
+  if (channel >= size_) {
+    resize(channel + 1);
+  }
+  words_[channel / 64] |= uint64_t{ 1 } << (channel % 64);
+}
+
+void ChannelMask::reset(size_t channel) {
+  if (channel < size_) {
+    words_[channel / 64] &= ~(uint64_t{ 1 } << (channel % 64));
+  }
+}
+
+void ChannelMask::clear() {
+  std::fill(words_.begin(), words_.end(), 0);
+}
 
 auto ChannelMask::channels() const -> std::vector<uint32_t> {
-  return channels_;
+  std::vector<uint32_t> result;
+  channels(&result);
+  return result;
+}
+
+auto ChannelMask::operator|=(ChannelMaskView other) -> ChannelMask& {
+  if (other.size() > size_) {
+    resize(other.size());
+  }
+  for (size_t i = 0; i < other.num_words(); ++i) {
+    words_[i] |= other.word(i);
+  }
+  return *this;
+}
+
+auto ChannelMask::operator&=(ChannelMaskView other) -> ChannelMask& {
+  const size_t n = std::min(words_.size(), other.num_words());
+  for (size_t i = 0; i < n; ++i) {
+    words_[i] &= other.word(i);
+  }
+  std::fill(words_.begin() + n, words_.end(), 0);
+  return *this;
+}
+
+auto ChannelMask::operator-=(ChannelMaskView other) -> ChannelMask& {
+  const size_t n = std::min(words_.size(), other.num_words());
+  for (size_t i = 0; i < n; ++i) {
+    words_[i] &= ~other.word(i);
+  }
+  return *this;
+}
+
+auto ChannelMask::operator==(ChannelMaskView other) const -> bool {
+  const size_t n = std::max(words_.size(), other.num_words());
+  for (size_t i = 0; i < n; ++i) {
+    const uint64_t ours = i < words_.size() ? words_[i] : 0;
+    const uint64_t theirs = i < other.num_words() ? other.word(i) : 0;
+    if (ours != theirs) {
+      return false;
+    }
+  }
+  return true;
 }
 
 }  // namespace synapse
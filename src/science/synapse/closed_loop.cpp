@@ -0,0 +1,154 @@
+#include "science/synapse/closed_loop.h"
+
+#include <chrono>
+#include <utility>
+
+#include "science/synapse/realtime.h"
+
+namespace synapse {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+}  // namespace
+
+ClosedLoop::ClosedLoop(Tap* input, Tap* output, Decision decision, const ClosedLoopOptions& options)
+  : input_(input), output_(output), decision_(std::move(decision)), options_(options) {}
+
+ClosedLoop::~ClosedLoop() {
+  stop();
+}
+
+auto ClosedLoop::create(
+  Tap* input,
+  Tap* output,
+  Decision decision,
+  std::unique_ptr<ClosedLoop>* loop,
+  const ClosedLoopOptions& options
+) -> science::Status {
+  if (loop == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "loop ptr must not be null" };
+  }
+  if (input == nullptr || output == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "tap ptrs must not be null" };
+  }
+  if (!decision) {
+    return { science::StatusCode::kInvalidArgument, "decision callback must be set" };
+  }
+
+  auto input_tap = input->connected_tap();
+  auto output_tap = output->connected_tap();
+  if (!input_tap || !output_tap) {
+    return { science::StatusCode::kFailedPrecondition, "both taps must be connected" };
+  }
+  if (input_tap->tap_type() == synapse::TapType::TAP_TYPE_CONSUMER) {
+    return { science::StatusCode::kInvalidArgument, "input must be a producer tap" };
+  }
+  if (output_tap->tap_type() != synapse::TapType::TAP_TYPE_CONSUMER) {
+    return { science::StatusCode::kInvalidArgument, "output must be a consumer tap" };
+  }
+
+  loop->reset(new ClosedLoop(input, output, std::move(decision), options));
+  return {};
+}
+
+auto ClosedLoop::start() -> science::Status {
+  if (running_) {
+    return { science::StatusCode::kFailedPrecondition, "already running" };
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_ = {};
+  }
+
+  // The thread places itself, then reports back before polling
+  running_ = true;
+  auto s = start_placed_thread(&thread_, [this]() { return place_thread(); }, [this]() { run(); });
+  if (!s.ok()) {
+    running_ = false;
+  }
+  return s;
+}
+
+void ClosedLoop::stop() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+auto ClosedLoop::status() const -> science::Status {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return status_;
+}
+
+auto ClosedLoop::stats() const -> ClosedLoopStats {
+  ClosedLoopStats stats;
+  stats.messages_received = messages_received_.load(std::memory_order_relaxed);
+  stats.commands_sent = commands_sent_.load(std::memory_order_relaxed);
+  stats.send_errors = send_errors_.load(std::memory_order_relaxed);
+  stats.empty_polls = empty_polls_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+auto ClosedLoop::place_thread() -> science::Status {
+  if (options_.cpu >= 0) {
+    auto s = pin_current_thread(options_.cpu);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  if (options_.realtime_priority > 0) {
+    return set_realtime_priority(options_.realtime_priority);
+  }
+  return {};
+}
+
+void ClosedLoop::run() {
+  zmq::message_t message;
+  std::vector<uint8_t> command;
+  command.reserve(options_.command_capacity);
+  science::Status s;
+
+  // Only this thread writes the counter, so a plain store avoids a locked add on every spin
+  uint64_t empty_polls = empty_polls_.load(std::memory_order_relaxed);
+  while (running_.load(std::memory_order_relaxed)) {
+    s = input_->try_read(&message);
+    if (s.code() == science::StatusCode::kDeadlineExceeded) {
+      empty_polls_.store(++empty_polls, std::memory_order_relaxed);
+      cpu_relax();
+      continue;
+    }
+    if (!s.ok()) {
+      break;
+    }
+
+    const auto received = Clock::now();
+    messages_received_.fetch_add(1, std::memory_order_relaxed);
+    command.clear();
+    if (!decision_(static_cast<const uint8_t*>(message.data()), message.size(), &command)) {
+      continue;
+    }
+
+    // A failed send loses one command; keep going so the loop serves the next event
+    if (output_->send(command.data(), command.size()).ok()) {
+      latency_.record(Clock::now() - received);
+      commands_sent_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      send_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  running_ = false;
+  if (!s.ok() && s.code() != science::StatusCode::kDeadlineExceeded) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_ = s;
+  }
+}
+
+}  // namespace synapse
@@ -8,9 +8,71 @@
 #include "science/synapse/nodes/spike_detector.h"
 #include "science/synapse/nodes/spike_source.h"
 
+#include <optional>
+#include <sstream>
+
+#include <google/protobuf/util/message_differencer.h>
 
 namespace synapse {
 
+namespace {
+
+// The kind of data carried along a connection in the signal chain
+enum class SignalKind { kNone, kAny, kBroadband, kSpikes, kBinnedSpikes };
+
+struct NodeSignature {
+  SignalKind input;
+  SignalKind output;
+};
+
+auto node_signature(synapse::NodeType type) -> std::optional<NodeSignature> {
+  switch (type) {
+    case synapse::NodeType::kBroadbandSource:
+      return NodeSignature{ SignalKind::kNone, SignalKind::kBroadband };
+
+    case synapse::NodeType::kSpikeSource:
+      return NodeSignature{ SignalKind::kNone, SignalKind::kSpikes };
+
+    case synapse::NodeType::kSpectralFilter:
+      return NodeSignature{ SignalKind::kBroadband, SignalKind::kBroadband };
+
+    case synapse::NodeType::kSpikeDetector:
+      return NodeSignature{ SignalKind::kBroadband, SignalKind::kSpikes };
+
+    case synapse::NodeType::kSpikeBinner:
+      return NodeSignature{ SignalKind::kSpikes, SignalKind::kBinnedSpikes };
+
+    case synapse::NodeType::kDiskWriter:
+    case synapse::NodeType::kElectricalStimulation:
+    case synapse::NodeType::kOpticalStimulation:
+      return NodeSignature{ SignalKind::kAny, SignalKind::kNone };
+
+    default:
+      return std::nullopt;
+  }
+}
+
+auto signal_kind_name(SignalKind kind) -> std::string {
+  switch (kind) {
+    case SignalKind::kBroadband:
+      return "broadband";
+    case SignalKind::kSpikes:
+      return "spikes";
+    case SignalKind::kBinnedSpikes:
+      return "binned spikes";
+    case SignalKind::kAny:
+      return "any";
+    default:
+      return "none";
+  }
+}
+
+auto describe(const Node& node) -> std::string {
+  return synapse::NodeType_Name(node.type()) + " (id " + std::to_string(node.id()) + ")";
+}
+
+}  // namespace
+
 auto create_node(const synapse::NodeConfig& config, std::shared_ptr<Node>* node_ptr) -> science::Status {
   if (node_ptr == nullptr) {
     return { science::StatusCode::kInvalidArgument, "node ptr must not be null" };
@@ -50,6 +112,11 @@ auto create_node(const synapse::NodeConfig& config, std::shared_ptr<Node>* node_
   }
 }
 
+auto ConfigDiff::empty() const -> bool {
+  return added_nodes.empty() && removed_nodes.empty() && changed_nodes.empty() &&
+         added_connections.empty() && removed_connections.empty();
+}
+
 auto Config::add(std::vector<std::shared_ptr<Node>> nodes) -> science::Status {
   science::Status s;
   for (auto& node : nodes) {
@@ -77,15 +144,7 @@ auto Config::add_node(std::shared_ptr<Node> node, uint32_t id) -> science::Statu
     id = gen_node_id();
   }
 
-  for (auto& n : nodes_) {
-    if (n->id() == id) {
-      return { science::StatusCode::kInvalidArgument, "id already in use" };
-    }
-  }
-
-  node->id_ = id;
-  nodes_.push_back(node);
-  return {};
+  return insert_node(node, id);
 }
 
 auto Config::connect(std::weak_ptr<Node> src, std::weak_ptr<Node> dst) -> science::Status {
@@ -98,38 +157,168 @@ auto Config::connect(std::weak_ptr<Node> src, std::weak_ptr<Node> dst) -> scienc
     return { science::StatusCode::kInvalidArgument, "src or dst node has no id" };
   }
 
-  bool src_exists = false;
-  bool dst_exists = false;
-  for (auto& node : nodes_) {
-    if (node->id() == src_node->id()) {
-      src_exists = true;
-    }
-    if (node->id() == dst_node->id()) {
-      dst_exists = true;
-    }
-  }
-
-  if (!src_exists) {
+  if (node_index_.find(src_node->id()) == node_index_.end()) {
     return { science::StatusCode::kInvalidArgument, "src node not found" };
   }
 
-  if (!dst_exists) {
+  if (node_index_.find(dst_node->id()) == node_index_.end()) {
     return { science::StatusCode::kInvalidArgument, "dst node not found" };
   }
 
-  auto exists = std::find_if(connections_.begin(), connections_.end(), [&](auto& c) {
-    return c.first == src_node->id() && c.second == dst_node->id();
-  }) != connections_.end();
-  if (exists) {
+  return insert_connection(src_node->id(), dst_node->id());
+}
+
+auto Config::connections() const -> const std::vector<std::pair<uint32_t, uint32_t>>& {
+  return connections_;
+}
+
+auto Config::nodes() const -> const std::vector<std::shared_ptr<Node>>& {
+  return nodes_;
+}
+
+auto Config::node(uint32_t id) const -> std::shared_ptr<Node> {
+  auto it = node_index_.find(id);
+  if (it == node_index_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+auto Config::gen_node_id() -> uint32_t {
+  uint32_t id = nodes_.size() + 1;
+  while (node_index_.find(id) != node_index_.end()) {
+    id++;
+  }
+  return id;
+}
+
+auto Config::insert_node(std::shared_ptr<Node> node, uint32_t id) -> science::Status {
+  if (!node_index_.emplace(id, node).second) {
+    return { science::StatusCode::kInvalidArgument, "id already in use" };
+  }
+
+  node->id_ = id;
+  nodes_.push_back(node);
+  structure_revision_++;
+  return {};
+}
+
+auto Config::insert_connection(uint32_t src, uint32_t dst) -> science::Status {
+  uint64_t key = (static_cast<uint64_t>(src) << 32) | dst;
+  if (!connection_index_.insert(key).second) {
     return { science::StatusCode::kInvalidArgument, "connection already exists" };
   }
 
-  connections_.push_back({ src_node->id(), dst_node->id() });
+  connections_.push_back({ src, dst });
+  structure_revision_++;
   return {};
 }
 
-auto Config::gen_node_id() -> uint32_t {
-  return nodes_.size() + 1;
+auto Config::topological_sort(std::vector<uint32_t>* order) const -> science::Status {
+  if (order == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "order ptr must not be null" };
+  }
+
+  std::unordered_map<uint32_t, std::vector<uint32_t>> outputs;
+  std::unordered_map<uint32_t, size_t> in_degree;
+  for (const auto& [src, dst] : connections_) {
+    outputs[src].push_back(dst);
+    in_degree[dst]++;
+  }
+
+  order->clear();
+  order->reserve(nodes_.size());
+  for (const auto& node : nodes_) {
+    if (in_degree[node->id()] == 0) {
+      order->push_back(node->id());
+    }
+  }
+
+  for (size_t i = 0; i < order->size(); ++i) {
+    auto it = outputs.find((*order)[i]);
+    if (it == outputs.end()) {
+      continue;
+    }
+    for (auto dst : it->second) {
+      if (--in_degree[dst] == 0) {
+        order->push_back(dst);
+      }
+    }
+  }
+
+  if (order->size() != nodes_.size()) {
+    std::string ids;
+    for (const auto& node : nodes_) {
+      if (in_degree[node->id()] > 0) {
+        ids += (ids.empty() ? "" : ", ") + std::to_string(node->id());
+      }
+    }
+    return { science::StatusCode::kInvalidArgument, "config contains a cycle (unresolved nodes: " + ids + ")" };
+  }
+
+  return {};
+}
+
+auto Config::validate() const -> science::Status {
+  std::vector<std::string> problems;
+
+  std::vector<uint32_t> order;
+  auto s = topological_sort(&order);
+  if (!s.ok()) {
+    problems.push_back(s.message());
+  }
+
+  std::unordered_map<uint32_t, size_t> in_degree;
+  std::unordered_map<uint32_t, size_t> out_degree;
+  for (const auto& [src_id, dst_id] : connections_) {
+    in_degree[dst_id]++;
+    out_degree[src_id]++;
+
+    const auto& src = node_index_.at(src_id);
+    const auto& dst = node_index_.at(dst_id);
+    auto src_sig = node_signature(src->type());
+    auto dst_sig = node_signature(dst->type());
+    if (!src_sig || !dst_sig) {
+      continue;
+    }
+
+    if (src_sig->output == SignalKind::kNone) {
+      problems.push_back(describe(*src) + " has no output but is connected to " + describe(*dst));
+    } else if (dst_sig->input == SignalKind::kNone) {
+      problems.push_back(describe(*dst) + " takes no input but is connected from " + describe(*src));
+    } else if (src_sig->output != dst_sig->input && dst_sig->input != SignalKind::kAny) {
+      problems.push_back(
+        describe(*dst) + " expects " + signal_kind_name(dst_sig->input) + " input but " + describe(*src) +
+        " produces " + signal_kind_name(src_sig->output)
+      );
+    }
+  }
+
+  for (const auto& node : nodes_) {
+    auto sig = node_signature(node->type());
+    if (!sig) {
+      continue;
+    }
+
+    if (sig->input != SignalKind::kNone && in_degree[node->id()] == 0) {
+      problems.push_back(describe(*node) + " has no input");
+    }
+
+    if (sig->input == SignalKind::kNone && out_degree[node->id()] == 0) {
+      problems.push_back(describe(*node) + " has no consumers");
+    }
+  }
+
+  if (problems.empty()) {
+    return {};
+  }
+
+  std::ostringstream message;
+  message << "invalid config: ";
+  for (size_t i = 0; i < problems.size(); ++i) {
+    message << (i ? "; " : "") << problems[i];
+  }
+  return { science::StatusCode::kInvalidArgument, message.str() };
 }
 
 auto Config::set_device(const IDevice* device) -> science::Status {
@@ -147,19 +336,161 @@ auto Config::set_device(const IDevice* device) -> science::Status {
 }
 
 auto Config::to_proto() -> synapse::DeviceConfiguration {
-  synapse::DeviceConfiguration config;
+  std::shared_ptr<const synapse::DeviceConfiguration> proto;
+  auto s = to_proto(&proto);
+  if (!s.ok() || proto == nullptr) {
+    return {};
+  }
+  return *proto;
+}
+
+auto Config::to_proto(std::shared_ptr<const synapse::DeviceConfiguration>* proto) -> science::Status {
+  if (proto == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "proto ptr must not be null" };
+  }
+
+  auto s = refresh_cache();
+  if (!s.ok()) {
+    return s;
+  }
+
+  *proto = cached_proto_;
+  return {};
+}
+
+auto Config::serialize(std::shared_ptr<const std::string>* bytes) -> science::Status {
+  if (bytes == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "bytes ptr must not be null" };
+  }
+
+  auto s = refresh_cache();
+  if (!s.ok()) {
+    return s;
+  }
+
+  *bytes = cached_bytes_;
+  return {};
+}
+
+auto Config::revision() const -> uint64_t {
+  // Node revisions only ever increase, so the sum changes iff something changed
+  uint64_t revision = structure_revision_;
+  for (const auto& node : nodes_) {
+    revision += node->revision();
+  }
+  return revision;
+}
+
+auto Config::refresh_cache() -> science::Status {
+  auto current = revision();
+  if (cached_proto_ != nullptr && cached_revision_ == current) {
+    return {};
+  }
+
+  auto config = std::make_shared<synapse::DeviceConfiguration>();
 
   for (auto& node : nodes_) {
-    auto s = node->to_proto(config.add_nodes());
+    auto s = node->to_proto(config->add_nodes());
+    if (!s.ok()) {
+      return { s.code(), "failed to serialize node " + std::to_string(node->id()) + ": " + s.message() };
+    }
   }
 
   for (auto& [src, dst] : connections_) {
-    auto connection = config.add_connections();
+    auto connection = config->add_connections();
     connection->set_src_node_id(src);
     connection->set_dst_node_id(dst);
   }
 
-  return config;
+  auto bytes = std::make_shared<std::string>();
+  if (!config->SerializeToString(bytes.get())) {
+    return { science::StatusCode::kInternal, "failed to serialize config" };
+  }
+
+  cached_proto_ = std::move(config);
+  cached_bytes_ = std::move(bytes);
+  cached_revision_ = current;
+  return {};
+}
+
+auto Config::diff(Config* to, ConfigDiff* diff) -> science::Status {
+  if (to == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "config ptr must not be null" };
+  }
+
+  std::shared_ptr<const synapse::DeviceConfiguration> from_config;
+  auto s = to_proto(&from_config);
+  if (!s.ok()) {
+    return s;
+  }
+
+  std::shared_ptr<const synapse::DeviceConfiguration> to_config;
+  s = to->to_proto(&to_config);
+  if (!s.ok()) {
+    return s;
+  }
+
+  return Config::diff(*from_config, *to_config, diff);
+}
+
+auto Config::diff(
+  const synapse::DeviceConfiguration& from,
+  const synapse::DeviceConfiguration& to,
+  ConfigDiff* diff
+) -> science::Status {
+  if (diff == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "diff ptr must not be null" };
+  }
+
+  *diff = {};
+
+  std::unordered_map<uint32_t, const synapse::NodeConfig*> from_nodes;
+  for (const auto& node : from.nodes()) {
+    from_nodes.emplace(node.id(), &node);
+  }
+
+  std::unordered_set<uint32_t> to_ids;
+  for (const auto& node : to.nodes()) {
+    to_ids.insert(node.id());
+
+    auto it = from_nodes.find(node.id());
+    if (it == from_nodes.end()) {
+      diff->added_nodes.push_back(node.id());
+    } else if (!google::protobuf::util::MessageDifferencer::Equals(*it->second, node)) {
+      diff->changed_nodes.push_back(node.id());
+    }
+  }
+
+  for (const auto& node : from.nodes()) {
+    if (to_ids.find(node.id()) == to_ids.end()) {
+      diff->removed_nodes.push_back(node.id());
+    }
+  }
+
+  auto key = [](const synapse::NodeConnection& c) {
+    return (static_cast<uint64_t>(c.src_node_id()) << 32) | c.dst_node_id();
+  };
+
+  std::unordered_set<uint64_t> from_connections;
+  for (const auto& connection : from.connections()) {
+    from_connections.insert(key(connection));
+  }
+
+  std::unordered_set<uint64_t> to_connections;
+  for (const auto& connection : to.connections()) {
+    to_connections.insert(key(connection));
+    if (from_connections.find(key(connection)) == from_connections.end()) {
+      diff->added_connections.push_back({ connection.src_node_id(), connection.dst_node_id() });
+    }
+  }
+
+  for (const auto& connection : from.connections()) {
+    if (to_connections.find(key(connection)) == to_connections.end()) {
+      diff->removed_connections.push_back({ connection.src_node_id(), connection.dst_node_id() });
+    }
+  }
+
+  return {};
 }
 
 auto Config::from_proto(const synapse::DeviceConfiguration& proto, Config* config) -> science::Status {
@@ -170,29 +501,25 @@ auto Config::from_proto(const synapse::DeviceConfiguration& proto, Config* confi
       return s;
     }
 
-    if (!node_ptr->id()) {
-      node_ptr->id_ = node_config.id();
+    s = config->insert_node(node_ptr, node_ptr->id() ? node_ptr->id() : node_config.id());
+    if (!s.ok()) {
+      return s;
     }
-    config->nodes_.push_back(node_ptr);
   }
 
   for (const auto& connection : proto.connections()) {
-    auto src = std::find_if(config->nodes_.begin(), config->nodes_.end(), [&](auto& n) {
-      return n->id() == connection.src_node_id();
-    });
-    auto dst = std::find_if(config->nodes_.begin(), config->nodes_.end(), [&](auto& n) {
-      return n->id() == connection.dst_node_id();
-    });
-
-    if (src == config->nodes_.end()) {
+    if (config->node_index_.find(connection.src_node_id()) == config->node_index_.end()) {
       return { science::StatusCode::kInvalidArgument, "src node not found" };
     }
 
-    if (dst == config->nodes_.end()) {
+    if (config->node_index_.find(connection.dst_node_id()) == config->node_index_.end()) {
       return { science::StatusCode::kInvalidArgument, "dst node not found" };
     }
 
-    config->connections_.push_back({ (*src)->id(), (*dst)->id() });
+    auto s = config->insert_connection(connection.src_node_id(), connection.dst_node_id());
+    if (!s.ok()) {
+      return s;
+    }
   }
 
   return {};
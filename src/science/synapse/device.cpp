@@ -1,5 +1,8 @@
 #include "science/synapse/device.h"
 
+#include <grpcpp/generic/generic_stub.h>
+#include <grpcpp/support/proto_buffer_reader.h>
+
 namespace synapse {
 
 Device::Device(const std::string& uri)
@@ -7,32 +10,125 @@ Device::Device(const std::string& uri)
     channel_(grpc::CreateChannel(uri, grpc::InsecureChannelCredentials())),
     rpc_(synapse::SynapseDevice::NewStub(channel_)) {}
 
+auto Device::connect(std::optional<std::chrono::milliseconds> timeout) -> science::Status {
+  auto deadline = std::chrono::system_clock::time_point::max();
+  if (timeout) {
+    deadline = std::chrono::system_clock::now() + *timeout;
+  }
+
+  if (!channel_->WaitForConnected(deadline)) {
+    return { science::StatusCode::kDeadlineExceeded, "timed out connecting to device at " + uri_ };
+  }
+
+  return {};
+}
+
 auto Device::configure(Config* config, std::optional<std::chrono::milliseconds> timeout) -> science::Status {
-  auto s = config->set_device(this);
+  // Catch graph problems locally rather than after a round trip to the device
+  auto s = config->validate();
+  if (!s.ok()) {
+    return s;
+  }
+
+  s = config->set_device(this);
   if (!s.ok()) {
     return { s.code(), "failed to set device: " + s.message() };
   }
 
+  return send_configuration(config, timeout);
+}
+
+auto Device::reconfigure(Config* config,
+                         ConfigDiff* diff,
+                         std::optional<std::chrono::milliseconds> timeout) -> science::Status {
+  auto s = config->validate();
+  if (!s.ok()) {
+    return s;
+  }
+
+  s = config->set_device(this);
+  if (!s.ok()) {
+    return { s.code(), "failed to set device: " + s.message() };
+  }
+
+  std::shared_ptr<const synapse::DeviceConfiguration> req;
+  std::shared_ptr<const std::string> bytes;
+  s = config->to_proto(&req);
+  if (s.ok()) {
+    s = config->serialize(&bytes);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+
+  // The same cached buffer as last time means nothing changed; no need to diff
+  if (applied_bytes_ != nullptr && applied_bytes_ == bytes) {
+    if (diff != nullptr) {
+      *diff = {};
+    }
+    return {};
+  }
+
+  ConfigDiff changes;
+  s = Config::diff(applied_config_ ? *applied_config_ : synapse::DeviceConfiguration{}, *req, &changes);
+  if (!s.ok()) {
+    return s;
+  }
+
+  if (diff != nullptr) {
+    *diff = changes;
+  }
+
+  if (applied_config_ && changes.empty()) {
+    return {};
+  }
+
+  return send_configuration(config, timeout);
+}
+
+auto Device::send_configuration(Config* config,
+                                std::optional<std::chrono::milliseconds> timeout) -> science::Status {
+  std::shared_ptr<const synapse::DeviceConfiguration> proto;
+  std::shared_ptr<const std::string> bytes;
+  auto s = config->to_proto(&proto);
+  if (s.ok()) {
+    s = config->serialize(&bytes);
+  }
+  if (!s.ok()) {
+    return { s.code(), "failed to serialize config: " + s.message() };
+  }
+
   grpc::ClientContext context;
   if (timeout) {
     context.set_deadline(std::chrono::system_clock::now() + *timeout);
   }
 
-  synapse::DeviceConfiguration req = config->to_proto();
+  // Send the cached wire bytes as-is rather than re-serializing the message for every device
+  grpc::Slice slice(bytes->data(), bytes->size(), grpc::Slice::STATIC_SLICE);
+  grpc::ByteBuffer req(&slice, 1);
+  grpc::ByteBuffer res_buffer;
+  grpc::GenericStub generic(channel_);
+  const std::string method = std::string("/") + synapse::SynapseDevice::service_full_name() + "/Configure";
+
   synapse::Status res;
   science::Status status;
   bool done = false;
   std::mutex m;
   std::condition_variable cv;
 
-  rpc_->async()->Configure(
-    &context, &req, &res,
-    [this, &res, &status, &done, &m, &cv](grpc::Status gstatus) mutable {
+  generic.UnaryCall(
+    &context, method, grpc::StubOptions(), &req, &res_buffer,
+    [this, &res_buffer, &res, &status, &done, &m, &cv](grpc::Status gstatus) mutable {
       science::Status s;
       if (!gstatus.ok()) {
         s = { static_cast<science::StatusCode>(gstatus.error_code()), gstatus.error_message() };
       } else {
-        s = handle_status_response(res);
+        grpc::ProtoBufferReader reader(&res_buffer);
+        if (!res.ParseFromZeroCopyStream(&reader)) {
+          s = { science::StatusCode::kInternal, "failed to parse configure response" };
+        } else {
+          s = handle_status_response(res);
+        }
       }
 
       std::lock_guard<std::mutex> lock(m);
@@ -43,6 +139,14 @@ auto Device::configure(Config* config, std::optional<std::chrono::milliseconds>
 
   std::unique_lock<std::mutex> lock(m);
   cv.wait(lock, [&done] { return done; });
+
+  if (status.ok()) {
+    applied_config_ = proto;
+    applied_bytes_ = bytes;
+  } else {
+    applied_config_.reset();
+    applied_bytes_.reset();
+  }
   return status;
 }
 
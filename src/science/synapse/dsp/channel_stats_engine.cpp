@@ -0,0 +1,286 @@
+#include "science/synapse/dsp/channel_stats_engine.h"
+#include "science/synapse/dsp/simd_internal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace synapse {
+
+namespace {
+
+// Keeps the MAD estimate of a flat channel from reaching zero, where its relative steps would stall
+constexpr float kMinMad = 1e-3f;
+
+struct Estimators {
+  float* median;
+  float* mad;
+  float rate;
+};
+
+struct BlockSums {
+  const float* shift;
+  float* sum;
+  float* sum_sq;
+};
+
+void update_row_scalar(const float* row, const Estimators& est, const BlockSums& sums, size_t channel_begin,
+                       size_t channel_end) {
+  const float up = 1.0f + est.rate;
+  const float down = 1.0f - est.rate;
+  for (size_t c = channel_begin; c < channel_end; ++c) {
+    const float x = row[c];
+    const float d = x - sums.shift[c];
+    sums.sum[c] += d;
+    sums.sum_sq[c] += d * d;
+
+    // Half the samples above and half below is the only place both estimators stay put
+    const float m = est.median[c];
+    const float a = est.mad[c];
+    const float step = est.rate * a;
+    est.median[c] = m + (x > m ? step : (x < m ? -step : 0.0f));
+    est.mad[c] = std::max(a * (std::fabs(x - m) > a ? up : down), kMinMad);
+  }
+}
+
+#if SYNAPSE_HAS_X86_SIMD
+SYNAPSE_TARGET_AVX2
+void update_row_avx2(const float* row, const Estimators& est, const BlockSums& sums, size_t channel_begin,
+                     size_t channel_end) {
+  const size_t vector_end = channel_begin + (channel_end - channel_begin) / 8 * 8;
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 rate = _mm256_set1_ps(est.rate);
+  const __m256 up = _mm256_set1_ps(1.0f + est.rate);
+  const __m256 down = _mm256_set1_ps(1.0f - est.rate);
+  const __m256 min_mad = _mm256_set1_ps(kMinMad);
+
+  for (size_t c = channel_begin; c < vector_end; c += 8) {
+    const __m256 x = _mm256_loadu_ps(row + c);
+    const __m256 d = _mm256_sub_ps(x, _mm256_loadu_ps(sums.shift + c));
+    _mm256_storeu_ps(sums.sum + c, _mm256_add_ps(_mm256_loadu_ps(sums.sum + c), d));
+    _mm256_storeu_ps(sums.sum_sq + c, _mm256_add_ps(_mm256_loadu_ps(sums.sum_sq + c), _mm256_mul_ps(d, d)));
+
+    const __m256 m = _mm256_loadu_ps(est.median + c);
+    const __m256 a = _mm256_loadu_ps(est.mad + c);
+    const __m256 step = _mm256_mul_ps(rate, a);
+    __m256 delta = _mm256_blendv_ps(zero, step, _mm256_cmp_ps(x, m, _CMP_GT_OQ));
+    delta = _mm256_blendv_ps(delta, _mm256_xor_ps(step, sign), _mm256_cmp_ps(x, m, _CMP_LT_OQ));
+    _mm256_storeu_ps(est.median + c, _mm256_add_ps(m, delta));
+
+    const __m256 deviation = _mm256_andnot_ps(sign, _mm256_sub_ps(x, m));
+    const __m256 factor = _mm256_blendv_ps(down, up, _mm256_cmp_ps(deviation, a, _CMP_GT_OQ));
+    _mm256_storeu_ps(est.mad + c, _mm256_max_ps(_mm256_mul_ps(a, factor), min_mad));
+  }
+
+  update_row_scalar(row, est, sums, vector_end, channel_end);
+}
+#endif
+
+}  // namespace
+
+ChannelStatsEngine::ChannelStatsEngine(size_t num_channels, const ChannelStatsOptions& options)
+  : num_channels_(num_channels),
+    options_(options),
+    simd_level_(detect_simd_level()),
+    count_(num_channels, 0),
+    weight_(num_channels, 0.0),
+    mean_(num_channels, 0.0),
+    m2_(num_channels, 0.0),
+    median_(num_channels, 0.0f),
+    mad_(num_channels, kMinMad),
+    shift_(num_channels, 0.0f),
+    block_sum_(num_channels, 0.0f),
+    block_sum_sq_(num_channels, 0.0f) {}
+
+auto ChannelStatsEngine::create(
+  size_t num_channels,
+  std::unique_ptr<ChannelStatsEngine>* engine,
+  const ChannelStatsOptions& options
+) -> science::Status {
+  if (engine == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "engine ptr must not be null" };
+  }
+  if (num_channels == 0) {
+    return { science::StatusCode::kInvalidArgument, "num channels must be positive" };
+  }
+  if (options.time_constant_s < 0) {
+    return { science::StatusCode::kInvalidArgument, "time constant must not be negative" };
+  }
+  if (!(options.quantile_rate > 0 && options.quantile_rate < 0.5f)) {
+    return { science::StatusCode::kInvalidArgument, "quantile rate must be in (0, 0.5)" };
+  }
+
+  engine->reset(new ChannelStatsEngine(num_channels, options));
+  return {};
+}
+
+auto ChannelStatsEngine::process(const SampleBlock& block, WorkStealingPool* pool) -> science::Status {
+  if (block.num_channels != num_channels_) {
+    return {
+      science::StatusCode::kInvalidArgument,
+      "block has " + std::to_string(block.num_channels) + " channels, engine expects " +
+        std::to_string(num_channels_)
+    };
+  }
+  if (block.num_samples == 0) {
+    return {};
+  }
+
+  double decay = 1.0;
+  if (options_.time_constant_s > 0 && block.sample_rate_hz > 0) {
+    decay = std::exp(-static_cast<double>(block.num_samples) / (options_.time_constant_s * block.sample_rate_hz));
+  }
+
+  if (pool == nullptr) {
+    process_channels(block, 0, num_channels_, decay);
+    return {};
+  }
+
+  pool->parallel_for(0, num_channels_, pool->channel_grain(num_channels_), [this, &block, decay](size_t begin,
+                                                                                                 size_t end) {
+    process_channels(block, begin, end, decay);
+  });
+  return {};
+}
+
+void ChannelStatsEngine::process_channels(const SampleBlock& block, size_t channel_begin, size_t channel_end,
+                                          double decay) {
+  seed_channels(block, channel_begin, channel_end);
+  std::fill(block_sum_.begin() + channel_begin, block_sum_.begin() + channel_end, 0.0f);
+  std::fill(block_sum_sq_.begin() + channel_begin, block_sum_sq_.begin() + channel_end, 0.0f);
+
+  auto* row_kernel = &update_row_scalar;
+#if SYNAPSE_HAS_X86_SIMD
+  if (simd_level_ == SimdLevel::kAvx2) {
+    row_kernel = &update_row_avx2;
+  }
+#endif
+
+  const Estimators est = { median_.data(), mad_.data(), options_.quantile_rate };
+  const BlockSums sums = { shift_.data(), block_sum_.data(), block_sum_sq_.data() };
+  for (size_t t = 0; t < block.num_samples; ++t) {
+    row_kernel(block.row(t), est, sums, channel_begin, channel_end);
+  }
+
+  // Merge the block into the running moments (Chan et al.), after decaying the old ones
+  const double n = static_cast<double>(block.num_samples);
+  for (size_t c = channel_begin; c < channel_end; ++c) {
+    const double block_mean = shift_[c] + block_sum_[c] / n;
+    const double block_m2 = std::max(0.0, block_sum_sq_[c] - static_cast<double>(block_sum_[c]) * block_sum_[c] / n);
+
+    const double weight = weight_[c] * decay;
+    const double total = weight + n;
+    const double delta = block_mean - mean_[c];
+    mean_[c] += delta * n / total;
+    m2_[c] = m2_[c] * decay + block_m2 + delta * delta * weight * n / total;
+    weight_[c] = total;
+    count_[c] += block.num_samples;
+    shift_[c] = static_cast<float>(mean_[c]);
+  }
+}
+
+void ChannelStatsEngine::seed_channels(const SampleBlock& block, size_t channel_begin, size_t channel_end) {
+  std::vector<float> column;
+  for (size_t c = channel_begin; c < channel_end; ++c) {
+    if (count_[c] > 0) {
+      continue;
+    }
+
+    column.resize(block.num_samples);
+    for (size_t t = 0; t < block.num_samples; ++t) {
+      column[t] = block.at(t, c);
+    }
+    const auto middle = column.begin() + column.size() / 2;
+    std::nth_element(column.begin(), middle, column.end());
+    const float median = *middle;
+    for (auto& x : column) {
+      x = std::fabs(x - median);
+    }
+    std::nth_element(column.begin(), middle, column.end());
+
+    median_[c] = median;
+    mad_[c] = std::max(*middle, kMinMad);
+    shift_[c] = median;
+  }
+}
+
+auto ChannelStatsEngine::stats(size_t channel) const -> ChannelStats {
+  ChannelStats stats;
+  if (channel >= num_channels_ || count_[channel] == 0) {
+    return stats;
+  }
+
+  const double variance = m2_[channel] / weight_[channel];
+  stats.count = count_[channel];
+  stats.mean = static_cast<float>(mean_[channel]);
+  stats.variance = static_cast<float>(variance);
+  stats.rms = static_cast<float>(std::sqrt(variance + mean_[channel] * mean_[channel]));
+  stats.median = median_[channel];
+  stats.mad = mad_[channel];
+  return stats;
+}
+
+void ChannelStatsEngine::all_stats(std::vector<ChannelStats>* stats) const {
+  if (stats == nullptr) {
+    return;
+  }
+  stats->resize(num_channels_);
+  for (size_t c = 0; c < num_channels_; ++c) {
+    (*stats)[c] = this->stats(c);
+  }
+}
+
+void ChannelStatsEngine::channel_thresholds_uv(std::vector<float>* thresholds_uv, float multiplier) const {
+  if (thresholds_uv == nullptr) {
+    return;
+  }
+  thresholds_uv->resize(num_channels_);
+  for (size_t c = 0; c < num_channels_; ++c) {
+    (*thresholds_uv)[c] = count_[c] > 0 ? multiplier * stats(c).noise() : 0.0f;
+  }
+}
+
+auto ChannelStatsEngine::suggest_threshold_uv(float* threshold_uv, float multiplier) const -> science::Status {
+  if (threshold_uv == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "threshold ptr must not be null" };
+  }
+
+  std::vector<float> thresholds;
+  for (size_t c = 0; c < num_channels_; ++c) {
+    if (count_[c] > 0) {
+      thresholds.push_back(multiplier * stats(c).noise());
+    }
+  }
+  if (thresholds.empty()) {
+    return { science::StatusCode::kUnavailable, "no data processed yet" };
+  }
+
+  const auto middle = thresholds.begin() + thresholds.size() / 2;
+  std::nth_element(thresholds.begin(), middle, thresholds.end());
+  *threshold_uv = *middle;
+  return {};
+}
+
+void ChannelStatsEngine::reset() {
+  std::fill(count_.begin(), count_.end(), 0);
+  std::fill(weight_.begin(), weight_.end(), 0.0);
+  std::fill(mean_.begin(), mean_.end(), 0.0);
+  std::fill(m2_.begin(), m2_.end(), 0.0);
+  std::fill(median_.begin(), median_.end(), 0.0f);
+  std::fill(mad_.begin(), mad_.end(), kMinMad);
+  std::fill(shift_.begin(), shift_.end(), 0.0f);
+}
+
+void ChannelStatsEngine::set_simd_level(SimdLevel level) {
+  if (level == SimdLevel::kAvx2 && detect_simd_level() != SimdLevel::kAvx2) {
+    level = SimdLevel::kScalar;
+  }
+  simd_level_ = level;
+}
+
+auto ChannelStatsEngine::num_channels() const -> size_t {
+  return num_channels_;
+}
+
+}  // namespace synapse
@@ -0,0 +1,455 @@
+#include "science/synapse/dsp/envelope_pyramid.h"
+#include "science/synapse/dsp/simd_internal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+namespace synapse {
+
+namespace {
+
+// Levels are added until the top one has about this many bins over the history
+constexpr size_t kTopLevelBins = 16;
+
+// Pixels drawn together by the all-channel query, so each channel's output is written in runs
+constexpr size_t kQueryTilePixels = 64;
+
+constexpr float kInf = std::numeric_limits<float>::infinity();
+
+void clear_pending(float* min, float* max, float* sum, size_t n) {
+  std::fill(min, min + n, kInf);
+  std::fill(max, max + n, -kInf);
+  std::fill(sum, sum + n, 0.0f);
+}
+
+void accumulate_row_scalar(const float* row, float* min, float* max, float* sum, size_t begin, size_t n) {
+  for (size_t c = begin; c < n; ++c) {
+    min[c] = std::min(min[c], row[c]);
+    max[c] = std::max(max[c], row[c]);
+    sum[c] += row[c];
+  }
+}
+
+// Writes a pending bin out as a completed one, and merges it into the next level's pending bin
+struct BinOutput {
+  float* min;
+  float* max;
+  float* mean;
+  float* next_min;  // null at the top level
+  float* next_max;
+  float* next_sum;
+};
+
+void finish_bin_scalar(const float* min, const float* max, const float* sum, float scale, const BinOutput& out,
+                       size_t begin, size_t n) {
+  for (size_t c = begin; c < n; ++c) {
+    const float mean = sum[c] * scale;
+    out.min[c] = min[c];
+    out.max[c] = max[c];
+    out.mean[c] = mean;
+    if (out.next_min != nullptr) {
+      out.next_min[c] = std::min(out.next_min[c], min[c]);
+      out.next_max[c] = std::max(out.next_max[c], max[c]);
+      out.next_sum[c] += mean;
+    }
+  }
+}
+
+// Folds a row of completed bins, weighted by their width, into a row of per-channel totals
+void combine_row_scalar(const float* min, const float* max, const float* mean, float width, float* acc_min,
+                        float* acc_max, float* acc_sum, size_t begin, size_t n) {
+  for (size_t c = begin; c < n; ++c) {
+    acc_min[c] = std::min(acc_min[c], min[c]);
+    acc_max[c] = std::max(acc_max[c], max[c]);
+    acc_sum[c] += mean[c] * width;
+  }
+}
+
+#if SYNAPSE_HAS_X86_SIMD
+SYNAPSE_TARGET_AVX2
+void combine_row_avx2(const float* min, const float* max, const float* mean, float width, float* acc_min,
+                      float* acc_max, float* acc_sum, size_t begin, size_t n) {
+  const size_t vector_end = begin + (n - begin) / 8 * 8;
+  const __m256 w = _mm256_set1_ps(width);
+  for (size_t c = begin; c < vector_end; c += 8) {
+    _mm256_storeu_ps(acc_min + c, _mm256_min_ps(_mm256_loadu_ps(acc_min + c), _mm256_loadu_ps(min + c)));
+    _mm256_storeu_ps(acc_max + c, _mm256_max_ps(_mm256_loadu_ps(acc_max + c), _mm256_loadu_ps(max + c)));
+    _mm256_storeu_ps(acc_sum + c, _mm256_fmadd_ps(_mm256_loadu_ps(mean + c), w, _mm256_loadu_ps(acc_sum + c)));
+  }
+  combine_row_scalar(min, max, mean, width, acc_min, acc_max, acc_sum, vector_end, n);
+}
+
+SYNAPSE_TARGET_AVX2
+void accumulate_row_avx2(const float* row, float* min, float* max, float* sum, size_t begin, size_t n) {
+  const size_t vector_end = begin + (n - begin) / 8 * 8;
+  for (size_t c = begin; c < vector_end; c += 8) {
+    const __m256 x = _mm256_loadu_ps(row + c);
+    _mm256_storeu_ps(min + c, _mm256_min_ps(_mm256_loadu_ps(min + c), x));
+    _mm256_storeu_ps(max + c, _mm256_max_ps(_mm256_loadu_ps(max + c), x));
+    _mm256_storeu_ps(sum + c, _mm256_add_ps(_mm256_loadu_ps(sum + c), x));
+  }
+  accumulate_row_scalar(row, min, max, sum, vector_end, n);
+}
+
+SYNAPSE_TARGET_AVX2
+void finish_bin_avx2(const float* min, const float* max, const float* sum, float scale, const BinOutput& out,
+                     size_t begin, size_t n) {
+  const size_t vector_end = begin + (n - begin) / 8 * 8;
+  const __m256 factor = _mm256_set1_ps(scale);
+  for (size_t c = begin; c < vector_end; c += 8) {
+    const __m256 lo = _mm256_loadu_ps(min + c);
+    const __m256 hi = _mm256_loadu_ps(max + c);
+    const __m256 mean = _mm256_mul_ps(_mm256_loadu_ps(sum + c), factor);
+    _mm256_storeu_ps(out.min + c, lo);
+    _mm256_storeu_ps(out.max + c, hi);
+    _mm256_storeu_ps(out.mean + c, mean);
+    if (out.next_min != nullptr) {
+      _mm256_storeu_ps(out.next_min + c, _mm256_min_ps(_mm256_loadu_ps(out.next_min + c), lo));
+      _mm256_storeu_ps(out.next_max + c, _mm256_max_ps(_mm256_loadu_ps(out.next_max + c), hi));
+      _mm256_storeu_ps(out.next_sum + c, _mm256_add_ps(_mm256_loadu_ps(out.next_sum + c), mean));
+    }
+  }
+  finish_bin_scalar(min, max, sum, scale, out, vector_end, n);
+}
+#endif
+
+}  // namespace
+
+struct EnvelopePyramid::Accumulator {
+  float min = kInf;
+  float max = -kInf;
+  double weighted_sum = 0;
+  uint64_t weight = 0;
+};
+
+struct EnvelopePyramid::RowAccumulator {
+  float* min;
+  float* max;
+  float* weighted_sum;
+  uint64_t weight;
+  decltype(&combine_row_scalar) kernel;
+};
+
+EnvelopePyramid::EnvelopePyramid(size_t num_channels, float sample_rate_hz)
+  : num_channels_(num_channels),
+    sample_rate_hz_(sample_rate_hz),
+    simd_level_(detect_simd_level()),
+    position_(0),
+    start_timestamp_ns_(0) {}
+
+auto EnvelopePyramid::create(
+  size_t num_channels,
+  float sample_rate_hz,
+  std::unique_ptr<EnvelopePyramid>* pyramid,
+  const EnvelopePyramidOptions& options
+) -> science::Status {
+  if (pyramid == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "pyramid ptr must not be null" };
+  }
+  if (num_channels == 0) {
+    return { science::StatusCode::kInvalidArgument, "num channels must be positive" };
+  }
+  if (!(sample_rate_hz > 0)) {
+    return { science::StatusCode::kInvalidArgument, "sample rate must be positive" };
+  }
+  if (options.base_bin_samples == 0) {
+    return { science::StatusCode::kInvalidArgument, "base bin samples must be positive" };
+  }
+  if (options.fanout < 2) {
+    return { science::StatusCode::kInvalidArgument, "fanout must be at least 2" };
+  }
+
+  const auto history_samples = static_cast<uint64_t>(std::ceil(options.history_s * sample_rate_hz));
+  if (!(options.history_s > 0) || history_samples < options.base_bin_samples) {
+    return { science::StatusCode::kInvalidArgument, "history must hold at least one base bin" };
+  }
+
+  std::unique_ptr<EnvelopePyramid> result(new EnvelopePyramid(num_channels, sample_rate_hz));
+  uint64_t bin_samples = options.base_bin_samples;
+  for (;;) {
+    Level level;
+    level.bin_samples = bin_samples;
+    // One spare bin, so the ring still spans the whole history while its newest bin fills
+    level.capacity = static_cast<size_t>((history_samples + bin_samples - 1) / bin_samples) + 1;
+    level.min.resize(level.capacity * num_channels);
+    level.max.resize(level.capacity * num_channels);
+    level.mean.resize(level.capacity * num_channels);
+    level.pending_min.resize(num_channels);
+    level.pending_max.resize(num_channels);
+    level.pending_sum.resize(num_channels);
+    result->levels_.push_back(std::move(level));
+
+    if (result->levels_.back().capacity <= kTopLevelBins) {
+      break;
+    }
+    bin_samples *= options.fanout;
+  }
+  result->reset();
+
+  *pyramid = std::move(result);
+  return {};
+}
+
+void EnvelopePyramid::reset() {
+  position_ = 0;
+  start_timestamp_ns_ = 0;
+  for (auto& level : levels_) {
+    level.written = 0;
+    level.pending_count = 0;
+    clear_pending(level.pending_min.data(), level.pending_max.data(), level.pending_sum.data(), num_channels_);
+  }
+}
+
+void EnvelopePyramid::set_simd_level(SimdLevel level) {
+  if (level == SimdLevel::kAvx2 && detect_simd_level() != SimdLevel::kAvx2) {
+    level = SimdLevel::kScalar;
+  }
+  simd_level_ = level;
+}
+
+auto EnvelopePyramid::process(const SampleBlock& block) -> science::Status {
+  if (block.num_channels != num_channels_) {
+    return {
+      science::StatusCode::kInvalidArgument,
+      "block has " + std::to_string(block.num_channels) + " channels, pyramid expects " +
+        std::to_string(num_channels_)
+    };
+  }
+  if (block.num_samples == 0) {
+    return {};
+  }
+  if (position_ == 0) {
+    start_timestamp_ns_ = block.start_timestamp_ns;
+  }
+
+  auto* row_kernel = &accumulate_row_scalar;
+#if SYNAPSE_HAS_X86_SIMD
+  if (simd_level_ == SimdLevel::kAvx2) {
+    row_kernel = &accumulate_row_avx2;
+  }
+#endif
+
+  auto& base = levels_.front();
+  for (size_t t = 0; t < block.num_samples; ++t) {
+    row_kernel(block.row(t), base.pending_min.data(), base.pending_max.data(), base.pending_sum.data(), 0,
+               num_channels_);
+    if (++base.pending_count == base.bin_samples) {
+      finish_bin(0);
+    }
+  }
+  position_ += block.num_samples;
+  return {};
+}
+
+void EnvelopePyramid::finish_bin(size_t level) {
+  auto& current = levels_[level];
+  const size_t offset = (current.written % current.capacity) * num_channels_;
+  Level* next = level + 1 < levels_.size() ? &levels_[level + 1] : nullptr;
+
+  const BinOutput out = {
+    current.min.data() + offset, current.max.data() + offset, current.mean.data() + offset,
+    next != nullptr ? next->pending_min.data() : nullptr,
+    next != nullptr ? next->pending_max.data() : nullptr,
+    next != nullptr ? next->pending_sum.data() : nullptr,
+  };
+  const float scale = 1.0f / static_cast<float>(current.pending_count);
+
+  auto* bin_kernel = &finish_bin_scalar;
+#if SYNAPSE_HAS_X86_SIMD
+  if (simd_level_ == SimdLevel::kAvx2) {
+    bin_kernel = &finish_bin_avx2;
+  }
+#endif
+  bin_kernel(current.pending_min.data(), current.pending_max.data(), current.pending_sum.data(), scale, out, 0,
+             num_channels_);
+
+  clear_pending(current.pending_min.data(), current.pending_max.data(), current.pending_sum.data(), num_channels_);
+  current.pending_count = 0;
+  current.written++;
+
+  // Each level's bins are a whole number of the level below's, so completions cascade
+  if (next != nullptr && ++next->pending_count == next->bin_samples / current.bin_samples) {
+    finish_bin(level + 1);
+  }
+}
+
+auto EnvelopePyramid::query(
+  size_t channel,
+  uint64_t begin_sample,
+  uint64_t end_sample,
+  size_t pixels,
+  std::vector<EnvelopeBin>* out
+) const -> science::Status {
+  if (out == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "out ptr must not be null" };
+  }
+  if (channel >= num_channels_) {
+    return {
+      science::StatusCode::kOutOfRange,
+      "channel " + std::to_string(channel) + " out of range for " + std::to_string(num_channels_) + " channels"
+    };
+  }
+  if (begin_sample >= end_sample) {
+    return { science::StatusCode::kInvalidArgument, "range must not be empty" };
+  }
+  if (pixels == 0) {
+    return { science::StatusCode::kInvalidArgument, "pixels must be positive" };
+  }
+
+  const size_t level = query_level(begin_sample, end_sample, pixels);
+  const uint64_t span = end_sample - begin_sample;
+  const uint64_t samples_per_pixel = span / pixels;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const uint64_t remainder = span % pixels;
+  out->resize(pixels);
+  for (size_t p = 0; p < pixels; ++p) {
+    // Pixel edges without overflow: begin + span * p / pixels
+    const uint64_t begin = begin_sample + samples_per_pixel * p + remainder * p / pixels;
+    const uint64_t end = begin_sample + samples_per_pixel * (p + 1) + remainder * (p + 1) / pixels;
+
+    Accumulator acc;
+    accumulate(level, channel, begin, end, &acc);
+    if (acc.weight == 0) {
+      (*out)[p] = { nan, nan, nan };
+    } else {
+      (*out)[p] = { acc.min, acc.max, static_cast<float>(acc.weighted_sum / acc.weight) };
+    }
+  }
+  return {};
+}
+
+auto EnvelopePyramid::query(uint64_t begin_sample, uint64_t end_sample, size_t pixels, std::vector<EnvelopeBin>* out)
+  const -> science::Status {
+  if (out == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "out ptr must not be null" };
+  }
+  if (begin_sample >= end_sample) {
+    return { science::StatusCode::kInvalidArgument, "range must not be empty" };
+  }
+  if (pixels == 0) {
+    return { science::StatusCode::kInvalidArgument, "pixels must be positive" };
+  }
+
+  const size_t level = query_level(begin_sample, end_sample, pixels);
+  const uint64_t span = end_sample - begin_sample;
+  const uint64_t samples_per_pixel = span / pixels;
+  const uint64_t remainder = span % pixels;
+
+  auto* kernel = &combine_row_scalar;
+#if SYNAPSE_HAS_X86_SIMD
+  if (simd_level_ == SimdLevel::kAvx2) {
+    kernel = &combine_row_avx2;
+  }
+#endif
+
+  // Per-pixel rows of channel totals for one tile of pixels
+  std::vector<float> tile_min(kQueryTilePixels * num_channels_);
+  std::vector<float> tile_max(kQueryTilePixels * num_channels_);
+  std::vector<float> tile_sum(kQueryTilePixels * num_channels_);
+  std::vector<uint64_t> tile_weight(kQueryTilePixels);
+
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  out->resize(pixels * num_channels_);
+  for (size_t tile = 0; tile < pixels; tile += kQueryTilePixels) {
+    const size_t tile_pixels = std::min(kQueryTilePixels, pixels - tile);
+    for (size_t i = 0; i < tile_pixels; ++i) {
+      const size_t p = tile + i;
+      const uint64_t begin = begin_sample + samples_per_pixel * p + remainder * p / pixels;
+      const uint64_t end = begin_sample + samples_per_pixel * (p + 1) + remainder * (p + 1) / pixels;
+
+      const size_t offset = i * num_channels_;
+      RowAccumulator acc = { tile_min.data() + offset, tile_max.data() + offset, tile_sum.data() + offset, 0, kernel };
+      clear_pending(acc.min, acc.max, acc.weighted_sum, num_channels_);
+      accumulate(level, begin, end, &acc);
+      tile_weight[i] = acc.weight;
+    }
+
+    for (size_t c = 0; c < num_channels_; ++c) {
+      EnvelopeBin* row = out->data() + c * pixels + tile;
+      for (size_t i = 0; i < tile_pixels; ++i) {
+        const size_t index = i * num_channels_ + c;
+        row[i] = tile_weight[i] > 0
+          ? EnvelopeBin{ tile_min[index], tile_max[index], tile_sum[index] / static_cast<float>(tile_weight[i]) }
+          : EnvelopeBin{ nan, nan, nan };
+      }
+    }
+  }
+  return {};
+}
+
+auto EnvelopePyramid::query_level(uint64_t begin_sample, uint64_t end_sample, size_t pixels) const -> size_t {
+  // The coarsest level with at least one bin per pixel
+  const uint64_t samples_per_pixel = (end_sample - begin_sample) / pixels;
+  size_t level = 0;
+  while (level + 1 < levels_.size() && levels_[level + 1].bin_samples <= samples_per_pixel) {
+    level++;
+  }
+  return level;
+}
+
+void EnvelopePyramid::accumulate(size_t level, size_t channel, uint64_t begin, uint64_t end, Accumulator* acc) const {
+  const auto& current = levels_[level];
+  const uint64_t width = current.bin_samples;
+  const uint64_t complete_end = current.written * width;
+  const uint64_t oldest = current.written > current.capacity ? (current.written - current.capacity) * width : 0;
+
+  // Every bin overlapping the range, so no pixel comes up empty between bins
+  const uint64_t first = std::max(begin, oldest);
+  const uint64_t last = std::min(end, complete_end);
+  if (first < last) {
+    for (uint64_t bin = first / width; bin <= (last - 1) / width; ++bin) {
+      const size_t index = (bin % current.capacity) * num_channels_ + channel;
+      acc->min = std::min(acc->min, current.min[index]);
+      acc->max = std::max(acc->max, current.max[index]);
+      acc->weighted_sum += static_cast<double>(current.mean[index]) * width;
+      acc->weight += width;
+    }
+  }
+
+  // The newest samples are only in finer levels' bins so far
+  if (end > complete_end && level > 0) {
+    accumulate(level - 1, channel, std::max(begin, complete_end), end, acc);
+  }
+}
+
+void EnvelopePyramid::accumulate(size_t level, uint64_t begin, uint64_t end, RowAccumulator* acc) const {
+  const auto& current = levels_[level];
+  const uint64_t width = current.bin_samples;
+  const uint64_t complete_end = current.written * width;
+  const uint64_t oldest = current.written > current.capacity ? (current.written - current.capacity) * width : 0;
+
+  const uint64_t first = std::max(begin, oldest);
+  const uint64_t last = std::min(end, complete_end);
+  if (first < last) {
+    for (uint64_t bin = first / width; bin <= (last - 1) / width; ++bin) {
+      const size_t offset = (bin % current.capacity) * num_channels_;
+      acc->kernel(current.min.data() + offset, current.max.data() + offset, current.mean.data() + offset,
+                  static_cast<float>(width), acc->min, acc->max, acc->weighted_sum, 0, num_channels_);
+      acc->weight += width;
+    }
+  }
+
+  if (end > complete_end && level > 0) {
+    accumulate(level - 1, std::max(begin, complete_end), end, acc);
+  }
+}
+
+auto EnvelopePyramid::sample_at(uint64_t timestamp_ns) const -> uint64_t {
+  if (timestamp_ns <= start_timestamp_ns_) {
+    return 0;
+  }
+  return static_cast<uint64_t>(static_cast<double>(timestamp_ns - start_timestamp_ns_) * sample_rate_hz_ / 1e9);
+}
+
+auto EnvelopePyramid::memory_bytes() const -> size_t {
+  size_t bytes = 0;
+  for (const auto& level : levels_) {
+    bytes += (level.min.size() + level.max.size() + level.mean.size()) * sizeof(float);
+    bytes += (level.pending_min.size() + level.pending_max.size() + level.pending_sum.size()) * sizeof(float);
+  }
+  return bytes;
+}
+
+}  // namespace synapse
@@ -0,0 +1,451 @@
+#include "science/synapse/dsp/pipeline.h"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+
+#include "science/synapse/dsp/spectral_filter_engine.h"
+#include "science/synapse/dsp/spike_detector_engine.h"
+#include "science/synapse/nodes/spectral_filter.h"
+#include "science/synapse/nodes/spike_binner.h"
+#include "science/synapse/nodes/spike_detector.h"
+
+namespace synapse {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+auto end_timestamp_ns(const SampleBlock& block) -> uint64_t {
+  if (block.sample_rate_hz <= 0) {
+    return block.start_timestamp_ns;
+  }
+  return block.start_timestamp_ns + static_cast<uint64_t>(block.num_samples * 1e9 / block.sample_rate_hz);
+}
+
+auto num_items(const PipelineData& data) -> uint64_t {
+  if (const auto* block = std::get_if<SampleBlock>(&data)) {
+    return block->num_samples * block->num_channels;
+  }
+  if (const auto* spikes = std::get_if<SpikeBatch>(&data)) {
+    return spikes->events.size();
+  }
+  uint64_t bins = 0;
+  for (const auto& counts : std::get<std::vector<SpikeCounts>>(data)) {
+    bins += counts.num_bins;
+  }
+  return bins;
+}
+
+}  // namespace
+
+struct Pipeline::Packet {
+  std::shared_ptr<const PipelineData> data;
+  Clock::time_point enqueued;
+};
+
+struct Pipeline::Stage {
+  std::shared_ptr<Node> node;
+  std::vector<Stage*> consumers;
+  OutputCallback callback;
+  WorkStealingPool* pool = nullptr;
+
+  // Guarded by Pipeline::mutex_
+  std::deque<Packet> inbox;
+  size_t reserved = 0;
+  bool running = false;
+  StageMetrics metrics;
+
+  // Only touched by the worker running the stage
+  std::unique_ptr<SpectralFilterEngine> filter;
+  std::unique_ptr<SpikeDetectorEngine> detector;
+  std::unique_ptr<SpikeBinnerEngine> binner;
+
+  auto process(const PipelineData& in, std::shared_ptr<const PipelineData>* out) -> science::Status;
+  auto filter_block(const SampleBlock& block, std::shared_ptr<const PipelineData>* out) -> science::Status;
+  auto detect_spikes(const SampleBlock& block, std::shared_ptr<const PipelineData>* out) -> science::Status;
+  auto bin_spikes(const SpikeBatch& spikes, std::shared_ptr<const PipelineData>* out) -> science::Status;
+};
+
+auto Pipeline::Stage::process(const PipelineData& in, std::shared_ptr<const PipelineData>* out) -> science::Status {
+  const auto* block = std::get_if<SampleBlock>(&in);
+  const auto* spikes = std::get_if<SpikeBatch>(&in);
+
+  switch (node->type()) {
+    case synapse::NodeType::kSpectralFilter:
+      if (block == nullptr) {
+        return { science::StatusCode::kInvalidArgument, "spectral filter expects broadband input" };
+      }
+      return filter_block(*block, out);
+
+    case synapse::NodeType::kSpikeDetector:
+      if (block == nullptr) {
+        return { science::StatusCode::kInvalidArgument, "spike detector expects broadband input" };
+      }
+      return detect_spikes(*block, out);
+
+    case synapse::NodeType::kSpikeBinner:
+      if (spikes == nullptr) {
+        return { science::StatusCode::kInvalidArgument, "spike binner expects spike input" };
+      }
+      return bin_spikes(*spikes, out);
+
+    default:
+      return { science::StatusCode::kUnimplemented, "no host stage for node type " + std::to_string(node->type()) };
+  }
+}
+
+auto Pipeline::Stage::filter_block(const SampleBlock& block, std::shared_ptr<const PipelineData>* out)
+    -> science::Status {
+  if (filter == nullptr) {
+    const auto& config = static_cast<const SpectralFilter&>(*node);
+    auto s = SpectralFilterEngine::create(config, block.sample_rate_hz, block.num_channels, &filter);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
+  auto result = std::make_shared<PipelineData>(block);
+  auto s = filter->process(&std::get<SampleBlock>(*result), pool);
+  if (!s.ok()) {
+    return s;
+  }
+  *out = std::move(result);
+  return {};
+}
+
+auto Pipeline::Stage::detect_spikes(const SampleBlock& block, std::shared_ptr<const PipelineData>* out)
+    -> science::Status {
+  if (detector == nullptr) {
+    const auto& config = static_cast<const SpikeDetector&>(*node);
+    auto s = SpikeDetectorEngine::create(config, block.num_channels, &detector);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
+  SpikeBatch result;
+  result.num_channels = block.num_channels;
+  result.start_timestamp_ns = block.start_timestamp_ns;
+  result.end_timestamp_ns = end_timestamp_ns(block);
+  auto s = detector->process(block, &result.events, pool);
+  if (!s.ok()) {
+    return s;
+  }
+  *out = std::make_shared<PipelineData>(std::move(result));
+  return {};
+}
+
+auto Pipeline::Stage::bin_spikes(const SpikeBatch& spikes, std::shared_ptr<const PipelineData>* out)
+    -> science::Status {
+  if (binner == nullptr) {
+    if (spikes.num_channels == 0) {
+      return { science::StatusCode::kInvalidArgument, "spike batch must set num_channels" };
+    }
+    const auto& config = static_cast<const SpikeBinner&>(*node);
+    auto s = SpikeBinnerEngine::create(config, spikes.num_channels, &binner);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
+  binner->add(spikes.events);
+
+  std::vector<SpikeCounts> counts;
+  auto s = binner->take(spikes.end_timestamp_ns, &counts);
+  if (!s.ok()) {
+    return s;
+  }
+
+  // Only pass on complete bins
+  bool any = std::any_of(counts.begin(), counts.end(), [](const SpikeCounts& c) { return c.num_bins > 0; });
+  if (any) {
+    *out = std::make_shared<PipelineData>(std::move(counts));
+  }
+  return {};
+}
+
+Pipeline::Pipeline(size_t num_workers, size_t queue_capacity)
+  : num_workers_(num_workers), queue_capacity_(queue_capacity) {}
+
+Pipeline::~Pipeline() {
+  stop();
+}
+
+auto Pipeline::create(
+  const Config& config,
+  std::unique_ptr<Pipeline>* pipeline,
+  size_t num_workers,
+  size_t queue_capacity
+) -> science::Status {
+  if (pipeline == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "pipeline ptr must not be null" };
+  }
+
+  if (queue_capacity == 0) {
+    return { science::StatusCode::kInvalidArgument, "queue capacity must be positive" };
+  }
+
+  std::vector<uint32_t> order;
+  auto s = config.topological_sort(&order);
+  if (!s.ok()) {
+    return s;
+  }
+
+  if (num_workers == 0) {
+    num_workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  std::unique_ptr<Pipeline> result(new Pipeline(num_workers, queue_capacity));
+  for (auto id : order) {
+    auto node = config.node(id);
+    switch (node->type()) {
+      case synapse::NodeType::kBroadbandSource:
+      case synapse::NodeType::kSpikeSource:
+        result->sources_[id].first = node->type();
+        break;
+
+      case synapse::NodeType::kSpectralFilter:
+      case synapse::NodeType::kSpikeDetector:
+      case synapse::NodeType::kSpikeBinner: {
+        auto stage = std::make_unique<Stage>();
+        stage->node = node;
+        stage->metrics.node_id = id;
+        stage->metrics.type = node->type();
+        result->stage_index_[id] = stage.get();
+        result->stages_.push_back(std::move(stage));
+        break;
+      }
+
+      default:
+        // Sinks have no host equivalent
+        break;
+    }
+  }
+
+  for (const auto& [src, dst] : config.connections()) {
+    auto consumer = result->stage_index_.find(dst);
+    if (consumer == result->stage_index_.end()) {
+      continue;
+    }
+
+    auto source = result->sources_.find(src);
+    if (source != result->sources_.end()) {
+      source->second.second.push_back(consumer->second);
+      continue;
+    }
+
+    auto producer = result->stage_index_.find(src);
+    if (producer != result->stage_index_.end()) {
+      producer->second->consumers.push_back(consumer->second);
+    }
+  }
+
+  *pipeline = std::move(result);
+  return {};
+}
+
+auto Pipeline::on_output(uint32_t node_id, OutputCallback callback) -> science::Status {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return { science::StatusCode::kFailedPrecondition, "output callbacks must be set before start()" };
+  }
+
+  auto it = stage_index_.find(node_id);
+  if (it == stage_index_.end()) {
+    return { science::StatusCode::kNotFound, "no stage for node " + std::to_string(node_id) };
+  }
+
+  it->second->callback = std::move(callback);
+  return {};
+}
+
+auto Pipeline::set_channel_pool(std::shared_ptr<WorkStealingPool> pool) -> science::Status {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return { science::StatusCode::kFailedPrecondition, "channel pool must be set before start()" };
+  }
+
+  channel_pool_ = std::move(pool);
+  for (auto& stage : stages_) {
+    stage->pool = channel_pool_.get();
+  }
+  return {};
+}
+
+auto Pipeline::start() -> science::Status {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return { science::StatusCode::kFailedPrecondition, "pipeline already running" };
+  }
+
+  running_ = true;
+  stopping_ = false;
+  for (size_t i = 0; i < num_workers_; ++i) {
+    workers_.emplace_back(&Pipeline::run_worker, this);
+  }
+  return {};
+}
+
+void Pipeline::stop() {
+  drain();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    stopping_ = true;
+  }
+  cv_.notify_all();
+
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_ = false;
+}
+
+auto Pipeline::push(uint32_t source_id, SampleBlock block) -> science::Status {
+  return push(source_id, synapse::NodeType::kBroadbandSource, PipelineData(std::move(block)));
+}
+
+auto Pipeline::push(uint32_t source_id, SpikeBatch spikes) -> science::Status {
+  return push(source_id, synapse::NodeType::kSpikeSource, PipelineData(std::move(spikes)));
+}
+
+auto Pipeline::push(uint32_t source_id, synapse::NodeType source_type, PipelineData data) -> science::Status {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = sources_.find(source_id);
+  if (it == sources_.end() || it->second.first != source_type) {
+    return {
+      science::StatusCode::kNotFound,
+      "no " + synapse::NodeType_Name(source_type) + " node with id " + std::to_string(source_id)
+    };
+  }
+
+  // Nothing would drain the queues, so a full one would block forever
+  if (!running_) {
+    return { science::StatusCode::kFailedPrecondition, "pipeline is not running" };
+  }
+
+  const auto& consumers = it->second.second;
+  cv_.wait(lock, [this, &consumers]() { return has_room(consumers) || stopping_; });
+  if (stopping_) {
+    return { science::StatusCode::kCancelled, "pipeline is stopping" };
+  }
+
+  deliver(consumers, std::make_shared<const PipelineData>(std::move(data)));
+  lock.unlock();
+  cv_.notify_all();
+  return {};
+}
+
+void Pipeline::drain() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!running_) {
+    return;
+  }
+  cv_.wait(lock, [this]() { return in_flight_ == 0; });
+}
+
+auto Pipeline::status() const -> science::Status {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return status_;
+}
+
+void Pipeline::metrics(std::vector<StageMetrics>* metrics) const {
+  if (metrics == nullptr) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  metrics->clear();
+  for (const auto& stage : stages_) {
+    metrics->push_back(stage->metrics);
+    metrics->back().queue_depth = stage->inbox.size();
+  }
+}
+
+auto Pipeline::has_room(const std::vector<Stage*>& consumers) const -> bool {
+  return std::all_of(consumers.begin(), consumers.end(), [this](const Stage* consumer) {
+    return consumer->inbox.size() + consumer->reserved < queue_capacity_;
+  });
+}
+
+void Pipeline::deliver(const std::vector<Stage*>& consumers, const std::shared_ptr<const PipelineData>& data) {
+  const auto now = Clock::now();
+  for (auto* consumer : consumers) {
+    consumer->inbox.push_back({ data, now });
+    consumer->metrics.max_queue_depth = std::max(consumer->metrics.max_queue_depth, consumer->inbox.size());
+    in_flight_++;
+  }
+}
+
+auto Pipeline::next_runnable() -> Stage* {
+  // Prefer stages closest to the sinks, so packets leave the pipeline before new ones enter
+  for (auto it = stages_.rbegin(); it != stages_.rend(); ++it) {
+    auto* stage = it->get();
+    if (!stage->running && !stage->inbox.empty() && has_room(stage->consumers)) {
+      return stage;
+    }
+  }
+  return nullptr;
+}
+
+void Pipeline::run_worker() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    Stage* stage = nullptr;
+    cv_.wait(lock, [this, &stage]() { return (stage = next_runnable()) != nullptr || stopping_; });
+    if (stage == nullptr) {
+      return;
+    }
+
+    // Claim the stage and room for its output, so no other worker can take either
+    Packet packet = std::move(stage->inbox.front());
+    stage->inbox.pop_front();
+    stage->running = true;
+    for (auto* consumer : stage->consumers) {
+      consumer->reserved++;
+    }
+    lock.unlock();
+
+    std::shared_ptr<const PipelineData> out;
+    const auto started = Clock::now();
+    auto s = stage->process(*packet.data, &out);
+    const auto finished = Clock::now();
+    if (s.ok() && out != nullptr && stage->callback) {
+      stage->callback(stage->metrics.node_id, *out);
+    }
+
+    lock.lock();
+    auto& metrics = stage->metrics;
+    const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(finished - packet.enqueued);
+    metrics.packets++;
+    metrics.items += num_items(*packet.data);
+    metrics.busy += std::chrono::duration_cast<std::chrono::nanoseconds>(finished - started);
+    metrics.total_latency += latency;
+    metrics.max_latency = std::max(metrics.max_latency, latency);
+    if (!s.ok()) {
+      metrics.errors++;
+      if (status_.ok()) {
+        status_ = { s.code(), "node " + std::to_string(metrics.node_id) + ": " + s.message() };
+      }
+    }
+
+    for (auto* consumer : stage->consumers) {
+      consumer->reserved--;
+    }
+    if (out != nullptr) {
+      deliver(stage->consumers, out);
+    }
+    stage->running = false;
+    in_flight_--;
+    cv_.notify_all();
+  }
+}
+
+}  // namespace synapse
@@ -0,0 +1,56 @@
+#include "science/synapse/dsp/sample_block.h"
+
+#include <string>
+
+namespace synapse {
+
+void SampleBlock::resize(size_t channels, size_t samples_per_channel) {
+  num_channels = channels;
+  num_samples = samples_per_channel;
+  samples.resize(channels * samples_per_channel);
+}
+
+auto SampleBlock::append(const synapse::BroadbandFrame& frame) -> science::Status {
+  auto channels = static_cast<size_t>(frame.frame_data_size());
+  if (num_samples == 0) {
+    num_channels = channels;
+    sample_rate_hz = frame.sample_rate_hz();
+    start_timestamp_ns = frame.timestamp_ns();
+    start_sequence_number = frame.sequence_number();
+    samples.clear();
+  } else if (channels != num_channels) {
+    return {
+      science::StatusCode::kInvalidArgument,
+      "frame has " + std::to_string(channels) + " channels, expected " + std::to_string(num_channels)
+    };
+  }
+
+  for (auto value : frame.frame_data()) {
+    samples.push_back(static_cast<float>(value));
+  }
+  num_samples++;
+  return {};
+}
+
+auto SampleBlock::from_frames(const std::vector<synapse::BroadbandFrame>& frames, SampleBlock* block)
+    -> science::Status {
+  if (block == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "block ptr must not be null" };
+  }
+
+  block->num_samples = 0;
+  block->samples.clear();
+  if (!frames.empty()) {
+    block->samples.reserve(frames.size() * frames.front().frame_data_size());
+  }
+
+  for (const auto& frame : frames) {
+    auto s = block->append(frame);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  return {};
+}
+
+}  // namespace synapse
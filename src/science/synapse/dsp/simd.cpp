@@ -0,0 +1,17 @@
+#include "science/synapse/dsp/simd.h"
+#include "science/synapse/dsp/simd_internal.h"
+
+namespace synapse {
+
+auto detect_simd_level() -> SimdLevel {
+#if SYNAPSE_HAS_X86_SIMD
+  static const SimdLevel level = (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    ? SimdLevel::kAvx2
+    : SimdLevel::kScalar;
+  return level;
+#else
+  return SimdLevel::kScalar;
+#endif
+}
+
+}  // namespace synapse
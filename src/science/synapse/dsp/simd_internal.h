@@ -0,0 +1,12 @@
+#pragma once
+
+// AVX2 kernels are compiled with per-function target attributes and selected at
+// runtime, so the library doesn't need -mavx2 and still runs on older x86 and arm64.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SYNAPSE_HAS_X86_SIMD 1
+#define SYNAPSE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#include <immintrin.h>
+#else
+#define SYNAPSE_HAS_X86_SIMD 0
+#define SYNAPSE_TARGET_AVX2
+#endif
@@ -0,0 +1,317 @@
+#include "science/synapse/dsp/spectral_filter_engine.h"
+#include "science/synapse/dsp/simd_internal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <string>
+#include <utility>
+
+namespace synapse {
+
+namespace {
+
+using Biquad = SpectralFilterEngine::Biquad;
+
+constexpr double kPi = 3.14159265358979323846;
+
+enum class Response { kLowPass, kHighPass };
+
+// RBJ cookbook sections; with Q taken from the Butterworth pole angles, a cascade of
+// these is exactly the bilinear-transformed Butterworth filter.
+auto design_section(Response response, double cutoff_hz, double q, double sample_rate_hz) -> Biquad {
+  const double w0 = 2.0 * kPi * cutoff_hz / sample_rate_hz;
+  const double cos_w0 = std::cos(w0);
+  const double alpha = std::sin(w0) / (2.0 * q);
+
+  double b0 = 0;
+  double b1 = 0;
+  double b2 = 0;
+  switch (response) {
+    case Response::kLowPass:
+      b0 = (1.0 - cos_w0) / 2.0;
+      b1 = 1.0 - cos_w0;
+      b2 = b0;
+      break;
+    case Response::kHighPass:
+      b0 = (1.0 + cos_w0) / 2.0;
+      b1 = -(1.0 + cos_w0);
+      b2 = b0;
+      break;
+  }
+
+  const double a0 = 1.0 + alpha;
+  return {
+    static_cast<float>(b0 / a0),
+    static_cast<float>(b1 / a0),
+    static_cast<float>(b2 / a0),
+    static_cast<float>(-2.0 * cos_w0 / a0),
+    static_cast<float>((1.0 - alpha) / a0)
+  };
+}
+
+void add_butterworth(
+  Response response,
+  double cutoff_hz,
+  uint32_t order,
+  double sample_rate_hz,
+  std::vector<Biquad>* sections
+) {
+  for (uint32_t k = 0; k < order / 2; ++k) {
+    double q = 1.0 / (2.0 * std::cos(kPi * (2.0 * k + 1.0) / (2.0 * order)));
+    sections->push_back(design_section(response, cutoff_hz, q, sample_rate_hz));
+  }
+}
+
+// Bilinear-transform one analog section (b2 s^2 + b1 s + b0) / (a2 s^2 + a1 s + a0)
+auto bilinear(double b2, double b1, double b0, double a2, double a1, double a0, double sample_rate_hz) -> Biquad {
+  const double k = 2.0 * sample_rate_hz;
+  const double kk = k * k;
+  const double d0 = a2 * kk + a1 * k + a0;
+  return {
+    static_cast<float>((b2 * kk + b1 * k + b0) / d0),
+    static_cast<float>(2.0 * (b0 - b2 * kk) / d0),
+    static_cast<float>((b2 * kk - b1 * k + b0) / d0),
+    static_cast<float>(2.0 * (a0 - a2 * kk) / d0),
+    static_cast<float>((a2 * kk - a1 * k + a0) / d0)
+  };
+}
+
+// Butterworth band-stop: each pole of the order-N analog low-pass prototype maps through
+// s -> B s / (s^2 + w0^2) to two poles, giving N sections with their zeros at +-j w0. The
+// edges are prewarped, so the digital filter is -3 dB at both cutoffs.
+void add_butterworth_band_stop(
+  double low_hz,
+  double high_hz,
+  uint32_t order,
+  double sample_rate_hz,
+  std::vector<Biquad>* sections
+) {
+  const double k = 2.0 * sample_rate_hz;
+  const double w_low = k * std::tan(kPi * low_hz / sample_rate_hz);
+  const double w_high = k * std::tan(kPi * high_hz / sample_rate_hz);
+  const double w0_squared = w_low * w_high;
+  const double bandwidth = w_high - w_low;
+
+  // Upper-half-plane prototype poles; their conjugates give the conjugate sections
+  for (uint32_t i = 0; i < order / 2; ++i) {
+    const auto pole = std::polar(1.0, kPi * (2.0 * i + order + 1.0) / (2.0 * order));
+    const auto half_b = bandwidth / pole / 2.0;
+    const auto root = std::sqrt(half_b * half_b - w0_squared);
+    for (const auto& p : { half_b + root, half_b - root }) {
+      // Unity gain at DC, where the prototype's gain is also unity
+      const double magnitude_squared = std::norm(p);
+      const double gain = magnitude_squared / w0_squared;
+      sections->push_back(bilinear(
+        gain, 0.0, gain * w0_squared, 1.0, -2.0 * p.real(), magnitude_squared, sample_rate_hz
+      ));
+    }
+  }
+}
+
+void filter_scalar(
+  const Biquad* sections, size_t num_sections, float* z1, float* z2, size_t state_stride,
+  float* samples, size_t stride, size_t num_samples, size_t channel_begin, size_t channel_end
+) {
+  for (size_t t = 0; t < num_samples; ++t) {
+    float* row = samples + t * stride;
+    for (size_t c = channel_begin; c < channel_end; ++c) {
+      float x = row[c];
+      for (size_t s = 0; s < num_sections; ++s) {
+        const Biquad& q = sections[s];
+        float* s1 = z1 + s * state_stride + c;
+        float* s2 = z2 + s * state_stride + c;
+        float y = q.b0 * x + *s1;
+        *s1 = q.b1 * x - q.a1 * y + *s2;
+        *s2 = q.b2 * x - q.a2 * y;
+        x = y;
+      }
+      row[c] = x;
+    }
+  }
+}
+
+#if SYNAPSE_HAS_X86_SIMD
+SYNAPSE_TARGET_AVX2
+void filter_avx2(
+  const Biquad* sections, size_t num_sections, float* z1, float* z2, size_t state_stride,
+  float* samples, size_t stride, size_t num_samples, size_t channel_begin, size_t channel_end
+) {
+  const size_t vector_end = channel_begin + (channel_end - channel_begin) / 8 * 8;
+
+  for (size_t t = 0; t < num_samples; ++t) {
+    float* row = samples + t * stride;
+    for (size_t c = channel_begin; c < vector_end; c += 8) {
+      __m256 x = _mm256_loadu_ps(row + c);
+      for (size_t s = 0; s < num_sections; ++s) {
+        const Biquad& q = sections[s];
+        float* s1 = z1 + s * state_stride + c;
+        float* s2 = z2 + s * state_stride + c;
+        __m256 y = _mm256_fmadd_ps(_mm256_set1_ps(q.b0), x, _mm256_loadu_ps(s1));
+        __m256 n1 = _mm256_fmadd_ps(_mm256_set1_ps(q.b1), x, _mm256_loadu_ps(s2));
+        n1 = _mm256_fnmadd_ps(_mm256_set1_ps(q.a1), y, n1);
+        __m256 n2 = _mm256_mul_ps(_mm256_set1_ps(q.b2), x);
+        n2 = _mm256_fnmadd_ps(_mm256_set1_ps(q.a2), y, n2);
+        _mm256_storeu_ps(s1, n1);
+        _mm256_storeu_ps(s2, n2);
+        x = y;
+      }
+      _mm256_storeu_ps(row + c, x);
+    }
+  }
+
+  if (vector_end < channel_end) {
+    filter_scalar(
+      sections, num_sections, z1, z2, state_stride, samples, stride, num_samples, vector_end, channel_end
+    );
+  }
+}
+#endif
+
+}  // namespace
+
+SpectralFilterEngine::SpectralFilterEngine(std::vector<Biquad> sections, size_t num_channels)
+  : sections_(std::move(sections)),
+    num_channels_(num_channels),
+    simd_level_(detect_simd_level()),
+    z1_(sections_.size() * num_channels, 0.0f),
+    z2_(sections_.size() * num_channels, 0.0f) {}
+
+auto SpectralFilterEngine::create(
+  const SpectralFilter& filter,
+  float sample_rate_hz,
+  size_t num_channels,
+  std::unique_ptr<SpectralFilterEngine>* engine,
+  uint32_t order
+) -> science::Status {
+  if (engine == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "engine ptr must not be null" };
+  }
+
+  if (order == 0 || order % 2 != 0) {
+    return { science::StatusCode::kInvalidArgument, "filter order must be a positive even number" };
+  }
+
+  if (sample_rate_hz <= 0) {
+    return { science::StatusCode::kInvalidArgument, "sample rate must be positive" };
+  }
+
+  const double nyquist = sample_rate_hz / 2.0;
+  const double low = filter.low_cutoff_hz();
+  const double high = filter.high_cutoff_hz();
+  auto in_range = [nyquist](double f) { return f > 0 && f < nyquist; };
+
+  std::vector<Biquad> sections;
+  switch (filter.method()) {
+    case synapse::SpectralFilterMethod::kLowPass:
+      if (!in_range(high)) {
+        return { science::StatusCode::kInvalidArgument, "low-pass cutoff must be between 0 Hz and nyquist" };
+      }
+      add_butterworth(Response::kLowPass, high, order, sample_rate_hz, &sections);
+      break;
+
+    case synapse::SpectralFilterMethod::kHighPass:
+      if (!in_range(low)) {
+        return { science::StatusCode::kInvalidArgument, "high-pass cutoff must be between 0 Hz and nyquist" };
+      }
+      add_butterworth(Response::kHighPass, low, order, sample_rate_hz, &sections);
+      break;
+
+    case synapse::SpectralFilterMethod::kBandPass:
+      if (!in_range(low) || !in_range(high) || low >= high) {
+        return { science::StatusCode::kInvalidArgument, "band-pass cutoffs must satisfy 0 < low < high < nyquist" };
+      }
+      add_butterworth(Response::kHighPass, low, order, sample_rate_hz, &sections);
+      add_butterworth(Response::kLowPass, high, order, sample_rate_hz, &sections);
+      break;
+
+    case synapse::SpectralFilterMethod::kBandStop:
+      if (!in_range(low) || !in_range(high) || low >= high) {
+        return { science::StatusCode::kInvalidArgument, "band-stop cutoffs must satisfy 0 < low < high < nyquist" };
+      }
+      add_butterworth_band_stop(low, high, order, sample_rate_hz, &sections);
+      break;
+
+    default:
+      return {
+        science::StatusCode::kInvalidArgument,
+        "unsupported spectral filter method \"" + std::to_string(filter.method()) + "\""
+      };
+  }
+
+  engine->reset(new SpectralFilterEngine(std::move(sections), num_channels));
+  return {};
+}
+
+auto SpectralFilterEngine::process(SampleBlock* block, WorkStealingPool* pool) -> science::Status {
+  if (block == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "block ptr must not be null" };
+  }
+
+  if (block->num_channels != num_channels_) {
+    return {
+      science::StatusCode::kInvalidArgument,
+      "block has " + std::to_string(block->num_channels) + " channels, filter expects " + std::to_string(num_channels_)
+    };
+  }
+
+  float* samples = block->samples.data();
+  const size_t num_samples = block->num_samples;
+  if (pool == nullptr) {
+    process_channels(samples, num_channels_, num_samples, 0, num_channels_);
+    return {};
+  }
+
+  pool->parallel_for(0, num_channels_, pool->channel_grain(num_channels_), [&](size_t begin, size_t end) {
+    process_channels(samples, num_channels_, num_samples, begin, end);
+  });
+  return {};
+}
+
+void SpectralFilterEngine::process_channels(
+  float* samples, size_t stride, size_t num_samples, size_t channel_begin, size_t channel_end
+) {
+  if (channel_end > num_channels_) {
+    channel_end = num_channels_;
+  }
+  if (channel_begin >= channel_end) {
+    return;
+  }
+
+#if SYNAPSE_HAS_X86_SIMD
+  if (simd_level_ == SimdLevel::kAvx2) {
+    filter_avx2(
+      sections_.data(), sections_.size(), z1_.data(), z2_.data(), num_channels_,
+      samples, stride, num_samples, channel_begin, channel_end
+    );
+    return;
+  }
+#endif
+
+  filter_scalar(
+    sections_.data(), sections_.size(), z1_.data(), z2_.data(), num_channels_,
+    samples, stride, num_samples, channel_begin, channel_end
+  );
+}
+
+void SpectralFilterEngine::reset() {
+  std::fill(z1_.begin(), z1_.end(), 0.0f);
+  std::fill(z2_.begin(), z2_.end(), 0.0f);
+}
+
+void SpectralFilterEngine::set_simd_level(SimdLevel level) {
+  if (level == SimdLevel::kAvx2 && detect_simd_level() != SimdLevel::kAvx2) {
+    level = SimdLevel::kScalar;
+  }
+  simd_level_ = level;
+}
+
+auto SpectralFilterEngine::num_channels() const -> size_t {
+  return num_channels_;
+}
+
+auto SpectralFilterEngine::num_sections() const -> size_t {
+  return sections_.size();
+}
+
+}  // namespace synapse
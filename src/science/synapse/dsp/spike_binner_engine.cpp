@@ -0,0 +1,175 @@
+#include "science/synapse/dsp/spike_binner_engine.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace synapse {
+
+namespace {
+
+// Each ring holds at least this much time ahead of its oldest untaken bin
+constexpr uint64_t kMinHorizonNs = 1000000000;
+
+constexpr uint64_t kNoBins = std::numeric_limits<uint64_t>::max();
+
+}  // namespace
+
+struct SpikeBinnerEngine::Ring {
+  Ring(uint32_t bin_size_ms, size_t num_channels)
+    : bin_ns(static_cast<uint64_t>(bin_size_ms) * 1000000),
+      capacity(std::max<uint64_t>(2, (kMinHorizonNs + bin_ns - 1) / bin_ns)),
+      next_bin(kNoBins),
+      counts(capacity * num_channels) {}
+
+  const uint64_t bin_ns;
+  const uint64_t capacity;
+
+  // Absolute index (timestamp / bin_ns) of the oldest bin not yet taken
+  std::atomic<uint64_t> next_bin;
+
+  // Bin-major: counts[(bin % capacity) * num_channels + channel]
+  std::vector<std::atomic<uint32_t>> counts;
+};
+
+void SpikeCounts::resize(size_t channels, size_t bins) {
+  num_channels = channels;
+  num_bins = bins;
+  counts.resize(channels * bins);
+}
+
+SpikeBinnerEngine::SpikeBinnerEngine(const std::vector<uint32_t>& bin_sizes_ms, size_t num_channels, bool concurrent)
+  : bin_sizes_ms_(bin_sizes_ms),
+    num_channels_(num_channels),
+    concurrent_(concurrent),
+    late_(0),
+    dropped_(0) {
+  for (auto bin_size_ms : bin_sizes_ms_) {
+    rings_.push_back(std::make_unique<Ring>(bin_size_ms, num_channels));
+  }
+}
+
+SpikeBinnerEngine::~SpikeBinnerEngine() = default;
+
+auto SpikeBinnerEngine::create(
+  const SpikeBinner& binner,
+  size_t num_channels,
+  std::unique_ptr<SpikeBinnerEngine>* engine,
+  const std::vector<uint32_t>& extra_bin_sizes_ms,
+  bool concurrent
+) -> science::Status {
+  if (engine == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "engine ptr must not be null" };
+  }
+
+  std::vector<uint32_t> bin_sizes_ms = { binner.bin_size_ms() };
+  bin_sizes_ms.insert(bin_sizes_ms.end(), extra_bin_sizes_ms.begin(), extra_bin_sizes_ms.end());
+  for (auto bin_size_ms : bin_sizes_ms) {
+    if (bin_size_ms == 0) {
+      return { science::StatusCode::kInvalidArgument, "bin size must be positive" };
+    }
+  }
+
+  engine->reset(new SpikeBinnerEngine(bin_sizes_ms, num_channels, concurrent));
+  return {};
+}
+
+void SpikeBinnerEngine::add(const SpikeEvent& event) {
+  if (event.channel >= num_channels_) {
+    dropped_.fetch_add(rings_.size(), std::memory_order_relaxed);
+    return;
+  }
+
+  for (auto& ring : rings_) {
+    const uint64_t bin = event.timestamp_ns / ring->bin_ns;
+
+    // The first event seen starts the ring
+    uint64_t base = ring->next_bin.load(std::memory_order_acquire);
+    if (base == kNoBins && ring->next_bin.compare_exchange_strong(base, bin, std::memory_order_acq_rel)) {
+      base = bin;
+    }
+
+    if (bin < base) {
+      late_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    if (bin - base >= ring->capacity) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    auto& counter = ring->counts[(bin % ring->capacity) * num_channels_ + event.channel];
+    if (concurrent_) {
+      counter.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      // Only one writer, so a plain load and store is enough and avoids a locked instruction
+      counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void SpikeBinnerEngine::add(const std::vector<SpikeEvent>& events) {
+  for (const auto& event : events) {
+    add(event);
+  }
+}
+
+auto SpikeBinnerEngine::take(uint64_t until_ns, std::vector<SpikeCounts>* counts) -> science::Status {
+  if (counts == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "counts ptr must not be null" };
+  }
+
+  counts->resize(rings_.size());
+  for (size_t i = 0; i < rings_.size(); ++i) {
+    auto& ring = *rings_[i];
+    auto& out = (*counts)[i];
+    out.bin_size_ms = bin_sizes_ms_[i];
+
+    const uint64_t base = ring.next_bin.load(std::memory_order_acquire);
+    const uint64_t end_bin = until_ns / ring.bin_ns;
+    if (base == kNoBins || end_bin <= base) {
+      out.resize(num_channels_, 0);
+      out.start_timestamp_ns = base == kNoBins ? 0 : base * ring.bin_ns;
+      continue;
+    }
+
+    const size_t num_bins = static_cast<size_t>(std::min(end_bin - base, ring.capacity));
+    out.resize(num_channels_, num_bins);
+    out.start_timestamp_ns = base * ring.bin_ns;
+
+    for (size_t b = 0; b < num_bins; ++b) {
+      auto* slot = ring.counts.data() + ((base + b) % ring.capacity) * num_channels_;
+      for (size_t c = 0; c < num_channels_; ++c) {
+        uint32_t value = 0;
+        if (concurrent_) {
+          value = slot[c].exchange(0, std::memory_order_relaxed);
+        } else {
+          value = slot[c].load(std::memory_order_relaxed);
+          slot[c].store(0, std::memory_order_relaxed);
+        }
+        out.counts[c * num_bins + b] = value;
+      }
+    }
+
+    ring.next_bin.store(base + num_bins, std::memory_order_release);
+  }
+
+  return {};
+}
+
+auto SpikeBinnerEngine::bin_sizes_ms() const -> const std::vector<uint32_t>& {
+  return bin_sizes_ms_;
+}
+
+auto SpikeBinnerEngine::num_channels() const -> size_t {
+  return num_channels_;
+}
+
+auto SpikeBinnerEngine::late() const -> uint64_t {
+  return late_.load(std::memory_order_relaxed);
+}
+
+auto SpikeBinnerEngine::dropped() const -> uint64_t {
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+}  // namespace synapse
@@ -0,0 +1,424 @@
+#include "science/synapse/dsp/spike_detector_engine.h"
+#include "science/synapse/dsp/simd_internal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace synapse {
+
+namespace {
+
+constexpr float kDefaultMinCorrelation = 0.9f;
+
+// Windows flatter than this have no meaningful correlation with the template
+constexpr float kMinVariance = 1e-6f;
+
+// Records a spike unless the channel is still refractory from the last one
+struct Emitter {
+  uint64_t* next_allowed;
+  uint64_t position;
+  uint32_t refractory_samples;
+  uint64_t start_timestamp_ns;
+  double ns_per_sample;
+  std::vector<SpikeEvent>* events;
+
+  void operator()(size_t channel, size_t t, float score) const {
+    const uint64_t sample = position + t;
+    if (sample < next_allowed[channel]) {
+      return;
+    }
+    next_allowed[channel] = sample + refractory_samples;
+
+    SpikeEvent event;
+    event.channel = static_cast<uint32_t>(channel);
+    event.sample = sample;
+    event.timestamp_ns = start_timestamp_ns + static_cast<uint64_t>(t * ns_per_sample);
+    event.score = score;
+    events->push_back(event);
+  }
+};
+
+void threshold_row_scalar(
+  const float* row, const float* prev, float threshold, size_t channel_begin, size_t channel_end, size_t t,
+  const Emitter& emit
+) {
+  for (size_t c = channel_begin; c < channel_end; ++c) {
+    const float magnitude = std::fabs(row[c]);
+    if (magnitude >= threshold && std::fabs(prev[c]) < threshold) {
+      emit(c, t, row[c]);
+    }
+  }
+}
+
+// Template length rows, oldest first: the first `split` come from the history, the rest from the block
+struct Window {
+  const float* history;
+  size_t history_stride;
+  const float* block;
+  size_t block_stride;
+  size_t split;
+  const float* tmpl;
+  size_t length;
+  float inv_norm;
+
+  auto row(size_t k) const -> const float* {
+    return k < split ? history + k * history_stride : block + (k - split) * block_stride;
+  }
+};
+
+void match_row_scalar(
+  const Window& window, float min_correlation, float* last_score, size_t channel_begin, size_t channel_end,
+  size_t t, const Emitter& emit
+) {
+  const float inv_length = 1.0f / window.length;
+  const float* newest = window.row(window.length - 1);
+
+  for (size_t c = channel_begin; c < channel_end; ++c) {
+    // Offsetting by the newest sample keeps the variance exact in float when there's a DC offset;
+    // the template is zero-mean, so the offset doesn't change the correlation.
+    const float offset = newest[c];
+    float sum = 0;
+    float sum_sq = 0;
+    float dot = 0;
+    for (size_t k = 0; k < window.length; ++k) {
+      const float d = window.row(k)[c] - offset;
+      sum += d;
+      sum_sq += d * d;
+      dot += window.tmpl[k] * d;
+    }
+
+    const float variance = sum_sq - sum * sum * inv_length;
+    const float score = variance > kMinVariance ? dot * window.inv_norm / std::sqrt(variance) : 0.0f;
+    if (score >= min_correlation && last_score[c] < min_correlation) {
+      emit(c, t, score);
+    }
+    last_score[c] = score;
+  }
+}
+
+#if SYNAPSE_HAS_X86_SIMD
+// Calls emit for each set bit of an 8-lane comparison mask, lowest channel first
+template <typename Scores>
+inline void emit_mask(int mask, size_t c, size_t t, const Scores& scores, const Emitter& emit) {
+  while (mask != 0) {
+    const int lane = __builtin_ctz(mask);
+    emit(c + lane, t, scores[lane]);
+    mask &= mask - 1;
+  }
+}
+
+SYNAPSE_TARGET_AVX2
+void threshold_row_avx2(
+  const float* row, const float* prev, float threshold, size_t channel_begin, size_t channel_end, size_t t,
+  const Emitter& emit
+) {
+  const size_t vector_end = channel_begin + (channel_end - channel_begin) / 8 * 8;
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  const __m256 limit = _mm256_set1_ps(threshold);
+
+  for (size_t c = channel_begin; c < vector_end; c += 8) {
+    const __m256 magnitude = _mm256_andnot_ps(sign, _mm256_loadu_ps(row + c));
+    const __m256 prev_magnitude = _mm256_andnot_ps(sign, _mm256_loadu_ps(prev + c));
+    const __m256 crossed = _mm256_and_ps(
+      _mm256_cmp_ps(magnitude, limit, _CMP_GE_OQ),
+      _mm256_cmp_ps(prev_magnitude, limit, _CMP_LT_OQ)
+    );
+    const int mask = _mm256_movemask_ps(crossed);
+    if (mask != 0) {
+      emit_mask(mask, c, t, row + c, emit);
+    }
+  }
+
+  threshold_row_scalar(row, prev, threshold, vector_end, channel_end, t, emit);
+}
+
+SYNAPSE_TARGET_AVX2
+void match_row_avx2(
+  const Window& window, float min_correlation, float* last_score, size_t channel_begin, size_t channel_end,
+  size_t t, const Emitter& emit
+) {
+  const size_t vector_end = channel_begin + (channel_end - channel_begin) / 8 * 8;
+  const __m256 inv_length = _mm256_set1_ps(1.0f / window.length);
+  const __m256 inv_norm = _mm256_set1_ps(window.inv_norm);
+  const __m256 min_variance = _mm256_set1_ps(kMinVariance);
+  const __m256 threshold = _mm256_set1_ps(min_correlation);
+  const float* newest = window.row(window.length - 1);
+
+  for (size_t c = channel_begin; c < vector_end; c += 8) {
+    const __m256 offset = _mm256_loadu_ps(newest + c);
+    __m256 sum = _mm256_setzero_ps();
+    __m256 sum_sq = _mm256_setzero_ps();
+    __m256 dot = _mm256_setzero_ps();
+    for (size_t k = 0; k < window.length; ++k) {
+      const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(window.row(k) + c), offset);
+      sum = _mm256_add_ps(sum, d);
+      sum_sq = _mm256_fmadd_ps(d, d, sum_sq);
+      dot = _mm256_fmadd_ps(_mm256_set1_ps(window.tmpl[k]), d, dot);
+    }
+
+    const __m256 variance = _mm256_fnmadd_ps(_mm256_mul_ps(sum, sum), inv_length, sum_sq);
+    const __m256 valid = _mm256_cmp_ps(variance, min_variance, _CMP_GT_OQ);
+    const __m256 safe_variance = _mm256_max_ps(variance, min_variance);
+    __m256 score = _mm256_div_ps(_mm256_mul_ps(dot, inv_norm), _mm256_sqrt_ps(safe_variance));
+    score = _mm256_and_ps(score, valid);
+
+    const __m256 last = _mm256_loadu_ps(last_score + c);
+    const __m256 crossed = _mm256_and_ps(
+      _mm256_cmp_ps(score, threshold, _CMP_GE_OQ),
+      _mm256_cmp_ps(last, threshold, _CMP_LT_OQ)
+    );
+    _mm256_storeu_ps(last_score + c, score);
+
+    const int mask = _mm256_movemask_ps(crossed);
+    if (mask != 0) {
+      alignas(32) float scores[8];
+      _mm256_store_ps(scores, score);
+      emit_mask(mask, c, t, scores, emit);
+    }
+  }
+
+  match_row_scalar(window, min_correlation, last_score, vector_end, channel_end, t, emit);
+}
+#endif
+
+}  // namespace
+
+SpikeDetectorEngine::SpikeDetectorEngine(const SpikeDetector& detector, size_t num_channels)
+  : mode_(detector.mode()),
+    num_channels_(num_channels),
+    simd_level_(detect_simd_level()),
+    threshold_uv_(static_cast<float>(detector.threshold_uv())),
+    min_correlation_(kDefaultMinCorrelation),
+    refractory_samples_(std::max<uint32_t>(detector.samples_per_spike(), 1)),
+    position_(0),
+    template_norm_(0),
+    next_allowed_(num_channels, 0),
+    last_score_(num_channels, 0.0f) {}
+
+auto SpikeDetectorEngine::create(
+  const SpikeDetector& detector,
+  size_t num_channels,
+  std::unique_ptr<SpikeDetectorEngine>* engine
+) -> science::Status {
+  if (engine == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "engine ptr must not be null" };
+  }
+
+  std::unique_ptr<SpikeDetectorEngine> result(new SpikeDetectorEngine(detector, num_channels));
+
+  if (detector.mode() == SpikeDetector::Mode::TemplateMatcher) {
+    const auto& template_uv = detector.template_uv();
+    if (template_uv.size() < 2) {
+      return { science::StatusCode::kInvalidArgument, "spike template must have at least 2 samples" };
+    }
+
+    double mean = 0;
+    for (auto value : template_uv) {
+      mean += value;
+    }
+    mean /= template_uv.size();
+
+    double norm = 0;
+    for (auto value : template_uv) {
+      const double centered = value - mean;
+      result->template_.push_back(static_cast<float>(centered));
+      norm += centered * centered;
+    }
+    if (norm == 0) {
+      return { science::StatusCode::kInvalidArgument, "spike template must not be constant" };
+    }
+
+    result->template_norm_ = static_cast<float>(std::sqrt(norm));
+    result->history_.assign((template_uv.size() - 1) * num_channels, 0.0f);
+  }
+
+  *engine = std::move(result);
+  return {};
+}
+
+auto SpikeDetectorEngine::process(
+  const SampleBlock& block,
+  std::vector<SpikeEvent>* events,
+  WorkStealingPool* pool
+) -> science::Status {
+  if (events == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "events ptr must not be null" };
+  }
+
+  if (block.num_channels != num_channels_) {
+    return {
+      science::StatusCode::kInvalidArgument,
+      "block has " + std::to_string(block.num_channels) + " channels, detector expects " +
+        std::to_string(num_channels_)
+    };
+  }
+
+  if (pool == nullptr) {
+    process_channels(block, 0, num_channels_, events);
+    advance(block);
+    return {};
+  }
+
+  const size_t grain = pool->channel_grain(num_channels_);
+  const size_t num_chunks = (num_channels_ + grain - 1) / grain;
+  if (chunk_events_.size() < num_chunks) {
+    chunk_events_.resize(num_chunks);
+  }
+  pool->parallel_for(0, num_channels_, grain, [this, &block, grain](size_t begin, size_t end) {
+    auto& chunk = chunk_events_[begin / grain];
+    chunk.clear();
+    process_channels(block, begin, end, &chunk);
+  });
+  advance(block);
+
+  // Each chunk is in (sample, channel) order; interleave them back into the single-threaded order
+  const size_t first = events->size();
+  for (size_t i = 0; i < num_chunks; ++i) {
+    events->insert(events->end(), chunk_events_[i].begin(), chunk_events_[i].end());
+  }
+  std::sort(events->begin() + first, events->end(), [](const SpikeEvent& a, const SpikeEvent& b) {
+    return a.sample != b.sample ? a.sample < b.sample : a.channel < b.channel;
+  });
+  return {};
+}
+
+void SpikeDetectorEngine::process_channels(
+  const SampleBlock& block,
+  size_t channel_begin,
+  size_t channel_end,
+  std::vector<SpikeEvent>* events
+) {
+  channel_end = std::min({ channel_end, num_channels_, block.num_channels });
+  if (events == nullptr || channel_begin >= channel_end || block.num_samples == 0) {
+    return;
+  }
+
+  if (mode_ == SpikeDetector::Mode::Thresholder) {
+    threshold_channels(block, channel_begin, channel_end, events);
+  } else {
+    match_channels(block, channel_begin, channel_end, events);
+  }
+}
+
+void SpikeDetectorEngine::threshold_channels(
+  const SampleBlock& block, size_t channel_begin, size_t channel_end, std::vector<SpikeEvent>* events
+) {
+  const Emitter emit = {
+    next_allowed_.data(), position_, refractory_samples_, block.start_timestamp_ns,
+    block.sample_rate_hz > 0 ? 1e9 / block.sample_rate_hz : 0.0, events
+  };
+
+  auto* row_kernel = &threshold_row_scalar;
+#if SYNAPSE_HAS_X86_SIMD
+  if (simd_level_ == SimdLevel::kAvx2) {
+    row_kernel = &threshold_row_avx2;
+  }
+#endif
+
+  // The first row is compared against the magnitudes left in last_score_ by the previous block
+  for (size_t t = 0; t < block.num_samples; ++t) {
+    const float* prev = t == 0 ? last_score_.data() : block.row(t - 1);
+    row_kernel(block.row(t), prev, threshold_uv_, channel_begin, channel_end, t, emit);
+  }
+
+  const float* last = block.row(block.num_samples - 1);
+  for (size_t c = channel_begin; c < channel_end; ++c) {
+    last_score_[c] = std::fabs(last[c]);
+  }
+}
+
+void SpikeDetectorEngine::match_channels(
+  const SampleBlock& block, size_t channel_begin, size_t channel_end, std::vector<SpikeEvent>* events
+) {
+  const Emitter emit = {
+    next_allowed_.data(), position_, refractory_samples_, block.start_timestamp_ns,
+    block.sample_rate_hz > 0 ? 1e9 / block.sample_rate_hz : 0.0, events
+  };
+
+  auto* row_kernel = &match_row_scalar;
+#if SYNAPSE_HAS_X86_SIMD
+  if (simd_level_ == SimdLevel::kAvx2) {
+    row_kernel = &match_row_avx2;
+  }
+#endif
+
+  // The window ending at row t starts history_rows - t rows into the history, or in the block once t passes it
+  const size_t history_rows = template_.size() - 1;
+  const size_t n = block.num_samples;
+  for (size_t t = 0; t < n; ++t) {
+    if (position_ + t < history_rows) {
+      // Not enough samples seen yet to fill a window
+      continue;
+    }
+    const size_t split = t < history_rows ? history_rows - t : 0;
+    const Window window = {
+      history_.data() + (history_rows - split) * num_channels_, num_channels_,
+      block.row(t + split - history_rows), block.num_channels, split,
+      template_.data(), template_.size(), 1.0f / template_norm_
+    };
+    row_kernel(window, min_correlation_, last_score_.data(), channel_begin, channel_end, t, emit);
+  }
+
+  // Keep the newest rows for windows that straddle the next block
+  if (n >= history_rows) {
+    for (size_t i = 0; i < history_rows; ++i) {
+      const float* src = block.row(n - history_rows + i);
+      std::copy(src + channel_begin, src + channel_end, history_.data() + i * num_channels_ + channel_begin);
+    }
+  } else {
+    for (size_t i = 0; i < history_rows; ++i) {
+      const float* src = i + n < history_rows ? history_.data() + (i + n) * num_channels_
+                                              : block.row(i + n - history_rows);
+      std::copy(src + channel_begin, src + channel_end, history_.data() + i * num_channels_ + channel_begin);
+    }
+  }
+}
+
+void SpikeDetectorEngine::advance(const SampleBlock& block) {
+  position_ += block.num_samples;
+}
+
+void SpikeDetectorEngine::reset() {
+  position_ = 0;
+  std::fill(next_allowed_.begin(), next_allowed_.end(), 0);
+  std::fill(last_score_.begin(), last_score_.end(), 0.0f);
+  std::fill(history_.begin(), history_.end(), 0.0f);
+}
+
+void SpikeDetectorEngine::set_threshold_uv(float threshold_uv) {
+  threshold_uv_ = threshold_uv;
+}
+
+void SpikeDetectorEngine::set_min_correlation(float min_correlation) {
+  min_correlation_ = min_correlation;
+}
+
+void SpikeDetectorEngine::set_simd_level(SimdLevel level) {
+  if (level == SimdLevel::kAvx2 && detect_simd_level() != SimdLevel::kAvx2) {
+    level = SimdLevel::kScalar;
+  }
+  simd_level_ = level;
+}
+
+auto SpikeDetectorEngine::mode() const -> SpikeDetector::Mode {
+  return mode_;
+}
+
+auto SpikeDetectorEngine::threshold_uv() const -> float {
+  return threshold_uv_;
+}
+
+auto SpikeDetectorEngine::min_correlation() const -> float {
+  return min_correlation_;
+}
+
+auto SpikeDetectorEngine::num_channels() const -> size_t {
+  return num_channels_;
+}
+
+auto SpikeDetectorEngine::position() const -> uint64_t {
+  return position_;
+}
+
+}  // namespace synapse
@@ -0,0 +1,287 @@
+#include "science/synapse/dsp/work_stealing_pool.h"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace synapse {
+
+namespace {
+
+// One cache line of floats
+constexpr size_t kChannelAlignment = 16;
+
+// Chunks per worker, so stealing has something to balance
+constexpr size_t kChunksPerWorker = 4;
+
+struct Placement {
+  int cpu;
+  int numa_node;
+};
+
+#ifdef __linux__
+// Parse a sysfs cpu list such as "0-3,8-11"
+auto parse_cpu_list(const std::string& list) -> std::vector<int> {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+// The CPUs this process may run on, grouped by NUMA node
+auto cpu_placements() -> std::vector<Placement> {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return {};
+  }
+
+  std::map<int, int> node_of_cpu;
+  for (int node = 0;; ++node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!file) {
+      break;
+    }
+    std::string list;
+    std::getline(file, list);
+    for (auto cpu : parse_cpu_list(list)) {
+      node_of_cpu[cpu] = node;
+    }
+  }
+
+  std::vector<Placement> placements;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) {
+      auto it = node_of_cpu.find(cpu);
+      placements.push_back({ cpu, it == node_of_cpu.end() ? 0 : it->second });
+    }
+  }
+  std::stable_sort(placements.begin(), placements.end(), [](const Placement& a, const Placement& b) {
+    return a.numa_node < b.numa_node;
+  });
+  return placements;
+}
+#endif
+
+}  // namespace
+
+struct WorkStealingPool::Job {
+  const std::function<void(size_t, size_t)>* fn;
+  size_t remaining;
+  std::mutex mutex;
+  std::condition_variable cv;
+};
+
+struct WorkStealingPool::Task {
+  Job* job = nullptr;
+  size_t begin = 0;
+  size_t end = 0;
+};
+
+struct WorkStealingPool::Worker {
+  // The owner takes from the front, thieves from the back
+  std::mutex mutex;
+  std::deque<Task> tasks;
+  int numa_node = 0;
+  std::thread thread;
+};
+
+WorkStealingPool::WorkStealingPool(size_t num_threads, bool pin_threads) : queued_(0), stopping_(false) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  std::vector<Placement> placements;
+#ifdef __linux__
+  if (pin_threads) {
+    placements = cpu_placements();
+  }
+#endif
+
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+    if (!placements.empty()) {
+      workers_[i]->numa_node = placements[i % placements.size()].numa_node;
+    }
+  }
+
+  // Neighbouring workers first: they hold the adjacent channel runs
+  steal_order_.resize(num_threads + 1);
+  for (size_t i = 0; i < num_threads; ++i) {
+    auto& order = steal_order_[i];
+    for (size_t d = 1; d < num_threads; ++d) {
+      order.push_back((i + d) % num_threads);
+    }
+    std::stable_partition(order.begin(), order.end(), [this, i](size_t victim) {
+      return workers_[victim]->numa_node == workers_[i]->numa_node;
+    });
+  }
+  for (size_t i = 0; i < num_threads; ++i) {
+    steal_order_[num_threads].push_back(i);
+  }
+
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_[i]->thread = std::thread(&WorkStealingPool::run_worker, this, i);
+#ifdef __linux__
+    if (!placements.empty()) {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(placements[i % placements.size()].cpu, &cpus);
+      pthread_setaffinity_np(workers_[i]->thread.native_handle(), sizeof(cpus), &cpus);
+    }
+#endif
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+void WorkStealingPool::parallel_for(
+  size_t begin,
+  size_t end,
+  size_t grain,
+  const std::function<void(size_t, size_t)>& fn
+) {
+  if (begin >= end) {
+    return;
+  }
+  grain = std::max<size_t>(grain, 1);
+  const size_t num_chunks = (end - begin + grain - 1) / grain;
+  if (num_chunks == 1) {
+    fn(begin, end);
+    return;
+  }
+
+  Job job;
+  job.fn = &fn;
+  job.remaining = num_chunks;
+
+  // Deal the chunks out as contiguous runs, so each worker sees the same channels every call
+  const size_t num_workers = workers_.size();
+  for (size_t w = 0; w < num_workers; ++w) {
+    const size_t first = w * num_chunks / num_workers;
+    const size_t last = (w + 1) * num_chunks / num_workers;
+    if (first == last) {
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(workers_[w]->mutex);
+    for (size_t chunk = first; chunk < last; ++chunk) {
+      const size_t chunk_begin = begin + chunk * grain;
+      workers_[w]->tasks.push_back({ &job, chunk_begin, std::min(chunk_begin + grain, end) });
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_.fetch_add(num_chunks);
+  }
+  cv_.notify_all();
+
+  // Help out until our chunks are done
+  Task task;
+  while (try_steal(num_workers, &task)) {
+    run_task(task);
+  }
+
+  std::unique_lock<std::mutex> lock(job.mutex);
+  job.cv.wait(lock, [&job]() { return job.remaining == 0; });
+}
+
+auto WorkStealingPool::channel_grain(size_t num_channels) const -> size_t {
+  const size_t num_chunks = workers_.size() * kChunksPerWorker;
+  const size_t target = (num_channels + num_chunks - 1) / num_chunks;
+  return std::max(kChannelAlignment, (target + kChannelAlignment - 1) / kChannelAlignment * kChannelAlignment);
+}
+
+auto WorkStealingPool::num_threads() const -> size_t {
+  return workers_.size();
+}
+
+auto WorkStealingPool::numa_node(size_t worker) const -> int {
+  return worker < workers_.size() ? workers_[worker]->numa_node : 0;
+}
+
+void WorkStealingPool::run_worker(size_t index) {
+  while (true) {
+    Task task;
+    if (try_pop(index, &task) || try_steal(index, &task)) {
+      run_task(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return queued_.load() > 0 || stopping_; });
+    if (stopping_ && queued_.load() == 0) {
+      return;
+    }
+  }
+}
+
+auto WorkStealingPool::try_pop(size_t index, Task* task) -> bool {
+  auto& worker = *workers_[index];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  if (worker.tasks.empty()) {
+    return false;
+  }
+  *task = worker.tasks.front();
+  worker.tasks.pop_front();
+  queued_.fetch_sub(1);
+  return true;
+}
+
+auto WorkStealingPool::try_steal(size_t thief, Task* task) -> bool {
+  for (auto victim : steal_order_[thief]) {
+    auto& worker = *workers_[victim];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+      continue;
+    }
+    *task = worker.tasks.back();
+    worker.tasks.pop_back();
+    queued_.fetch_sub(1);
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::run_task(const Task& task) {
+  (*task.job->fn)(task.begin, task.end);
+
+  // The job lives on the caller's stack; it can't return until we release its mutex
+  std::lock_guard<std::mutex> lock(task.job->mutex);
+  if (--task.job->remaining == 0) {
+    task.job->cv.notify_all();
+  }
+}
+
+}  // namespace synapse
@@ -0,0 +1,121 @@
+#include "science/synapse/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace synapse {
+
+namespace {
+
+// Index of the highest set bit; value must be non-zero
+auto highest_bit(uint64_t value) -> unsigned {
+  unsigned bit = 0;
+  while (value >>= 1) {
+    bit++;
+  }
+  return bit;
+}
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram() : min_ns_(std::numeric_limits<uint64_t>::max()) {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+// Values below 32 get a bucket each; above that, value = mantissa << shift with a mantissa of
+// 16-31, and the bucket is shift * 16 + mantissa
+auto LatencyHistogram::bucket(uint64_t value) -> size_t {
+  if (value < 2 * kSubBuckets) {
+    return static_cast<size_t>(value);
+  }
+  const unsigned shift = highest_bit(value) - 4;
+  return shift * kSubBuckets + static_cast<size_t>(value >> shift);
+}
+
+auto LatencyHistogram::bucket_upper_bound(size_t bucket) -> uint64_t {
+  if (bucket < 2 * kSubBuckets) {
+    return bucket;
+  }
+  const size_t shift = bucket / kSubBuckets - 1;
+  const uint64_t mantissa = bucket % kSubBuckets + kSubBuckets;
+  return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+  const auto value = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+  buckets_[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  total_ns_.fetch_add(value, std::memory_order_relaxed);
+
+  // Single writers never contend here; the loops only retry against other writers
+  uint64_t current = min_ns_.load(std::memory_order_relaxed);
+  while (value < current && !min_ns_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+  current = max_ns_.load(std::memory_order_relaxed);
+  while (value > current && !max_ns_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset() {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  total_ns_.store(0, std::memory_order_relaxed);
+  min_ns_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+  max_ns_.store(0, std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::count() const -> uint64_t {
+  return count_.load(std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::min() const -> std::chrono::nanoseconds {
+  return count() == 0 ? std::chrono::nanoseconds(0)
+                      : std::chrono::nanoseconds(min_ns_.load(std::memory_order_relaxed));
+}
+
+auto LatencyHistogram::max() const -> std::chrono::nanoseconds {
+  return std::chrono::nanoseconds(max_ns_.load(std::memory_order_relaxed));
+}
+
+auto LatencyHistogram::mean() const -> std::chrono::nanoseconds {
+  const uint64_t n = count();
+  return n == 0 ? std::chrono::nanoseconds(0)
+                : std::chrono::nanoseconds(total_ns_.load(std::memory_order_relaxed) / n);
+}
+
+auto LatencyHistogram::percentile(double percentile) const -> std::chrono::nanoseconds {
+  // Sum the buckets rather than trusting count_, which concurrent writers may have moved on from
+  uint64_t total = 0;
+  for (const auto& bucket : buckets_) {
+    total += bucket.load(std::memory_order_relaxed);
+  }
+  if (total == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+
+  const double clamped = std::min(std::max(percentile, 0.0), 100.0);
+  const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * total)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      const uint64_t bound = std::min(bucket_upper_bound(i), max_ns_.load(std::memory_order_relaxed));
+      return std::chrono::nanoseconds(static_cast<int64_t>(bound));
+    }
+  }
+  return max();
+}
+
+auto LatencyHistogram::summary() const -> std::string {
+  std::ostringstream out;
+  out << "n " << count() << ", mean " << mean().count() / 1e3 << " us, p50 " << percentile(50).count() / 1e3
+      << " us, p99 " << percentile(99).count() / 1e3 << " us, p99.9 " << percentile(99.9).count() / 1e3
+      << " us, max " << max().count() / 1e3 << " us";
+  return out.str();
+}
+
+}  // namespace synapse
@@ -0,0 +1,115 @@
+#include "science/synapse/latest_frame.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace synapse {
+
+namespace {
+
+constexpr size_t kWordSize = sizeof(uint64_t);
+
+auto num_words(size_t size) -> size_t {
+  return (size + kWordSize - 1) / kWordSize;
+}
+
+}  // namespace
+
+LatestFrame::LatestFrame(size_t max_size) : max_size_(max_size) {
+  for (auto& slot : slots_) {
+    slot.words.reset(new std::atomic<uint64_t>[num_words(max_size_)]);
+  }
+}
+
+auto LatestFrame::publish(const uint8_t* data, size_t size) -> science::Status {
+  if (data == nullptr && size > 0) {
+    return { science::StatusCode::kInvalidArgument, "data ptr must not be null" };
+  }
+  if (size > max_size_) {
+    return { science::StatusCode::kInvalidArgument,
+             "message of " + std::to_string(size) + " bytes exceeds max size of " + std::to_string(max_size_) };
+  }
+
+  const uint64_t generation = generation_.load(std::memory_order_relaxed) + 1;
+  auto& slot = slots_[generation % kSlots];
+
+  slot.sequence.store(2 * generation - 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.size.store(size, std::memory_order_relaxed);
+  const size_t full_words = size / kWordSize;
+  for (size_t i = 0; i < full_words; ++i) {
+    uint64_t word;
+    std::memcpy(&word, data + i * kWordSize, kWordSize);
+    slot.words[i].store(word, std::memory_order_relaxed);
+  }
+  if (const size_t tail = size % kWordSize; tail > 0) {
+    uint64_t word = 0;
+    std::memcpy(&word, data + full_words * kWordSize, tail);
+    slot.words[full_words].store(word, std::memory_order_relaxed);
+  }
+
+  slot.sequence.store(2 * generation, std::memory_order_release);
+  generation_.store(generation, std::memory_order_release);
+  return {};
+}
+
+auto LatestFrame::read(std::vector<uint8_t>* data, uint64_t* generation) const -> science::Status {
+  if (data == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "data ptr must not be null" };
+  }
+
+  for (;;) {
+    const uint64_t latest = generation_.load(std::memory_order_acquire);
+    if (latest == 0) {
+      return { science::StatusCode::kUnavailable, "nothing published yet" };
+    }
+
+    const auto& slot = slots_[latest % kSlots];
+    if (slot.sequence.load(std::memory_order_acquire) != 2 * latest) {
+      // Already being overwritten; a newer message is complete in another slot
+      read_retries_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    const size_t size = std::min(slot.size.load(std::memory_order_relaxed), max_size_);
+    data->resize(size);
+    const size_t full_words = size / kWordSize;
+    for (size_t i = 0; i < full_words; ++i) {
+      const uint64_t word = slot.words[i].load(std::memory_order_relaxed);
+      std::memcpy(data->data() + i * kWordSize, &word, kWordSize);
+    }
+    if (const size_t tail = size % kWordSize; tail > 0) {
+      const uint64_t word = slot.words[full_words].load(std::memory_order_relaxed);
+      std::memcpy(data->data() + full_words * kWordSize, &word, tail);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == 2 * latest) {
+      if (generation != nullptr) {
+        *generation = latest;
+      }
+      return {};
+    }
+    read_retries_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+auto LatestFrame::read(synapse::BroadbandFrame* frame, uint64_t* generation) const -> science::Status {
+  if (frame == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "frame ptr must not be null" };
+  }
+
+  std::vector<uint8_t> buffer;
+  auto s = read(&buffer, generation);
+  if (!s.ok()) {
+    return s;
+  }
+  if (!frame->ParseFromArray(buffer.data(), static_cast<int>(buffer.size()))) {
+    return { science::StatusCode::kInternal, "failed to parse BroadbandFrame" };
+  }
+  return {};
+}
+
+}  // namespace synapse
@@ -2,12 +2,24 @@
 
 namespace synapse {
 
-Node::Node(const NodeType& type) : id_(0), type_(type) {}
+Node::Node(const NodeType& type) : id_(0), type_(type), device_(nullptr), revision_(0) {}
 
 auto Node::id() const -> uint32_t {
   return id_;
 }
 
+auto Node::type() const -> synapse::NodeType {
+  return type_;
+}
+
+auto Node::revision() const -> uint64_t {
+  return revision_;
+}
+
+void Node::mark_dirty() {
+  revision_++;
+}
+
 auto Node::set_device(const IDevice* device) -> science::Status {
   if (device == nullptr) {
     return { science::StatusCode::kInvalidArgument, "device ptr must not be null" };
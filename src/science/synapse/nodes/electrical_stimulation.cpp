@@ -41,6 +41,26 @@ auto ElectricalStimulation::from_proto(const synapse::NodeConfig& proto, std::sh
   return {};
 }
 
+auto ElectricalStimulation::peripheral_id() const -> uint32_t {
+  return peripheral_id_;
+}
+
+auto ElectricalStimulation::channels() const -> const std::vector<Ch>& {
+  return channels_;
+}
+
+auto ElectricalStimulation::bit_width() const -> uint32_t {
+  return bit_width_;
+}
+
+auto ElectricalStimulation::sample_rate() const -> uint32_t {
+  return sample_rate_;
+}
+
+auto ElectricalStimulation::lsb() const -> uint32_t {
+  return lsb_;
+}
+
 auto ElectricalStimulation::p_to_proto(synapse::NodeConfig* proto) -> science::Status {
   if (proto == nullptr) {
     return { science::StatusCode::kInvalidArgument, "proto ptr must not be null" };
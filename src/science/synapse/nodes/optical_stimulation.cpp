@@ -23,8 +23,7 @@ auto OpticalStimulation::from_proto(const synapse::NodeConfig& proto, std::share
   const auto& config = proto.optical_stimulation();
   std::optional<ChannelMask> pixel_mask;
   if (config.pixel_mask_size() > 0) {
-    std::vector<uint32_t> indices(config.pixel_mask().begin(), config.pixel_mask().end());
-    pixel_mask = ChannelMask(indices);
+    pixel_mask = ChannelMask::from_proto(config.pixel_mask());
   }
 
   *node = std::make_shared<OpticalStimulation>(
@@ -38,6 +37,26 @@ auto OpticalStimulation::from_proto(const synapse::NodeConfig& proto, std::share
   return {};
 }
 
+auto OpticalStimulation::peripheral_id() const -> uint32_t {
+  return peripheral_id_;
+}
+
+auto OpticalStimulation::pixel_mask() const -> const std::optional<ChannelMask>& {
+  return pixel_mask_;
+}
+
+auto OpticalStimulation::bit_width() const -> uint32_t {
+  return bit_width_;
+}
+
+auto OpticalStimulation::frame_rate() const -> uint32_t {
+  return frame_rate_;
+}
+
+auto OpticalStimulation::gain() const -> uint32_t {
+  return gain_;
+}
+
 auto OpticalStimulation::p_to_proto(synapse::NodeConfig* proto) -> science::Status {
   if (proto == nullptr) {
     return { science::StatusCode::kInvalidArgument, "proto ptr must not be null" };
@@ -46,10 +65,7 @@ auto OpticalStimulation::p_to_proto(synapse::NodeConfig* proto) -> science::Stat
   synapse::OpticalStimulationConfig* config = proto->mutable_optical_stimulation();
 
   if (pixel_mask_.has_value()) {
-    const auto& channels = pixel_mask_->channels();
-    for (const auto& c : channels) {
-      config->add_pixel_mask(c);
-    }
+    pixel_mask_->to_proto(config->mutable_pixel_mask());
   }
 
   config->set_peripheral_id(peripheral_id_);
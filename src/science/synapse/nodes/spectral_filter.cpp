@@ -27,6 +27,18 @@ auto SpectralFilter::from_proto(const synapse::NodeConfig& proto, std::shared_pt
   return {};
 }
 
+auto SpectralFilter::method() const -> synapse::SpectralFilterMethod {
+  return method_;
+}
+
+auto SpectralFilter::low_cutoff_hz() const -> uint32_t {
+  return low_cutoff_hz_;
+}
+
+auto SpectralFilter::high_cutoff_hz() const -> uint32_t {
+  return high_cutoff_hz_;
+}
+
 auto SpectralFilter::p_to_proto(synapse::NodeConfig* proto) -> science::Status {
   if (proto == nullptr) {
     return { science::StatusCode::kInvalidArgument, "proto ptr must not be null" };
@@ -19,6 +19,10 @@ auto SpikeBinner::from_proto(const synapse::NodeConfig& proto,
   return {};
 }
 
+auto SpikeBinner::bin_size_ms() const -> uint32_t {
+  return bin_size_ms_;
+}
+
 auto SpikeBinner::p_to_proto(synapse::NodeConfig* proto) -> science::Status {
   if (proto == nullptr) {
     return {science::StatusCode::kInvalidArgument, "proto ptr must not be null"};
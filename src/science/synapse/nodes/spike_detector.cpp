@@ -46,6 +46,31 @@ auto SpikeDetector::from_proto(const synapse::NodeConfig& proto, std::shared_ptr
   return {};
 }
 
+auto SpikeDetector::mode() const -> Mode {
+  return mode_;
+}
+
+auto SpikeDetector::threshold_uv() const -> uint32_t {
+  return threshold_uv_;
+}
+
+auto SpikeDetector::template_uv() const -> const std::vector<uint32_t>& {
+  return template_uv_;
+}
+
+auto SpikeDetector::samples_per_spike() const -> uint32_t {
+  return samples_per_spike_;
+}
+
+auto SpikeDetector::set_threshold_uv(uint32_t threshold_uv) -> science::Status {
+  if (mode_ != Mode::Thresholder) {
+    return { science::StatusCode::kFailedPrecondition, "only a thresholder has a threshold" };
+  }
+  threshold_uv_ = threshold_uv;
+  mark_dirty();
+  return {};
+}
+
 auto SpikeDetector::p_to_proto(synapse::NodeConfig* proto) -> science::Status {
   if (proto == nullptr) {
     return { science::StatusCode::kInvalidArgument, "proto ptr must not be null" };
@@ -47,6 +47,15 @@ auto SpikeSource::from_proto(const synapse::NodeConfig& proto, std::shared_ptr<N
   return {};
 }
 
+auto SpikeSource::threshold_uV() const -> float {
+  return threshold_uV_;
+}
+
+void SpikeSource::set_threshold_uV(float threshold_uV) {
+  threshold_uV_ = threshold_uV;
+  mark_dirty();
+}
+
 auto SpikeSource::p_to_proto(synapse::NodeConfig* proto) -> science::Status {
   if (proto == nullptr) {
     return { science::StatusCode::kInvalidArgument, "proto ptr must not be null" };
@@ -0,0 +1,109 @@
+#include "science/synapse/realtime.h"
+
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/prctl.h>
+#include <time.h>
+#endif
+
+namespace synapse {
+
+auto pin_current_thread(int cpu) -> science::Status {
+#ifdef __linux__
+  if (cpu < 0 || cpu >= CPU_SETSIZE) {
+    return { science::StatusCode::kInvalidArgument, "invalid cpu " + std::to_string(cpu) };
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  if (result != 0) {
+    return { science::StatusCode::kInvalidArgument,
+             "failed to pin to cpu " + std::to_string(cpu) + ": " + std::strerror(result) };
+  }
+  return {};
+#else
+  (void)cpu;
+  return { science::StatusCode::kUnimplemented, "thread pinning is only supported on Linux" };
+#endif
+}
+
+auto set_realtime_priority(int priority) -> science::Status {
+#ifdef __linux__
+  sched_param param{};
+  param.sched_priority = priority;
+  int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+  if (result == EPERM) {
+    return { science::StatusCode::kPermissionDenied, "SCHED_FIFO needs CAP_SYS_NICE or an rtprio limit" };
+  }
+  if (result != 0) {
+    return { science::StatusCode::kInvalidArgument,
+             "failed to set priority " + std::to_string(priority) + ": " + std::strerror(result) };
+  }
+  return {};
+#else
+  (void)priority;
+  return { science::StatusCode::kUnimplemented, "real-time priority is only supported on Linux" };
+#endif
+}
+
+void sleep_until(std::chrono::steady_clock::time_point deadline) {
+#ifdef __linux__
+  const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+  if (ns <= 0) {
+    return;
+  }
+  timespec ts{};
+  ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+  ts.tv_nsec = static_cast<long>(ns % 1000000000);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+  }
+#else
+  std::this_thread::sleep_until(deadline);
+#endif
+}
+
+auto set_timer_slack(std::chrono::nanoseconds slack) -> science::Status {
+#ifdef __linux__
+  // 0 would reset to the default, so ask for the smallest nonzero slack instead
+  const unsigned long value = slack.count() > 0 ? static_cast<unsigned long>(slack.count()) : 1;
+  if (prctl(PR_SET_TIMERSLACK, value, 0, 0, 0) != 0) {
+    return { science::StatusCode::kInternal, std::string("failed to set timer slack: ") + std::strerror(errno) };
+  }
+  return {};
+#else
+  (void)slack;
+  return { science::StatusCode::kUnimplemented, "timer slack is only supported on Linux" };
+#endif
+}
+
+auto start_placed_thread(std::thread* thread,
+                         std::function<science::Status()> place,
+                         std::function<void()> body) -> science::Status {
+  // The thread owns the promise, so it stays alive until set_value has returned
+  std::promise<science::Status> placed;
+  auto placed_result = placed.get_future();
+  *thread = std::thread([place = std::move(place), body = std::move(body), placed = std::move(placed)]() mutable {
+    auto s = place();
+    placed.set_value(s);
+    if (s.ok()) {
+      body();
+    }
+  });
+
+  auto s = placed_result.get();
+  if (!s.ok()) {
+    thread->join();
+  }
+  return s;
+}
+
+}  // namespace synapse
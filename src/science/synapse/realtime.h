@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "science/synapse/status.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#endif
+
+namespace synapse {
+
+/**
+ * Pin the calling thread to one CPU (Linux only).
+ *
+ * @param cpu The CPU index.
+ * @return science::Status kUnimplemented on other platforms.
+ */
+auto pin_current_thread(int cpu) -> science::Status;
+
+/**
+ * Move the calling thread to SCHED_FIFO at the given priority (Linux only).
+ *
+ * Needs CAP_SYS_NICE or an rtprio limit; fails with kPermissionDenied otherwise.
+ *
+ * @param priority 1 (lowest) to 99.
+ * @return science::Status
+ */
+auto set_realtime_priority(int priority) -> science::Status;
+
+/**
+ * Sleep until an absolute deadline, without the drift of sleeping for a relative duration.
+ *
+ * Uses clock_nanosleep with TIMER_ABSTIME on Linux, where steady_clock is CLOCK_MONOTONIC, and
+ * std::this_thread::sleep_until elsewhere. Wakes up late by the scheduler's latency and the
+ * thread's timer slack; spin out the last stretch if that matters.
+ */
+void sleep_until(std::chrono::steady_clock::time_point deadline);
+
+/**
+ * Set the calling thread's timer slack, how late the kernel may make its timed wakeups to batch
+ * them (Linux only; 50 us by default, and ignored under SCHED_FIFO).
+ *
+ * @return science::Status kUnimplemented on other platforms.
+ */
+auto set_timer_slack(std::chrono::nanoseconds slack) -> science::Status;
+
+/**
+ * Start a thread that places itself (e.g. pins itself or raises its priority) before running.
+ *
+ * Blocks until `place` has returned on the new thread, so the caller learns whether placement
+ * worked. On failure the thread is joined without running `body`.
+ *
+ * @param thread Output parameter for the thread; must not be joinable.
+ * @param place Run first, on the new thread.
+ * @param body Run on the new thread once `place` succeeds.
+ * @return science::Status The status from `place`.
+ */
+auto start_placed_thread(std::thread* thread,
+                         std::function<science::Status()> place,
+                         std::function<void()> body) -> science::Status;
+
+/**
+ * Hint to the CPU that we're in a spin loop, so a sibling hyperthread gets the core.
+ */
+inline void cpu_relax() {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  _mm_pause();
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+  asm volatile("yield");
+#endif
+}
+
+}  // namespace synapse
@@ -0,0 +1,688 @@
+#include "science/synapse/recording/chunked_recording.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+#ifdef _WIN32
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "science/synapse/recording/file_writer.h"
+#include "science/synapse/recording/tap_recorder.h"
+
+namespace synapse {
+
+namespace {
+
+// All fields are stored in host (little-endian) byte order
+constexpr char kFileMagic[8] = { 'S', 'Y', 'N', 'R', 'E', 'C', '0', '1' };
+constexpr char kIndexMagic[8] = { 'S', 'Y', 'N', 'I', 'D', 'X', '0', '1' };
+constexpr uint32_t kVersion = 1;
+constexpr size_t kFileHeaderSize = kDirectIoAlignment;
+constexpr uint32_t kChunkMarker = 0x4b4e4843;  // "CHNK"
+constexpr uint32_t kSampleChunk = 1;
+constexpr uint32_t kSpikeChunk = 2;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint32_t num_channels;
+  uint32_t samples_per_chunk;
+  float sample_rate_hz;
+};
+
+// Sample chunks hold `stride` timestamps, `stride` sequence numbers, then `stride` samples per channel
+struct ChunkHeader {
+  uint32_t marker;
+  uint32_t kind;
+  uint32_t num_items;
+  uint32_t stride;
+  uint64_t first_timestamp_ns;
+  uint64_t last_timestamp_ns;
+  uint64_t first_sequence_number;
+  uint64_t payload_bytes;
+  uint8_t reserved[16];
+};
+static_assert(sizeof(ChunkHeader) == 64, "chunk header must keep the payload 64 byte aligned");
+
+struct RecordedSpike {
+  uint64_t timestamp_ns;
+  uint64_t sample;
+  uint32_t channel;
+  float score;
+};
+static_assert(sizeof(RecordedSpike) == 24, "unexpected spike record padding");
+
+struct IndexTrailer {
+  char magic[8];
+  uint64_t index_offset;
+  uint64_t num_entries;
+};
+static_assert(sizeof(ChunkIndexEntry) == 40, "unexpected index entry padding");
+
+auto sample_payload_bytes(size_t stride, size_t num_channels) -> uint64_t {
+  return stride * (2 * sizeof(uint64_t) + num_channels * sizeof(int32_t));
+}
+
+// Sizes below come from the file, so these checks are written so they can't overflow
+auto chunk_fits(uint64_t offset, uint64_t payload_bytes, size_t size) -> bool {
+  return offset >= kFileHeaderSize && offset <= size && size - offset >= sizeof(ChunkHeader) &&
+         payload_bytes <= size - offset - sizeof(ChunkHeader);
+}
+
+// The payload size a chunk must have for its item count, or an error if the count is impossible
+auto chunk_payload_bytes(const ChunkIndexEntry& entry, size_t samples_per_chunk, size_t num_channels,
+                         uint64_t* payload_bytes) -> science::Status {
+  if (entry.kind == kSampleChunk) {
+    if (entry.num_items == 0 || entry.num_items > samples_per_chunk) {
+      return {
+        science::StatusCode::kDataLoss,
+        "sample chunk at offset " + std::to_string(entry.offset) + " holds " + std::to_string(entry.num_items) +
+          " samples, expected 1 to " + std::to_string(samples_per_chunk)
+      };
+    }
+    *payload_bytes = sample_payload_bytes(samples_per_chunk, num_channels);
+  } else if (entry.kind == kSpikeChunk) {
+    if (entry.num_items == 0) {
+      return { science::StatusCode::kDataLoss, "spike chunk at offset " + std::to_string(entry.offset) + " is empty" };
+    }
+    *payload_bytes = uint64_t(entry.num_items) * sizeof(RecordedSpike);
+  } else {
+    *payload_bytes = 0;
+  }
+  return {};
+}
+
+auto validate_channels(const std::vector<uint32_t>& channels, size_t num_channels) -> science::Status {
+  for (auto channel : channels) {
+    if (channel >= num_channels) {
+      return {
+        science::StatusCode::kOutOfRange,
+        "channel " + std::to_string(channel) + " out of range for " + std::to_string(num_channels) + " channels"
+      };
+    }
+  }
+  return {};
+}
+
+}  // namespace
+
+auto RecordingWindow::num_samples() const -> size_t {
+  size_t total = 0;
+  for (const auto& chunk : chunks) {
+    total += chunk.num_samples;
+  }
+  return total;
+}
+
+RecordingWriter::RecordingWriter(std::unique_ptr<FileWriter> file, size_t num_channels,
+                                 const RecordingOptions& options)
+    : file_(std::move(file)), num_channels_(num_channels), options_(options) {
+  auto size = sizeof(ChunkHeader) + sample_payload_bytes(options_.samples_per_chunk, num_channels_);
+  chunk_ = std::make_unique<AlignedBuffer>(size);
+  std::memset(chunk_->data(), 0, chunk_->capacity());
+}
+
+RecordingWriter::~RecordingWriter() {
+  (void)close();
+}
+
+auto RecordingWriter::create(
+  const std::string& path,
+  size_t num_channels,
+  float sample_rate_hz,
+  std::unique_ptr<RecordingWriter>* writer,
+  const RecordingOptions& options
+) -> science::Status {
+  if (writer == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "writer ptr must not be null" };
+  }
+  if (num_channels == 0) {
+    return { science::StatusCode::kInvalidArgument, "recording must have at least one channel" };
+  }
+  if (sample_rate_hz <= 0) {
+    return { science::StatusCode::kInvalidArgument, "sample rate must be positive" };
+  }
+  if (options.samples_per_chunk == 0 || options.spikes_per_chunk == 0) {
+    return { science::StatusCode::kInvalidArgument, "chunk sizes must be positive" };
+  }
+
+  std::unique_ptr<FileWriter> file;
+  auto s = FileWriter::open(path, options.direct_io, 0, &file);
+  if (!s.ok()) {
+    return s;
+  }
+
+  AlignedBuffer header(kFileHeaderSize);
+  std::memset(header.data(), 0, header.capacity());
+  FileHeader fields;
+  std::memcpy(fields.magic, kFileMagic, sizeof(kFileMagic));
+  fields.version = kVersion;
+  fields.header_size = static_cast<uint32_t>(kFileHeaderSize);
+  fields.num_channels = static_cast<uint32_t>(num_channels);
+  fields.samples_per_chunk = static_cast<uint32_t>(options.samples_per_chunk);
+  fields.sample_rate_hz = sample_rate_hz;
+  std::memcpy(header.data(), &fields, sizeof(fields));
+  header.size = header.capacity();
+  s = file->append(&header);
+  if (!s.ok()) {
+    return s;
+  }
+
+  std::unique_ptr<RecordingWriter> result(new RecordingWriter(std::move(file), num_channels, options));
+  result->offset_ = kFileHeaderSize;
+  *writer = std::move(result);
+  return {};
+}
+
+auto RecordingWriter::import_tap_recording(
+  const std::string& tap_recording_path,
+  const std::string& path,
+  const RecordingOptions& options
+) -> science::Status {
+  std::unique_ptr<TapRecordingReader> reader;
+  auto s = TapRecordingReader::open(tap_recording_path, &reader);
+  if (!s.ok()) {
+    return s;
+  }
+  if (!reader->message_type().empty() && reader->message_type().find("BroadbandFrame") == std::string::npos) {
+    return { science::StatusCode::kUnimplemented, "cannot import " + reader->message_type() + " messages" };
+  }
+
+  std::unique_ptr<RecordingWriter> writer;
+  std::vector<uint8_t> message;
+  synapse::BroadbandFrame frame;
+  while ((s = reader->next(&message)).ok()) {
+    if (!frame.ParseFromArray(message.data(), static_cast<int>(message.size()))) {
+      return { science::StatusCode::kDataLoss, "failed to parse BroadbandFrame" };
+    }
+    if (writer == nullptr) {
+      s = create(path, frame.frame_data_size(), frame.sample_rate_hz(), &writer, options);
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    s = writer->append(frame);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  if (s.code() != science::StatusCode::kOutOfRange) {
+    return s;
+  }
+  if (writer == nullptr) {
+    return { science::StatusCode::kInvalidArgument, tap_recording_path + " has no frames" };
+  }
+  return writer->close();
+}
+
+auto RecordingWriter::append(const synapse::BroadbandFrame& frame) -> science::Status {
+  if (closed_) {
+    return { science::StatusCode::kFailedPrecondition, "recording is closed" };
+  }
+  if (static_cast<size_t>(frame.frame_data_size()) != num_channels_) {
+    return {
+      science::StatusCode::kInvalidArgument,
+      "frame has " + std::to_string(frame.frame_data_size()) + " channels, expected " + std::to_string(num_channels_)
+    };
+  }
+  if (frame.timestamp_ns() < last_timestamp_ns_) {
+    return { science::StatusCode::kInvalidArgument, "frames must be appended in timestamp order" };
+  }
+  last_timestamp_ns_ = frame.timestamp_ns();
+
+  const auto stride = options_.samples_per_chunk;
+  auto* timestamps = reinterpret_cast<uint64_t*>(chunk_->data() + sizeof(ChunkHeader));
+  auto* sequence_numbers = timestamps + stride;
+  auto* samples = reinterpret_cast<int32_t*>(sequence_numbers + stride);
+  timestamps[chunk_samples_] = frame.timestamp_ns();
+  sequence_numbers[chunk_samples_] = frame.sequence_number();
+  for (size_t c = 0; c < num_channels_; ++c) {
+    samples[c * stride + chunk_samples_] = frame.frame_data(static_cast<int>(c));
+  }
+
+  if (++chunk_samples_ == stride) {
+    return flush_samples();
+  }
+  return {};
+}
+
+auto RecordingWriter::append_spikes(const std::vector<SpikeEvent>& events) -> science::Status {
+  if (closed_) {
+    return { science::StatusCode::kFailedPrecondition, "recording is closed" };
+  }
+
+  for (const auto& event : events) {
+    if (event.timestamp_ns < last_spike_timestamp_ns_) {
+      return { science::StatusCode::kInvalidArgument, "spikes must be appended in timestamp order" };
+    }
+    last_spike_timestamp_ns_ = event.timestamp_ns;
+    spikes_.push_back(event);
+    if (spikes_.size() == options_.spikes_per_chunk) {
+      auto s = flush_spikes();
+      if (!s.ok()) {
+        return s;
+      }
+    }
+  }
+  return {};
+}
+
+auto RecordingWriter::close() -> science::Status {
+  if (closed_) {
+    return {};
+  }
+  closed_ = true;
+
+  auto s = flush_samples();
+  if (s.ok()) {
+    s = flush_spikes();
+  }
+  if (!s.ok()) {
+    (void)file_->close();
+    return s;
+  }
+
+  IndexTrailer trailer;
+  std::memcpy(trailer.magic, kIndexMagic, sizeof(kIndexMagic));
+  trailer.index_offset = offset_;
+  trailer.num_entries = index_.size();
+
+  auto index_bytes = index_.size() * sizeof(ChunkIndexEntry);
+  AlignedBuffer buffer(index_bytes + sizeof(trailer));
+  if (index_bytes > 0) {
+    std::memcpy(buffer.data(), index_.data(), index_bytes);
+  }
+  std::memcpy(buffer.data() + index_bytes, &trailer, sizeof(trailer));
+  buffer.size = index_bytes + sizeof(trailer);
+
+  s = file_->append(&buffer);
+  auto closed = file_->close();
+  return s.ok() ? closed : s;
+}
+
+auto RecordingWriter::flush_samples() -> science::Status {
+  if (chunk_samples_ == 0) {
+    return {};
+  }
+
+  const auto stride = options_.samples_per_chunk;
+  const auto n = chunk_samples_;
+  auto* timestamps = reinterpret_cast<uint64_t*>(chunk_->data() + sizeof(ChunkHeader));
+  auto* sequence_numbers = timestamps + stride;
+  auto* samples = reinterpret_cast<int32_t*>(sequence_numbers + stride);
+
+  // Clear what a previous chunk left past the end of a partial one
+  if (n < stride) {
+    std::fill(timestamps + n, timestamps + stride, 0);
+    std::fill(sequence_numbers + n, sequence_numbers + stride, 0);
+    for (size_t c = 0; c < num_channels_; ++c) {
+      std::fill(samples + c * stride + n, samples + (c + 1) * stride, 0);
+    }
+  }
+
+  ChunkHeader header = {};
+  header.marker = kChunkMarker;
+  header.kind = kSampleChunk;
+  header.num_items = static_cast<uint32_t>(n);
+  header.stride = static_cast<uint32_t>(stride);
+  header.first_timestamp_ns = timestamps[0];
+  header.last_timestamp_ns = timestamps[n - 1];
+  header.first_sequence_number = sequence_numbers[0];
+  header.payload_bytes = sample_payload_bytes(stride, num_channels_);
+  std::memcpy(chunk_->data(), &header, sizeof(header));
+
+  chunk_->size = chunk_->capacity();
+  auto s = file_->append(chunk_.get());
+  if (!s.ok()) {
+    return s;
+  }
+
+  index_.push_back({ header.first_timestamp_ns, header.last_timestamp_ns, header.first_sequence_number, offset_,
+                     header.num_items, kSampleChunk });
+  offset_ += chunk_->size;
+  chunk_samples_ = 0;
+  return {};
+}
+
+auto RecordingWriter::flush_spikes() -> science::Status {
+  if (spikes_.empty()) {
+    return {};
+  }
+
+  ChunkHeader header = {};
+  header.marker = kChunkMarker;
+  header.kind = kSpikeChunk;
+  header.num_items = static_cast<uint32_t>(spikes_.size());
+  header.first_timestamp_ns = spikes_.front().timestamp_ns;
+  header.last_timestamp_ns = spikes_.back().timestamp_ns;
+  header.payload_bytes = spikes_.size() * sizeof(RecordedSpike);
+
+  AlignedBuffer buffer(sizeof(header) + header.payload_bytes);
+  std::memset(buffer.data(), 0, buffer.capacity());
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  auto* records = reinterpret_cast<RecordedSpike*>(buffer.data() + sizeof(header));
+  for (size_t i = 0; i < spikes_.size(); ++i) {
+    records[i] = { spikes_[i].timestamp_ns, spikes_[i].sample, spikes_[i].channel, spikes_[i].score };
+  }
+
+  buffer.size = buffer.capacity();
+  auto s = file_->append(&buffer);
+  if (!s.ok()) {
+    return s;
+  }
+
+  index_.push_back({ header.first_timestamp_ns, header.last_timestamp_ns, 0, offset_, header.num_items, kSpikeChunk });
+  offset_ += buffer.size;
+  spikes_.clear();
+  return {};
+}
+
+RecordingReader::RecordingReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+RecordingReader::~RecordingReader() {
+#ifdef _WIN32
+  delete[] data_;
+#else
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+#endif
+}
+
+auto RecordingReader::open(const std::string& path, std::unique_ptr<RecordingReader>* reader) -> science::Status {
+  if (reader == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "reader ptr must not be null" };
+  }
+
+#ifdef _WIN32
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return { science::StatusCode::kNotFound, "failed to open " + path };
+  }
+  std::fseek(file, 0, SEEK_END);
+  auto size = static_cast<size_t>(std::ftell(file));
+  std::fseek(file, 0, SEEK_SET);
+  auto* data = new uint8_t[size];
+  auto read = std::fread(data, 1, size, file);
+  std::fclose(file);
+  std::unique_ptr<RecordingReader> result(new RecordingReader(data, size));
+  if (read != size) {
+    return { science::StatusCode::kInternal, "failed to read " + path };
+  }
+#else
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return { science::StatusCode::kNotFound, "failed to open " + path };
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kFileHeaderSize)) {
+    ::close(fd);
+    return { science::StatusCode::kInvalidArgument, path + " is not a recording" };
+  }
+  auto size = static_cast<size_t>(st.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return { science::StatusCode::kInternal, "failed to map " + path };
+  }
+  std::unique_ptr<RecordingReader> result(new RecordingReader(static_cast<const uint8_t*>(data), size));
+#endif
+
+  auto s = result->load_index();
+  if (!s.ok()) {
+    return s;
+  }
+  *reader = std::move(result);
+  return {};
+}
+
+auto RecordingReader::load_index() -> science::Status {
+  FileHeader header;
+  if (size_ < kFileHeaderSize) {
+    return { science::StatusCode::kInvalidArgument, "file is not a recording" };
+  }
+  std::memcpy(&header, data_, sizeof(header));
+  if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0) {
+    return { science::StatusCode::kInvalidArgument, "file is not a recording" };
+  }
+  if (header.version != kVersion) {
+    return { science::StatusCode::kUnimplemented, "unsupported recording version " + std::to_string(header.version) };
+  }
+  num_channels_ = header.num_channels;
+  samples_per_chunk_ = header.samples_per_chunk;
+  sample_rate_hz_ = header.sample_rate_hz;
+  if (num_channels_ == 0 || samples_per_chunk_ == 0 ||
+      samples_per_chunk_ > std::numeric_limits<uint64_t>::max() / sample_payload_bytes(1, num_channels_)) {
+    return { science::StatusCode::kDataLoss, "file header has impossible chunk dimensions" };
+  }
+
+  // Use the index written on close, or rebuild it if the recording was cut short
+  std::vector<ChunkIndexEntry> entries;
+  IndexTrailer trailer = {};
+  if (size_ >= kFileHeaderSize + sizeof(trailer)) {
+    std::memcpy(&trailer, data_ + size_ - sizeof(trailer), sizeof(trailer));
+  }
+  if (std::memcmp(trailer.magic, kIndexMagic, sizeof(kIndexMagic)) == 0 &&
+      trailer.num_entries <= (size_ - kFileHeaderSize - sizeof(trailer)) / sizeof(ChunkIndexEntry) &&
+      trailer.index_offset == size_ - sizeof(trailer) - trailer.num_entries * sizeof(ChunkIndexEntry)) {
+    entries.resize(trailer.num_entries);
+    if (!entries.empty()) {
+      std::memcpy(entries.data(), data_ + trailer.index_offset, entries.size() * sizeof(ChunkIndexEntry));
+    }
+  } else {
+    return scan_chunks();
+  }
+
+  for (const auto& entry : entries) {
+    uint64_t payload_bytes = 0;
+    auto s = chunk_payload_bytes(entry, samples_per_chunk_, num_channels_, &payload_bytes);
+    if (!s.ok()) {
+      return s;
+    }
+    if (!chunk_fits(entry.offset, payload_bytes, size_)) {
+      return { science::StatusCode::kDataLoss, "index points past the end of the file" };
+    }
+    if (entry.kind == kSampleChunk) {
+      sample_index_.push_back(entry);
+      num_samples_ += entry.num_items;
+    } else if (entry.kind == kSpikeChunk) {
+      spike_index_.push_back(entry);
+      num_spikes_ += entry.num_items;
+    }
+  }
+  return {};
+}
+
+auto RecordingReader::scan_chunks() -> science::Status {
+  uint64_t offset = kFileHeaderSize;
+  while (offset <= size_ && size_ - offset >= sizeof(ChunkHeader)) {
+    ChunkHeader header;
+    std::memcpy(&header, data_ + offset, sizeof(header));
+
+    if (header.marker != kChunkMarker) {
+      break;
+    }
+    if (header.kind == kSampleChunk && header.stride != samples_per_chunk_) {
+      return { science::StatusCode::kDataLoss, "chunk stride does not match the file header" };
+    }
+
+    ChunkIndexEntry entry = { header.first_timestamp_ns, header.last_timestamp_ns, header.first_sequence_number,
+                              offset, header.num_items, header.kind };
+    uint64_t payload_bytes = 0;
+    auto s = chunk_payload_bytes(entry, samples_per_chunk_, num_channels_, &payload_bytes);
+    if (!s.ok()) {
+      return s;
+    }
+    if ((header.kind == kSampleChunk || header.kind == kSpikeChunk) && header.payload_bytes != payload_bytes) {
+      return {
+        science::StatusCode::kDataLoss,
+        "chunk at offset " + std::to_string(offset) + " has " + std::to_string(header.payload_bytes) +
+          " payload bytes, expected " + std::to_string(payload_bytes)
+      };
+    }
+
+    // A chunk the recording was cut short in the middle of
+    if (!chunk_fits(offset, header.payload_bytes, size_)) {
+      break;
+    }
+
+    if (header.kind == kSampleChunk) {
+      sample_index_.push_back(entry);
+      num_samples_ += entry.num_items;
+    } else if (header.kind == kSpikeChunk) {
+      spike_index_.push_back(entry);
+      num_spikes_ += entry.num_items;
+    }
+    offset += AlignedBuffer::rounded_size(sizeof(header) + header.payload_bytes);
+  }
+  return {};
+}
+
+auto RecordingReader::seek(uint64_t timestamp_ns) const -> size_t {
+  auto it = std::lower_bound(
+    sample_index_.begin(), sample_index_.end(), timestamp_ns,
+    [](const ChunkIndexEntry& entry, uint64_t t) { return entry.last_timestamp_ns < t; }
+  );
+  return static_cast<size_t>(it - sample_index_.begin());
+}
+
+auto RecordingReader::seek_sequence(uint64_t sequence_number) const -> size_t {
+  auto it = std::upper_bound(
+    sample_index_.begin(), sample_index_.end(), sequence_number,
+    [](uint64_t n, const ChunkIndexEntry& entry) { return n < entry.first_sequence_number; }
+  );
+  if (it == sample_index_.begin()) {
+    return 0;
+  }
+
+  // Past the last sequence number of the final chunk is past the end
+  auto chunk = static_cast<size_t>(it - sample_index_.begin()) - 1;
+  if (chunk + 1 == sample_index_.size()) {
+    ChunkView last;
+    view(sample_index_[chunk], 0, sample_index_[chunk].num_items, { 0 }, &last);
+    if (sequence_number > last.sequence_numbers[last.num_samples - 1]) {
+      return sample_index_.size();
+    }
+  }
+  return chunk;
+}
+
+auto RecordingReader::chunk(size_t chunk, const std::vector<uint32_t>& channels, ChunkView* view) const
+  -> science::Status {
+  if (view == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "view ptr must not be null" };
+  }
+  if (chunk >= sample_index_.size()) {
+    return { science::StatusCode::kOutOfRange, "chunk " + std::to_string(chunk) + " out of range" };
+  }
+  auto s = validate_channels(channels, num_channels_);
+  if (!s.ok()) {
+    return s;
+  }
+
+  std::vector<uint32_t> all;
+  if (channels.empty()) {
+    all.resize(num_channels_);
+    std::iota(all.begin(), all.end(), 0);
+  }
+  this->view(sample_index_[chunk], 0, sample_index_[chunk].num_items, channels.empty() ? all : channels, view);
+  return {};
+}
+
+auto RecordingReader::read(
+  uint64_t start_ns,
+  uint64_t end_ns,
+  const std::vector<uint32_t>& channels,
+  RecordingWindow* window
+) const -> science::Status {
+  if (window == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "window ptr must not be null" };
+  }
+  auto s = validate_channels(channels, num_channels_);
+  if (!s.ok()) {
+    return s;
+  }
+
+  window->chunks.clear();
+  window->channels = channels;
+  if (channels.empty()) {
+    window->channels.resize(num_channels_);
+    std::iota(window->channels.begin(), window->channels.end(), 0);
+  }
+
+  for (auto i = seek(start_ns); i < sample_index_.size() && sample_index_[i].first_timestamp_ns < end_ns; ++i) {
+    const auto& entry = sample_index_[i];
+    const auto* timestamps = reinterpret_cast<const uint64_t*>(data_ + entry.offset + sizeof(ChunkHeader));
+    const auto* end = timestamps + entry.num_items;
+    auto begin = static_cast<size_t>(std::lower_bound(timestamps, end, start_ns) - timestamps);
+    auto stop = static_cast<size_t>(std::lower_bound(timestamps, end, end_ns) - timestamps);
+    if (begin < stop) {
+      window->chunks.emplace_back();
+      view(entry, begin, stop, window->channels, &window->chunks.back());
+    }
+  }
+  return {};
+}
+
+auto RecordingReader::read_spikes(
+  uint64_t start_ns,
+  uint64_t end_ns,
+  const std::vector<uint32_t>& channels,
+  std::vector<SpikeEvent>* events
+) const -> science::Status {
+  if (events == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "events ptr must not be null" };
+  }
+  auto s = validate_channels(channels, num_channels_);
+  if (!s.ok()) {
+    return s;
+  }
+
+  std::vector<bool> keep(num_channels_, channels.empty());
+  for (auto channel : channels) {
+    keep[channel] = true;
+  }
+
+  auto it = std::lower_bound(
+    spike_index_.begin(), spike_index_.end(), start_ns,
+    [](const ChunkIndexEntry& entry, uint64_t t) { return entry.last_timestamp_ns < t; }
+  );
+  for (; it != spike_index_.end() && it->first_timestamp_ns < end_ns; ++it) {
+    const auto* records = reinterpret_cast<const RecordedSpike*>(data_ + it->offset + sizeof(ChunkHeader));
+    for (size_t i = 0; i < it->num_items; ++i) {
+      const auto& record = records[i];
+      if (record.timestamp_ns >= start_ns && record.timestamp_ns < end_ns && record.channel < num_channels_ &&
+          keep[record.channel]) {
+        events->push_back({ record.channel, record.sample, record.timestamp_ns, record.score });
+      }
+    }
+  }
+  return {};
+}
+
+auto RecordingReader::view(const ChunkIndexEntry& entry, size_t begin, size_t end,
+                           const std::vector<uint32_t>& channels, ChunkView* view) const -> void {
+  const auto stride = samples_per_chunk_;
+  const auto* timestamps = reinterpret_cast<const uint64_t*>(data_ + entry.offset + sizeof(ChunkHeader));
+  const auto* sequence_numbers = timestamps + stride;
+  const auto* samples = reinterpret_cast<const int32_t*>(sequence_numbers + stride);
+
+  view->num_samples = end - begin;
+  view->timestamps_ns = timestamps + begin;
+  view->sequence_numbers = sequence_numbers + begin;
+  view->channels.resize(channels.size());
+  for (size_t i = 0; i < channels.size(); ++i) {
+    view->channels[i] = samples + channels[i] * stride + begin;
+  }
+}
+
+}  // namespace synapse
@@ -0,0 +1,195 @@
+#include "science/synapse/recording/file_writer.h"
+
+#include <fcntl.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace synapse {
+
+namespace {
+
+auto round_up(uint64_t value, uint64_t alignment) -> uint64_t {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+auto errno_message(const std::string& what) -> std::string {
+  return what + ": " + std::strerror(errno);
+}
+
+#ifdef _WIN32
+auto open_file(const std::string& path, bool) -> int {
+  return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+auto write_some(int fd, const uint8_t* data, size_t size, uint64_t) -> int64_t {
+  return _write(fd, data, static_cast<unsigned int>(size));
+}
+auto truncate_file(int fd, uint64_t size) -> int {
+  return _chsize_s(fd, static_cast<int64_t>(size)) == 0 ? 0 : -1;
+}
+auto close_file(int fd) -> int {
+  return _close(fd);
+}
+#else
+auto open_file(const std::string& path, bool direct_io) -> int {
+  int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+#ifdef O_DIRECT
+  if (direct_io) {
+    flags |= O_DIRECT;
+  }
+#endif
+  return ::open(path.c_str(), flags, 0644);
+}
+auto write_some(int fd, const uint8_t* data, size_t size, uint64_t offset) -> int64_t {
+  return ::pwrite(fd, data, size, static_cast<off_t>(offset));
+}
+auto truncate_file(int fd, uint64_t size) -> int {
+  return ::ftruncate(fd, static_cast<off_t>(size));
+}
+auto close_file(int fd) -> int {
+  return ::close(fd);
+}
+#endif
+
+}  // namespace
+
+AlignedBuffer::AlignedBuffer(size_t size) : capacity_(rounded_size(size)) {
+  void* data = nullptr;
+#ifdef _WIN32
+  data = _aligned_malloc(capacity_, kDirectIoAlignment);
+#else
+  if (posix_memalign(&data, kDirectIoAlignment, capacity_) != 0) {
+    data = nullptr;
+  }
+#endif
+  if (data == nullptr) {
+    throw std::bad_alloc();
+  }
+  data_ = static_cast<uint8_t*>(data);
+}
+
+AlignedBuffer::~AlignedBuffer() {
+#ifdef _WIN32
+  _aligned_free(data_);
+#else
+  std::free(data_);
+#endif
+}
+
+FileWriter::FileWriter(int fd, bool direct, uint64_t preallocate_bytes)
+    : fd_(fd), direct_(direct), preallocate_bytes_(preallocate_bytes), allocated_(0), size_(0), offset_(0) {}
+
+FileWriter::~FileWriter() {
+  if (fd_ >= 0) {
+    (void)close();
+  }
+}
+
+auto FileWriter::open(
+  const std::string& path,
+  bool direct_io,
+  uint64_t preallocate_bytes,
+  std::unique_ptr<FileWriter>* writer
+) -> science::Status {
+  if (writer == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "writer ptr must not be null" };
+  }
+
+  bool direct = false;
+  int fd = -1;
+  if (direct_io) {
+    // Filesystems like tmpfs reject O_DIRECT, so fall back to buffered writes there
+    fd = open_file(path, true);
+#if defined(O_DIRECT)
+    direct = fd >= 0;
+#elif defined(F_NOCACHE)
+    direct = fd >= 0 && fcntl(fd, F_NOCACHE, 1) == 0;
+#endif
+  }
+  if (fd < 0) {
+    fd = open_file(path, false);
+  }
+  if (fd < 0) {
+    return { science::StatusCode::kInternal, errno_message("failed to open " + path) };
+  }
+
+  writer->reset(new FileWriter(fd, direct, preallocate_bytes));
+  return {};
+}
+
+auto FileWriter::append(AlignedBuffer* buffer) -> science::Status {
+  if (fd_ < 0) {
+    return { science::StatusCode::kFailedPrecondition, "file is closed" };
+  }
+  if (buffer == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "buffer ptr must not be null" };
+  }
+  if (offset_ != size_) {
+    return { science::StatusCode::kFailedPrecondition, "only the last write may be unaligned" };
+  }
+
+  size_t length = buffer->size;
+  if (direct_) {
+    length = round_up(length, kDirectIoAlignment);
+    if (length > buffer->capacity()) {
+      return { science::StatusCode::kInvalidArgument, "buffer has no room for alignment padding" };
+    }
+    std::memset(buffer->data() + buffer->size, 0, length - buffer->size);
+  }
+
+#ifdef __linux__
+  // Reserve space in large steps so writes land in already-allocated extents
+  if (preallocate_bytes_ > 0 && offset_ + length > allocated_) {
+    auto target = round_up(offset_ + length, preallocate_bytes_);
+    if (fallocate(fd_, 0, static_cast<off_t>(allocated_), static_cast<off_t>(target - allocated_)) == 0) {
+      allocated_ = target;
+    } else if (errno == EOPNOTSUPP) {
+      preallocate_bytes_ = 0;
+    } else {
+      return { science::StatusCode::kInternal, errno_message("failed to preallocate") };
+    }
+  }
+#endif
+
+  size_t written = 0;
+  while (written < length) {
+    auto n = write_some(fd_, buffer->data() + written, length - written, offset_ + written);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return { science::StatusCode::kInternal, errno_message("failed to write") };
+    }
+    written += static_cast<size_t>(n);
+  }
+
+  offset_ += length;
+  size_ += buffer->size;
+  return {};
+}
+
+auto FileWriter::close() -> science::Status {
+  if (fd_ < 0) {
+    return {};
+  }
+
+  science::Status status;
+  if ((offset_ != size_ || allocated_ > size_) && truncate_file(fd_, size_) != 0) {
+    status = { science::StatusCode::kInternal, errno_message("failed to truncate") };
+  }
+  if (close_file(fd_) != 0 && status.ok()) {
+    status = { science::StatusCode::kInternal, errno_message("failed to close") };
+  }
+  fd_ = -1;
+  return status;
+}
+
+}  // namespace synapse
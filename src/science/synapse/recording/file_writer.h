@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "science/synapse/status.h"
+
+namespace synapse {
+
+// Alignment O_DIRECT needs for buffer addresses, write sizes and file offsets
+constexpr size_t kDirectIoAlignment = 4096;
+
+/**
+ * An aligned, heap-allocated byte buffer suitable for O_DIRECT writes.
+ */
+class AlignedBuffer {
+ public:
+  explicit AlignedBuffer(size_t size);
+  ~AlignedBuffer();
+
+  AlignedBuffer(const AlignedBuffer&) = delete;
+  AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+  [[nodiscard]] auto data() -> uint8_t* { return data_; }
+  [[nodiscard]] auto data() const -> const uint8_t* { return data_; }
+  [[nodiscard]] auto capacity() const -> size_t { return capacity_; }
+
+  // The capacity a buffer of the given size gets
+  [[nodiscard]] static auto rounded_size(size_t size) -> size_t {
+    return (size + kDirectIoAlignment - 1) / kDirectIoAlignment * kDirectIoAlignment;
+  }
+
+  // Bytes of valid data at the front of the buffer
+  size_t size = 0;
+
+ private:
+  uint8_t* data_;
+  size_t capacity_;
+};
+
+/**
+ * Appends to a file with O_DIRECT where the filesystem allows it, preallocating space
+ * ahead of the write position with fallocate.
+ *
+ * With direct I/O every write but the last must be a multiple of kDirectIoAlignment;
+ * close() trims the padding of the last write.
+ */
+class FileWriter {
+ public:
+  /**
+   * @param path The file to create or truncate.
+   * @param direct_io Whether to try O_DIRECT; falls back to buffered I/O if unsupported.
+   * @param preallocate_bytes How far ahead of the write position to reserve space (0 to disable).
+   * @param writer Output parameter for the writer.
+   */
+  [[nodiscard]] static auto open(
+    const std::string& path,
+    bool direct_io,
+    uint64_t preallocate_bytes,
+    std::unique_ptr<FileWriter>* writer
+  ) -> science::Status;
+
+  ~FileWriter();
+
+  /**
+   * Append a buffer. With direct I/O, the buffer's capacity must allow padding its size to the alignment.
+   */
+  [[nodiscard]] auto append(AlignedBuffer* buffer) -> science::Status;
+
+  /**
+   * Trim any padding and preallocated space, and close the file.
+   */
+  [[nodiscard]] auto close() -> science::Status;
+
+  [[nodiscard]] auto direct() const -> bool { return direct_; }
+  [[nodiscard]] auto size() const -> uint64_t { return size_; }
+
+ private:
+  FileWriter(int fd, bool direct, uint64_t preallocate_bytes);
+
+  int fd_;
+  bool direct_;
+  uint64_t preallocate_bytes_;
+  uint64_t allocated_;
+
+  // Bytes of data written, and where the next write goes (past any padding)
+  uint64_t size_;
+  uint64_t offset_;
+};
+
+}  // namespace synapse
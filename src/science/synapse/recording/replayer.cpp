@@ -0,0 +1,364 @@
+#include "science/synapse/recording/replayer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+namespace synapse {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Longest single sleep, so stop() is noticed during long gaps in a recording
+constexpr auto kMaxSleep = std::chrono::milliseconds(50);
+
+}  // namespace
+
+Replayer::Replayer(const ReplayOptions& options) : options_(options), speed_(options.speed) {}
+
+Replayer::~Replayer() {
+  stop();
+}
+
+auto Replayer::create(
+  const std::string& path,
+  std::unique_ptr<Replayer>* replayer,
+  const ReplayOptions& options
+) -> science::Status {
+  if (replayer == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "replayer ptr must not be null" };
+  }
+  if (!(options.speed >= 0) || !std::isfinite(options.speed)) {
+    return { science::StatusCode::kInvalidArgument, "speed must be zero or positive" };
+  }
+  if (options.index_interval == 0) {
+    return { science::StatusCode::kInvalidArgument, "index interval must be positive" };
+  }
+
+  std::unique_ptr<Replayer> result(new Replayer(options));
+  auto s = TapRecordingReader::open(path, &result->reader_);
+  if (!s.ok()) {
+    return s;
+  }
+  const auto& message_type = result->reader_->message_type();
+  if (options.codec_batch_frames > 0 && !message_type.empty() &&
+      message_type.find("BroadbandFrame") == std::string::npos) {
+    return { science::StatusCode::kInvalidArgument, "cannot encode " + message_type + " messages" };
+  }
+  s = result->build_index();
+  if (!s.ok()) {
+    return s;
+  }
+
+  try {
+    result->zmq_context_ = std::make_unique<zmq::context_t>(1);
+    result->zmq_socket_ = std::make_unique<zmq::socket_t>(*result->zmq_context_, zmq::socket_type::pub);
+    result->zmq_socket_->set(zmq::sockopt::sndhwm, options.send_hwm);
+    result->zmq_socket_->set(zmq::sockopt::linger, 0);
+    result->zmq_socket_->bind(options.endpoint);
+    result->endpoint_ = result->zmq_socket_->get(zmq::sockopt::last_endpoint);
+  } catch (const zmq::error_t& e) {
+    return { science::StatusCode::kInternal, "Failed to bind " + options.endpoint + ": " + std::string(e.what()) };
+  }
+  if (result->endpoint_.empty()) {
+    result->endpoint_ = options.endpoint;
+  }
+
+  *replayer = std::move(result);
+  return {};
+}
+
+auto Replayer::connection() const -> synapse::TapConnection {
+  synapse::TapConnection connection;
+  connection.set_name(reader_->stream_name().empty() ? "replay" : reader_->stream_name());
+  connection.set_endpoint(endpoint_);
+  connection.set_message_type(options_.codec_batch_frames > 0 ? kSampleCodecFramesType : reader_->message_type());
+  connection.set_tap_type(synapse::TapType::TAP_TYPE_PRODUCER);
+  return connection;
+}
+
+void Replayer::on_frame(FrameCallback callback) {
+  callback_ = std::move(callback);
+}
+
+auto Replayer::start() -> science::Status {
+  if (playing_) {
+    return { science::StatusCode::kFailedPrecondition, "already playing" };
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_ = {};
+  }
+  running_ = true;
+  playing_ = true;
+  thread_ = std::thread(&Replayer::run, this);
+  return {};
+}
+
+void Replayer::stop() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+auto Replayer::wait(std::chrono::milliseconds timeout) -> bool {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return finished_.wait_for(lock, timeout, [this]() { return !playing_; });
+}
+
+auto Replayer::seek(uint64_t timestamp_ns) -> science::Status {
+  if (timestamp_ns > end_timestamp_ns_) {
+    return { science::StatusCode::kOutOfRange, "timestamp is past the end of the recording" };
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (playing_) {
+    seek_pending_ = true;
+    seek_timestamp_ns_ = timestamp_ns;
+    return {};
+  }
+  return seek_reader(timestamp_ns);
+}
+
+auto Replayer::set_speed(double speed) -> science::Status {
+  if (!(speed >= 0) || !std::isfinite(speed)) {
+    return { science::StatusCode::kInvalidArgument, "speed must be zero or positive" };
+  }
+  speed_ = speed;
+  return {};
+}
+
+auto Replayer::status() const -> science::Status {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return status_;
+}
+
+auto Replayer::stats() const -> ReplayStats {
+  ReplayStats stats;
+  stats.frames_sent = frames_sent_.load(std::memory_order_relaxed);
+  stats.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+  stats.loops = loops_.load(std::memory_order_relaxed);
+
+  auto paced = paced_frames_.load(std::memory_order_relaxed);
+  if (paced > 0) {
+    stats.mean_lateness =
+      std::chrono::nanoseconds(total_lateness_ns_.load(std::memory_order_relaxed) / static_cast<int64_t>(paced));
+  }
+  stats.max_lateness = std::chrono::nanoseconds(max_lateness_ns_.load(std::memory_order_relaxed));
+  return stats;
+}
+
+auto Replayer::build_index() -> science::Status {
+  auto position = reader_->position();
+  uint64_t timestamp_ns = 0;
+  science::Status s;
+  while ((s = reader_->skip(&timestamp_ns)).ok()) {
+    if (num_frames_ % options_.index_interval == 0) {
+      index_.push_back({ timestamp_ns, position });
+    }
+    if (num_frames_ == 0) {
+      start_timestamp_ns_ = timestamp_ns;
+    }
+    end_timestamp_ns_ = timestamp_ns;
+    num_frames_++;
+    position = reader_->position();
+  }
+  if (s.code() != science::StatusCode::kOutOfRange) {
+    return s;
+  }
+  if (index_.empty()) {
+    return { science::StatusCode::kInvalidArgument, "recording has no frames" };
+  }
+  return reader_->seek(index_.front().position);
+}
+
+auto Replayer::seek_reader(uint64_t timestamp_ns) -> science::Status {
+  auto it = std::upper_bound(
+    index_.begin(), index_.end(), timestamp_ns,
+    [](uint64_t t, const IndexEntry& entry) { return t < entry.timestamp_ns; }
+  );
+  if (it != index_.begin()) {
+    --it;
+  }
+  auto s = reader_->seek(it->position);
+  if (!s.ok()) {
+    return s;
+  }
+
+  // At most index_interval frames to step over from the indexed position
+  while (true) {
+    auto position = reader_->position();
+    uint64_t frame_timestamp_ns = 0;
+    s = reader_->skip(&frame_timestamp_ns);
+    if (!s.ok() || frame_timestamp_ns >= timestamp_ns) {
+      return reader_->seek(position);
+    }
+  }
+}
+
+auto Replayer::wait_until(Clock::time_point due) -> bool {
+  while (running_) {
+    auto now = Clock::now();
+    if (now >= due) {
+      return true;
+    }
+    auto remaining = due - now;
+    if (remaining > options_.spin_window) {
+      std::this_thread::sleep_for(std::min<Clock::duration>(remaining - options_.spin_window, kMaxSleep));
+    }
+  }
+  return false;
+}
+
+auto Replayer::publish(const std::vector<uint8_t>& data, uint64_t timestamp_ns, uint64_t num_frames)
+  -> science::Status {
+  try {
+    zmq::message_t message(data.data(), data.size());
+    zmq_socket_->send(message, zmq::send_flags::none);
+  } catch (const zmq::error_t& e) {
+    return { science::StatusCode::kInternal, "Error sending message: " + std::string(e.what()) };
+  }
+  if (callback_) {
+    callback_(data, timestamp_ns);
+  }
+  frames_sent_.fetch_add(num_frames, std::memory_order_relaxed);
+  bytes_sent_.fetch_add(data.size(), std::memory_order_relaxed);
+  return {};
+}
+
+auto Replayer::flush_batch() -> science::Status {
+  if (batch_.empty()) {
+    return {};
+  }
+  auto s = codec_.encode_frames(batch_, &encoded_);
+  if (s.ok()) {
+    s = publish(encoded_, batch_timestamp_ns_, batch_.size());
+  }
+  batch_.clear();
+  return s;
+}
+
+void Replayer::run() {
+  science::Status s;
+  std::vector<uint8_t> frame;
+  uint64_t timestamp_ns = 0;
+
+  // Frames are scheduled relative to an anchor, reset on every seek, loop or speed change
+  bool anchored = false;
+  double anchor_speed = 0;
+  Clock::time_point anchor_time;
+  uint64_t anchor_timestamp_ns = 0;
+
+  while (running_) {
+    std::optional<uint64_t> seek_timestamp_ns;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (seek_pending_) {
+        seek_pending_ = false;
+        seek_timestamp_ns = seek_timestamp_ns_;
+      }
+    }
+
+    // Outside the lock, as sending a batch runs the callback; seek() leaves the reader to this thread while playing
+    if (seek_timestamp_ns) {
+      anchored = false;
+      s = flush_batch();
+      if (!s.ok()) {
+        break;
+      }
+      s = seek_reader(*seek_timestamp_ns);
+      if (!s.ok()) {
+        break;
+      }
+    }
+
+    auto position = reader_->position();
+    s = reader_->next(&frame, &timestamp_ns);
+    if (s.code() == science::StatusCode::kOutOfRange) {
+      s = flush_batch();
+      if (!options_.loop || !s.ok()) {
+        break;
+      }
+      s = reader_->seek(index_.front().position);
+      if (!s.ok()) {
+        break;
+      }
+      loops_.fetch_add(1, std::memory_order_relaxed);
+      anchored = false;
+      continue;
+    }
+    if (!s.ok()) {
+      break;
+    }
+
+    double speed = speed_;
+    if (speed > 0) {
+      if (!anchored || speed != anchor_speed) {
+        anchored = true;
+        anchor_speed = speed;
+        anchor_time = Clock::now();
+        anchor_timestamp_ns = timestamp_ns;
+      }
+      auto offset_ns = timestamp_ns > anchor_timestamp_ns ? (timestamp_ns - anchor_timestamp_ns) / speed : 0.0;
+      auto due = anchor_time + std::chrono::nanoseconds(static_cast<int64_t>(offset_ns));
+
+      // Put the frame back if stopped while waiting, so start() resumes with it
+      if (!wait_until(due)) {
+        s = reader_->seek(position);
+        break;
+      }
+
+      auto lateness = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due).count();
+      total_lateness_ns_.fetch_add(lateness, std::memory_order_relaxed);
+      paced_frames_.fetch_add(1, std::memory_order_relaxed);
+      if (lateness > max_lateness_ns_.load(std::memory_order_relaxed)) {
+        max_lateness_ns_.store(lateness, std::memory_order_relaxed);
+      }
+    }
+
+    if (options_.codec_batch_frames == 0) {
+      s = publish(frame, timestamp_ns, 1);
+      if (!s.ok()) {
+        break;
+      }
+      continue;
+    }
+
+    if (batch_.empty()) {
+      batch_position_ = position;
+    }
+    batch_.emplace_back();
+    if (!batch_.back().ParseFromArray(frame.data(), static_cast<int>(frame.size()))) {
+      s = { science::StatusCode::kDataLoss, "failed to parse BroadbandFrame" };
+      break;
+    }
+    batch_timestamp_ns_ = timestamp_ns;
+    if (batch_.size() == options_.codec_batch_frames) {
+      s = flush_batch();
+      if (!s.ok()) {
+        break;
+      }
+    }
+  }
+
+  // Likewise put back the frames of a batch cut short by stop()
+  if (s.ok() && !batch_.empty()) {
+    s = reader_->seek(batch_position_);
+  }
+  batch_.clear();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!s.ok()) {
+    status_ = s;
+  }
+  playing_ = false;
+  finished_.notify_all();
+}
+
+}  // namespace synapse
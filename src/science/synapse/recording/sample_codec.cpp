@@ -0,0 +1,630 @@
+#include "science/synapse/recording/sample_codec.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "science/synapse/dsp/simd_internal.h"
+
+namespace synapse {
+
+namespace {
+
+// All fields are stored in host (little-endian) byte order
+constexpr uint32_t kMagic = 0x31435953;  // "SYC1"
+constexpr uint8_t kVersion = 1;
+constexpr uint8_t kHasFrames = 1;
+
+// Values per packed block; each is stored as a width byte then 32 * width bytes
+constexpr size_t kBlockSize = 256;
+constexpr size_t kLanes = 8;
+constexpr size_t kMaxBlockBytes = 1 + kBlockSize * 32 / 8;
+
+// Samples per encoded block, over all channels; 1 GiB once decoded
+constexpr size_t kMaxBlockSamples = size_t{ 1 } << 28;
+
+// Timestamp and sequence number series
+constexpr uint8_t kSeriesPacked = 0;
+constexpr uint8_t kSeriesRaw = 1;
+
+struct BlockHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t predictor;
+  uint8_t flags;
+  uint8_t reserved;
+  uint32_t num_channels;
+  uint32_t num_samples;
+};
+static_assert(sizeof(BlockHeader) == 16, "unexpected block header size");
+
+auto max_channel_size(size_t num_samples) -> size_t {
+  if (num_samples == 0) {
+    return 0;
+  }
+  return sizeof(int32_t) + (num_samples + kBlockSize - 1) / kBlockSize * kMaxBlockBytes;
+}
+
+auto max_series_size(size_t count) -> size_t {
+  return 1 + std::max(sizeof(uint64_t) + max_channel_size(count > 0 ? count - 1 : 0), count * sizeof(uint64_t));
+}
+
+auto bit_width(uint32_t value) -> unsigned {
+  unsigned width = 0;
+  while (value != 0) {
+    width++;
+    value >>= 1;
+  }
+  return width;
+}
+
+auto zigzag(uint32_t residual) -> uint32_t {
+  return (residual << 1) ^ (0u - (residual >> 31));
+}
+
+auto unzigzag(uint32_t value) -> uint32_t {
+  return (value >> 1) ^ (0u - (value & 1));
+}
+
+// Arithmetic wraps in uint32, so every int32 sequence round-trips
+auto prediction(const int32_t* x, size_t t, SamplePredictor predictor) -> uint32_t {
+  if (t == 0) {
+    return static_cast<uint32_t>(x[0]);
+  }
+  const auto previous = static_cast<uint32_t>(x[t - 1]);
+  if (predictor == SamplePredictor::kDelta || t == 1) {
+    return previous;
+  }
+  return 2 * previous - static_cast<uint32_t>(x[t - 2]);
+}
+
+auto load_word(const uint8_t* data, size_t index) -> uint32_t {
+  uint32_t word;
+  std::memcpy(&word, data + index * sizeof(word), sizeof(word));
+  return word;
+}
+
+auto store_word(uint8_t* data, size_t index, uint32_t word) -> void {
+  std::memcpy(data + index * sizeof(word), &word, sizeof(word));
+}
+
+// Writes the zigzagged residuals of x[t0, t0 + count) and returns their bitwise or
+auto predict_scalar(const int32_t* x, size_t t0, size_t count, SamplePredictor predictor, uint32_t* out) -> uint32_t {
+  uint32_t bits = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const size_t t = t0 + i;
+    out[i] = zigzag(static_cast<uint32_t>(x[t]) - prediction(x, t, predictor));
+    bits |= out[i];
+  }
+  return bits;
+}
+
+// Value i of a block goes to lane i % 8; each lane fills its own run of 32-bit words, and the
+// words of all lanes are interleaved, so word w of lane l is at w * 8 + l
+void pack_scalar(const uint32_t* in, unsigned width, uint8_t* out) {
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    uint64_t accumulator = 0;
+    unsigned bits = 0;
+    size_t word = 0;
+    for (size_t k = 0; k < kBlockSize / kLanes; ++k) {
+      accumulator |= static_cast<uint64_t>(in[k * kLanes + lane]) << bits;
+      bits += width;
+      if (bits >= 32) {
+        store_word(out, word * kLanes + lane, static_cast<uint32_t>(accumulator));
+        accumulator >>= 32;
+        bits -= 32;
+        word++;
+      }
+    }
+  }
+}
+
+void unpack_scalar(const uint8_t* in, unsigned width, uint32_t* out) {
+  const uint64_t mask = (uint64_t{ 1 } << width) - 1;
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    uint64_t buffer = 0;
+    unsigned available = 0;
+    size_t word = 0;
+    for (size_t k = 0; k < kBlockSize / kLanes; ++k) {
+      if (available < width) {
+        buffer |= static_cast<uint64_t>(load_word(in, word * kLanes + lane)) << available;
+        available += 32;
+        word++;
+      }
+      out[k * kLanes + lane] = static_cast<uint32_t>(buffer & mask);
+      buffer >>= width;
+      available -= width;
+    }
+  }
+}
+
+#if SYNAPSE_HAS_X86_SIMD
+SYNAPSE_TARGET_AVX2
+auto predict_avx2(const int32_t* x, size_t t0, size_t count, SamplePredictor predictor, uint32_t* out) -> uint32_t {
+  // The first two samples of a channel have fewer predecessors
+  const size_t head = t0 >= 2 ? 0 : std::min(count, 2 - t0);
+  uint32_t bits = predict_scalar(x, t0, head, predictor, out);
+
+  __m256i accumulator = _mm256_setzero_si256();
+  size_t i = head;
+  for (; i + kLanes <= count; i += kLanes) {
+    const int32_t* current = x + t0 + i;
+    const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+    const __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current - 1));
+    __m256i predicted = previous;
+    if (predictor == SamplePredictor::kLinear) {
+      const __m256i before = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current - 2));
+      predicted = _mm256_sub_epi32(_mm256_add_epi32(previous, previous), before);
+    }
+    const __m256i residual = _mm256_sub_epi32(value, predicted);
+    const __m256i zigzagged = _mm256_xor_si256(_mm256_slli_epi32(residual, 1), _mm256_srai_epi32(residual, 31));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), zigzagged);
+    accumulator = _mm256_or_si256(accumulator, zigzagged);
+  }
+
+  alignas(32) uint32_t lanes[kLanes];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), accumulator);
+  for (auto lane : lanes) {
+    bits |= lane;
+  }
+  return bits | predict_scalar(x, t0 + i, count - i, predictor, out + i);
+}
+
+SYNAPSE_TARGET_AVX2
+void pack_avx2(const uint32_t* in, unsigned width, uint8_t* out) {
+  __m256i accumulator = _mm256_setzero_si256();
+  unsigned bits = 0;
+  for (size_t k = 0; k < kBlockSize / kLanes; ++k) {
+    const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + k * kLanes));
+    accumulator = _mm256_or_si256(accumulator, _mm256_sll_epi32(value, _mm_cvtsi32_si128(bits)));
+    bits += width;
+    if (bits >= 32) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), accumulator);
+      out += sizeof(__m256i);
+      bits -= 32;
+      // The bits of value that didn't fit; shifts of 32 or more give zero
+      accumulator = _mm256_srl_epi32(value, _mm_cvtsi32_si128(width - bits));
+    }
+  }
+}
+
+SYNAPSE_TARGET_AVX2
+void unpack_avx2(const uint8_t* in, unsigned width, uint32_t* out) {
+  const __m256i mask = _mm256_set1_epi32(width == 32 ? -1 : static_cast<int>((1u << width) - 1));
+  __m256i word = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+  in += sizeof(__m256i);
+  unsigned bits = 0;
+  for (size_t k = 0; k < kBlockSize / kLanes; ++k) {
+    __m256i value = _mm256_srl_epi32(word, _mm_cvtsi32_si128(bits));
+    bits += width;
+    if (bits >= 32) {
+      bits -= 32;
+      // Don't read past the block once the last value ends on a word boundary
+      if (k + 1 < kBlockSize / kLanes || bits > 0) {
+        word = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+        in += sizeof(__m256i);
+        value = _mm256_or_si256(value, _mm256_sll_epi32(word, _mm_cvtsi32_si128(width - bits)));
+      }
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + k * kLanes), _mm256_and_si256(value, mask));
+  }
+}
+#endif
+
+struct Kernels {
+  uint32_t (*predict)(const int32_t*, size_t, size_t, SamplePredictor, uint32_t*);
+  void (*pack)(const uint32_t*, unsigned, uint8_t*);
+  void (*unpack)(const uint8_t*, unsigned, uint32_t*);
+};
+
+auto kernels(SimdLevel level) -> Kernels {
+#if SYNAPSE_HAS_X86_SIMD
+  if (level == SimdLevel::kAvx2) {
+    return { &predict_avx2, &pack_avx2, &unpack_avx2 };
+  }
+#endif
+  return { &predict_scalar, &pack_scalar, &unpack_scalar };
+}
+
+void reconstruct(const uint32_t* residuals, size_t t0, size_t count, SamplePredictor predictor, int32_t* x) {
+  // The first sample is stored as is, and the second has only one predecessor
+  size_t i = t0 == 0 ? 1 : 0;
+  for (; i < count && t0 + i < 2; ++i) {
+    x[t0 + i] = static_cast<int32_t>(prediction(x, t0 + i, predictor) + unzigzag(residuals[i]));
+  }
+  if (i == count) {
+    return;
+  }
+
+  // Carry predecessors in registers; each sample depends on the last, so this doesn't vectorize
+  auto previous = static_cast<uint32_t>(x[t0 + i - 1]);
+  if (predictor == SamplePredictor::kDelta) {
+    for (; i < count; ++i) {
+      previous += unzigzag(residuals[i]);
+      x[t0 + i] = static_cast<int32_t>(previous);
+    }
+    return;
+  }
+  auto before = static_cast<uint32_t>(x[t0 + i - 2]);
+  for (; i < count; ++i) {
+    const uint32_t value = 2 * previous - before + unzigzag(residuals[i]);
+    x[t0 + i] = static_cast<int32_t>(value);
+    before = previous;
+    previous = value;
+  }
+}
+
+// Returns the end of an encoded channel without decoding it, or nullptr if it's corrupt or truncated
+auto skip_channel(const uint8_t* in, const uint8_t* end, size_t num_samples) -> const uint8_t* {
+  if (num_samples == 0) {
+    return in;
+  }
+  if (static_cast<size_t>(end - in) < sizeof(int32_t)) {
+    return nullptr;
+  }
+  in += sizeof(int32_t);
+  for (size_t t0 = 0; t0 < num_samples; t0 += kBlockSize) {
+    if (in == end) {
+      return nullptr;
+    }
+    const unsigned width = *in++;
+    const size_t packed_size = kBlockSize * width / 8;
+    if (width > 32 || static_cast<size_t>(end - in) < packed_size) {
+      return nullptr;
+    }
+    in += packed_size;
+  }
+  return in;
+}
+
+auto valid_predictor(uint8_t predictor) -> bool {
+  return predictor == static_cast<uint8_t>(SamplePredictor::kDelta) ||
+         predictor == static_cast<uint8_t>(SamplePredictor::kLinear);
+}
+
+}  // namespace
+
+SampleCodec::SampleCodec(SamplePredictor predictor)
+  : predictor_(predictor), simd_level_(detect_simd_level()), block_(kBlockSize) {}
+
+void SampleCodec::set_simd_level(SimdLevel level) {
+  if (level == SimdLevel::kAvx2 && detect_simd_level() != SimdLevel::kAvx2) {
+    level = SimdLevel::kScalar;
+  }
+  simd_level_ = level;
+}
+
+auto SampleCodec::encode(const std::vector<const int32_t*>& channels, size_t num_samples, std::vector<uint8_t>* out)
+  -> science::Status {
+  if (out == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "out ptr must not be null" };
+  }
+  if (channels.size() > std::numeric_limits<uint32_t>::max() ||
+      num_samples > kMaxBlockSamples || channels.size() * num_samples > kMaxBlockSamples) {
+    return { science::StatusCode::kInvalidArgument, "block is too large" };
+  }
+  if (num_samples > 0 && std::find(channels.begin(), channels.end(), nullptr) != channels.end()) {
+    return { science::StatusCode::kInvalidArgument, "channel ptrs must not be null" };
+  }
+
+  BlockHeader header = {
+    kMagic, kVersion, static_cast<uint8_t>(predictor_), 0, 0, static_cast<uint32_t>(channels.size()),
+    static_cast<uint32_t>(num_samples)
+  };
+  out->resize(sizeof(header) + channels.size() * max_channel_size(num_samples));
+  std::memcpy(out->data(), &header, sizeof(header));
+
+  uint8_t* end = out->data() + sizeof(header);
+  for (const int32_t* channel : channels) {
+    end = encode_channel(channel, num_samples, predictor_, end);
+  }
+  out->resize(end - out->data());
+  return {};
+}
+
+auto SampleCodec::decode(
+  const uint8_t* data,
+  size_t size,
+  std::vector<int32_t>* samples,
+  size_t* num_channels,
+  size_t* num_samples
+) -> science::Status {
+  if (data == nullptr && size > 0) {
+    return { science::StatusCode::kInvalidArgument, "data ptr must not be null" };
+  }
+  bool has_frames = false;
+  return decode_block(&data, data + size, samples, num_channels, num_samples, &has_frames);
+}
+
+auto SampleCodec::encode_frames(const std::vector<synapse::BroadbandFrame>& frames, std::vector<uint8_t>* out)
+  -> science::Status {
+  if (out == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "out ptr must not be null" };
+  }
+
+  const size_t num_samples = frames.size();
+  const size_t num_channels = frames.empty() ? 0 : static_cast<size_t>(frames.front().frame_data_size());
+  std::vector<uint64_t> timestamps(num_samples);
+  std::vector<uint64_t> sequence_numbers(num_samples);
+  transposed_.resize(num_channels * num_samples);
+  for (size_t t = 0; t < num_samples; ++t) {
+    const auto& frame = frames[t];
+    if (static_cast<size_t>(frame.frame_data_size()) != num_channels) {
+      return { science::StatusCode::kInvalidArgument, "frames must all have the same number of channels" };
+    }
+    for (size_t c = 0; c < num_channels; ++c) {
+      transposed_[c * num_samples + t] = frame.frame_data(static_cast<int>(c));
+    }
+    timestamps[t] = frame.timestamp_ns();
+    sequence_numbers[t] = frame.sequence_number();
+  }
+
+  std::vector<const int32_t*> channels(num_channels);
+  for (size_t c = 0; c < num_channels; ++c) {
+    channels[c] = transposed_.data() + c * num_samples;
+  }
+  auto s = encode(channels, num_samples, out);
+  if (!s.ok()) {
+    return s;
+  }
+  (*out)[offsetof(BlockHeader, flags)] |= kHasFrames;
+
+  const float sample_rate_hz = frames.empty() ? 0 : frames.front().sample_rate_hz();
+  const size_t offset = out->size();
+  out->resize(offset + sizeof(sample_rate_hz));
+  std::memcpy(out->data() + offset, &sample_rate_hz, sizeof(sample_rate_hz));
+  encode_series(timestamps, out);
+  encode_series(sequence_numbers, out);
+  return {};
+}
+
+auto SampleCodec::decode_frames(const uint8_t* data, size_t size, std::vector<synapse::BroadbandFrame>* frames)
+  -> science::Status {
+  if (frames == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "frames ptr must not be null" };
+  }
+  if (data == nullptr && size > 0) {
+    return { science::StatusCode::kInvalidArgument, "data ptr must not be null" };
+  }
+
+  const uint8_t* end = data + size;
+  size_t num_channels = 0;
+  size_t num_samples = 0;
+  bool has_frames = false;
+  auto s = decode_block(&data, end, &transposed_, &num_channels, &num_samples, &has_frames);
+  if (!s.ok()) {
+    return s;
+  }
+  if (!has_frames) {
+    return { science::StatusCode::kInvalidArgument, "block was not encoded from frames" };
+  }
+
+  float sample_rate_hz = 0;
+  std::vector<uint64_t> timestamps;
+  std::vector<uint64_t> sequence_numbers;
+  if (static_cast<size_t>(end - data) < sizeof(sample_rate_hz)) {
+    return { science::StatusCode::kDataLoss, "truncated frame metadata" };
+  }
+  std::memcpy(&sample_rate_hz, data, sizeof(sample_rate_hz));
+  data += sizeof(sample_rate_hz);
+  if (!decode_series(&data, end, num_samples, &timestamps) ||
+      !decode_series(&data, end, num_samples, &sequence_numbers)) {
+    return { science::StatusCode::kDataLoss, "corrupt frame metadata" };
+  }
+
+  frames->resize(num_samples);
+  for (size_t t = 0; t < num_samples; ++t) {
+    auto& frame = (*frames)[t];
+    frame.set_timestamp_ns(timestamps[t]);
+    frame.set_sequence_number(sequence_numbers[t]);
+    frame.set_sample_rate_hz(sample_rate_hz);
+    auto* frame_data = frame.mutable_frame_data();
+    frame_data->Resize(static_cast<int>(num_channels), 0);
+    for (size_t c = 0; c < num_channels; ++c) {
+      frame_data->Set(static_cast<int>(c), transposed_[c * num_samples + t]);
+    }
+  }
+  return {};
+}
+
+auto SampleCodec::decode_block(
+  const uint8_t** data,
+  const uint8_t* end,
+  std::vector<int32_t>* samples,
+  size_t* num_channels,
+  size_t* num_samples,
+  bool* has_frames
+) -> science::Status {
+  if (samples == nullptr || num_channels == nullptr || num_samples == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "output ptrs must not be null" };
+  }
+
+  BlockHeader header;
+  if (static_cast<size_t>(end - *data) < sizeof(header)) {
+    return { science::StatusCode::kDataLoss, "truncated block header" };
+  }
+  std::memcpy(&header, *data, sizeof(header));
+  *data += sizeof(header);
+  if (header.magic != kMagic) {
+    return { science::StatusCode::kDataLoss, "not an encoded sample block" };
+  }
+  if (header.version != kVersion) {
+    return { science::StatusCode::kUnimplemented, "unsupported block version " + std::to_string(header.version) };
+  }
+  if (!valid_predictor(header.predictor)) {
+    return { science::StatusCode::kDataLoss, "unknown predictor " + std::to_string(header.predictor) };
+  }
+
+  // A block of zero residuals decodes to 1024 bytes per width byte, so the input size alone doesn't
+  // bound the output; cap the block, then check every channel is present before allocating for it
+  const size_t total_samples = static_cast<size_t>(header.num_channels) * header.num_samples;
+  if (total_samples > kMaxBlockSamples || header.num_samples > kMaxBlockSamples) {
+    return { science::StatusCode::kDataLoss, "block is too large" };
+  }
+  const size_t min_channel_size =
+    header.num_samples == 0 ? 0 : sizeof(int32_t) + (header.num_samples + kBlockSize - 1) / kBlockSize;
+  if (min_channel_size > 0 && header.num_channels > static_cast<size_t>(end - *data) / min_channel_size) {
+    return { science::StatusCode::kDataLoss, "truncated block" };
+  }
+  const uint8_t* channel_end = *data;
+  for (size_t c = 0; c < header.num_channels && header.num_samples > 0; ++c) {
+    channel_end = skip_channel(channel_end, end, header.num_samples);
+    if (channel_end == nullptr) {
+      return { science::StatusCode::kDataLoss, "corrupt or truncated channel " + std::to_string(c) };
+    }
+  }
+
+  const auto predictor = static_cast<SamplePredictor>(header.predictor);
+  samples->resize(total_samples);
+  for (size_t c = 0; c < header.num_channels; ++c) {
+    if (!decode_channel(data, end, header.num_samples, predictor, samples->data() + c * header.num_samples)) {
+      return { science::StatusCode::kDataLoss, "corrupt or truncated channel " + std::to_string(c) };
+    }
+  }
+
+  *num_channels = header.num_channels;
+  *num_samples = header.num_samples;
+  *has_frames = (header.flags & kHasFrames) != 0;
+  return {};
+}
+
+auto SampleCodec::encode_channel(const int32_t* samples, size_t num_samples, SamplePredictor predictor, uint8_t* out)
+  -> uint8_t* {
+  if (num_samples == 0) {
+    return out;
+  }
+  std::memcpy(out, samples, sizeof(int32_t));
+  out += sizeof(int32_t);
+
+  const auto k = kernels(simd_level_);
+  for (size_t t0 = 0; t0 < num_samples; t0 += kBlockSize) {
+    const size_t count = std::min(kBlockSize, num_samples - t0);
+    const unsigned width = bit_width(k.predict(samples, t0, count, predictor, block_.data()));
+    std::fill(block_.begin() + count, block_.end(), 0);
+
+    *out++ = static_cast<uint8_t>(width);
+    if (width > 0) {
+      k.pack(block_.data(), width, out);
+      out += kBlockSize * width / 8;
+    }
+  }
+  return out;
+}
+
+auto SampleCodec::decode_channel(
+  const uint8_t** data,
+  const uint8_t* end,
+  size_t num_samples,
+  SamplePredictor predictor,
+  int32_t* samples
+) -> bool {
+  if (num_samples == 0) {
+    return true;
+  }
+  const uint8_t* in = *data;
+  if (static_cast<size_t>(end - in) < sizeof(int32_t)) {
+    return false;
+  }
+  std::memcpy(samples, in, sizeof(int32_t));
+  in += sizeof(int32_t);
+
+  const auto k = kernels(simd_level_);
+  for (size_t t0 = 0; t0 < num_samples; t0 += kBlockSize) {
+    if (in == end) {
+      return false;
+    }
+    const unsigned width = *in++;
+    const size_t packed_size = kBlockSize * width / 8;
+    if (width > 32 || static_cast<size_t>(end - in) < packed_size) {
+      return false;
+    }
+    if (width == 0) {
+      std::fill(block_.begin(), block_.end(), 0);
+    } else {
+      k.unpack(in, width, block_.data());
+      in += packed_size;
+    }
+    reconstruct(block_.data(), t0, std::min(kBlockSize, num_samples - t0), predictor, samples);
+  }
+
+  *data = in;
+  return true;
+}
+
+auto SampleCodec::encode_series(const std::vector<uint64_t>& values, std::vector<uint8_t>* out) -> void {
+  const size_t offset = out->size();
+  out->resize(offset + max_series_size(values.size()));
+  uint8_t* end = out->data() + offset;
+
+  // Clock timestamps and sequence numbers usually advance by nearly constant steps, which pack to a
+  // few bits each; anything that goes backwards or jumps by 2^32 is stored raw
+  std::vector<int32_t> steps;
+  steps.reserve(values.size());
+  for (size_t i = 1; i < values.size(); ++i) {
+    if (values[i] < values[i - 1] || values[i] - values[i - 1] > std::numeric_limits<uint32_t>::max()) {
+      break;
+    }
+    steps.push_back(static_cast<int32_t>(static_cast<uint32_t>(values[i] - values[i - 1])));
+  }
+
+  if (values.empty() || steps.size() + 1 == values.size()) {
+    *end++ = kSeriesPacked;
+    const uint64_t first = values.empty() ? 0 : values.front();
+    std::memcpy(end, &first, sizeof(first));
+    end = encode_channel(steps.data(), steps.size(), SamplePredictor::kDelta, end + sizeof(first));
+  } else {
+    *end++ = kSeriesRaw;
+    std::memcpy(end, values.data(), values.size() * sizeof(uint64_t));
+    end += values.size() * sizeof(uint64_t);
+  }
+  out->resize(end - out->data());
+}
+
+auto SampleCodec::decode_series(const uint8_t** data, const uint8_t* end, size_t count, std::vector<uint64_t>* values)
+  -> bool {
+  const uint8_t* in = *data;
+  if (in == end) {
+    return false;
+  }
+  const uint8_t mode = *in++;
+  if (mode == kSeriesRaw) {
+    if (static_cast<size_t>(end - in) / sizeof(uint64_t) < count) {
+      return false;
+    }
+    values->resize(count);
+    std::memcpy(values->data(), in, count * sizeof(uint64_t));
+    *data = in + count * sizeof(uint64_t);
+    return true;
+  }
+  if (mode != kSeriesPacked) {
+    return false;
+  }
+
+  uint64_t first = 0;
+  if (static_cast<size_t>(end - in) < sizeof(first)) {
+    return false;
+  }
+  std::memcpy(&first, in, sizeof(first));
+  in += sizeof(first);
+  if (count > 1 && static_cast<size_t>(end - in) < sizeof(int32_t) + (count - 1 + kBlockSize - 1) / kBlockSize) {
+    return false;
+  }
+
+  std::vector<int32_t> steps(count > 0 ? count - 1 : 0);
+  if (!decode_channel(&in, end, steps.size(), SamplePredictor::kDelta, steps.data())) {
+    return false;
+  }
+  values->resize(count);
+  if (count > 0) {
+    (*values)[0] = first;
+  }
+  for (size_t i = 1; i < count; ++i) {
+    (*values)[i] = (*values)[i - 1] + static_cast<uint32_t>(steps[i - 1]);
+  }
+  *data = in;
+  return true;
+}
+
+}  // namespace synapse
@@ -0,0 +1,428 @@
+#include "science/synapse/recording/tap_recorder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "science/synapse/recording/file_writer.h"
+
+namespace synapse {
+
+namespace {
+
+constexpr char kMagic[8] = { 'S', 'Y', 'N', 'T', 'A', 'P', 'R', '1' };
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = kDirectIoAlignment;
+constexpr uint32_t kRecordMarker = 0x46524d54;  // "TMRF"
+constexpr size_t kRecordHeaderSize = 16;
+constexpr size_t kMaxNameSize = 1024;
+
+auto now_ns() -> uint64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+    .count();
+}
+
+auto put_string(std::vector<uint8_t>* header, size_t* offset, const std::string& value) -> void {
+  auto length = static_cast<uint32_t>(std::min(value.size(), kMaxNameSize));
+  std::memcpy(header->data() + *offset, &length, sizeof(length));
+  std::memcpy(header->data() + *offset + sizeof(length), value.data(), length);
+  *offset += sizeof(length) + length;
+}
+
+auto get_string(const std::vector<uint8_t>& header, size_t* offset, std::string* value) -> bool {
+  uint32_t length = 0;
+  if (*offset + sizeof(length) > header.size()) {
+    return false;
+  }
+  std::memcpy(&length, header.data() + *offset, sizeof(length));
+  if (*offset + sizeof(length) + length > header.size()) {
+    return false;
+  }
+  value->assign(reinterpret_cast<const char*>(header.data() + *offset + sizeof(length)), length);
+  *offset += sizeof(length) + length;
+  return true;
+}
+
+}  // namespace
+
+TapRecorder::TapRecorder(std::unique_ptr<FileWriter> writer, const TapRecorderOptions& options)
+    : options_(options), writer_(std::move(writer)) {
+  write_thread_ = std::thread(&TapRecorder::write_loop, this);
+}
+
+TapRecorder::~TapRecorder() {
+  (void)stop();
+}
+
+auto TapRecorder::create(
+  const std::string& path,
+  std::unique_ptr<TapRecorder>* recorder,
+  const TapRecorderOptions& options
+) -> science::Status {
+  if (recorder == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "recorder ptr must not be null" };
+  }
+  if (options.buffer_size == 0) {
+    return { science::StatusCode::kInvalidArgument, "buffer size must be positive" };
+  }
+  if (options.max_buffers < 2) {
+    return { science::StatusCode::kInvalidArgument, "at least two buffers are needed to write while receiving" };
+  }
+
+  std::unique_ptr<FileWriter> writer;
+  auto s = FileWriter::open(path, options.direct_io, options.preallocate_bytes, &writer);
+  if (!s.ok()) {
+    return s;
+  }
+
+  recorder->reset(new TapRecorder(std::move(writer), options));
+  return {};
+}
+
+auto TapRecorder::start(Tap* tap, int timeout_ms) -> science::Status {
+  if (tap == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "tap ptr must not be null" };
+  }
+  if (!tap->is_connected()) {
+    return { science::StatusCode::kFailedPrecondition, "tap is not connected" };
+  }
+  auto connection = tap->connected_tap();
+  if (connection->tap_type() == synapse::TapType::TAP_TYPE_CONSUMER) {
+    return { science::StatusCode::kInvalidArgument, "cannot record a consumer tap" };
+  }
+  if (receive_thread_.joinable()) {
+    return { science::StatusCode::kFailedPrecondition, "already recording a tap" };
+  }
+  if (closed_) {
+    return { science::StatusCode::kFailedPrecondition, "recorder is stopped" };
+  }
+
+  if (!header_written_) {
+    if (options_.stream_name.empty()) {
+      options_.stream_name = connection->name();
+    }
+    if (options_.message_type.empty()) {
+      options_.message_type = connection->message_type();
+    }
+  }
+
+  receiving_ = true;
+  receive_thread_ = std::thread(&TapRecorder::receive_loop, this, tap, timeout_ms);
+  return {};
+}
+
+auto TapRecorder::record(const uint8_t* data, size_t size, uint64_t timestamp_ns) -> science::Status {
+  if (data == nullptr && size > 0) {
+    return { science::StatusCode::kInvalidArgument, "data ptr must not be null" };
+  }
+  if (closed_) {
+    return { science::StatusCode::kFailedPrecondition, "recorder is stopped" };
+  }
+  if (!header_written_) {
+    write_header();
+  }
+
+  auto s = reserve(kRecordHeaderSize + size);
+  if (!s.ok()) {
+    if (s.code() == science::StatusCode::kResourceExhausted) {
+      frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return s;
+  }
+
+  uint8_t record_header[kRecordHeaderSize];
+  auto length = static_cast<uint32_t>(size);
+  std::memcpy(record_header, &kRecordMarker, 4);
+  std::memcpy(record_header + 4, &length, 4);
+  std::memcpy(record_header + 8, &timestamp_ns, 8);
+  append(record_header, kRecordHeaderSize);
+  append(data, size);
+
+  frames_.fetch_add(1, std::memory_order_relaxed);
+  bytes_received_.fetch_add(size, std::memory_order_relaxed);
+  return {};
+}
+
+auto TapRecorder::stop() -> science::Status {
+  if (receive_thread_.joinable()) {
+    receiving_ = false;
+    receive_thread_.join();
+  }
+  if (closed_) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+  }
+
+  if (!header_written_) {
+    write_header();
+  }
+  if (current_ != nullptr && current_->size > 0) {
+    submit_buffer();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  write_thread_.join();
+
+  auto s = writer_->close();
+  closed_ = true;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (status_.ok()) {
+    status_ = s;
+  }
+  return status_;
+}
+
+auto TapRecorder::stats() const -> TapRecorderStats {
+  TapRecorderStats stats;
+  stats.frames = frames_.load(std::memory_order_relaxed);
+  stats.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+  stats.bytes_received = bytes_received_.load(std::memory_order_relaxed);
+  stats.direct_io = writer_->direct();
+
+  auto appended = bytes_appended_.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.bytes_written = bytes_written_;
+  stats.write_time = write_time_;
+  stats.backlog_bytes = appended > bytes_written_ ? appended - bytes_written_ : 0;
+  stats.max_backlog_bytes = std::max(max_backlog_bytes_, stats.backlog_bytes);
+  return stats;
+}
+
+auto TapRecorder::write_header() -> void {
+  std::vector<uint8_t> header(kHeaderSize, 0);
+  size_t offset = 0;
+  std::memcpy(header.data(), kMagic, sizeof(kMagic));
+  offset += sizeof(kMagic);
+  auto header_size = static_cast<uint32_t>(kHeaderSize);
+  std::memcpy(header.data() + offset, &kVersion, sizeof(kVersion));
+  std::memcpy(header.data() + offset + 4, &header_size, sizeof(header_size));
+  offset += 8;
+  put_string(&header, &offset, options_.stream_name);
+  put_string(&header, &offset, options_.message_type);
+
+  // The header is always written, so it needs no reservation
+  append(header.data(), header.size());
+  header_written_ = true;
+}
+
+auto TapRecorder::reserve(size_t size) -> science::Status {
+  size_t capacity = current_ != nullptr ? current_->capacity() : AlignedBuffer::rounded_size(options_.buffer_size);
+  size_t remaining = current_ != nullptr ? capacity - current_->size : 0;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!status_.ok()) {
+    return status_;
+  }
+  if (size <= remaining) {
+    return {};
+  }
+
+  // Only this thread takes buffers, so what is available now stays available until append()
+  size_t needed = (size - remaining + capacity - 1) / capacity;
+  size_t available = free_.size() + (options_.max_buffers - allocated_buffers_);
+  if (needed > available) {
+    return { science::StatusCode::kResourceExhausted, "all buffers are waiting on disk; frame dropped" };
+  }
+  return {};
+}
+
+auto TapRecorder::submit_buffer() -> void {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    full_.push_back(std::move(current_));
+    auto appended = bytes_appended_.load(std::memory_order_relaxed);
+    max_backlog_bytes_ = std::max(max_backlog_bytes_, appended - bytes_written_);
+  }
+  cv_.notify_one();
+}
+
+auto TapRecorder::append(const uint8_t* data, size_t size) -> void {
+  bytes_appended_.fetch_add(size, std::memory_order_relaxed);
+  while (size > 0) {
+    if (current_ != nullptr && current_->size == current_->capacity()) {
+      submit_buffer();
+    }
+    if (current_ == nullptr) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!free_.empty()) {
+        current_ = std::move(free_.back());
+        free_.pop_back();
+      } else {
+        current_ = std::make_unique<AlignedBuffer>(options_.buffer_size);
+        allocated_buffers_++;
+      }
+    }
+
+    size_t n = std::min(size, current_->capacity() - current_->size);
+    std::memcpy(current_->data() + current_->size, data, n);
+    current_->size += n;
+    data += n;
+    size -= n;
+  }
+}
+
+auto TapRecorder::receive_loop(Tap* tap, int timeout_ms) -> void {
+  std::vector<uint8_t> frame;
+  while (receiving_) {
+    auto s = tap->read(&frame, timeout_ms);
+    if (s.code() == science::StatusCode::kDeadlineExceeded) {
+      continue;
+    }
+    if (s.ok()) {
+      s = record(frame.data(), frame.size(), now_ns());
+      if (s.ok() || s.code() == science::StatusCode::kResourceExhausted) {
+        continue;
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (status_.ok()) {
+      status_ = s;
+    }
+    break;
+  }
+}
+
+auto TapRecorder::write_loop() -> void {
+  while (true) {
+    std::unique_ptr<AlignedBuffer> buffer;
+    bool write = false;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stopping_ || !full_.empty(); });
+      if (full_.empty()) {
+        return;
+      }
+      buffer = std::move(full_.front());
+      full_.pop_front();
+      write = status_.ok();
+    }
+
+    science::Status s;
+    auto start = std::chrono::steady_clock::now();
+    if (write) {
+      s = writer_->append(buffer.get());
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (write && s.ok()) {
+      bytes_written_ += buffer->size;
+      write_time_ += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+    } else if (status_.ok()) {
+      status_ = s;
+    }
+    buffer->size = 0;
+    free_.push_back(std::move(buffer));
+  }
+}
+
+TapRecordingReader::TapRecordingReader(std::FILE* file) : file_(file) {}
+
+TapRecordingReader::~TapRecordingReader() {
+  std::fclose(file_);
+}
+
+auto TapRecordingReader::open(const std::string& path, std::unique_ptr<TapRecordingReader>* reader)
+  -> science::Status {
+  if (reader == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "reader ptr must not be null" };
+  }
+
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return { science::StatusCode::kNotFound, "failed to open " + path };
+  }
+  std::unique_ptr<TapRecordingReader> result(new TapRecordingReader(file));
+
+  std::vector<uint8_t> header(kHeaderSize);
+  if (std::fread(header.data(), 1, header.size(), file) != header.size() ||
+      std::memcmp(header.data(), kMagic, sizeof(kMagic)) != 0) {
+    return { science::StatusCode::kInvalidArgument, path + " is not a tap recording" };
+  }
+  uint32_t version = 0;
+  std::memcpy(&version, header.data() + sizeof(kMagic), sizeof(version));
+  if (version != kVersion) {
+    return { science::StatusCode::kUnimplemented, "unsupported recording version " + std::to_string(version) };
+  }
+
+  size_t offset = sizeof(kMagic) + 8;
+  if (!get_string(header, &offset, &result->stream_name_) || !get_string(header, &offset, &result->message_type_)) {
+    return { science::StatusCode::kDataLoss, "corrupt recording header" };
+  }
+
+  *reader = std::move(result);
+  return {};
+}
+
+auto TapRecordingReader::next(std::vector<uint8_t>* out, uint64_t* timestamp_ns) -> science::Status {
+  if (out == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "out ptr must not be null" };
+  }
+
+  uint32_t length = 0;
+  auto s = read_record_header(&length, timestamp_ns);
+  if (!s.ok()) {
+    return s;
+  }
+
+  out->resize(length);
+  if (std::fread(out->data(), 1, length, file_) != length) {
+    return { science::StatusCode::kDataLoss, "recording ends mid-frame" };
+  }
+  return {};
+}
+
+auto TapRecordingReader::skip(uint64_t* timestamp_ns) -> science::Status {
+  uint32_t length = 0;
+  auto s = read_record_header(&length, timestamp_ns);
+  if (!s.ok()) {
+    return s;
+  }
+  return seek(position() + length);
+}
+
+auto TapRecordingReader::position() const -> uint64_t {
+#ifdef _WIN32
+  return static_cast<uint64_t>(_ftelli64(file_));
+#else
+  return static_cast<uint64_t>(ftello(file_));
+#endif
+}
+
+auto TapRecordingReader::seek(uint64_t position) -> science::Status {
+#ifdef _WIN32
+  auto result = _fseeki64(file_, static_cast<int64_t>(position), SEEK_SET);
+#else
+  auto result = fseeko(file_, static_cast<off_t>(position), SEEK_SET);
+#endif
+  if (result != 0) {
+    return { science::StatusCode::kInternal, "failed to seek to " + std::to_string(position) };
+  }
+  return {};
+}
+
+auto TapRecordingReader::read_record_header(uint32_t* length, uint64_t* timestamp_ns) -> science::Status {
+  // A missing marker means the end of the data, including zeroed space left by an interrupted recording
+  uint8_t record_header[kRecordHeaderSize];
+  if (std::fread(record_header, 1, kRecordHeaderSize, file_) != kRecordHeaderSize) {
+    return { science::StatusCode::kOutOfRange, "end of recording" };
+  }
+  uint32_t marker = 0;
+  std::memcpy(&marker, record_header, 4);
+  if (marker != kRecordMarker) {
+    return { science::StatusCode::kOutOfRange, "end of recording" };
+  }
+
+  std::memcpy(length, record_header + 4, 4);
+  if (timestamp_ns != nullptr) {
+    std::memcpy(timestamp_ns, record_header + 8, 8);
+  }
+  return {};
+}
+
+}  // namespace synapse
@@ -0,0 +1,288 @@
+#include "science/synapse/stimulation_command.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "science/synapse/api/datatype.pb.h"
+
+namespace synapse {
+
+namespace {
+
+// Protobuf wire types (https://protobuf.dev/programming-guides/encoding/)
+constexpr uint32_t kWireTypeVarint = 0;
+constexpr uint32_t kWireTypeLengthDelimited = 2;
+constexpr uint32_t kWireTypeFixed32 = 5;
+
+constexpr auto field_tag(int field_number, uint32_t wire_type) -> uint32_t {
+  return (static_cast<uint32_t>(field_number) << 3) | wire_type;
+}
+
+// BroadbandFrame field tags: timestamp_ns and sequence_number (varint), frame_data (packed
+// sint32) and sample_rate_hz (fixed32)
+constexpr uint32_t kTimestampTag = field_tag(BroadbandFrame::kTimestampNsFieldNumber, kWireTypeVarint);
+constexpr uint32_t kSequenceNumberTag = field_tag(BroadbandFrame::kSequenceNumberFieldNumber, kWireTypeVarint);
+constexpr uint32_t kFrameDataTag = field_tag(BroadbandFrame::kFrameDataFieldNumber, kWireTypeLengthDelimited);
+constexpr uint32_t kSampleRateTag = field_tag(BroadbandFrame::kSampleRateHzFieldNumber, kWireTypeFixed32);
+
+// The offsets below assume every tag fits in one byte
+static_assert(kTimestampTag < 0x80, "timestamp_ns tag must be a single byte");
+static_assert(kSequenceNumberTag < 0x80, "sequence_number tag must be a single byte");
+static_assert(kFrameDataTag < 0x80, "frame_data tag must be a single byte");
+static_assert(kSampleRateTag < 0x80, "sample_rate_hz tag must be a single byte");
+
+// Longest varint encodings, so every value of a field takes the same bytes
+constexpr size_t kUint64Width = 10;
+constexpr size_t kSint32Width = 5;
+
+constexpr size_t kTimestampOffset = 1;
+constexpr size_t kSequenceNumberOffset = kTimestampOffset + kUint64Width + 1;
+constexpr size_t kFrameDataTagOffset = kSequenceNumberOffset + kUint64Width;
+
+// Every byte but the last has its continuation bit set, whether or not the value needs it
+inline void write_padded_varint(uint8_t* out, uint64_t value, size_t width) {
+  for (size_t i = 0; i + 1 < width; ++i) {
+    out[i] = static_cast<uint8_t>(value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+  out[width - 1] = static_cast<uint8_t>(value & 0x7f);
+}
+
+auto write_varint(uint8_t* out, uint64_t value) -> size_t {
+  size_t i = 0;
+  while (value >= 0x80) {
+    out[i++] = static_cast<uint8_t>(value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+  out[i++] = static_cast<uint8_t>(value);
+  return i;
+}
+
+auto varint_size(uint64_t value) -> size_t {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+inline auto zigzag(int32_t value) -> uint32_t {
+  return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+}  // namespace
+
+StimulationCommand::StimulationCommand(
+  size_t size, size_t amplitudes_offset, size_t num_channels, int32_t min_code, int32_t max_code
+) : buffer_(size),
+    amplitudes_offset_(amplitudes_offset),
+    num_channels_(num_channels),
+    min_code_(min_code),
+    max_code_(max_code) {}
+
+void StimulationCommand::set_timestamp_ns(uint64_t timestamp_ns) {
+  write_padded_varint(buffer_.data() + kTimestampOffset, timestamp_ns, kUint64Width);
+}
+
+void StimulationCommand::set_sequence_number(uint64_t sequence_number) {
+  write_padded_varint(buffer_.data() + kSequenceNumberOffset, sequence_number, kUint64Width);
+}
+
+void StimulationCommand::set_amplitude(size_t index, int32_t code) {
+  code = std::clamp(code, min_code_, max_code_);
+  write_padded_varint(buffer_.data() + amplitudes_offset_ + index * kSint32Width, zigzag(code), kSint32Width);
+}
+
+void StimulationCommand::set_amplitudes(const int32_t* codes) {
+  for (size_t i = 0; i < num_channels_; ++i) {
+    set_amplitude(i, codes[i]);
+  }
+}
+
+void StimulationCommandBuilder::Release::operator()(StimulationCommand* command) const {
+  builder->release(command);
+}
+
+StimulationCommandBuilder::StimulationCommandBuilder(
+  size_t num_channels,
+  int32_t min_code,
+  int32_t max_code,
+  double code_scale,
+  float sample_rate_hz,
+  size_t pool_size
+) : num_channels_(num_channels),
+    min_code_(min_code),
+    max_code_(max_code),
+    code_scale_(code_scale),
+    sample_rate_hz_(sample_rate_hz) {
+  const size_t frame_data_size = num_channels_ * kSint32Width;
+  const size_t amplitudes_offset = kFrameDataTagOffset + 1 + varint_size(frame_data_size);
+  const size_t size = amplitudes_offset + frame_data_size + 1 + sizeof(float);
+
+  pool_.reserve(pool_size);
+  free_.reserve(pool_size);
+  for (size_t i = 0; i < pool_size; ++i) {
+    pool_.emplace_back(new StimulationCommand(size, amplitudes_offset, num_channels_, min_code_, max_code_));
+    free_.push_back(pool_.back().get());
+  }
+}
+
+StimulationCommandBuilder::~StimulationCommandBuilder() = default;
+
+auto StimulationCommandBuilder::create(
+  const ElectricalStimulation& node,
+  std::unique_ptr<StimulationCommandBuilder>* builder,
+  size_t pool_size
+) -> science::Status {
+  if (builder == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "builder ptr must not be null" };
+  }
+  if (node.channels().empty()) {
+    return { science::StatusCode::kInvalidArgument, "node must have at least one channel" };
+  }
+  if (node.bit_width() == 0 || node.bit_width() > 32) {
+    return { science::StatusCode::kInvalidArgument, "bit width must be between 1 and 32" };
+  }
+  if (node.lsb() == 0) {
+    return { science::StatusCode::kInvalidArgument, "lsb must be positive" };
+  }
+  if (pool_size == 0) {
+    return { science::StatusCode::kInvalidArgument, "pool size must be positive" };
+  }
+
+  // Electrical amplitudes are signed, for either phase of a pulse
+  const int64_t half_range = int64_t(1) << (node.bit_width() - 1);
+  builder->reset(new StimulationCommandBuilder(
+    node.channels().size(),
+    static_cast<int32_t>(-half_range),
+    static_cast<int32_t>(half_range - 1),
+    1.0 / node.lsb(),
+    static_cast<float>(node.sample_rate()),
+    pool_size
+  ));
+  return {};
+}
+
+auto StimulationCommandBuilder::create(
+  const OpticalStimulation& node,
+  std::unique_ptr<StimulationCommandBuilder>* builder,
+  size_t pool_size
+) -> science::Status {
+  if (builder == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "builder ptr must not be null" };
+  }
+  if (!node.pixel_mask().has_value() || node.pixel_mask()->none()) {
+    return { science::StatusCode::kInvalidArgument, "node must have a pixel mask with at least one pixel" };
+  }
+  if (node.bit_width() == 0 || node.bit_width() > 31) {
+    return { science::StatusCode::kInvalidArgument, "bit width must be between 1 and 31" };
+  }
+  if (pool_size == 0) {
+    return { science::StatusCode::kInvalidArgument, "pool size must be positive" };
+  }
+
+  const int32_t max_code = static_cast<int32_t>((int64_t(1) << node.bit_width()) - 1);
+  builder->reset(new StimulationCommandBuilder(
+    node.pixel_mask()->count(),
+    0,
+    max_code,
+    max_code,
+    static_cast<float>(node.frame_rate()),
+    pool_size
+  ));
+  return {};
+}
+
+auto StimulationCommandBuilder::add_pattern(const std::vector<int32_t>& codes, size_t* pattern) -> science::Status {
+  if (pattern == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "pattern ptr must not be null" };
+  }
+  if (codes.size() != num_channels_) {
+    return {
+      science::StatusCode::kInvalidArgument,
+      "expected " + std::to_string(num_channels_) + " codes, got " + std::to_string(codes.size())
+    };
+  }
+  for (auto code : codes) {
+    if (code < min_code_ || code > max_code_) {
+      return {
+        science::StatusCode::kOutOfRange,
+        "code " + std::to_string(code) + " is outside the bit width's range [" + std::to_string(min_code_) + ", " +
+          std::to_string(max_code_) + "]"
+      };
+    }
+  }
+
+  const size_t frame_data_size = num_channels_ * kSint32Width;
+  std::vector<uint8_t> bytes(pool_.front()->size());
+  uint8_t* out = bytes.data();
+  out[0] = static_cast<uint8_t>(kTimestampTag);
+  write_padded_varint(out + kTimestampOffset, 0, kUint64Width);
+  out[kSequenceNumberOffset - 1] = static_cast<uint8_t>(kSequenceNumberTag);
+  write_padded_varint(out + kSequenceNumberOffset, 0, kUint64Width);
+  out[kFrameDataTagOffset] = static_cast<uint8_t>(kFrameDataTag);
+  size_t offset = kFrameDataTagOffset + 1;
+  offset += write_varint(out + offset, frame_data_size);
+  for (auto code : codes) {
+    write_padded_varint(out + offset, zigzag(code), kSint32Width);
+    offset += kSint32Width;
+  }
+
+  // fixed32 is little-endian on the wire
+  out[offset++] = static_cast<uint8_t>(kSampleRateTag);
+  uint32_t sample_rate_bits;
+  std::memcpy(&sample_rate_bits, &sample_rate_hz_, sizeof(sample_rate_bits));
+  for (size_t i = 0; i < sizeof(sample_rate_bits); ++i) {
+    out[offset++] = static_cast<uint8_t>(sample_rate_bits >> (8 * i));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  *pattern = patterns_.size();
+  patterns_.push_back(std::move(bytes));
+  return {};
+}
+
+auto StimulationCommandBuilder::acquire(size_t pattern, CommandPtr* command) -> science::Status {
+  if (command == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "command ptr must not be null" };
+  }
+
+  StimulationCommand* acquired;
+  const uint8_t* bytes;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pattern >= patterns_.size()) {
+      return { science::StatusCode::kNotFound, "no pattern " + std::to_string(pattern) };
+    }
+    if (free_.empty()) {
+      return { science::StatusCode::kResourceExhausted, "every pooled command is in use" };
+    }
+    acquired = free_.back();
+    free_.pop_back();
+    bytes = patterns_[pattern].data();
+  }
+
+  std::memcpy(acquired->buffer_.data(), bytes, acquired->buffer_.size());
+  *command = CommandPtr(acquired, Release{ this });
+  return {};
+}
+
+auto StimulationCommandBuilder::to_code(double amplitude) const -> int32_t {
+  const double code = std::round(amplitude * code_scale_);
+  return static_cast<int32_t>(std::clamp(code, static_cast<double>(min_code_), static_cast<double>(max_code_)));
+}
+
+auto StimulationCommandBuilder::available() const -> size_t {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return free_.size();
+}
+
+void StimulationCommandBuilder::release(StimulationCommand* command) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_.push_back(command);
+}
+
+}  // namespace synapse
@@ -0,0 +1,181 @@
+#include "science/synapse/stimulation_sequencer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "science/synapse/realtime.h"
+
+namespace synapse {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Longest single sleep, so stop() takes effect promptly during long gaps in the timeline
+constexpr auto kMaxSleep = std::chrono::milliseconds(10);
+
+}  // namespace
+
+StimulationSequencer::StimulationSequencer(Tap* output, const StimulationSequencerOptions& options)
+  : output_(output), options_(options) {}
+
+StimulationSequencer::~StimulationSequencer() {
+  stop();
+}
+
+auto StimulationSequencer::create(
+  Tap* output,
+  std::unique_ptr<StimulationSequencer>* sequencer,
+  const StimulationSequencerOptions& options
+) -> science::Status {
+  if (sequencer == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "sequencer ptr must not be null" };
+  }
+  if (output == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "tap ptr must not be null" };
+  }
+  if (options.spin.count() < 0) {
+    return { science::StatusCode::kInvalidArgument, "spin must not be negative" };
+  }
+
+  auto output_tap = output->connected_tap();
+  if (!output_tap) {
+    return { science::StatusCode::kFailedPrecondition, "tap must be connected" };
+  }
+  if (output_tap->tap_type() != synapse::TapType::TAP_TYPE_CONSUMER) {
+    return { science::StatusCode::kInvalidArgument, "output must be a consumer tap" };
+  }
+
+  sequencer->reset(new StimulationSequencer(output, options));
+  return {};
+}
+
+auto StimulationSequencer::add(std::chrono::nanoseconds offset, StimulationCommandBuilder::CommandPtr command)
+  -> science::Status {
+  if (running_) {
+    return { science::StatusCode::kFailedPrecondition, "cannot change the timeline while running" };
+  }
+  if (!command) {
+    return { science::StatusCode::kInvalidArgument, "command must not be null" };
+  }
+  if (offset.count() < 0) {
+    return { science::StatusCode::kInvalidArgument, "offset must not be negative" };
+  }
+
+  timeline_.push_back({ offset, std::move(command) });
+  return {};
+}
+
+auto StimulationSequencer::clear() -> science::Status {
+  if (running_) {
+    return { science::StatusCode::kFailedPrecondition, "cannot change the timeline while running" };
+  }
+  timeline_.clear();
+  return {};
+}
+
+auto StimulationSequencer::start() -> science::Status {
+  if (running_) {
+    return { science::StatusCode::kFailedPrecondition, "already running" };
+  }
+  wait();
+
+  std::stable_sort(timeline_.begin(), timeline_.end(), [](const Entry& a, const Entry& b) {
+    return a.offset < b.offset;
+  });
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_ = {};
+  }
+  commands_sent_ = 0;
+  send_errors_ = 0;
+  jitter_.reset();
+
+  // The thread places itself, then reports back before dispatching
+  std::lock_guard<std::mutex> lock(join_mutex_);
+  running_ = true;
+  auto s = start_placed_thread(&thread_, [this]() { return place_thread(); }, [this]() { run(); });
+  if (!s.ok()) {
+    running_ = false;
+  }
+  return s;
+}
+
+void StimulationSequencer::wait() {
+  std::lock_guard<std::mutex> lock(join_mutex_);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void StimulationSequencer::stop() {
+  running_ = false;
+  wait();
+}
+
+auto StimulationSequencer::status() const -> science::Status {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return status_;
+}
+
+auto StimulationSequencer::stats() const -> StimulationSequencerStats {
+  StimulationSequencerStats stats;
+  stats.commands_sent = commands_sent_.load(std::memory_order_relaxed);
+  stats.send_errors = send_errors_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+auto StimulationSequencer::place_thread() -> science::Status {
+  if (options_.cpu >= 0) {
+    auto s = pin_current_thread(options_.cpu);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  if (options_.realtime_priority > 0) {
+    return set_realtime_priority(options_.realtime_priority);
+  }
+
+  // Best effort: without it, wakeups may come up to 50 us late and eat into the spin
+  (void)set_timer_slack(std::chrono::nanoseconds(1));
+  return {};
+}
+
+void StimulationSequencer::run() {
+  const auto start = Clock::now();
+  for (const auto& entry : timeline_) {
+    const auto deadline = start + entry.offset;
+    const auto wake = deadline - options_.spin;
+
+    while (running_.load(std::memory_order_relaxed)) {
+      const auto now = Clock::now();
+      if (now >= wake) {
+        break;
+      }
+      sleep_until(std::min<Clock::time_point>(wake, now + kMaxSleep));
+    }
+    while (running_.load(std::memory_order_relaxed) && Clock::now() < deadline) {
+      cpu_relax();
+    }
+    if (!running_.load(std::memory_order_relaxed)) {
+      break;
+    }
+
+    jitter_.record(Clock::now() - deadline);
+    auto s = output_->send(entry.command->data(), entry.command->size());
+    if (s.ok()) {
+      commands_sent_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    // Keep to the schedule for the rest of the timeline; report the first failure
+    if (send_errors_.fetch_add(1, std::memory_order_relaxed) == 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      status_ = s;
+    }
+  }
+
+  running_ = false;
+}
+
+}  // namespace synapse
@@ -0,0 +1,243 @@
+#include "science/synapse/supervised_tap.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <google/protobuf/io/coded_stream.h>
+
+#include "science/synapse/api/datatype.pb.h"
+
+namespace synapse {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Longest a read blocks, so stop() and the watchdog are serviced promptly
+constexpr auto kMaxPoll = std::chrono::milliseconds(100);
+
+// Protobuf wire types (https://protobuf.dev/programming-guides/encoding/)
+constexpr uint32_t kWireTypeVarint = 0;
+constexpr uint32_t kWireTypeFixed64 = 1;
+constexpr uint32_t kWireTypeLengthDelimited = 2;
+constexpr uint32_t kWireTypeFixed32 = 5;
+
+constexpr uint32_t kSequenceNumberTag =
+  (static_cast<uint32_t>(synapse::BroadbandFrame::kSequenceNumberFieldNumber) << 3) | kWireTypeVarint;
+
+auto skip_field(google::protobuf::io::CodedInputStream* input, uint32_t tag) -> bool {
+  switch (tag & 0x7) {
+    case kWireTypeVarint: {
+      uint64_t value;
+      return input->ReadVarint64(&value);
+    }
+    case kWireTypeFixed64:
+      return input->Skip(8);
+    case kWireTypeLengthDelimited: {
+      uint32_t length;
+      return input->ReadVarint32(&length) && input->Skip(static_cast<int>(length));
+    }
+    case kWireTypeFixed32:
+      return input->Skip(4);
+    default:
+      // Groups don't appear in BroadbandFrame
+      return false;
+  }
+}
+
+}  // namespace
+
+auto broadband_sequence_number(const uint8_t* data, size_t size) -> std::optional<uint64_t> {
+  google::protobuf::io::CodedInputStream input(data, static_cast<int>(size));
+  while (uint32_t tag = input.ReadTag()) {
+    if (tag == kSequenceNumberTag) {
+      uint64_t value;
+      if (!input.ReadVarint64(&value)) {
+        return std::nullopt;
+      }
+      return value;
+    }
+    if (!skip_field(&input, tag)) {
+      return std::nullopt;
+    }
+  }
+  return std::nullopt;
+}
+
+SupervisedTap::SupervisedTap(
+  Tap* tap, MessageCallback on_message, const SupervisedTapOptions& options, GapCallback on_gap
+) : tap_(tap), on_message_(std::move(on_message)), options_(options), on_gap_(std::move(on_gap)) {}
+
+SupervisedTap::~SupervisedTap() {
+  stop();
+}
+
+auto SupervisedTap::create(
+  Tap* tap,
+  MessageCallback on_message,
+  std::unique_ptr<SupervisedTap>* supervised,
+  const SupervisedTapOptions& options,
+  GapCallback on_gap
+) -> science::Status {
+  if (supervised == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "supervised ptr must not be null" };
+  }
+  if (tap == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "tap ptr must not be null" };
+  }
+  if (!on_message) {
+    return { science::StatusCode::kInvalidArgument, "message callback must be set" };
+  }
+  if (options.stall_timeout.count() <= 0) {
+    return { science::StatusCode::kInvalidArgument, "stall timeout must be positive" };
+  }
+  if (options.initial_backoff.count() <= 0 || options.max_backoff < options.initial_backoff) {
+    return { science::StatusCode::kInvalidArgument, "backoff must be positive and no more than max backoff" };
+  }
+
+  auto connected = tap->connected_tap();
+  if (!connected) {
+    return { science::StatusCode::kFailedPrecondition, "tap must be connected" };
+  }
+  if (connected->tap_type() == synapse::TapType::TAP_TYPE_CONSUMER) {
+    return { science::StatusCode::kInvalidArgument, "tap must be a producer tap" };
+  }
+
+  supervised->reset(new SupervisedTap(tap, std::move(on_message), options, std::move(on_gap)));
+  return {};
+}
+
+auto SupervisedTap::start() -> science::Status {
+  if (running_) {
+    return { science::StatusCode::kFailedPrecondition, "already running" };
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  running_ = true;
+  thread_ = std::thread([this]() { run(); });
+  return {};
+}
+
+void SupervisedTap::stop() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+auto SupervisedTap::stats() const -> SupervisedTapStats {
+  SupervisedTapStats stats;
+  stats.messages = messages_.load(std::memory_order_relaxed);
+  stats.stalls = stalls_.load(std::memory_order_relaxed);
+  stats.reconnects = reconnects_.load(std::memory_order_relaxed);
+  stats.gaps = gaps_.load(std::memory_order_relaxed);
+  stats.lost_messages = lost_messages_.load(std::memory_order_relaxed);
+  stats.stalled = stalled_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+auto SupervisedTap::last_gap() const -> std::optional<TapGap> {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_gap_;
+}
+
+auto SupervisedTap::status() const -> science::Status {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return status_;
+}
+
+void SupervisedTap::report_gap(const TapGap& gap) {
+  gaps_.fetch_add(1, std::memory_order_relaxed);
+  if (auto lost = gap.lost()) {
+    lost_messages_.fetch_add(*lost, std::memory_order_relaxed);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_gap_ = gap;
+  }
+  if (on_gap_) {
+    on_gap_(gap);
+  }
+}
+
+void SupervisedTap::run() {
+  const int poll_ms = static_cast<int>(std::min<std::chrono::milliseconds>(options_.stall_timeout, kMaxPoll).count());
+  std::vector<uint8_t> buffer;
+
+  auto last_message = Clock::now();
+  std::optional<uint64_t> last_sequence;
+  bool stalled = false;
+  uint32_t attempts = 0;
+  auto backoff = options_.initial_backoff;
+  auto next_attempt = Clock::time_point::min();
+
+  while (running_.load(std::memory_order_relaxed)) {
+    auto s = tap_->read(&buffer, poll_ms);
+    auto now = Clock::now();
+
+    if (s.ok()) {
+      std::optional<uint64_t> sequence;
+      if (options_.sequence_number) {
+        sequence = options_.sequence_number(buffer.data(), buffer.size());
+      }
+
+      const bool skipped = sequence && last_sequence && *sequence != *last_sequence + 1;
+      if (stalled || skipped) {
+        TapGap gap;
+        gap.duration = now - last_message;
+        gap.reconnects = attempts;
+        gap.last_sequence_number = last_sequence;
+        gap.next_sequence_number = sequence;
+        report_gap(gap);
+      }
+      if (stalled) {
+        stalled = false;
+        stalled_ = false;
+        attempts = 0;
+        backoff = options_.initial_backoff;
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_ = {};
+      }
+
+      last_message = now;
+      if (sequence) {
+        last_sequence = sequence;
+      }
+      messages_.fetch_add(1, std::memory_order_relaxed);
+      on_message_(buffer.data(), buffer.size());
+      continue;
+    }
+
+    if (now - last_message >= options_.stall_timeout) {
+      if (!stalled) {
+        stalled = true;
+        stalled_ = true;
+        stalls_.fetch_add(1, std::memory_order_relaxed);
+        next_attempt = now;
+      }
+      if (now >= next_attempt) {
+        attempts++;
+        reconnects_.fetch_add(1, std::memory_order_relaxed);
+        auto reconnected = tap_->reconnect();
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          status_ = reconnected;
+        }
+        next_attempt = now + backoff;
+        backoff = std::min(backoff * 2, options_.max_backoff);
+        continue;
+      }
+    }
+
+    // Reads fail immediately without a socket, so wait rather than spin
+    if (s.code() != science::StatusCode::kDeadlineExceeded) {
+      auto wait = stalled ? std::min<Clock::duration>(next_attempt - now, kMaxPoll) : Clock::duration(kMaxPoll);
+      std::this_thread::sleep_for(wait);
+    }
+  }
+}
+
+}  // namespace synapse
@@ -1,8 +1,12 @@
 #include "science/synapse/tap.h"
 #include "science/synapse/device.h"
+#include "science/synapse/realtime.h"
+#include "science/synapse/tap_monitor.h"
 #include "science/synapse/api/query.pb.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <regex>
 
@@ -12,7 +16,8 @@ Tap::Tap(const std::string& device_uri)
     : device_uri_(device_uri),
       zmq_context_(nullptr),
       zmq_socket_(nullptr),
-      connected_tap_(std::nullopt) {}
+      connected_tap_(std::nullopt),
+      monitor_(std::make_unique<TapMonitor>()) {}
 
 Tap::~Tap() {
   cleanup();
@@ -22,7 +27,11 @@ Tap::Tap(Tap&& other) noexcept
     : device_uri_(std::move(other.device_uri_)),
       zmq_context_(std::move(other.zmq_context_)),
       zmq_socket_(std::move(other.zmq_socket_)),
-      connected_tap_(std::move(other.connected_tap_)) {}
+      connected_tap_(std::move(other.connected_tap_)),
+      connected_endpoint_(std::move(other.connected_endpoint_)),
+      receive_options_(other.receive_options_),
+      monitor_(std::move(other.monitor_)),
+      receive_timeout_ms_(other.receive_timeout_ms_) {}
 
 Tap& Tap::operator=(Tap&& other) noexcept {
   if (this != &other) {
@@ -31,6 +40,10 @@ Tap& Tap::operator=(Tap&& other) noexcept {
     zmq_context_ = std::move(other.zmq_context_);
     zmq_socket_ = std::move(other.zmq_socket_);
     connected_tap_ = std::move(other.connected_tap_);
+    connected_endpoint_ = std::move(other.connected_endpoint_);
+    receive_options_ = other.receive_options_;
+    monitor_ = std::move(other.monitor_);
+    receive_timeout_ms_ = other.receive_timeout_ms_;
   }
   return *this;
 }
@@ -77,11 +90,76 @@ auto Tap::connect(const std::string& tap_name) -> science::Status {
     return {science::StatusCode::kNotFound, "Tap '" + tap_name + "' not found"};
   }
 
+  // Build the endpoint URL, replacing the host with our device URI
+  std::string endpoint = selected_tap->endpoint();
+  if (endpoint.find("://") != std::string::npos) {
+    // Extract protocol and port from the endpoint
+    std::regex endpoint_regex("([^:]+)://[^:]+:(\\d+)");
+    std::smatch match;
+    if (std::regex_match(endpoint, match, endpoint_regex)) {
+      std::string protocol = match[1].str();
+      std::string port = match[2].str();
+
+      // Extract host from device URI (strip port if present)
+      std::string host = device_uri_;
+      auto colon_pos = host.find(':');
+      if (colon_pos != std::string::npos) {
+        host = host.substr(0, colon_pos);
+      }
+
+      endpoint = protocol + "://" + host + ":" + port;
+    }
+  }
+
+  return connect_endpoint(*selected_tap, endpoint);
+}
+
+auto Tap::connect(const synapse::TapConnection& tap) -> science::Status {
+  return connect_endpoint(tap, tap.endpoint());
+}
+
+auto Tap::connect_endpoint(const synapse::TapConnection& tap, const std::string& endpoint) -> science::Status {
+  cleanup();
+
   // Initialize ZMQ context
   zmq_context_ = std::make_unique<zmq::context_t>(1);
 
+  // A moved-from tap gives up its monitor
+  if (!monitor_) {
+    monitor_ = std::make_unique<TapMonitor>();
+  }
+  monitor_->reset();
+
+  auto status = open_socket(tap, endpoint);
+  if (!status.ok()) {
+    cleanup();
+    return status;
+  }
+
+  connected_tap_ = tap;
+  connected_endpoint_ = endpoint;
+  return {};
+}
+
+auto Tap::reconnect() -> science::Status {
+  if (!connected_tap_.has_value() || zmq_context_ == nullptr) {
+    return {science::StatusCode::kFailedPrecondition, "Not connected to any tap"};
+  }
+
+  monitor_->detach();
+  if (zmq_socket_) {
+    zmq_socket_->close();
+    zmq_socket_.reset();
+  }
+  receive_timeout_ms_.reset();
+
+  monitor_->reset();
+  return open_socket(*connected_tap_, connected_endpoint_);
+}
+
+auto Tap::open_socket(const synapse::TapConnection& tap, const std::string& endpoint) -> science::Status {
   // Create appropriate socket type based on tap type
-  if (selected_tap->tap_type() == synapse::TapType::TAP_TYPE_CONSUMER) {
+  if (tap.tap_type() == synapse::TapType::TAP_TYPE_CONSUMER) {
     // For consumer taps, we need to publish data TO the tap
     zmq_socket_ = std::make_unique<zmq::socket_t>(*zmq_context_, zmq::socket_type::pub);
   } else {
@@ -104,43 +182,55 @@ auto Tap::connect(const std::string& tap_name) -> science::Status {
   zmq_socket_->set(zmq::sockopt::tcp_keepalive, 1);
   zmq_socket_->set(zmq::sockopt::tcp_keepalive_idle, 60);
 
-  // Build the endpoint URL, replacing the host with our device URI
-  std::string endpoint = selected_tap->endpoint();
-  if (endpoint.find("://") != std::string::npos) {
-    // Extract protocol and port from the endpoint
-    std::regex endpoint_regex("([^:]+)://[^:]+:(\\d+)");
-    std::smatch match;
-    if (std::regex_match(endpoint, match, endpoint_regex)) {
-      std::string protocol = match[1].str();
-      std::string port = match[2].str();
-
-      // Extract host from device URI (strip port if present)
-      std::string host = device_uri_;
-      auto colon_pos = host.find(':');
-      if (colon_pos != std::string::npos) {
-        host = host.substr(0, colon_pos);
-      }
-
-      endpoint = protocol + "://" + host + ":" + port;
+  // Must be set before connecting, as it applies to the TCP sockets libzmq creates
+  if (receive_options_.socket_busy_poll_us > 0) {
+    // ZMQ_BUSY_POLL is in the draft section of zmq.h, defined only under ZMQ_BUILD_DRAFT_API
+#ifdef ZMQ_BUSY_POLL
+    int busy_poll_us = receive_options_.socket_busy_poll_us;
+    if (zmq_setsockopt(zmq_socket_->handle(), ZMQ_BUSY_POLL, &busy_poll_us, sizeof(busy_poll_us)) != 0) {
+      std::string error = zmq_strerror(zmq_errno());
+      zmq_socket_.reset();
+      return {science::StatusCode::kUnimplemented,
+              "Failed to set busy poll (libzmq needs its draft API; or set net.core.busy_read): " + error};
     }
+#else
+    zmq_socket_.reset();
+    return {science::StatusCode::kUnimplemented,
+            "Socket busy poll needs ZMQ_BUILD_DRAFT_API (or set net.core.busy_read instead)"};
+#endif
   }
 
   try {
+    // Attach before connecting, so the first events aren't missed
+    if (receive_options_.monitor_connection) {
+      monitor_->attach(zmq_context_.get(), zmq_socket_.get());
+    }
     zmq_socket_->connect(endpoint);
 
     // Only set subscription for subscriber sockets
-    if (selected_tap->tap_type() != synapse::TapType::TAP_TYPE_CONSUMER) {
+    if (tap.tap_type() != synapse::TapType::TAP_TYPE_CONSUMER) {
       zmq_socket_->set(zmq::sockopt::subscribe, "");
     }
 
-    connected_tap_ = *selected_tap;
     return {};
   } catch (const zmq::error_t& e) {
-    cleanup();
+    monitor_->detach();
+    zmq_socket_.reset();
     return {science::StatusCode::kInternal, "Failed to connect to tap: " + std::string(e.what())};
   }
 }
 
+auto Tap::set_receive_options(const TapReceiveOptions& options) -> science::Status {
+  if (options.spin_budget.count() < 0) {
+    return {science::StatusCode::kInvalidArgument, "spin budget must not be negative"};
+  }
+  if (options.socket_busy_poll_us < 0) {
+    return {science::StatusCode::kInvalidArgument, "socket busy poll must not be negative"};
+  }
+  receive_options_ = options;
+  return {};
+}
+
 void Tap::disconnect() {
   cleanup();
 }
@@ -153,6 +243,13 @@ auto Tap::connected_tap() const -> std::optional<synapse::TapConnection> {
   return connected_tap_;
 }
 
+auto Tap::connection_stats() const -> TapConnectionStats {
+  if (!monitor_) {
+    return {};
+  }
+  return monitor_->stats();
+}
+
 auto Tap::read(std::vector<uint8_t>* out, int timeout_ms) -> science::Status {
   if (!is_connected()) {
     return {science::StatusCode::kFailedPrecondition, "Not connected to any tap"};
@@ -166,19 +263,73 @@ auto Tap::read(std::vector<uint8_t>* out, int timeout_ms) -> science::Status {
     return {science::StatusCode::kInvalidArgument, "Output buffer cannot be null"};
   }
 
+  zmq::message_t message;
+  auto status = receive(&message, timeout_ms);
+  if (!status.ok()) {
+    return status;
+  }
+  monitor_->on_message();
+
+  out->resize(message.size());
+  std::memcpy(out->data(), message.data(), message.size());
+  return {};
+}
+
+auto Tap::read(zmq::message_t* message, int timeout_ms) -> science::Status {
+  if (!is_connected()) {
+    return {science::StatusCode::kFailedPrecondition, "Not connected to any tap"};
+  }
+
+  if (connected_tap_->tap_type() == synapse::TapType::TAP_TYPE_CONSUMER) {
+    return {science::StatusCode::kInvalidArgument, "Cannot read from consumer tap"};
+  }
+
+  if (message == nullptr) {
+    return {science::StatusCode::kInvalidArgument, "message ptr must not be null"};
+  }
+
+  auto status = receive(message, timeout_ms);
+  if (status.ok()) {
+    monitor_->on_message();
+  }
+  return status;
+}
+
+auto Tap::receive(zmq::message_t* message, int timeout_ms) -> science::Status {
   try {
-    zmq_socket_->set(zmq::sockopt::rcvtimeo, timeout_ms);
+    if (receive_options_.busy_poll) {
+      // Spin for whichever is shorter, the budget or the timeout; a negative timeout waits forever
+      auto start = std::chrono::steady_clock::now();
+      auto spin = receive_options_.spin_budget;
+      if (timeout_ms >= 0) {
+        spin = std::min<std::chrono::microseconds>(spin, std::chrono::milliseconds(timeout_ms));
+      }
+      while (true) {
+        if (zmq_socket_->recv(*message, zmq::recv_flags::dontwait).has_value()) {
+          return {};
+        }
+        if (std::chrono::steady_clock::now() - start >= spin) {
+          break;
+        }
+        cpu_relax();
+      }
 
-    zmq::message_t message;
-    auto result = zmq_socket_->recv(message);
+      if (timeout_ms >= 0) {
+        auto spun = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        timeout_ms -= static_cast<int>(spun.count());
+        if (timeout_ms <= 0) {
+          return {science::StatusCode::kDeadlineExceeded, "Timeout waiting for data"};
+        }
+      }
+    }
+
+    set_receive_timeout(timeout_ms);
+    auto result = zmq_socket_->recv(*message);
 
     if (!result.has_value()) {
       return {science::StatusCode::kDeadlineExceeded, "Timeout waiting for data"};
     }
 
-    out->resize(message.size());
-    std::memcpy(out->data(), message.data(), message.size());
-
     return {};
   } catch (const zmq::error_t& e) {
     if (e.num() == EAGAIN) {
@@ -188,7 +339,43 @@ auto Tap::read(std::vector<uint8_t>* out, int timeout_ms) -> science::Status {
   }
 }
 
+void Tap::set_receive_timeout(int timeout_ms) {
+  if (receive_timeout_ms_ != timeout_ms) {
+    zmq_socket_->set(zmq::sockopt::rcvtimeo, timeout_ms);
+    receive_timeout_ms_ = timeout_ms;
+  }
+}
+
+auto Tap::try_read(zmq::message_t* message) -> science::Status {
+  if (!is_connected()) {
+    return {science::StatusCode::kFailedPrecondition, "Not connected to any tap"};
+  }
+
+  if (connected_tap_->tap_type() == synapse::TapType::TAP_TYPE_CONSUMER) {
+    return {science::StatusCode::kInvalidArgument, "Cannot read from consumer tap"};
+  }
+
+  if (message == nullptr) {
+    return {science::StatusCode::kInvalidArgument, "message ptr must not be null"};
+  }
+
+  try {
+    auto result = zmq_socket_->recv(*message, zmq::recv_flags::dontwait);
+    if (!result.has_value()) {
+      return {science::StatusCode::kDeadlineExceeded, "No message waiting"};
+    }
+    monitor_->on_message();
+    return {};
+  } catch (const zmq::error_t& e) {
+    return {science::StatusCode::kInternal, "Error receiving message: " + std::string(e.what())};
+  }
+}
+
 auto Tap::send(const std::vector<uint8_t>& data) -> science::Status {
+  return send(data.data(), data.size());
+}
+
+auto Tap::send(const uint8_t* data, size_t size) -> science::Status {
   if (!is_connected()) {
     return {science::StatusCode::kFailedPrecondition, "Not connected to any tap"};
   }
@@ -198,7 +385,7 @@ auto Tap::send(const std::vector<uint8_t>& data) -> science::Status {
   }
 
   try {
-    zmq::message_t message(data.data(), data.size());
+    zmq::message_t message(data, size);
     auto result = zmq_socket_->send(message, zmq::send_flags::none);
 
     if (!result.has_value()) {
@@ -225,7 +412,7 @@ auto Tap::read_batch(std::vector<std::vector<uint8_t>>* out,
   out->clear();
   out->reserve(max_messages);
 
-  zmq_socket_->set(zmq::sockopt::rcvtimeo, timeout_ms);
+  set_receive_timeout(timeout_ms);
 
   try {
     while (out->size() < max_messages) {
@@ -245,10 +432,19 @@ auto Tap::read_batch(std::vector<std::vector<uint8_t>>* out,
     // Ignore errors in batch mode
   }
 
+  if (!out->empty()) {
+    monitor_->on_message();
+  }
   return out->size();
 }
 
 void Tap::cleanup() {
+  // The monitor's socket shares the context, so it has to go first
+  if (monitor_) {
+    monitor_->detach();
+    monitor_->set_disconnected();
+  }
+
   if (zmq_socket_) {
     zmq_socket_->close();
     zmq_socket_.reset();
@@ -260,6 +456,8 @@ void Tap::cleanup() {
   }
 
   connected_tap_.reset();
+  connected_endpoint_.clear();
+  receive_timeout_ms_.reset();
 }
 
 }  // namespace synapse
@@ -0,0 +1,226 @@
+#include "science/synapse/tap_hub.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace synapse {
+
+namespace {
+
+// Longest a read blocks, so stop() is serviced promptly
+constexpr int kReadTimeoutMs = 100;
+
+}  // namespace
+
+TapSubscriber::TapSubscriber(const TapSubscriberOptions& options) : options_(options) {}
+
+auto TapSubscriber::pop(TapMessage* message, std::chrono::milliseconds timeout) -> science::Status {
+  if (message == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "message ptr must not be null" };
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!ready_.wait_for(lock, timeout, [this]() { return !queue_.empty() || closed_; })) {
+    return { science::StatusCode::kDeadlineExceeded, "no message within timeout" };
+  }
+  if (queue_.empty()) {
+    return { science::StatusCode::kCancelled, "subscriber closed" };
+  }
+
+  *message = std::move(queue_.front());
+  queue_.pop_front();
+  return {};
+}
+
+auto TapSubscriber::try_pop(TapMessage* message) -> science::Status {
+  return pop(message, std::chrono::milliseconds(0));
+}
+
+void TapSubscriber::close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  ready_.notify_all();
+}
+
+auto TapSubscriber::is_closed() const -> bool {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return closed_;
+}
+
+auto TapSubscriber::stats() const -> TapSubscriberStats {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto stats = stats_;
+  stats.queue_depth = queue_.size();
+  return stats;
+}
+
+auto TapSubscriber::push(const TapMessage& message) -> bool {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+      return false;
+    }
+    if (queue_.size() >= options_.capacity) {
+      stats_.dropped++;
+      if (options_.drop_policy == DropPolicy::kDropNewest) {
+        return true;
+      }
+      queue_.pop_front();
+    }
+    queue_.push_back(message);
+    stats_.received++;
+    stats_.max_queue_depth = std::max(stats_.max_queue_depth, queue_.size());
+  }
+  ready_.notify_one();
+  return true;
+}
+
+TapHub::TapHub(Tap* tap) : tap_(tap) {}
+
+TapHub::~TapHub() {
+  stop();
+
+  // Let blocked subscribers know nothing more is coming
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& subscriber : subscribers_) {
+    subscriber->close();
+  }
+}
+
+auto TapHub::create(Tap* tap, std::unique_ptr<TapHub>* hub) -> science::Status {
+  if (hub == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "hub ptr must not be null" };
+  }
+  if (tap == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "tap ptr must not be null" };
+  }
+
+  auto connected = tap->connected_tap();
+  if (!connected) {
+    return { science::StatusCode::kFailedPrecondition, "tap must be connected" };
+  }
+  if (connected->tap_type() == synapse::TapType::TAP_TYPE_CONSUMER) {
+    return { science::StatusCode::kInvalidArgument, "tap must be a producer tap" };
+  }
+
+  hub->reset(new TapHub(tap));
+  return {};
+}
+
+auto TapHub::subscribe(std::shared_ptr<TapSubscriber>* subscriber, const TapSubscriberOptions& options)
+  -> science::Status {
+  if (subscriber == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "subscriber ptr must not be null" };
+  }
+  if (options.capacity == 0) {
+    return { science::StatusCode::kInvalidArgument, "capacity must be positive" };
+  }
+
+  *subscriber = std::make_shared<TapSubscriber>(options);
+  std::lock_guard<std::mutex> lock(mutex_);
+  subscribers_.push_back(*subscriber);
+  return {};
+}
+
+auto TapHub::subscribe_latest(std::shared_ptr<LatestFrame>* latest, size_t max_size) -> science::Status {
+  if (latest == nullptr) {
+    return { science::StatusCode::kInvalidArgument, "latest ptr must not be null" };
+  }
+  if (max_size == 0) {
+    return { science::StatusCode::kInvalidArgument, "max size must be positive" };
+  }
+
+  *latest = std::make_shared<LatestFrame>(max_size);
+  std::lock_guard<std::mutex> lock(mutex_);
+  latest_.push_back(*latest);
+  return {};
+}
+
+auto TapHub::num_subscribers() const -> size_t {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto queued = std::count_if(subscribers_.begin(), subscribers_.end(), [](const auto& subscriber) {
+    return !subscriber->is_closed();
+  });
+  auto conflated = std::count_if(latest_.begin(), latest_.end(), [](const auto& latest) {
+    return latest.use_count() > 1;
+  });
+  return queued + conflated;
+}
+
+auto TapHub::start() -> science::Status {
+  if (running_) {
+    return { science::StatusCode::kFailedPrecondition, "already running" };
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_ = {};
+  }
+  running_ = true;
+  thread_ = std::thread([this]() { run(); });
+  return {};
+}
+
+void TapHub::stop() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+auto TapHub::status() const -> science::Status {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return status_;
+}
+
+void TapHub::run() {
+  science::Status s;
+  while (running_.load(std::memory_order_relaxed)) {
+    zmq::message_t message;
+    s = tap_->read(&message, kReadTimeoutMs);
+    if (s.code() == science::StatusCode::kDeadlineExceeded) {
+      continue;
+    }
+    if (!s.ok()) {
+      break;
+    }
+    messages_received_.fetch_add(1, std::memory_order_relaxed);
+
+    // One allocation per message, however many subscribers share it
+    TapMessage shared = std::make_shared<const zmq::message_t>(std::move(message));
+
+    // Closed subscribers refuse the message and are dropped
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscribers_.erase(
+      std::remove_if(subscribers_.begin(), subscribers_.end(), [&shared](const auto& subscriber) {
+        return !subscriber->push(shared);
+      }),
+      subscribers_.end()
+    );
+
+    // Oversized messages are skipped; views nobody else holds any more are dropped
+    latest_.erase(
+      std::remove_if(latest_.begin(), latest_.end(), [&shared](const auto& latest) {
+        if (latest.use_count() == 1) {
+          return true;
+        }
+        (void)latest->publish(static_cast<const uint8_t*>(shared->data()), shared->size());
+        return false;
+      }),
+      latest_.end()
+    );
+  }
+
+  running_ = false;
+  if (!s.ok() && s.code() != science::StatusCode::kDeadlineExceeded) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_ = s;
+  }
+}
+
+}  // namespace synapse
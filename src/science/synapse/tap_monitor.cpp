@@ -0,0 +1,201 @@
+#include "science/synapse/tap_monitor.h"
+
+#include <cstring>
+#include <string>
+
+namespace synapse {
+
+namespace {
+
+// Longest the monitor thread waits for an event; after detach(), how long it waits for the last one
+constexpr int kEventTimeoutMs = 100;
+
+constexpr int kMonitoredEvents = ZMQ_EVENT_CONNECTED | ZMQ_EVENT_CONNECT_DELAYED | ZMQ_EVENT_CONNECT_RETRIED |
+                                 ZMQ_EVENT_DISCONNECTED | ZMQ_EVENT_HANDSHAKE_SUCCEEDED |
+                                 ZMQ_EVENT_HANDSHAKE_FAILED_NO_DETAIL | ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL |
+                                 ZMQ_EVENT_HANDSHAKE_FAILED_AUTH | ZMQ_EVENT_MONITOR_STOPPED;
+
+auto to_duration(int64_t ns) -> std::optional<std::chrono::nanoseconds> {
+  if (ns < 0) {
+    return std::nullopt;
+  }
+  return std::chrono::nanoseconds(ns);
+}
+
+// Each monitor needs its own inproc endpoint
+std::atomic<uint64_t> next_monitor_id{ 0 };
+
+}  // namespace
+
+TapMonitor::TapMonitor() : connect_time_(std::chrono::steady_clock::now()),
+                           state_(static_cast<int>(TapConnectionState::kDisconnected)) {}
+
+TapMonitor::~TapMonitor() {
+  detach();
+}
+
+void TapMonitor::reset() {
+  connect_time_ = std::chrono::steady_clock::now();
+  first_message_ = false;
+  set_state(TapConnectionState::kConnecting);
+  connects_ = 0;
+  connect_delays_ = 0;
+  connect_retries_ = 0;
+  disconnects_ = 0;
+  handshakes_ = 0;
+  handshake_failures_ = 0;
+  time_to_connect_ns_ = -1;
+  time_to_handshake_ns_ = -1;
+  time_to_first_message_ns_ = -1;
+}
+
+void TapMonitor::attach(zmq::context_t* context, zmq::socket_t* socket) {
+  detach();
+
+  // The event socket has to be connected before the monitored socket does anything, since
+  // libzmq drops events while nothing is connected
+  const std::string endpoint = "inproc://synapse-tap-monitor-" + std::to_string(next_monitor_id++);
+  if (zmq_socket_monitor(socket->handle(), endpoint.c_str(), kMonitoredEvents) != 0) {
+    // Stats just stay empty; the tap works the same without them
+    return;
+  }
+  try {
+    events_ = zmq::socket_t(*context, zmq::socket_type::pair);
+    events_.connect(endpoint);
+  } catch (const zmq::error_t&) {
+    zmq_socket_monitor(socket->handle(), nullptr, 0);
+    events_.close();
+    return;
+  }
+
+  socket_ = socket;
+  running_ = true;
+  thread_ = std::thread([this]() { run(); });
+}
+
+void TapMonitor::detach() {
+  if (socket_ == nullptr) {
+    return;
+  }
+
+  // Stopping the monitor sends a final MONITOR_STOPPED event, which ends the thread
+  zmq_socket_monitor(socket_->handle(), nullptr, 0);
+  socket_ = nullptr;
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void TapMonitor::run() {
+  while (true) {
+    zmq_pollitem_t item = { events_.handle(), 0, ZMQ_POLLIN, 0 };
+    const int rc = zmq_poll(&item, 1, kEventTimeoutMs);
+    if (rc < 0) {
+      break;
+    }
+    if (rc == 0) {
+      // After detach() there's nothing left to wait for, even if MONITOR_STOPPED was dropped
+      // because the event queue was full
+      if (!running_.load(std::memory_order_relaxed)) {
+        break;
+      }
+      continue;
+    }
+
+    // Each event is a frame with its id and value, then one with the endpoint
+    uint16_t event = 0;
+    try {
+      zmq::message_t frame;
+      if (!events_.recv(frame, zmq::recv_flags::none).has_value()) {
+        continue;
+      }
+      if (frame.size() >= sizeof(event)) {
+        std::memcpy(&event, frame.data(), sizeof(event));
+      }
+      while (frame.more()) {
+        if (!events_.recv(frame, zmq::recv_flags::none).has_value()) {
+          break;
+        }
+      }
+    } catch (const zmq::error_t&) {
+      break;
+    }
+
+    if (event == ZMQ_EVENT_MONITOR_STOPPED) {
+      break;
+    }
+    on_event(event);
+  }
+
+  // The event socket belongs to this thread, so it's closed here
+  events_.close();
+}
+
+void TapMonitor::on_event(uint16_t event) {
+  switch (event) {
+    case ZMQ_EVENT_CONNECTED:
+      connects_.fetch_add(1, std::memory_order_relaxed);
+      on_connected();
+      break;
+    case ZMQ_EVENT_CONNECT_DELAYED:
+      connect_delays_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    case ZMQ_EVENT_CONNECT_RETRIED:
+      connect_retries_.fetch_add(1, std::memory_order_relaxed);
+      set_state(TapConnectionState::kConnecting);
+      break;
+    case ZMQ_EVENT_DISCONNECTED:
+      disconnects_.fetch_add(1, std::memory_order_relaxed);
+      set_state(TapConnectionState::kConnecting);
+      break;
+    case ZMQ_EVENT_HANDSHAKE_SUCCEEDED: {
+      handshakes_.fetch_add(1, std::memory_order_relaxed);
+      int64_t unset = -1;
+      time_to_handshake_ns_.compare_exchange_strong(unset, elapsed_ns());
+      break;
+    }
+    case ZMQ_EVENT_HANDSHAKE_FAILED_NO_DETAIL:
+    case ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL:
+    case ZMQ_EVENT_HANDSHAKE_FAILED_AUTH:
+      handshake_failures_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    default:
+      break;
+  }
+}
+
+void TapMonitor::set_disconnected() {
+  set_state(TapConnectionState::kDisconnected);
+}
+
+auto TapMonitor::stats() const -> TapConnectionStats {
+  TapConnectionStats stats;
+  stats.state = static_cast<TapConnectionState>(state_.load(std::memory_order_relaxed));
+  stats.connects = connects_.load(std::memory_order_relaxed);
+  stats.connect_delays = connect_delays_.load(std::memory_order_relaxed);
+  stats.connect_retries = connect_retries_.load(std::memory_order_relaxed);
+  stats.disconnects = disconnects_.load(std::memory_order_relaxed);
+  stats.handshakes = handshakes_.load(std::memory_order_relaxed);
+  stats.handshake_failures = handshake_failures_.load(std::memory_order_relaxed);
+  stats.time_to_connect = to_duration(time_to_connect_ns_.load(std::memory_order_relaxed));
+  stats.time_to_handshake = to_duration(time_to_handshake_ns_.load(std::memory_order_relaxed));
+  stats.time_to_first_message = to_duration(time_to_first_message_ns_.load(std::memory_order_relaxed));
+  return stats;
+}
+
+auto TapMonitor::elapsed_ns() const -> int64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - connect_time_).count();
+}
+
+void TapMonitor::on_connected() {
+  set_state(TapConnectionState::kConnected);
+  int64_t unset = -1;
+  time_to_connect_ns_.compare_exchange_strong(unset, elapsed_ns());
+}
+
+void TapMonitor::set_state(TapConnectionState state) {
+  state_.store(static_cast<int>(state), std::memory_order_relaxed);
+}
+
+}  // namespace synapse
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <zmq.hpp>
+#include "science/synapse/tap.h"
+
+namespace synapse {
+
+/**
+ * Keeps a Tap's connection stats, optionally from a ZMQ socket monitor.
+ *
+ * Monitor events are handled on a thread of its own, and only update atomics, so the Tap's
+ * receive path only pays for on_message(). Without attach(), only the state and the time to the
+ * first message are tracked.
+ */
+class TapMonitor {
+ public:
+  TapMonitor();
+  ~TapMonitor();
+
+  TapMonitor(const TapMonitor&) = delete;
+  TapMonitor& operator=(const TapMonitor&) = delete;
+
+  /**
+   * Start counting for a new connection: clears the stats and restarts the clock.
+   */
+  void reset();
+
+  /**
+   * Start monitoring a socket, from the thread that owns it. The context must outlive the
+   * monitor, until detach().
+   */
+  void attach(zmq::context_t* context, zmq::socket_t* socket);
+
+  /**
+   * Stop monitoring, from the thread that owns the socket; must be called before it is closed.
+   */
+  void detach();
+
+  /**
+   * Mark the tap as disconnected by the user, rather than by the network.
+   */
+  void set_disconnected();
+
+  /**
+   * Note a received message; only the first after reset() does any work.
+   */
+  void on_message() {
+    if (!first_message_) {
+      first_message_ = true;
+      time_to_first_message_ns_.store(elapsed_ns(), std::memory_order_relaxed);
+      set_state(TapConnectionState::kConnected);
+    }
+  }
+
+  [[nodiscard]] auto stats() const -> TapConnectionStats;
+
+ private:
+  auto elapsed_ns() const -> int64_t;
+  void run();
+  void on_event(uint16_t event);
+  void on_connected();
+  void set_state(TapConnectionState state);
+
+  // The monitored socket, and the PAIR socket its events arrive on; the thread owns the latter
+  zmq::socket_t* socket_ = nullptr;
+  zmq::socket_t events_;
+  std::thread thread_;
+  std::atomic<bool> running_{ false };
+
+  std::chrono::steady_clock::time_point connect_time_;
+  bool first_message_ = false;
+
+  std::atomic<int> state_;
+  std::atomic<uint64_t> connects_{ 0 };
+  std::atomic<uint64_t> connect_delays_{ 0 };
+  std::atomic<uint64_t> connect_retries_{ 0 };
+  std::atomic<uint64_t> disconnects_{ 0 };
+  std::atomic<uint64_t> handshakes_{ 0 };
+  std::atomic<uint64_t> handshake_failures_{ 0 };
+
+  // -1 until it happens
+  std::atomic<int64_t> time_to_connect_ns_{ -1 };
+  std::atomic<int64_t> time_to_handshake_ns_{ -1 };
+  std::atomic<int64_t> time_to_first_message_ns_{ -1 };
+};
+
+}  // namespace synapse
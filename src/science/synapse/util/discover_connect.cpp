@@ -0,0 +1,94 @@
+#include "science/synapse/util/discover_connect.h"
+#include "science/synapse/util/discover.h"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+
+namespace synapse {
+
+namespace {
+
+auto connect_device(const DeviceAdvertisement& advertisement,
+                    std::optional<std::chrono::milliseconds> timeout) -> ConnectedDevice {
+  ConnectedDevice connected;
+  connected.advertisement = advertisement;
+  connected.device = std::make_shared<Device>(advertisement.host + ":" + std::to_string(advertisement.port));
+
+  auto start_time = std::chrono::steady_clock::now();
+  connected.status = connected.device->connect(timeout);
+  if (!connected.status.ok()) {
+    return connected;
+  }
+
+  // Spend whatever is left of the budget on the info call
+  std::optional<std::chrono::milliseconds> remaining;
+  if (timeout) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+    remaining = std::max(std::chrono::milliseconds(0), *timeout - elapsed);
+  }
+
+  connected.status = connected.device->info(&connected.info, remaining);
+  return connected;
+}
+
+}  // namespace
+
+auto discover_connect(std::function<bool(const ConnectedDevice&)> callback,
+                      unsigned int timeout_ms,
+                      std::optional<std::chrono::milliseconds> connect_timeout) -> science::Status {
+  if (!callback) {
+    return {science::StatusCode::kInvalidArgument, "callback must not be null"};
+  }
+
+  // Without a per-device budget, an advertisement for a device that can't be reached
+  // would leave its connection pending forever; bound it by the discovery timeout
+  if (!connect_timeout) {
+    connect_timeout = std::chrono::milliseconds(timeout_ms == 0 ? 10000 : timeout_ms);
+  }
+
+  std::atomic<bool> stopped{false};
+  std::mutex callback_mutex;
+  std::vector<std::future<void>> pending;
+
+  auto s = discover_iter([&](const DeviceAdvertisement& advertisement) {
+    if (stopped.load()) {
+      return false;
+    }
+
+    pending.push_back(std::async(std::launch::async, [&, advertisement]() {
+      auto connected = connect_device(advertisement, connect_timeout);
+
+      std::lock_guard<std::mutex> lock(callback_mutex);
+      if (!callback(connected)) {
+        stopped.store(true);
+      }
+    }));
+
+    return !stopped.load();
+  }, timeout_ms);
+
+  for (auto& f : pending) {
+    f.wait();
+  }
+
+  return s;
+}
+
+auto discover_connect(unsigned int timeout_ms,
+                      std::vector<ConnectedDevice>* connected,
+                      std::optional<std::chrono::milliseconds> connect_timeout) -> science::Status {
+  if (connected == nullptr) {
+    return {science::StatusCode::kInvalidArgument, "connected must not be null"};
+  }
+
+  connected->clear();
+  return discover_connect([connected](const ConnectedDevice& device) {
+    connected->push_back(device);
+    return true;
+  }, timeout_ms, connect_timeout);
+}
+
+}  // namespace synapse
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+#include <science/synapse/api/tap.pb.h>
+
+// A tap description for a test endpoint, as a device's tap listing would give it
+inline auto tap_connection(
+  const std::string& endpoint,
+  synapse::TapType type = synapse::TapType::TAP_TYPE_PRODUCER,
+  const std::string& name = "broadband"
+) -> synapse::TapConnection {
+  synapse::TapConnection connection;
+  connection.set_name(name);
+  connection.set_endpoint(endpoint);
+  connection.set_tap_type(type);
+  return connection;
+}
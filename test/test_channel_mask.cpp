@@ -0,0 +1,125 @@
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/channel_mask.h>
+#include <science/synapse/api/nodes/optical_stimulation.pb.h>
+
+using synapse::ChannelMask;
+using synapse::ChannelMaskView;
+
+TEST(ChannelMaskTest, BuildsFromIndicesAndSizes) {
+  ChannelMask all(100);
+  EXPECT_EQ(all.size(), 100);
+  EXPECT_EQ(all.count(), 100);
+  EXPECT_TRUE(all.test(99));
+  EXPECT_FALSE(all.test(100));
+
+  ChannelMask none(100, false);
+  EXPECT_TRUE(none.none());
+  EXPECT_EQ(none.num_words(), 2);
+
+  ChannelMask mask(std::vector<uint32_t>{ 70, 3, 3, 64, 0 });
+  EXPECT_EQ(mask.size(), 71);
+  EXPECT_EQ(mask.count(), 4);
+  EXPECT_EQ(mask.channels(), (std::vector<uint32_t>{ 0, 3, 64, 70 }));
+
+  mask.set(200);
+  mask.reset(3);
+  mask.reset(1000);
+  EXPECT_EQ(mask.size(), 201);
+  EXPECT_EQ(mask.channels(), (std::vector<uint32_t>{ 0, 64, 70, 200 }));
+
+  // Shrinking drops channels for good
+  mask.resize(65);
+  mask.resize(300);
+  EXPECT_EQ(mask.channels(), (std::vector<uint32_t>{ 0, 64 }));
+}
+
+TEST(ChannelMaskTest, SetOperations) {
+  const ChannelMask a(std::vector<uint32_t>{ 1, 2, 100, 4000 });
+  const ChannelMask b(std::vector<uint32_t>{ 2, 3, 100 });
+
+  EXPECT_EQ((a | b).channels(), (std::vector<uint32_t>{ 1, 2, 3, 100, 4000 }));
+  EXPECT_EQ((a & b).channels(), (std::vector<uint32_t>{ 2, 100 }));
+  EXPECT_EQ((a - b).channels(), (std::vector<uint32_t>{ 1, 4000 }));
+  EXPECT_EQ((b - a).channels(), (std::vector<uint32_t>{ 3 }));
+  EXPECT_EQ((a | b).size(), a.size());
+  EXPECT_EQ((b | a).size(), a.size());
+
+  EXPECT_TRUE(a.intersects(b));
+  EXPECT_FALSE((a - b).intersects(b));
+  EXPECT_TRUE((a & b).is_subset_of(a));
+  EXPECT_FALSE(a.is_subset_of(b));
+
+  // Equality ignores size
+  ChannelMask c = b;
+  c.resize(5000);
+  EXPECT_TRUE(c == b);
+  c.set(4999);
+  EXPECT_TRUE(c != b);
+}
+
+TEST(ChannelMaskTest, MatchesReferenceOnRandomMasks) {
+  std::mt19937 rng(5);
+  for (size_t size : { 1, 63, 64, 65, 255, 256, 257, 4096, 4100 }) {
+    for (double density : { 0.0, 0.01, 0.5, 1.0 }) {
+      std::bernoulli_distribution selected(density);
+      std::vector<uint32_t> expected;
+      ChannelMask mask(size, false);
+      for (uint32_t c = 0; c < size; ++c) {
+        if (selected(rng)) {
+          expected.push_back(c);
+          mask.set(c);
+        }
+      }
+
+      EXPECT_EQ(mask.count(), expected.size()) << size << " " << density;
+      EXPECT_EQ(mask.channels(), expected) << size << " " << density;
+
+      std::vector<uint32_t> visited;
+      mask.for_each([&visited](uint32_t c) { visited.push_back(c); });
+      EXPECT_EQ(visited, expected);
+    }
+  }
+}
+
+TEST(ChannelMaskTest, ViewsWrapExternalBitsets) {
+  // Bits past the view's size are ignored
+  const uint64_t words[2] = { 0x8000000000000001ull, 0xffffffffffffffffull };
+  ChannelMaskView view(words, 68);
+  EXPECT_EQ(view.count(), 6);
+  EXPECT_TRUE(view.test(63));
+  EXPECT_FALSE(view.test(68));
+
+  std::vector<uint32_t> channels;
+  view.channels(&channels);
+  EXPECT_EQ(channels, (std::vector<uint32_t>{ 0, 63, 64, 65, 66, 67 }));
+
+  ChannelMask copy(view);
+  EXPECT_EQ(copy.count(), 6);
+  EXPECT_EQ(copy.size(), 68);
+
+  ChannelMask mask(std::vector<uint32_t>{ 0, 1 });
+  mask |= view;
+  EXPECT_EQ(mask.count(), 7);
+}
+
+TEST(ChannelMaskTest, ConvertsToAndFromProto) {
+  synapse::OpticalStimulationConfig config;
+  for (uint32_t pixel : { 4095, 7, 7, 128 }) {
+    config.add_pixel_mask(pixel);
+  }
+
+  auto mask = ChannelMask::from_proto(config.pixel_mask());
+  EXPECT_EQ(mask.size(), 4096);
+  EXPECT_EQ(mask.count(), 3);
+
+  mask.to_proto(config.mutable_pixel_mask());
+  EXPECT_EQ(
+    std::vector<uint32_t>(config.pixel_mask().begin(), config.pixel_mask().end()),
+    (std::vector<uint32_t>{ 7, 128, 4095 })
+  );
+}
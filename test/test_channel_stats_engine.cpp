@@ -0,0 +1,127 @@
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/dsp/channel_stats_engine.h>
+
+using synapse::ChannelStats;
+using synapse::ChannelStatsEngine;
+using synapse::ChannelStatsOptions;
+using synapse::SampleBlock;
+
+namespace {
+
+// Gaussian noise of a different level per channel, with an occasional large spike
+auto make_block(size_t num_channels, size_t num_samples, float noise_scale, std::mt19937* rng) -> SampleBlock {
+  SampleBlock block;
+  block.resize(num_channels, num_samples);
+  block.sample_rate_hz = 30000;
+  std::normal_distribution<float> noise(0.0f, 1.0f);
+  std::uniform_int_distribution<int> spike(0, 999);
+  for (size_t t = 0; t < num_samples; ++t) {
+    for (size_t c = 0; c < num_channels; ++c) {
+      float x = 5.0f + noise_scale * (10.0f + c) * noise(*rng);
+      if (spike(*rng) == 0) {
+        x -= 300.0f;
+      }
+      block.row(t)[c] = x;
+    }
+  }
+  return block;
+}
+
+}  // namespace
+
+TEST(ChannelStatsEngineTest, ValidatesOptions) {
+  std::unique_ptr<ChannelStatsEngine> engine;
+  EXPECT_EQ(ChannelStatsEngine::create(0, &engine).code(), science::StatusCode::kInvalidArgument);
+  ChannelStatsOptions options;
+  options.quantile_rate = 0;
+  EXPECT_EQ(ChannelStatsEngine::create(4, &engine, options).code(), science::StatusCode::kInvalidArgument);
+
+  ASSERT_TRUE(ChannelStatsEngine::create(4, &engine).ok());
+  float threshold = 0;
+  EXPECT_EQ(engine->suggest_threshold_uv(&threshold).code(), science::StatusCode::kUnavailable);
+  SampleBlock block;
+  block.resize(3, 10);
+  EXPECT_EQ(engine->process(block).code(), science::StatusCode::kInvalidArgument);
+}
+
+TEST(ChannelStatsEngineTest, EstimatesNoiseDespiteSpikes) {
+  const size_t num_channels = 11;  // one AVX2 vector and a scalar tail
+  for (auto level : { synapse::SimdLevel::kScalar, synapse::SimdLevel::kAvx2 }) {
+    std::unique_ptr<ChannelStatsEngine> engine;
+    ASSERT_TRUE(ChannelStatsEngine::create(num_channels, &engine).ok());
+    engine->set_simd_level(level);
+
+    // Exact moments of everything processed, to check the running ones against
+    std::vector<double> sum(num_channels, 0);
+    std::vector<double> sum_sq(num_channels, 0);
+    std::mt19937 rng(7);
+    for (int i = 0; i < 100; ++i) {
+      auto block = make_block(num_channels, 300, 1.0f, &rng);
+      ASSERT_TRUE(engine->process(block).ok());
+      for (size_t t = 0; t < block.num_samples; ++t) {
+        for (size_t c = 0; c < num_channels; ++c) {
+          sum[c] += block.at(t, c);
+          sum_sq[c] += static_cast<double>(block.at(t, c)) * block.at(t, c);
+        }
+      }
+    }
+
+    std::vector<ChannelStats> stats;
+    engine->all_stats(&stats);
+    ASSERT_EQ(stats.size(), num_channels);
+    for (size_t c = 0; c < num_channels; ++c) {
+      const double n = 30000;
+      const double mean = sum[c] / n;
+      const double variance = sum_sq[c] / n - mean * mean;
+      EXPECT_EQ(stats[c].count, 30000);
+      EXPECT_NEAR(stats[c].mean, mean, 1e-3 * std::sqrt(variance));
+      EXPECT_NEAR(stats[c].variance, variance, 1e-3 * variance);
+      EXPECT_NEAR(stats[c].rms, std::sqrt(variance + mean * mean), 1e-3 * std::sqrt(variance));
+
+      // The spikes inflate the standard deviation, but not the robust noise estimate
+      const float sigma = 10.0f + c;
+      EXPECT_GT(std::sqrt(stats[c].variance), 1.1f * sigma);
+      EXPECT_NEAR(stats[c].median, 5.0f, 0.15f * sigma);
+      EXPECT_NEAR(stats[c].noise(), sigma, 0.1f * sigma) << "channel " << c;
+    }
+
+    // The median channel's threshold; channels are 10 to 20 uV of noise
+    float threshold = 0;
+    ASSERT_TRUE(engine->suggest_threshold_uv(&threshold, 4.0f).ok());
+    EXPECT_NEAR(threshold, 4.0f * 15.0f, 6.0f);
+
+    std::vector<float> thresholds;
+    engine->channel_thresholds_uv(&thresholds, 5.0f);
+    EXPECT_FLOAT_EQ(thresholds[3], 5.0f * stats[3].noise());
+
+    engine->reset();
+    EXPECT_EQ(engine->stats(0).count, 0);
+  }
+}
+
+TEST(ChannelStatsEngineTest, TracksChangingNoise) {
+  ChannelStatsOptions options;
+  options.time_constant_s = 0.1;
+  std::unique_ptr<ChannelStatsEngine> engine;
+  ASSERT_TRUE(ChannelStatsEngine::create(8, &engine, options).ok());
+  synapse::WorkStealingPool pool(2);
+
+  std::mt19937 rng(11);
+  for (int i = 0; i < 50; ++i) {
+    ASSERT_TRUE(engine->process(make_block(8, 300, 1.0f, &rng), &pool).ok());
+  }
+  // Noise triples; a second later both the moments and the quantiles have followed
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(engine->process(make_block(8, 300, 3.0f, &rng), &pool).ok());
+  }
+
+  auto stats = engine->stats(2);
+  EXPECT_NEAR(stats.noise(), 36.0f, 3.6f);
+  EXPECT_GT(std::sqrt(stats.variance), 36.0f);
+  EXPECT_LT(std::sqrt(stats.variance), 1.5f * 36.0f);
+}
@@ -0,0 +1,247 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/recording/chunked_recording.h>
+#include <science/synapse/recording/tap_recorder.h>
+
+using synapse::RecordingOptions;
+using synapse::RecordingReader;
+using synapse::RecordingWindow;
+using synapse::RecordingWriter;
+
+namespace {
+
+constexpr size_t kChannels = 8;
+constexpr uint64_t kStartNs = 1000000000;
+constexpr uint64_t kPeriodNs = 33333;
+
+auto timestamp(size_t i) -> uint64_t {
+  return kStartNs + i * kPeriodNs;
+}
+
+auto make_frame(size_t i) -> synapse::BroadbandFrame {
+  synapse::BroadbandFrame frame;
+  frame.set_timestamp_ns(timestamp(i));
+  frame.set_sequence_number(100 + i);
+  frame.set_sample_rate_hz(30000);
+  for (size_t c = 0; c < kChannels; ++c) {
+    frame.add_frame_data(static_cast<int32_t>(i * 10 + c) - 5000);
+  }
+  return frame;
+}
+
+auto write_recording(const std::string& path, size_t num_frames) -> void {
+  RecordingOptions options;
+  options.samples_per_chunk = 512;
+  options.spikes_per_chunk = 16;
+
+  std::unique_ptr<RecordingWriter> writer;
+  ASSERT_TRUE(RecordingWriter::create(path, kChannels, 30000, &writer, options).ok());
+  for (size_t i = 0; i < num_frames; ++i) {
+    ASSERT_TRUE(writer->append(make_frame(i)).ok());
+    if (i % 50 == 0) {
+      ASSERT_TRUE(writer->append_spikes({ { static_cast<uint32_t>(i % kChannels), i, timestamp(i), 0.5f } }).ok());
+    }
+  }
+  ASSERT_TRUE(writer->close().ok());
+}
+
+// Overwrite part of a file in place, as a damaged disk or a crafted file would
+template <typename T>
+auto patch(const std::string& path, uint64_t offset, T value) -> void {
+  std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(static_cast<std::streamoff>(offset));
+  file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+auto open_code(const std::string& path) -> science::StatusCode {
+  std::unique_ptr<RecordingReader> reader;
+  return RecordingReader::open(path, &reader).code();
+}
+
+}  // namespace
+
+TEST(ChunkedRecordingTest, ReadsTimeWindowForChannelSubset) {
+  const std::string path = ::testing::TempDir() + "chunked_recording_window.rec";
+  write_recording(path, 5000);
+
+  std::unique_ptr<RecordingReader> reader;
+  ASSERT_TRUE(RecordingReader::open(path, &reader).ok());
+  EXPECT_EQ(reader->num_channels(), kChannels);
+  EXPECT_EQ(reader->sample_rate_hz(), 30000);
+  EXPECT_EQ(reader->num_samples(), 5000);
+  ASSERT_EQ(reader->chunk_index().size(), 10);
+  EXPECT_EQ(reader->chunk_index().back().num_items, 5000 - 9 * 512);
+
+  RecordingWindow window;
+  ASSERT_TRUE(reader->read(timestamp(1000), timestamp(2000), { 1, 5 }, &window).ok());
+  ASSERT_EQ(window.num_samples(), 1000);
+  EXPECT_EQ(window.chunks.size(), 3);
+
+  size_t i = 1000;
+  for (const auto& chunk : window.chunks) {
+    ASSERT_EQ(chunk.channels.size(), 2);
+    for (size_t t = 0; t < chunk.num_samples; ++t, ++i) {
+      EXPECT_EQ(chunk.timestamps_ns[t], timestamp(i));
+      EXPECT_EQ(chunk.sequence_numbers[t], 100 + i);
+      EXPECT_EQ(chunk.channels[0][t], static_cast<int32_t>(i * 10 + 1) - 5000);
+      EXPECT_EQ(chunk.channels[1][t], static_cast<int32_t>(i * 10 + 5) - 5000);
+    }
+  }
+
+  EXPECT_EQ(reader->seek(0), 0);
+  EXPECT_EQ(reader->seek(timestamp(1024)), 2);
+  EXPECT_EQ(reader->seek(timestamp(5000)), 10);
+  EXPECT_EQ(reader->seek_sequence(100 + 1535), 2);
+  EXPECT_EQ(reader->seek_sequence(100 + 1536), 3);
+  EXPECT_EQ(reader->seek_sequence(100 + 5000), 10);
+
+  EXPECT_EQ(reader->read(0, 1, { kChannels }, &window).code(), science::StatusCode::kOutOfRange);
+  ASSERT_TRUE(reader->read(timestamp(6000), timestamp(7000), {}, &window).ok());
+  EXPECT_EQ(window.num_samples(), 0);
+
+  std::remove(path.c_str());
+}
+
+TEST(ChunkedRecordingTest, ReadsSpikes) {
+  const std::string path = ::testing::TempDir() + "chunked_recording_spikes.rec";
+  write_recording(path, 5000);
+
+  std::unique_ptr<RecordingReader> reader;
+  ASSERT_TRUE(RecordingReader::open(path, &reader).ok());
+  EXPECT_EQ(reader->num_spikes(), 100);
+
+  std::vector<synapse::SpikeEvent> events;
+  ASSERT_TRUE(reader->read_spikes(timestamp(1000), timestamp(2000), {}, &events).ok());
+  ASSERT_EQ(events.size(), 20);
+  EXPECT_EQ(events.front().sample, 1000);
+  EXPECT_EQ(events.front().timestamp_ns, timestamp(1000));
+  EXPECT_EQ(events.front().score, 0.5f);
+
+  events.clear();
+  ASSERT_TRUE(reader->read_spikes(0, timestamp(5000), { 2 }, &events).ok());
+  ASSERT_EQ(events.size(), 25);
+  for (const auto& event : events) {
+    EXPECT_EQ(event.channel, 2);
+  }
+
+  std::remove(path.c_str());
+}
+
+TEST(ChunkedRecordingTest, RebuildsIndexOfUnclosedRecording) {
+  const std::string path = ::testing::TempDir() + "chunked_recording_unclosed.rec";
+  write_recording(path, 3000);
+
+  size_t num_entries = 0;
+  {
+    std::unique_ptr<RecordingReader> reader;
+    ASSERT_TRUE(RecordingReader::open(path, &reader).ok());
+    num_entries = reader->chunk_index().size() + (reader->num_spikes() + 15) / 16;
+  }
+
+  // Drop the index and trailer, as if the writer never closed the file
+  auto size = std::filesystem::file_size(path);
+  std::filesystem::resize_file(path, size - num_entries * sizeof(synapse::ChunkIndexEntry) - 24);
+
+  std::unique_ptr<RecordingReader> reader;
+  ASSERT_TRUE(RecordingReader::open(path, &reader).ok());
+  EXPECT_EQ(reader->num_samples(), 3000);
+  EXPECT_EQ(reader->num_spikes(), 60);
+
+  RecordingWindow window;
+  ASSERT_TRUE(reader->read(timestamp(2990), timestamp(4000), { 7 }, &window).ok());
+  ASSERT_EQ(window.num_samples(), 10);
+  EXPECT_EQ(window.chunks.back().channels[0][9], static_cast<int32_t>(2999 * 10 + 7) - 5000);
+
+  std::remove(path.c_str());
+}
+
+TEST(ChunkedRecordingTest, RejectsCorruptSizes) {
+  const std::string path = ::testing::TempDir() + "chunked_recording_corrupt.rec";
+  write_recording(path, 1000);
+
+  uint64_t first_chunk = 0;
+  uint64_t num_entries = 0;
+  {
+    std::unique_ptr<RecordingReader> reader;
+    ASSERT_TRUE(RecordingReader::open(path, &reader).ok());
+    ASSERT_EQ(reader->chunk_index().front().num_items, 512);
+    first_chunk = reader->chunk_index().front().offset;
+    num_entries = reader->chunk_index().size() + (reader->num_spikes() + 15) / 16;
+  }
+  const auto size = std::filesystem::file_size(path);
+  const uint64_t trailer = size - 24;
+  const uint64_t index_offset = trailer - num_entries * sizeof(synapse::ChunkIndexEntry);
+
+  // An entry count whose index size wraps around 2^64 isn't trusted; the chunks are scanned instead
+  patch<uint64_t>(path, trailer + 16, (1ull << 61) + num_entries);
+  {
+    std::unique_ptr<RecordingReader> reader;
+    ASSERT_TRUE(RecordingReader::open(path, &reader).ok());
+    EXPECT_EQ(reader->num_samples(), 1000);
+  }
+  patch<uint64_t>(path, trailer + 16, num_entries);
+
+  // An index entry with more samples than a chunk holds
+  patch<uint32_t>(path, index_offset + 32, 513);
+  EXPECT_EQ(open_code(path), science::StatusCode::kDataLoss);
+  patch<uint32_t>(path, index_offset + 32, 512);
+  ASSERT_EQ(open_code(path), science::StatusCode::kOk);
+
+  // Without the index, the chunk headers are checked instead
+  std::filesystem::resize_file(path, index_offset);
+  patch<uint32_t>(path, first_chunk + 8, 0);
+  EXPECT_EQ(open_code(path), science::StatusCode::kDataLoss);
+  patch<uint32_t>(path, first_chunk + 8, 512);
+
+  // A payload size that wraps the chunk's end around to its start
+  patch<uint64_t>(path, first_chunk + 40, UINT64_MAX - 63);
+  EXPECT_EQ(open_code(path), science::StatusCode::kDataLoss);
+  patch<uint64_t>(path, first_chunk + 40, 512 * (16 + kChannels * 4));
+  ASSERT_EQ(open_code(path), science::StatusCode::kOk);
+
+  // Chunk dimensions in the file header whose payload size overflows
+  patch<uint32_t>(path, 16, UINT32_MAX);
+  patch<uint32_t>(path, 20, UINT32_MAX);
+  EXPECT_EQ(open_code(path), science::StatusCode::kDataLoss);
+
+  std::remove(path.c_str());
+}
+
+TEST(ChunkedRecordingTest, ImportsTapRecording) {
+  const std::string raw_path = ::testing::TempDir() + "chunked_recording_import.tap";
+  const std::string path = ::testing::TempDir() + "chunked_recording_import.rec";
+
+  {
+    synapse::TapRecorderOptions options;
+    options.message_type = "synapse.BroadbandFrame";
+    std::unique_ptr<synapse::TapRecorder> recorder;
+    ASSERT_TRUE(synapse::TapRecorder::create(raw_path, &recorder, options).ok());
+    for (size_t i = 0; i < 1000; ++i) {
+      auto bytes = make_frame(i).SerializeAsString();
+      ASSERT_TRUE(recorder->record(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), i).ok());
+    }
+    ASSERT_TRUE(recorder->stop().ok());
+  }
+
+  ASSERT_TRUE(RecordingWriter::import_tap_recording(raw_path, path).ok());
+
+  std::unique_ptr<RecordingReader> reader;
+  ASSERT_TRUE(RecordingReader::open(path, &reader).ok());
+  EXPECT_EQ(reader->num_channels(), kChannels);
+  EXPECT_EQ(reader->num_samples(), 1000);
+
+  synapse::ChunkView view;
+  ASSERT_TRUE(reader->chunk(0, { 3 }, &view).ok());
+  EXPECT_EQ(view.num_samples, 1000);
+  EXPECT_EQ(view.channels[0][999], static_cast<int32_t>(999 * 10 + 3) - 5000);
+
+  std::remove(raw_path.c_str());
+  std::remove(path.c_str());
+}
@@ -0,0 +1,128 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <zmq.hpp>
+#include <science/synapse/closed_loop.h>
+#include <science/synapse/latency_histogram.h>
+#include "tap_test_util.h"
+
+using synapse::ClosedLoop;
+using synapse::LatencyHistogram;
+
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.percentile(50).count(), 0);
+
+  // 1..1000 us
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.record(std::chrono::microseconds(i));
+  }
+  EXPECT_EQ(histogram.count(), 1000);
+  EXPECT_EQ(histogram.min(), std::chrono::microseconds(1));
+  EXPECT_EQ(histogram.max(), std::chrono::microseconds(1000));
+  EXPECT_NEAR(histogram.mean().count(), 500500, 1);
+
+  for (double p : { 1.0, 50.0, 90.0, 99.0, 99.9 }) {
+    const double expected = p * 10000;
+    EXPECT_GE(histogram.percentile(p).count(), expected) << p;
+    EXPECT_LE(histogram.percentile(p).count(), expected * 1.07) << p;
+  }
+  EXPECT_EQ(histogram.percentile(100), std::chrono::microseconds(1000));
+
+  // Small values are exact
+  histogram.reset();
+  EXPECT_EQ(histogram.count(), 0);
+  histogram.record(std::chrono::nanoseconds(7));
+  histogram.record(std::chrono::nanoseconds(-5));
+  EXPECT_EQ(histogram.percentile(100).count(), 7);
+  EXPECT_EQ(histogram.min().count(), 0);
+  EXPECT_FALSE(histogram.summary().empty());
+}
+
+TEST(ClosedLoopTest, RequiresConnectedTapsOfTheRightType) {
+  auto decide = [](const uint8_t*, size_t, std::vector<uint8_t>*) { return false; };
+  std::unique_ptr<ClosedLoop> loop;
+
+  synapse::Tap input("127.0.0.1");
+  synapse::Tap output("127.0.0.1");
+  EXPECT_EQ(ClosedLoop::create(&input, &output, decide, &loop).code(), science::StatusCode::kFailedPrecondition);
+  EXPECT_EQ(ClosedLoop::create(&input, &output, nullptr, &loop).code(), science::StatusCode::kInvalidArgument);
+
+  ASSERT_TRUE(input.connect(tap_connection("tcp://127.0.0.1:5999", synapse::TapType::TAP_TYPE_PRODUCER)).ok());
+  ASSERT_TRUE(output.connect(tap_connection("tcp://127.0.0.1:5998", synapse::TapType::TAP_TYPE_PRODUCER)).ok());
+  EXPECT_EQ(ClosedLoop::create(&input, &output, decide, &loop).code(), science::StatusCode::kInvalidArgument);
+
+  ASSERT_TRUE(output.connect(tap_connection("tcp://127.0.0.1:5998", synapse::TapType::TAP_TYPE_CONSUMER, "stim")).ok());
+  ASSERT_TRUE(ClosedLoop::create(&input, &output, decide, &loop).ok());
+  ASSERT_TRUE(loop->start().ok());
+  EXPECT_TRUE(loop->is_running());
+  EXPECT_EQ(loop->start().code(), science::StatusCode::kFailedPrecondition);
+  loop->stop();
+  EXPECT_FALSE(loop->is_running());
+  EXPECT_TRUE(loop->status().ok());
+}
+
+TEST(ClosedLoopTest, RespondsToEvents) {
+  // Stand-ins for the device: a producer tap to publish events, a consumer tap to collect commands
+  zmq::context_t context(1);
+  zmq::socket_t events(context, zmq::socket_type::pub);
+  events.bind("tcp://127.0.0.1:*");
+  zmq::socket_t commands(context, zmq::socket_type::sub);
+  commands.set(zmq::sockopt::subscribe, "");
+  commands.set(zmq::sockopt::rcvtimeo, 100);
+  commands.bind("tcp://127.0.0.1:*");
+
+  synapse::Tap input("127.0.0.1");
+  synapse::Tap output("127.0.0.1");
+  ASSERT_TRUE(input.connect(tap_connection(
+    events.get(zmq::sockopt::last_endpoint), synapse::TapType::TAP_TYPE_PRODUCER
+  )).ok());
+  ASSERT_TRUE(output.connect(tap_connection(
+    commands.get(zmq::sockopt::last_endpoint), synapse::TapType::TAP_TYPE_CONSUMER, "stim"
+  )).ok());
+
+  // Stimulate on odd events, echoing the event number
+  std::unique_ptr<ClosedLoop> loop;
+  auto decide = [](const uint8_t* data, size_t size, std::vector<uint8_t>* command) {
+    if (size != sizeof(uint32_t) || data[0] % 2 == 0) {
+      return false;
+    }
+    command->assign(data, data + size);
+    return true;
+  };
+  ASSERT_TRUE(ClosedLoop::create(&input, &output, decide, &loop).ok());
+  ASSERT_TRUE(loop->start().ok());
+
+  // Publish until both subscriptions are up and a few commands come back
+  uint32_t event = 0;
+  std::vector<uint32_t> received;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (received.size() < 10 && std::chrono::steady_clock::now() < deadline) {
+    zmq::message_t out(&event, sizeof(event));
+    events.send(out, zmq::send_flags::none);
+    event++;
+
+    zmq::message_t in;
+    if (commands.recv(in, zmq::recv_flags::dontwait) && in.size() == sizeof(uint32_t)) {
+      uint32_t value;
+      std::memcpy(&value, in.data(), sizeof(value));
+      received.push_back(value);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  loop->stop();
+
+  ASSERT_GE(received.size(), 10);
+  for (auto value : received) {
+    EXPECT_EQ(value % 2, 1);
+  }
+  auto stats = loop->stats();
+  EXPECT_GE(stats.messages_received, stats.commands_sent);
+  EXPECT_EQ(loop->latency().count(), stats.commands_sent);
+  EXPECT_GT(loop->latency().max().count(), 0);
+}
@@ -0,0 +1,293 @@
+#include <gtest/gtest.h>
+#include <science/synapse/config.h>
+#include <science/synapse/device.h>
+#include <science/synapse/nodes/broadband_source.h>
+#include <science/synapse/nodes/disk_writer.h>
+#include <science/synapse/nodes/spectral_filter.h>
+#include <science/synapse/nodes/spike_binner.h>
+#include <science/synapse/nodes/spike_detector.h>
+
+using synapse::Config;
+using synapse::SpikeBinner;
+
+namespace {
+
+auto make_source() -> std::shared_ptr<synapse::BroadbandSource> {
+  return std::make_shared<synapse::BroadbandSource>(1, 16, 30000, 1.0, synapse::Signal{synapse::Electrodes{{}, 300, 6000}});
+}
+
+// A node whose serialization can be made to fail or change
+class TestNode : public synapse::Node {
+ public:
+  TestNode() : Node(synapse::NodeType::kSpikeBinner) {}
+
+  void set_bin_size_ms(uint32_t bin_size_ms) {
+    bin_size_ms_ = bin_size_ms;
+    mark_dirty();
+  }
+
+  bool fail = false;
+
+ protected:
+  auto p_to_proto(synapse::NodeConfig* proto) -> science::Status override {
+    if (fail) {
+      return { science::StatusCode::kInternal, "test failure" };
+    }
+    proto->mutable_spike_binner()->set_bin_size_ms(bin_size_ms_);
+    return {};
+  }
+
+ private:
+  uint32_t bin_size_ms_ = 10;
+};
+
+}  // namespace
+
+TEST(ConfigTest, AddNodeAssignsIds) {
+  Config config;
+  auto a = std::make_shared<SpikeBinner>(10);
+  auto b = std::make_shared<SpikeBinner>(20);
+
+  EXPECT_TRUE(config.add({a, b}).ok());
+  EXPECT_EQ(a->id(), 1);
+  EXPECT_EQ(b->id(), 2);
+  EXPECT_EQ(config.node(1), a);
+  EXPECT_EQ(config.node(2), b);
+  EXPECT_EQ(config.node(3), nullptr);
+}
+
+TEST(ConfigTest, AddNodeRejectsIdInUse) {
+  Config config;
+  EXPECT_TRUE(config.add_node(std::make_shared<SpikeBinner>(10), 5).ok());
+
+  auto status = config.add_node(std::make_shared<SpikeBinner>(10), 5);
+  EXPECT_FALSE(status.ok());
+  EXPECT_EQ(status.code(), science::StatusCode::kInvalidArgument);
+}
+
+TEST(ConfigTest, AddNodeSkipsExplicitIds) {
+  Config config;
+  EXPECT_TRUE(config.add_node(std::make_shared<SpikeBinner>(10), 2).ok());
+
+  auto a = std::make_shared<SpikeBinner>(10);
+  EXPECT_TRUE(config.add_node(a).ok());
+  EXPECT_EQ(a->id(), 3);
+}
+
+TEST(ConfigTest, ConnectRejectsDuplicatesAndUnknownNodes) {
+  Config config;
+  auto a = std::make_shared<SpikeBinner>(10);
+  auto b = std::make_shared<SpikeBinner>(10);
+  EXPECT_TRUE(config.add({a, b}).ok());
+
+  EXPECT_TRUE(config.connect(a, b).ok());
+  EXPECT_FALSE(config.connect(a, b).ok());
+  EXPECT_TRUE(config.connect(b, a).ok());
+  EXPECT_EQ(config.connections().size(), 2);
+
+  Config other;
+  auto c = std::make_shared<SpikeBinner>(10);
+  EXPECT_TRUE(other.add_node(c, 100).ok());
+  EXPECT_FALSE(config.connect(a, c).ok());
+}
+
+TEST(ConfigTest, RoundTripsThroughProto) {
+  Config config;
+  auto a = std::make_shared<SpikeBinner>(10);
+  auto b = std::make_shared<SpikeBinner>(20);
+  EXPECT_TRUE(config.add({a, b}).ok());
+  EXPECT_TRUE(config.connect(a, b).ok());
+
+  Config parsed;
+  EXPECT_TRUE(Config::from_proto(config.to_proto(), &parsed).ok());
+  EXPECT_EQ(parsed.nodes().size(), 2);
+  ASSERT_EQ(parsed.connections().size(), 1);
+  EXPECT_EQ(parsed.connections()[0].first, a->id());
+  EXPECT_EQ(parsed.connections()[0].second, b->id());
+  EXPECT_NE(parsed.node(b->id()), nullptr);
+}
+
+TEST(ConfigTest, FromProtoRejectsUnknownConnection) {
+  Config config;
+  auto a = std::make_shared<SpikeBinner>(10);
+  EXPECT_TRUE(config.add_node(a).ok());
+
+  auto proto = config.to_proto();
+  auto* connection = proto.add_connections();
+  connection->set_src_node_id(a->id());
+  connection->set_dst_node_id(42);
+
+  Config parsed;
+  auto status = Config::from_proto(proto, &parsed);
+  EXPECT_FALSE(status.ok());
+  EXPECT_EQ(status.code(), science::StatusCode::kInvalidArgument);
+}
+
+TEST(ConfigTest, ValidateAcceptsSignalChain) {
+  Config config;
+  auto source = make_source();
+  auto filter = std::make_shared<synapse::SpectralFilter>(synapse::SpectralFilterMethod::kBandPass, 300, 6000);
+  auto detector = synapse::SpikeDetector::create_thresholder(50, 32);
+  auto binner = std::make_shared<SpikeBinner>(10);
+  auto writer = std::make_shared<synapse::DiskWriter>("out.dat");
+  EXPECT_TRUE(config.add({source, filter, detector, binner, writer}).ok());
+  EXPECT_TRUE(config.connect(source, filter).ok());
+  EXPECT_TRUE(config.connect(filter, detector).ok());
+  EXPECT_TRUE(config.connect(detector, binner).ok());
+  EXPECT_TRUE(config.connect(binner, writer).ok());
+
+  EXPECT_TRUE(config.validate().ok());
+
+  std::vector<uint32_t> order;
+  EXPECT_TRUE(config.topological_sort(&order).ok());
+  EXPECT_EQ(order, (std::vector<uint32_t>{source->id(), filter->id(), detector->id(), binner->id(), writer->id()}));
+}
+
+TEST(ConfigTest, ValidateRejectsCycle) {
+  Config config;
+  auto source = make_source();
+  auto a = std::make_shared<synapse::SpectralFilter>(synapse::SpectralFilterMethod::kLowPass, 0, 6000);
+  auto b = std::make_shared<synapse::SpectralFilter>(synapse::SpectralFilterMethod::kHighPass, 300, 0);
+  EXPECT_TRUE(config.add({source, a, b}).ok());
+  EXPECT_TRUE(config.connect(source, a).ok());
+  EXPECT_TRUE(config.connect(a, b).ok());
+  EXPECT_TRUE(config.connect(b, a).ok());
+
+  std::vector<uint32_t> order;
+  EXPECT_FALSE(config.topological_sort(&order).ok());
+  EXPECT_EQ(config.validate().code(), science::StatusCode::kInvalidArgument);
+}
+
+TEST(ConfigTest, ValidateRejectsMismatchedSignalTypes) {
+  Config config;
+  auto source = make_source();
+  auto binner = std::make_shared<SpikeBinner>(10);
+  EXPECT_TRUE(config.add({source, binner}).ok());
+  EXPECT_TRUE(config.connect(source, binner).ok());
+
+  auto status = config.validate();
+  EXPECT_FALSE(status.ok());
+  EXPECT_NE(status.message().find("expects spikes"), std::string::npos);
+}
+
+TEST(ConfigTest, ValidateRejectsDanglingNodes) {
+  Config config;
+  auto source = make_source();
+  auto binner = std::make_shared<SpikeBinner>(10);
+  EXPECT_TRUE(config.add({source, binner}).ok());
+
+  auto status = config.validate();
+  EXPECT_FALSE(status.ok());
+  EXPECT_NE(status.message().find("has no consumers"), std::string::npos);
+  EXPECT_NE(status.message().find("has no input"), std::string::npos);
+}
+
+TEST(ConfigTest, DeviceRejectsInvalidConfigWithoutRequest) {
+  Config config;
+  auto source = make_source();
+  auto binner = std::make_shared<SpikeBinner>(10);
+  EXPECT_TRUE(config.add({source, binner}).ok());
+
+  // Nothing listens here; a request would fail with kUnavailable or kDeadlineExceeded instead
+  synapse::Device device("127.0.0.1:1");
+  auto status = device.configure(&config, std::chrono::milliseconds(500));
+  EXPECT_EQ(status.code(), science::StatusCode::kInvalidArgument);
+  EXPECT_NE(status.message().find("has no consumers"), std::string::npos);
+
+  synapse::ConfigDiff diff;
+  status = device.reconfigure(&config, &diff, std::chrono::milliseconds(500));
+  EXPECT_EQ(status.code(), science::StatusCode::kInvalidArgument);
+}
+
+TEST(ConfigTest, DiffReportsChangedNodesAndConnections) {
+  Config before;
+  auto source = make_source();
+  auto detector = synapse::SpikeDetector::create_thresholder(50, 32);
+  EXPECT_TRUE(before.add({source, detector}).ok());
+  EXPECT_TRUE(before.connect(source, detector).ok());
+
+  Config after;
+  EXPECT_TRUE(Config::from_proto(before.to_proto(), &after).ok());
+
+  synapse::ConfigDiff diff;
+  EXPECT_TRUE(before.diff(&after, &diff).ok());
+  EXPECT_TRUE(diff.empty());
+
+  auto proto = before.to_proto();
+  proto.mutable_nodes(1)->mutable_spike_detector()->mutable_thresholder()->set_threshold_uv(80);
+  auto* binner = proto.add_nodes();
+  binner->set_id(3);
+  binner->set_type(synapse::NodeType::kSpikeBinner);
+  binner->mutable_spike_binner()->set_bin_size_ms(10);
+  proto.clear_connections();
+  auto* connection = proto.add_connections();
+  connection->set_src_node_id(detector->id());
+  connection->set_dst_node_id(3);
+
+  EXPECT_TRUE(Config::diff(before.to_proto(), proto, &diff).ok());
+  EXPECT_EQ(diff.changed_nodes, std::vector<uint32_t>{detector->id()});
+  EXPECT_EQ(diff.added_nodes, std::vector<uint32_t>{3});
+  EXPECT_TRUE(diff.removed_nodes.empty());
+  ASSERT_EQ(diff.added_connections.size(), 1);
+  EXPECT_EQ(diff.added_connections[0], std::make_pair(detector->id(), 3u));
+  ASSERT_EQ(diff.removed_connections.size(), 1);
+  EXPECT_EQ(diff.removed_connections[0], std::make_pair(source->id(), detector->id()));
+}
+
+TEST(ConfigTest, SerializeReusesCachedBuffer) {
+  Config config;
+  auto node = std::make_shared<TestNode>();
+  EXPECT_TRUE(config.add_node(node).ok());
+
+  std::shared_ptr<const std::string> first;
+  std::shared_ptr<const std::string> second;
+  EXPECT_TRUE(config.serialize(&first).ok());
+  EXPECT_TRUE(config.serialize(&second).ok());
+  EXPECT_EQ(first, second);
+
+  synapse::DeviceConfiguration parsed;
+  ASSERT_TRUE(parsed.ParseFromString(*first));
+  EXPECT_EQ(parsed.nodes(0).spike_binner().bin_size_ms(), 10);
+
+  node->set_bin_size_ms(20);
+  EXPECT_TRUE(config.serialize(&second).ok());
+  EXPECT_NE(first, second);
+  ASSERT_TRUE(parsed.ParseFromString(*second));
+  EXPECT_EQ(parsed.nodes(0).spike_binner().bin_size_ms(), 20);
+
+  EXPECT_TRUE(config.add_node(std::make_shared<TestNode>()).ok());
+  EXPECT_TRUE(config.serialize(&first).ok());
+  EXPECT_NE(first, second);
+}
+
+TEST(ConfigTest, ThresholdSettersInvalidateCachedProto) {
+  Config config;
+  auto detector = synapse::SpikeDetector::create_thresholder(50, 32);
+  EXPECT_TRUE(config.add_node(detector).ok());
+
+  std::shared_ptr<const synapse::DeviceConfiguration> proto;
+  EXPECT_TRUE(config.to_proto(&proto).ok());
+  EXPECT_EQ(proto->nodes(0).spike_detector().thresholder().threshold_uv(), 50);
+
+  EXPECT_TRUE(detector->set_threshold_uv(42).ok());
+  EXPECT_TRUE(config.to_proto(&proto).ok());
+  EXPECT_EQ(proto->nodes(0).spike_detector().thresholder().threshold_uv(), 42);
+
+  auto matcher = synapse::SpikeDetector::create_template_matcher({ 0, 100, 0 }, 32);
+  EXPECT_EQ(matcher->set_threshold_uv(42).code(), science::StatusCode::kFailedPrecondition);
+}
+
+TEST(ConfigTest, SerializePropagatesNodeErrors) {
+  Config config;
+  auto node = std::make_shared<TestNode>();
+  node->fail = true;
+  EXPECT_TRUE(config.add_node(node).ok());
+
+  std::shared_ptr<const std::string> bytes;
+  auto status = config.serialize(&bytes);
+  EXPECT_EQ(status.code(), science::StatusCode::kInternal);
+  EXPECT_NE(status.message().find("test failure"), std::string::npos);
+
+  std::shared_ptr<const synapse::DeviceConfiguration> proto;
+  EXPECT_FALSE(config.to_proto(&proto).ok());
+}
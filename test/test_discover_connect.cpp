@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <science/synapse/status.h>
+#include <science/synapse/util/discover_connect.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using synapse::ConnectedDevice;
+
+TEST(DiscoverConnectTest, UnreachableAdvertisementTimesOut) {
+  // Advertise a device on loopback whose port has nothing listening behind it
+  std::atomic<bool> done{false};
+  std::thread advertiser([&done]() {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sock, 0);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(6470);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const std::string message = "ID UNREACHABLE SYN2.0.0 1 unreachable-device";
+    while (!done.load()) {
+      sendto(sock, message.data(), message.size(), 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    close(sock);
+  });
+
+  std::vector<ConnectedDevice> connected;
+  auto start = std::chrono::steady_clock::now();
+  auto s = synapse::discover_connect([&connected](const ConnectedDevice& device) {
+    connected.push_back(device);
+    return false;
+  }, 500);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  done.store(true);
+  advertiser.join();
+
+  EXPECT_TRUE(s.ok());
+  ASSERT_EQ(connected.size(), 1);
+  EXPECT_EQ(connected[0].advertisement.serial, "UNREACHABLE");
+  EXPECT_EQ(connected[0].status.code(), science::StatusCode::kDeadlineExceeded);
+  EXPECT_NE(connected[0].device, nullptr);
+
+  // Bounded by the discovery timeout plus the default per-device budget
+  EXPECT_LT(elapsed, std::chrono::seconds(5));
+}
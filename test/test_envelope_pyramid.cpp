@@ -0,0 +1,158 @@
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/dsp/envelope_pyramid.h>
+
+using synapse::EnvelopeBin;
+using synapse::EnvelopePyramid;
+using synapse::EnvelopePyramidOptions;
+using synapse::SampleBlock;
+
+namespace {
+
+auto make_block(size_t num_channels, size_t num_samples, uint64_t start) -> SampleBlock {
+  SampleBlock block;
+  block.resize(num_channels, num_samples);
+  block.sample_rate_hz = 1000;
+  uint32_t state = static_cast<uint32_t>(start) * 2654435761u + 1;
+  for (auto& sample : block.samples) {
+    state = state * 1664525u + 1013904223u;
+    sample = static_cast<float>(state >> 24) - 128.0f;
+  }
+  return block;
+}
+
+// The envelope straight from the samples, with each pixel covering every base bin it overlaps
+auto brute_force(const std::vector<float>& samples, size_t num_channels, size_t channel, uint64_t begin,
+                 uint64_t end, uint64_t bin) -> EnvelopeBin {
+  const uint64_t first = begin / bin * bin;
+  const uint64_t last = (end + bin - 1) / bin * bin;
+  EnvelopeBin result = { INFINITY, -INFINITY, 0 };
+  for (uint64_t t = first; t < last; ++t) {
+    const float x = samples[t * num_channels + channel];
+    result.min = std::min(result.min, x);
+    result.max = std::max(result.max, x);
+    result.mean += x;
+  }
+  result.mean /= static_cast<float>(last - first);
+  return result;
+}
+
+}  // namespace
+
+TEST(EnvelopePyramidTest, ValidatesOptions) {
+  std::unique_ptr<EnvelopePyramid> pyramid;
+  EXPECT_EQ(EnvelopePyramid::create(0, 1000, &pyramid).code(), science::StatusCode::kInvalidArgument);
+  EXPECT_EQ(EnvelopePyramid::create(4, 0, &pyramid).code(), science::StatusCode::kInvalidArgument);
+  EnvelopePyramidOptions options;
+  options.fanout = 1;
+  EXPECT_EQ(EnvelopePyramid::create(4, 1000, &pyramid, options).code(), science::StatusCode::kInvalidArgument);
+  options = {};
+  options.history_s = 0.001;
+  EXPECT_EQ(EnvelopePyramid::create(4, 1000, &pyramid, options).code(), science::StatusCode::kInvalidArgument);
+
+  ASSERT_TRUE(EnvelopePyramid::create(4, 1000, &pyramid).ok());
+  std::vector<EnvelopeBin> out;
+  EXPECT_EQ(pyramid->process(make_block(3, 10, 0)).code(), science::StatusCode::kInvalidArgument);
+  EXPECT_EQ(pyramid->query(4, 0, 10, 1, &out).code(), science::StatusCode::kOutOfRange);
+  EXPECT_EQ(pyramid->query(0, 10, 10, 1, &out).code(), science::StatusCode::kInvalidArgument);
+}
+
+TEST(EnvelopePyramidTest, MatchesSamplesAtEveryZoom) {
+  const size_t num_channels = 11;  // one AVX2 vector and a scalar tail
+  EnvelopePyramidOptions options;
+  options.history_s = 4.0;
+  options.base_bin_samples = 4;
+  options.fanout = 4;
+
+  for (auto level : { synapse::SimdLevel::kScalar, synapse::SimdLevel::kAvx2 }) {
+    std::unique_ptr<EnvelopePyramid> pyramid;
+    ASSERT_TRUE(EnvelopePyramid::create(num_channels, 1000, &pyramid, options).ok());
+    pyramid->set_simd_level(level);
+    ASSERT_GT(pyramid->num_levels(), 3);
+
+    std::vector<float> samples;
+    for (uint64_t start = 0; start < 3003; start += 77) {
+      auto block = make_block(num_channels, 77, start);
+      samples.insert(samples.end(), block.samples.begin(), block.samples.end());
+      ASSERT_TRUE(pyramid->process(block).ok());
+    }
+    ASSERT_EQ(pyramid->position(), 3003);
+
+    // From one pixel per base bin to the whole history in a few pixels, ending at the live edge
+    const uint64_t end = pyramid->position() / 4 * 4;
+    for (size_t pixels : { size_t(750), size_t(100), size_t(37), size_t(3) }) {
+      std::vector<EnvelopeBin> out;
+      ASSERT_TRUE(pyramid->query(5, 0, end, pixels, &out).ok());
+      ASSERT_EQ(out.size(), pixels);
+
+      float min = INFINITY;
+      float max = -INFINITY;
+      for (size_t p = 0; p < pixels; ++p) {
+        EXPECT_FALSE(std::isnan(out[p].min)) << pixels << " pixels, pixel " << p;
+        min = std::min(min, out[p].min);
+        max = std::max(max, out[p].max);
+      }
+      auto expected = brute_force(samples, num_channels, 5, 0, end, 4);
+      EXPECT_EQ(min, expected.min);
+      EXPECT_EQ(max, expected.max);
+    }
+
+    // At base resolution each pixel is exactly one bin
+    std::vector<EnvelopeBin> out;
+    ASSERT_TRUE(pyramid->query(10, 400, 480, 20, &out).ok());
+    for (size_t p = 0; p < out.size(); ++p) {
+      auto expected = brute_force(samples, num_channels, 10, 400 + p * 4, 404 + p * 4, 4);
+      EXPECT_EQ(out[p].min, expected.min);
+      EXPECT_EQ(out[p].max, expected.max);
+      EXPECT_NEAR(out[p].mean, expected.mean, 1e-3);
+    }
+
+    // Drawing every channel at once matches drawing them one by one
+    std::vector<EnvelopeBin> all;
+    ASSERT_TRUE(pyramid->query(100, end, 37, &all).ok());
+    ASSERT_EQ(all.size(), 37 * num_channels);
+    for (size_t c = 0; c < num_channels; ++c) {
+      ASSERT_TRUE(pyramid->query(c, 100, end, 37, &out).ok());
+      for (size_t p = 0; p < out.size(); ++p) {
+        EXPECT_EQ(all[c * 37 + p].min, out[p].min);
+        EXPECT_EQ(all[c * 37 + p].max, out[p].max);
+        EXPECT_NEAR(all[c * 37 + p].mean, out[p].mean, 1e-3);
+      }
+    }
+
+    // Beyond the live edge is empty
+    ASSERT_TRUE(pyramid->query(0, end, end + 100, 10, &out).ok());
+    EXPECT_TRUE(std::isnan(out.back().min));
+  }
+}
+
+TEST(EnvelopePyramidTest, KeepsABoundedHistory) {
+  EnvelopePyramidOptions options;
+  options.history_s = 1.0;
+  options.base_bin_samples = 10;
+  std::unique_ptr<EnvelopePyramid> pyramid;
+  ASSERT_TRUE(EnvelopePyramid::create(2, 1000, &pyramid, options).ok());
+  const size_t bytes = pyramid->memory_bytes();
+
+  for (uint64_t start = 0; start < 10000; start += 100) {
+    ASSERT_TRUE(pyramid->process(make_block(2, 100, start)).ok());
+  }
+  EXPECT_EQ(pyramid->memory_bytes(), bytes);
+
+  // The last second is all there; well before it is gone
+  std::vector<EnvelopeBin> out;
+  ASSERT_TRUE(pyramid->query(1, 9000, 10000, 100, &out).ok());
+  for (const auto& bin : out) {
+    EXPECT_FALSE(std::isnan(bin.min));
+  }
+  ASSERT_TRUE(pyramid->query(1, 0, 1000, 10, &out).ok());
+  EXPECT_TRUE(std::isnan(out.front().min));
+
+  pyramid->reset();
+  EXPECT_EQ(pyramid->position(), 0);
+  ASSERT_TRUE(pyramid->query(1, 0, 1000, 10, &out).ok());
+  EXPECT_TRUE(std::isnan(out.back().min));
+}
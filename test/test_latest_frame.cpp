@@ -0,0 +1,85 @@
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/latest_frame.h>
+
+using synapse::LatestFrame;
+
+TEST(LatestFrameTest, KeepsOnlyTheLatestMessage) {
+  LatestFrame latest(16);
+  std::vector<uint8_t> data;
+  uint64_t generation = 0;
+  EXPECT_EQ(latest.read(&data).code(), science::StatusCode::kUnavailable);
+
+  std::vector<uint8_t> too_big(17);
+  EXPECT_EQ(latest.publish(too_big.data(), too_big.size()).code(), science::StatusCode::kInvalidArgument);
+
+  // Enough publishes to reuse every slot, with sizes that aren't whole words
+  for (uint8_t i = 1; i <= 10; ++i) {
+    std::vector<uint8_t> message(i, i);
+    ASSERT_TRUE(latest.publish(message.data(), message.size()).ok());
+  }
+  ASSERT_TRUE(latest.read(&data, &generation).ok());
+  EXPECT_EQ(data, std::vector<uint8_t>(10, 10));
+  EXPECT_EQ(generation, 10);
+  EXPECT_EQ(latest.generation(), 10);
+
+  synapse::BroadbandFrame frame;
+  frame.set_sequence_number(42);
+  frame.add_frame_data(-7);
+  auto bytes = frame.SerializeAsString();
+  ASSERT_TRUE(latest.publish(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size()).ok());
+
+  synapse::BroadbandFrame read;
+  ASSERT_TRUE(latest.read(&read).ok());
+  EXPECT_EQ(read.sequence_number(), 42);
+  ASSERT_EQ(read.frame_data_size(), 1);
+  EXPECT_EQ(read.frame_data(0), -7);
+}
+
+TEST(LatestFrameTest, ReadersNeverSeeTornMessages) {
+  constexpr size_t kSize = 1027;
+  LatestFrame latest(kSize);
+  std::atomic<bool> done{ false };
+
+  // Every byte of a message is its generation, so a torn copy mixes values
+  std::thread writer([&]() {
+    std::vector<uint8_t> message(kSize);
+    for (uint64_t generation = 1; generation <= 200000; ++generation) {
+      std::fill(message.begin(), message.end(), static_cast<uint8_t>(generation));
+      ASSERT_TRUE(latest.publish(message.data(), message.size()).ok());
+    }
+    done = true;
+  });
+
+  std::vector<std::thread> readers;
+  std::atomic<uint64_t> torn{ 0 };
+  for (int r = 0; r < 3; ++r) {
+    readers.emplace_back([&]() {
+      std::vector<uint8_t> data;
+      uint64_t generation = 0;
+      uint64_t last = 0;
+      while (!done) {
+        if (!latest.read(&data, &generation).ok()) {
+          continue;
+        }
+        bool consistent = data.size() == kSize && generation >= last;
+        for (auto byte : data) {
+          consistent &= byte == static_cast<uint8_t>(generation);
+        }
+        torn += consistent ? 0 : 1;
+        last = generation;
+      }
+    });
+  }
+
+  writer.join();
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(torn, 0);
+  EXPECT_EQ(latest.generation(), 200000);
+}
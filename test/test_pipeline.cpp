@@ -0,0 +1,227 @@
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/config.h>
+#include <science/synapse/dsp/pipeline.h>
+#include <science/synapse/dsp/spectral_filter_engine.h>
+#include <science/synapse/dsp/spike_detector_engine.h>
+#include <science/synapse/nodes/broadband_source.h>
+#include <science/synapse/nodes/disk_writer.h>
+#include <science/synapse/nodes/spectral_filter.h>
+#include <science/synapse/nodes/spike_binner.h>
+#include <science/synapse/nodes/spike_detector.h>
+
+using synapse::Pipeline;
+using synapse::PipelineData;
+using synapse::SampleBlock;
+using synapse::SpikeBatch;
+using synapse::SpikeCounts;
+
+namespace {
+
+constexpr size_t kChannels = 19;
+constexpr size_t kBlockSamples = 300;
+constexpr float kSampleRate = 30000;
+
+auto make_block(size_t index) -> SampleBlock {
+  SampleBlock block;
+  block.resize(kChannels, kBlockSamples);
+  block.sample_rate_hz = kSampleRate;
+  block.start_timestamp_ns = static_cast<uint64_t>(index * kBlockSamples * 1e9 / kSampleRate);
+  uint32_t state = static_cast<uint32_t>(index * 2654435761u + 1);
+  for (size_t t = 0; t < kBlockSamples; ++t) {
+    for (size_t c = 0; c < kChannels; ++c) {
+      state = state * 1664525u + 1013904223u;
+      block.row(t)[c] = static_cast<float>(state >> 26) - 32.0f;
+      if ((t + 37 * c + index) % 211 == 0) {
+        block.row(t)[c] -= 400.0f;
+      }
+    }
+  }
+  return block;
+}
+
+struct Graph {
+  synapse::Config config;
+  std::shared_ptr<synapse::BroadbandSource> source;
+  std::shared_ptr<synapse::SpectralFilter> filter;
+  std::shared_ptr<synapse::SpikeDetector> detector;
+  std::shared_ptr<synapse::SpikeBinner> binner;
+  std::shared_ptr<synapse::DiskWriter> writer;
+
+  Graph() {
+    synapse::Signal signal{synapse::Electrodes{{}, 300, 6000}};
+    source = std::make_shared<synapse::BroadbandSource>(1, 16, 30000, 1.0, signal);
+    filter = std::make_shared<synapse::SpectralFilter>(synapse::SpectralFilterMethod::kBandPass, 300, 6000);
+    detector = synapse::SpikeDetector::create_thresholder(100, 30);
+    binner = std::make_shared<synapse::SpikeBinner>(20);
+    writer = std::make_shared<synapse::DiskWriter>("out.dat");
+    EXPECT_TRUE(config.add({ source, filter, detector, binner, writer }).ok());
+    EXPECT_TRUE(config.connect(source, filter).ok());
+    EXPECT_TRUE(config.connect(filter, detector).ok());
+    EXPECT_TRUE(config.connect(detector, binner).ok());
+    EXPECT_TRUE(config.connect(detector, writer).ok());
+  }
+};
+
+}  // namespace
+
+TEST(PipelineTest, MatchesEnginesRunInSequence) {
+  Graph graph;
+  std::unique_ptr<Pipeline> pipeline;
+  ASSERT_TRUE(Pipeline::create(graph.config, &pipeline, 3, 2).ok());
+
+  std::mutex mutex;
+  std::vector<synapse::SpikeEvent> spikes;
+  std::vector<uint32_t> counts;
+  ASSERT_TRUE(pipeline->on_output(graph.detector->id(), [&](uint32_t, const PipelineData& data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto& batch = std::get<SpikeBatch>(data);
+    spikes.insert(spikes.end(), batch.events.begin(), batch.events.end());
+  }).ok());
+  ASSERT_TRUE(pipeline->on_output(graph.binner->id(), [&](uint32_t, const PipelineData& data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto& bins = std::get<std::vector<SpikeCounts>>(data).front();
+    for (size_t b = 0; b < bins.num_bins; ++b) {
+      uint32_t total = 0;
+      for (size_t c = 0; c < bins.num_channels; ++c) {
+        total += bins.at(c, b);
+      }
+      counts.push_back(total);
+    }
+  }).ok());
+
+  const size_t num_blocks = 50;
+  ASSERT_TRUE(pipeline->start().ok());
+  for (size_t i = 0; i < num_blocks; ++i) {
+    ASSERT_TRUE(pipeline->push(graph.source->id(), make_block(i)).ok());
+  }
+  pipeline->drain();
+  ASSERT_TRUE(pipeline->status().ok());
+
+  // The same chain, run by hand
+  std::unique_ptr<synapse::SpectralFilterEngine> filter;
+  std::unique_ptr<synapse::SpikeDetectorEngine> detector;
+  ASSERT_TRUE(synapse::SpectralFilterEngine::create(*graph.filter, kSampleRate, kChannels, &filter).ok());
+  ASSERT_TRUE(synapse::SpikeDetectorEngine::create(*graph.detector, kChannels, &detector).ok());
+  std::vector<synapse::SpikeEvent> expected;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    auto block = make_block(i);
+    ASSERT_TRUE(filter->process(&block).ok());
+    ASSERT_TRUE(detector->process(block, &expected).ok());
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(spikes.size(), expected.size());
+  EXPECT_GT(expected.size(), 100);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(spikes[i].channel, expected[i].channel);
+    EXPECT_EQ(spikes[i].sample, expected[i].sample);
+  }
+
+  // 50 blocks of 10 ms make 25 complete 20 ms bins
+  ASSERT_EQ(counts.size(), 25);
+  uint32_t binned = 0;
+  for (auto count : counts) {
+    binned += count;
+  }
+  EXPECT_EQ(binned, expected.size());
+
+  std::vector<synapse::StageMetrics> metrics;
+  pipeline->metrics(&metrics);
+  ASSERT_EQ(metrics.size(), 3);
+  EXPECT_EQ(metrics[0].type, synapse::NodeType::kSpectralFilter);
+  EXPECT_EQ(metrics[0].packets, num_blocks);
+  EXPECT_EQ(metrics[0].items, num_blocks * kBlockSamples * kChannels);
+  EXPECT_EQ(metrics[2].items, expected.size());
+  for (const auto& m : metrics) {
+    EXPECT_EQ(m.queue_depth, 0);
+    EXPECT_LE(m.max_queue_depth, 2);
+    EXPECT_GT(m.throughput(), 0);
+    EXPECT_GE(m.max_latency, m.mean_latency());
+  }
+
+  pipeline->stop();
+}
+
+TEST(PipelineTest, ReportsStageErrors) {
+  Graph graph;
+  std::unique_ptr<Pipeline> pipeline;
+  ASSERT_TRUE(Pipeline::create(graph.config, &pipeline, 2).ok());
+  ASSERT_TRUE(pipeline->start().ok());
+
+  EXPECT_EQ(pipeline->push(graph.filter->id(), make_block(0)).code(), science::StatusCode::kNotFound);
+  EXPECT_EQ(pipeline->push(graph.source->id(), SpikeBatch()).code(), science::StatusCode::kNotFound);
+
+  ASSERT_TRUE(pipeline->push(graph.source->id(), make_block(0)).ok());
+  SampleBlock narrow;
+  narrow.resize(3, 10);
+  narrow.sample_rate_hz = kSampleRate;
+  ASSERT_TRUE(pipeline->push(graph.source->id(), narrow).ok());
+  pipeline->drain();
+
+  auto s = pipeline->status();
+  EXPECT_EQ(s.code(), science::StatusCode::kInvalidArgument);
+  EXPECT_NE(s.message().find("node " + std::to_string(graph.filter->id())), std::string::npos);
+
+  std::vector<synapse::StageMetrics> metrics;
+  pipeline->metrics(&metrics);
+  EXPECT_EQ(metrics[0].errors, 1);
+  EXPECT_EQ(metrics[1].packets, 1);
+}
+
+TEST(PipelineTest, RejectsPushWhenNotRunning) {
+  Graph graph;
+  std::unique_ptr<Pipeline> pipeline;
+  ASSERT_TRUE(Pipeline::create(graph.config, &pipeline, 1, 1).ok());
+
+  // More pushes than the queue holds must fail rather than block
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(pipeline->push(graph.source->id(), make_block(i)).code(), science::StatusCode::kFailedPrecondition);
+  }
+
+  ASSERT_TRUE(pipeline->start().ok());
+  ASSERT_TRUE(pipeline->push(graph.source->id(), make_block(0)).ok());
+  pipeline->stop();
+  EXPECT_EQ(pipeline->push(graph.source->id(), make_block(1)).code(), science::StatusCode::kFailedPrecondition);
+}
+
+TEST(PipelineTest, SplitsChannelsAcrossPool) {
+  Graph graph;
+  std::unique_ptr<Pipeline> pipeline;
+  ASSERT_TRUE(Pipeline::create(graph.config, &pipeline, 2).ok());
+  ASSERT_TRUE(pipeline->set_channel_pool(std::make_shared<synapse::WorkStealingPool>(3)).ok());
+
+  std::vector<synapse::SpikeEvent> spikes;
+  ASSERT_TRUE(pipeline->on_output(graph.detector->id(), [&spikes](uint32_t, const PipelineData& data) {
+    const auto& batch = std::get<SpikeBatch>(data);
+    spikes.insert(spikes.end(), batch.events.begin(), batch.events.end());
+  }).ok());
+
+  ASSERT_TRUE(pipeline->start().ok());
+  EXPECT_EQ(pipeline->set_channel_pool(nullptr).code(), science::StatusCode::kFailedPrecondition);
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_TRUE(pipeline->push(graph.source->id(), make_block(i)).ok());
+  }
+  pipeline->stop();
+  ASSERT_TRUE(pipeline->status().ok());
+
+  std::unique_ptr<synapse::SpectralFilterEngine> filter;
+  std::unique_ptr<synapse::SpikeDetectorEngine> detector;
+  ASSERT_TRUE(synapse::SpectralFilterEngine::create(*graph.filter, kSampleRate, kChannels, &filter).ok());
+  ASSERT_TRUE(synapse::SpikeDetectorEngine::create(*graph.detector, kChannels, &detector).ok());
+  std::vector<synapse::SpikeEvent> expected;
+  for (size_t i = 0; i < 10; ++i) {
+    auto block = make_block(i);
+    ASSERT_TRUE(filter->process(&block).ok());
+    ASSERT_TRUE(detector->process(block, &expected).ok());
+  }
+
+  ASSERT_EQ(spikes.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(spikes[i].channel, expected[i].channel);
+    EXPECT_EQ(spikes[i].sample, expected[i].sample);
+  }
+}
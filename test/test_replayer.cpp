@@ -0,0 +1,225 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/api/datatype.pb.h>
+#include <science/synapse/recording/replayer.h>
+#include <science/synapse/recording/tap_recorder.h>
+#include <science/synapse/tap.h>
+
+using synapse::Replayer;
+using synapse::ReplayOptions;
+
+namespace {
+
+constexpr size_t kFrames = 50;
+constexpr uint64_t kStartNs = 5000000000;
+constexpr uint64_t kPeriodNs = 2000000;
+
+auto write_recording(const std::string& path) -> void {
+  synapse::TapRecorderOptions options;
+  options.stream_name = "broadband";
+  options.message_type = "synapse.BroadbandFrame";
+
+  std::unique_ptr<synapse::TapRecorder> recorder;
+  ASSERT_TRUE(synapse::TapRecorder::create(path, &recorder, options).ok());
+  for (size_t i = 0; i < kFrames; ++i) {
+    std::vector<uint8_t> frame(100 + i, static_cast<uint8_t>(i));
+    ASSERT_TRUE(recorder->record(frame.data(), frame.size(), kStartNs + i * kPeriodNs).ok());
+  }
+  ASSERT_TRUE(recorder->stop().ok());
+}
+
+struct Received {
+  std::mutex mutex;
+  std::vector<uint64_t> timestamps;
+  std::vector<std::chrono::steady_clock::time_point> times;
+
+  auto callback() -> Replayer::FrameCallback {
+    return [this](const std::vector<uint8_t>&, uint64_t timestamp_ns) {
+      std::lock_guard<std::mutex> lock(mutex);
+      timestamps.push_back(timestamp_ns);
+      times.push_back(std::chrono::steady_clock::now());
+    };
+  }
+};
+
+}  // namespace
+
+TEST(ReplayerTest, KeepsRecordedTimingAtSpeed) {
+  const std::string path = ::testing::TempDir() + "replayer_timing.rec";
+  write_recording(path);
+
+  ReplayOptions options;
+  options.speed = 2.0;
+  std::unique_ptr<Replayer> replayer;
+  ASSERT_TRUE(Replayer::create(path, &replayer, options).ok());
+  EXPECT_EQ(replayer->num_frames(), kFrames);
+  EXPECT_EQ(replayer->start_timestamp_ns(), kStartNs);
+  EXPECT_EQ(replayer->connection().name(), "broadband");
+  EXPECT_EQ(replayer->connection().tap_type(), synapse::TapType::TAP_TYPE_PRODUCER);
+
+  Received received;
+  replayer->on_frame(received.callback());
+  ASSERT_TRUE(replayer->start().ok());
+  ASSERT_TRUE(replayer->wait(std::chrono::seconds(5)));
+  ASSERT_TRUE(replayer->status().ok());
+
+  ASSERT_EQ(received.timestamps.size(), kFrames);
+  EXPECT_EQ(received.timestamps.back(), kStartNs + (kFrames - 1) * kPeriodNs);
+
+  // 49 gaps of 2 ms at double speed; frames are never sent early
+  auto elapsed = received.times.back() - received.times.front();
+  EXPECT_GE(elapsed, std::chrono::microseconds(48000));
+
+  // Sends are late by scheduling noise only; the bound is loose so a loaded machine doesn't fail it
+  auto stats = replayer->stats();
+  EXPECT_EQ(stats.frames_sent, kFrames);
+  EXPECT_EQ(stats.bytes_sent, kFrames * 100 + kFrames * (kFrames - 1) / 2);
+  EXPECT_GE(stats.max_lateness, stats.mean_lateness);
+  EXPECT_LT(stats.mean_lateness, std::chrono::milliseconds(20));
+
+  std::remove(path.c_str());
+}
+
+TEST(ReplayerTest, SeeksAndLoops) {
+  const std::string path = ::testing::TempDir() + "replayer_seek.rec";
+  write_recording(path);
+
+  ReplayOptions options;
+  options.speed = 0;
+  options.index_interval = 8;
+  std::unique_ptr<Replayer> replayer;
+  ASSERT_TRUE(Replayer::create(path, &replayer, options).ok());
+
+  Received received;
+  replayer->on_frame(received.callback());
+  ASSERT_TRUE(replayer->seek(kStartNs + 30 * kPeriodNs - 1).ok());
+  EXPECT_EQ(replayer->seek(kStartNs + kFrames * kPeriodNs).code(), science::StatusCode::kOutOfRange);
+  ASSERT_TRUE(replayer->start().ok());
+  ASSERT_TRUE(replayer->wait(std::chrono::seconds(5)));
+  ASSERT_EQ(received.timestamps.size(), 20);
+  EXPECT_EQ(received.timestamps.front(), kStartNs + 30 * kPeriodNs);
+
+  std::unique_ptr<Replayer> looping;
+  options.loop = true;
+  ASSERT_TRUE(Replayer::create(path, &looping, options).ok());
+  ASSERT_TRUE(looping->start().ok());
+  EXPECT_FALSE(looping->wait(std::chrono::milliseconds(100)));
+  looping->stop();
+  EXPECT_FALSE(looping->is_playing());
+  EXPECT_GT(looping->stats().loops, 1);
+  EXPECT_TRUE(looping->status().ok());
+
+  std::remove(path.c_str());
+}
+
+TEST(ReplayerTest, PublishesToTap) {
+  const std::string path = ::testing::TempDir() + "replayer_tap.rec";
+  write_recording(path);
+
+  // Paced, so the subscriber's queue never fills and drops frames
+  ReplayOptions options;
+  options.speed = 10;
+  options.loop = true;
+  std::unique_ptr<Replayer> replayer;
+  ASSERT_TRUE(Replayer::create(path, &replayer, options).ok());
+
+  synapse::Tap tap("127.0.0.1");
+  ASSERT_TRUE(tap.connect(replayer->connection()).ok());
+  ASSERT_TRUE(replayer->start().ok());
+
+  // Subscribers miss whatever is sent before they join, so look for a whole pass
+  std::vector<uint8_t> frame;
+  size_t expected = 0;
+  for (size_t i = 0; i < 10 * kFrames && expected < kFrames; ++i) {
+    ASSERT_TRUE(tap.read(&frame, 1000).ok());
+    if (frame.size() == 100 + expected) {
+      expected++;
+    } else {
+      expected = frame.size() == 100 ? 1 : 0;
+    }
+  }
+  EXPECT_EQ(expected, kFrames);
+
+  replayer->stop();
+  std::remove(path.c_str());
+}
+
+TEST(ReplayerTest, PublishesCodecBatches) {
+  const std::string path = ::testing::TempDir() + "replayer_codec.rec";
+  synapse::TapRecorderOptions recorder_options;
+  recorder_options.message_type = "synapse.BroadbandFrame";
+  std::vector<synapse::BroadbandFrame> frames(20);
+  {
+    std::unique_ptr<synapse::TapRecorder> recorder;
+    ASSERT_TRUE(synapse::TapRecorder::create(path, &recorder, recorder_options).ok());
+    for (size_t i = 0; i < frames.size(); ++i) {
+      frames[i].set_timestamp_ns(kStartNs + i * kPeriodNs);
+      frames[i].set_sequence_number(i);
+      frames[i].set_sample_rate_hz(30000);
+      for (int c = 0; c < 4; ++c) {
+        frames[i].add_frame_data(static_cast<int32_t>(i) * 3 - c * 100);
+      }
+      auto bytes = frames[i].SerializeAsString();
+      ASSERT_TRUE(recorder->record(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(),
+                                   frames[i].timestamp_ns()).ok());
+    }
+    ASSERT_TRUE(recorder->stop().ok());
+  }
+
+  ReplayOptions options;
+  options.speed = 0;
+  options.codec_batch_frames = 8;
+  std::unique_ptr<Replayer> replayer;
+  ASSERT_TRUE(Replayer::create(path, &replayer, options).ok());
+  EXPECT_EQ(replayer->connection().message_type(), synapse::kSampleCodecFramesType);
+
+  std::vector<std::vector<uint8_t>> batches;
+  std::vector<uint64_t> timestamps;
+  replayer->on_frame([&](const std::vector<uint8_t>& batch, uint64_t timestamp_ns) {
+    batches.push_back(batch);
+    timestamps.push_back(timestamp_ns);
+  });
+  ASSERT_TRUE(replayer->start().ok());
+  ASSERT_TRUE(replayer->wait(std::chrono::seconds(5)));
+  ASSERT_TRUE(replayer->status().ok());
+
+  // Two full batches, then the rest when the recording ends
+  ASSERT_EQ(batches.size(), 3);
+  EXPECT_EQ(timestamps[0], frames[7].timestamp_ns());
+  EXPECT_EQ(timestamps[2], frames[19].timestamp_ns());
+
+  synapse::SampleCodec codec;
+  std::vector<synapse::BroadbandFrame> decoded;
+  size_t next = 0;
+  uint64_t bytes_sent = 0;
+  for (const auto& batch : batches) {
+    ASSERT_TRUE(codec.decode_frames(batch.data(), batch.size(), &decoded).ok());
+    for (const auto& frame : decoded) {
+      ASSERT_LT(next, frames.size());
+      EXPECT_EQ(frame.SerializeAsString(), frames[next++].SerializeAsString());
+    }
+    bytes_sent += batch.size();
+  }
+  EXPECT_EQ(next, frames.size());
+  EXPECT_EQ(replayer->stats().frames_sent, frames.size());
+  EXPECT_EQ(replayer->stats().bytes_sent, bytes_sent);
+
+  // Only broadband recordings can be encoded
+  recorder_options.message_type = "synapse.SpiketrainFrame";
+  {
+    std::unique_ptr<synapse::TapRecorder> recorder;
+    ASSERT_TRUE(synapse::TapRecorder::create(path, &recorder, recorder_options).ok());
+    ASSERT_TRUE(recorder->record(reinterpret_cast<const uint8_t*>("x"), 1, kStartNs).ok());
+    ASSERT_TRUE(recorder->stop().ok());
+  }
+  EXPECT_EQ(Replayer::create(path, &replayer, options).code(), science::StatusCode::kInvalidArgument);
+
+  std::remove(path.c_str());
+}
@@ -0,0 +1,221 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/recording/sample_codec.h>
+
+using synapse::SampleCodec;
+using synapse::SamplePredictor;
+
+namespace {
+
+// Channel-major samples: a slow sine per channel plus noise, at int16 resolution
+auto make_samples(size_t num_channels, size_t num_samples) -> std::vector<int32_t> {
+  std::mt19937 rng(7);
+  std::normal_distribution<double> noise(0, 5);
+  std::vector<int32_t> samples(num_channels * num_samples);
+  for (size_t c = 0; c < num_channels; ++c) {
+    for (size_t t = 0; t < num_samples; ++t) {
+      samples[c * num_samples + t] = static_cast<int32_t>(std::lround(
+        2000 * std::sin(2 * M_PI * (c + 1) * t / 3000.0) + noise(rng)
+      ));
+    }
+  }
+  return samples;
+}
+
+auto channel_ptrs(const std::vector<int32_t>& samples, size_t num_channels, size_t num_samples)
+  -> std::vector<const int32_t*> {
+  std::vector<const int32_t*> channels;
+  for (size_t c = 0; c < num_channels; ++c) {
+    channels.push_back(samples.data() + c * num_samples);
+  }
+  return channels;
+}
+
+auto round_trip(SampleCodec* codec, const std::vector<int32_t>& samples, size_t num_channels, size_t num_samples)
+  -> std::vector<uint8_t> {
+  std::vector<uint8_t> encoded;
+  EXPECT_TRUE(codec->encode(channel_ptrs(samples, num_channels, num_samples), num_samples, &encoded).ok());
+
+  std::vector<int32_t> decoded;
+  size_t decoded_channels = 0;
+  size_t decoded_samples = 0;
+  EXPECT_TRUE(codec->decode(encoded.data(), encoded.size(), &decoded, &decoded_channels, &decoded_samples).ok());
+  EXPECT_EQ(decoded_channels, num_channels);
+  EXPECT_EQ(decoded_samples, num_samples);
+  EXPECT_EQ(decoded, samples);
+  return encoded;
+}
+
+}  // namespace
+
+TEST(SampleCodecTest, RoundTripsAndCompresses) {
+  for (auto predictor : { SamplePredictor::kDelta, SamplePredictor::kLinear }) {
+    SampleCodec codec(predictor);
+    for (size_t num_samples : { 0, 1, 2, 9, 256, 1000 }) {
+      auto samples = make_samples(5, num_samples);
+      round_trip(&codec, samples, 5, num_samples);
+    }
+
+    auto samples = make_samples(32, 4096);
+    auto encoded = round_trip(&codec, samples, 32, 4096);
+    EXPECT_LT(encoded.size(), samples.size() * sizeof(int16_t) * 3 / 4);
+  }
+}
+
+TEST(SampleCodecTest, RoundTripsExtremeValues) {
+  constexpr size_t kSamples = 600;
+  const int32_t min = std::numeric_limits<int32_t>::min();
+  const int32_t max = std::numeric_limits<int32_t>::max();
+
+  std::mt19937 rng(3);
+  std::vector<int32_t> samples(3 * kSamples);
+  for (size_t t = 0; t < kSamples; ++t) {
+    samples[t] = t % 2 == 0 ? min : max;
+    samples[kSamples + t] = static_cast<int32_t>(rng());
+    samples[2 * kSamples + t] = -7;
+  }
+
+  for (auto predictor : { SamplePredictor::kDelta, SamplePredictor::kLinear }) {
+    SampleCodec codec(predictor);
+    round_trip(&codec, samples, 3, kSamples);
+  }
+}
+
+TEST(SampleCodecTest, SimdMatchesScalar) {
+  SampleCodec simd(SamplePredictor::kLinear);
+  SampleCodec scalar(SamplePredictor::kLinear);
+  scalar.set_simd_level(synapse::SimdLevel::kScalar);
+
+  // Every bit width, up to the full 32
+  std::mt19937 rng(11);
+  constexpr size_t kSamples = 33 * 256;
+  std::vector<int32_t> samples(kSamples);
+  for (size_t t = 0; t < kSamples; ++t) {
+    const size_t width = t / 256;
+    samples[t] = width == 0 ? 0 : static_cast<int32_t>(rng() >> (32 - width));
+  }
+  const std::vector<const int32_t*> channels = { samples.data() };
+
+  std::vector<uint8_t> simd_encoded;
+  std::vector<uint8_t> scalar_encoded;
+  ASSERT_TRUE(simd.encode(channels, kSamples, &simd_encoded).ok());
+  ASSERT_TRUE(scalar.encode(channels, kSamples, &scalar_encoded).ok());
+  EXPECT_EQ(simd_encoded, scalar_encoded);
+
+  std::vector<int32_t> decoded;
+  size_t num_channels = 0;
+  size_t num_samples = 0;
+  ASSERT_TRUE(scalar.decode(simd_encoded.data(), simd_encoded.size(), &decoded, &num_channels, &num_samples).ok());
+  EXPECT_EQ(decoded, samples);
+}
+
+TEST(SampleCodecTest, RoundTripsFrames) {
+  std::vector<synapse::BroadbandFrame> frames(700);
+  for (size_t t = 0; t < frames.size(); ++t) {
+    auto& frame = frames[t];
+    frame.set_timestamp_ns(1700000000000000000ull + t * 33333 + (t % 3));
+    frame.set_sequence_number(t + 10);
+    frame.set_sample_rate_hz(30000);
+    for (int c = 0; c < 4; ++c) {
+      frame.add_frame_data(static_cast<int32_t>(c * 100 + (t % 17)));
+    }
+  }
+  // A clock step backwards is kept exactly
+  frames[300].set_timestamp_ns(5);
+
+  SampleCodec codec;
+  std::vector<uint8_t> encoded;
+  ASSERT_TRUE(codec.encode_frames(frames, &encoded).ok());
+
+  std::vector<synapse::BroadbandFrame> decoded;
+  ASSERT_TRUE(codec.decode_frames(encoded.data(), encoded.size(), &decoded).ok());
+  ASSERT_EQ(decoded.size(), frames.size());
+  for (size_t t = 0; t < frames.size(); ++t) {
+    EXPECT_EQ(decoded[t].SerializeAsString(), frames[t].SerializeAsString()) << "frame " << t;
+  }
+
+  frames[1].add_frame_data(0);
+  EXPECT_EQ(codec.encode_frames(frames, &encoded).code(), science::StatusCode::kInvalidArgument);
+}
+
+TEST(SampleCodecTest, RejectsCorruptData) {
+  SampleCodec codec;
+  auto samples = make_samples(4, 1000);
+  std::vector<uint8_t> encoded;
+  ASSERT_TRUE(codec.encode(channel_ptrs(samples, 4, 1000), 1000, &encoded).ok());
+
+  std::vector<int32_t> decoded;
+  size_t num_channels = 0;
+  size_t num_samples = 0;
+  for (size_t size : { size_t{ 0 }, size_t{ 10 }, size_t{ 40 }, encoded.size() - 1 }) {
+    EXPECT_EQ(
+      codec.decode(encoded.data(), size, &decoded, &num_channels, &num_samples).code(),
+      science::StatusCode::kDataLoss
+    ) << "size " << size;
+  }
+
+  // A channel count far beyond what the data could hold
+  auto huge = encoded;
+  huge[8] = 0xff;
+  huge[9] = 0xff;
+  huge[10] = 0xff;
+  EXPECT_EQ(
+    codec.decode(huge.data(), huge.size(), &decoded, &num_channels, &num_samples).code(),
+    science::StatusCode::kDataLoss
+  );
+
+  auto bad_magic = encoded;
+  bad_magic[0] ^= 1;
+  EXPECT_EQ(
+    codec.decode(bad_magic.data(), bad_magic.size(), &decoded, &num_channels, &num_samples).code(),
+    science::StatusCode::kDataLoss
+  );
+
+  std::vector<synapse::BroadbandFrame> frames;
+  EXPECT_EQ(
+    codec.decode_frames(encoded.data(), encoded.size(), &frames).code(), science::StatusCode::kInvalidArgument
+  );
+}
+
+TEST(SampleCodecTest, RejectsOversizedHeaders) {
+  SampleCodec codec;
+  std::vector<uint8_t> encoded;
+  int32_t sample = 0;
+  ASSERT_TRUE(codec.encode({ &sample }, 1, &encoded).ok());
+
+  // Zero-width blocks are one byte per 256 samples, so ~1 MB of zeros is a well-formed channel of
+  // 2^28 + 256 samples; it must be refused rather than decoded into over 1 GiB
+  const uint32_t too_many = (uint32_t{ 1 } << 28) + 256;
+  auto oversized = encoded;
+  std::memcpy(oversized.data() + 12, &too_many, sizeof(too_many));
+  oversized.resize(16 + sizeof(int32_t) + too_many / 256, 0);
+
+  std::vector<int32_t> decoded;
+  size_t num_channels = 0;
+  size_t num_samples = 0;
+  EXPECT_EQ(
+    codec.decode(oversized.data(), oversized.size(), &decoded, &num_channels, &num_samples).code(),
+    science::StatusCode::kDataLoss
+  );
+  EXPECT_TRUE(decoded.empty());
+
+  // A sample count within the cap, with only the first few blocks present, fails before allocating
+  const uint32_t truncated_samples = uint32_t{ 1 } << 20;
+  auto truncated = encoded;
+  std::memcpy(truncated.data() + 12, &truncated_samples, sizeof(truncated_samples));
+  truncated.resize(16 + sizeof(int32_t) + 64, 0);
+  EXPECT_EQ(
+    codec.decode(truncated.data(), truncated.size(), &decoded, &num_channels, &num_samples).code(),
+    science::StatusCode::kDataLoss
+  );
+  EXPECT_TRUE(decoded.empty());
+
+  std::vector<const int32_t*> channels(2, &sample);
+  EXPECT_EQ(codec.encode(channels, (size_t{ 1 } << 27) + 1, &encoded).code(), science::StatusCode::kInvalidArgument);
+}
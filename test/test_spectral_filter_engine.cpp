@@ -0,0 +1,120 @@
+#include <cmath>
+#include <memory>
+
+#include <gtest/gtest.h>
+#include <science/synapse/dsp/spectral_filter_engine.h>
+
+using synapse::SampleBlock;
+using synapse::SpectralFilter;
+using synapse::SpectralFilterEngine;
+using synapse::SpectralFilterMethod;
+
+namespace {
+
+constexpr float kSampleRate = 30000;
+constexpr float kPi = 3.14159265f;
+
+// Fill each channel with a sine at the given frequency, returning the RMS of the filtered output
+auto filtered_rms(SpectralFilterEngine* engine, size_t num_channels, float frequency_hz) -> float {
+  SampleBlock block;
+  block.resize(num_channels, 30000);
+  for (size_t t = 0; t < block.num_samples; ++t) {
+    for (size_t c = 0; c < num_channels; ++c) {
+      block.row(t)[c] = std::sin(2.0f * kPi * frequency_hz * t / kSampleRate);
+    }
+  }
+
+  engine->reset();
+  EXPECT_TRUE(engine->process(&block).ok());
+
+  // Skip the first half to let the filter settle
+  double sum = 0;
+  size_t count = 0;
+  for (size_t t = block.num_samples / 2; t < block.num_samples; ++t) {
+    for (size_t c = 0; c < num_channels; ++c) {
+      sum += block.at(t, c) * block.at(t, c);
+      count++;
+    }
+  }
+  return static_cast<float>(std::sqrt(sum / count));
+}
+
+}  // namespace
+
+TEST(SpectralFilterEngineTest, BandPassAttenuatesOutOfBand) {
+  SpectralFilter filter(SpectralFilterMethod::kBandPass, 300, 6000);
+  std::unique_ptr<SpectralFilterEngine> engine;
+  ASSERT_TRUE(SpectralFilterEngine::create(filter, kSampleRate, 13, &engine).ok());
+  EXPECT_EQ(engine->num_sections(), 4);
+
+  const float unity = 1.0f / std::sqrt(2.0f);
+  EXPECT_NEAR(filtered_rms(engine.get(), 13, 1500), unity, 0.02);
+  EXPECT_LT(filtered_rms(engine.get(), 13, 30), 0.01);
+  EXPECT_LT(filtered_rms(engine.get(), 13, 14000), 0.01);
+}
+
+TEST(SpectralFilterEngineTest, CutoffIsHalfPower) {
+  SpectralFilter filter(SpectralFilterMethod::kLowPass, 0, 1000);
+  std::unique_ptr<SpectralFilterEngine> engine;
+  ASSERT_TRUE(SpectralFilterEngine::create(filter, kSampleRate, 8, &engine).ok());
+
+  EXPECT_NEAR(filtered_rms(engine.get(), 8, 1000), 0.5f, 0.01);
+}
+
+TEST(SpectralFilterEngineTest, BandStopEdgesAreHalfPower) {
+  SpectralFilter filter(SpectralFilterMethod::kBandStop, 500, 2000);
+  std::unique_ptr<SpectralFilterEngine> engine;
+  ASSERT_TRUE(SpectralFilterEngine::create(filter, kSampleRate, 8, &engine).ok());
+  EXPECT_EQ(engine->num_sections(), 4);
+
+  const float unity = 1.0f / std::sqrt(2.0f);
+  EXPECT_NEAR(filtered_rms(engine.get(), 8, 500), 0.5f, 0.01);
+  EXPECT_NEAR(filtered_rms(engine.get(), 8, 2000), 0.5f, 0.01);
+  EXPECT_LT(filtered_rms(engine.get(), 8, 1000), 0.01);
+  EXPECT_NEAR(filtered_rms(engine.get(), 8, 50), unity, 0.02);
+  EXPECT_NEAR(filtered_rms(engine.get(), 8, 10000), unity, 0.02);
+}
+
+TEST(SpectralFilterEngineTest, SimdMatchesScalar) {
+  SpectralFilter filter(SpectralFilterMethod::kBandPass, 300, 6000);
+  std::unique_ptr<SpectralFilterEngine> scalar;
+  std::unique_ptr<SpectralFilterEngine> simd;
+  ASSERT_TRUE(SpectralFilterEngine::create(filter, kSampleRate, 37, &scalar).ok());
+  ASSERT_TRUE(SpectralFilterEngine::create(filter, kSampleRate, 37, &simd).ok());
+  scalar->set_simd_level(synapse::SimdLevel::kScalar);
+  simd->set_simd_level(synapse::SimdLevel::kAvx2);
+
+  SampleBlock a;
+  a.resize(37, 1000);
+  for (size_t i = 0; i < a.samples.size(); ++i) {
+    a.samples[i] = static_cast<float>((i * 7919) % 201) - 100.0f;
+  }
+  SampleBlock b = a;
+
+  ASSERT_TRUE(scalar->process(&a).ok());
+  ASSERT_TRUE(simd->process(&b).ok());
+  for (size_t i = 0; i < a.samples.size(); ++i) {
+    ASSERT_NEAR(a.samples[i], b.samples[i], 1e-3f * (1.0f + std::abs(a.samples[i])));
+  }
+}
+
+TEST(SpectralFilterEngineTest, RejectsUnrealizableCutoffs) {
+  std::unique_ptr<SpectralFilterEngine> engine;
+  SpectralFilter above_nyquist(SpectralFilterMethod::kLowPass, 0, 20000);
+  auto status = SpectralFilterEngine::create(above_nyquist, kSampleRate, 1, &engine);
+  EXPECT_EQ(status.code(), science::StatusCode::kInvalidArgument);
+
+  SpectralFilter inverted(SpectralFilterMethod::kBandPass, 6000, 300);
+  status = SpectralFilterEngine::create(inverted, kSampleRate, 1, &engine);
+  EXPECT_EQ(status.code(), science::StatusCode::kInvalidArgument);
+}
+
+TEST(SpectralFilterEngineTest, RejectsMismatchedBlock) {
+  SpectralFilter filter(SpectralFilterMethod::kHighPass, 300, 0);
+  std::unique_ptr<SpectralFilterEngine> engine;
+  ASSERT_TRUE(SpectralFilterEngine::create(filter, kSampleRate, 4, &engine).ok());
+
+  SampleBlock block;
+  block.resize(5, 10);
+  EXPECT_EQ(engine->process(&block).code(), science::StatusCode::kInvalidArgument);
+}
@@ -0,0 +1,126 @@
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/dsp/spike_binner_engine.h>
+
+using synapse::SpikeBinner;
+using synapse::SpikeBinnerEngine;
+using synapse::SpikeCounts;
+using synapse::SpikeEvent;
+
+namespace {
+
+constexpr uint64_t kMs = 1000000;
+
+auto spike(uint32_t channel, uint64_t timestamp_ns) -> SpikeEvent {
+  SpikeEvent event;
+  event.channel = channel;
+  event.timestamp_ns = timestamp_ns;
+  return event;
+}
+
+auto total(const SpikeCounts& counts) -> uint64_t {
+  uint64_t sum = 0;
+  for (auto count : counts.counts) {
+    sum += count;
+  }
+  return sum;
+}
+
+}  // namespace
+
+TEST(SpikeBinnerEngineTest, CountsSeveralWidthsInOnePass) {
+  SpikeBinner binner(10);
+  std::unique_ptr<SpikeBinnerEngine> engine;
+  ASSERT_TRUE(SpikeBinnerEngine::create(binner, 4, &engine, { 25 }).ok());
+  ASSERT_EQ(engine->bin_sizes_ms(), std::vector<uint32_t>({ 10, 25 }));
+
+  engine->add({ spike(0, 1000 * kMs), spike(0, 1009 * kMs), spike(3, 1012 * kMs), spike(2, 1052 * kMs) });
+
+  std::vector<SpikeCounts> counts;
+  ASSERT_TRUE(engine->take(1050 * kMs, &counts).ok());
+  ASSERT_EQ(counts.size(), 2);
+
+  EXPECT_EQ(counts[0].bin_size_ms, 10);
+  EXPECT_EQ(counts[0].start_timestamp_ns, 1000 * kMs);
+  EXPECT_EQ(counts[0].num_bins, 5);
+  EXPECT_EQ(counts[0].at(0, 0), 2);
+  EXPECT_EQ(counts[0].at(3, 1), 1);
+  EXPECT_EQ(total(counts[0]), 3);
+
+  // 25 ms bins are aligned to multiples of 25 ms, so both start at 1000 ms
+  EXPECT_EQ(counts[1].start_timestamp_ns, 1000 * kMs);
+  EXPECT_EQ(counts[1].num_bins, 2);
+  EXPECT_EQ(counts[1].at(0, 0), 2);
+  EXPECT_EQ(counts[1].at(3, 0), 1);
+  EXPECT_EQ(total(counts[1]), 3);
+
+  ASSERT_TRUE(engine->take(1075 * kMs, &counts).ok());
+  EXPECT_EQ(counts[0].num_bins, 2);
+  EXPECT_EQ(counts[0].at(2, 0), 1);
+  EXPECT_EQ(total(counts[0]), 1);
+  EXPECT_EQ(counts[1].num_bins, 1);
+  EXPECT_EQ(counts[1].at(2, 0), 1);
+}
+
+TEST(SpikeBinnerEngineTest, ReusesBuffersAndCountsDrops) {
+  SpikeBinner binner(1);
+  std::unique_ptr<SpikeBinnerEngine> engine;
+  ASSERT_TRUE(SpikeBinnerEngine::create(binner, 2, &engine).ok());
+
+  std::vector<SpikeCounts> counts;
+  engine->add(spike(1, 0));
+  ASSERT_TRUE(engine->take(100 * kMs, &counts).ok());
+  const auto* data = counts[0].counts.data();
+
+  engine->add(spike(1, 50 * kMs));        // already taken
+  engine->add(spike(5, 150 * kMs));       // no such channel
+  engine->add(spike(1, 5000 * kMs));      // too far ahead of the oldest bin
+  engine->add(spike(0, 150 * kMs));
+  EXPECT_EQ(engine->late(), 1);
+  EXPECT_EQ(engine->dropped(), 2);
+
+  ASSERT_TRUE(engine->take(200 * kMs, &counts).ok());
+  EXPECT_EQ(counts[0].counts.data(), data);
+  EXPECT_EQ(counts[0].at(0, 50), 1);
+  EXPECT_EQ(total(counts[0]), 1);
+}
+
+TEST(SpikeBinnerEngineTest, ConcurrentProducers) {
+  SpikeBinner binner(5);
+  std::unique_ptr<SpikeBinnerEngine> engine;
+  ASSERT_TRUE(SpikeBinnerEngine::create(binner, 16, &engine, { 20, 100 }, true).ok());
+  engine->add(spike(0, 0));
+
+  const size_t num_threads = 4;
+  const size_t per_thread = 20000;
+  std::vector<std::thread> producers;
+  for (size_t i = 0; i < num_threads; ++i) {
+    producers.emplace_back([&engine, i]() {
+      for (size_t j = 0; j < per_thread; ++j) {
+        engine->add(spike(static_cast<uint32_t>((i + j) % 16), (j % 900) * kMs));
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  std::vector<SpikeCounts> counts;
+  ASSERT_TRUE(engine->take(1000 * kMs, &counts).ok());
+  for (const auto& c : counts) {
+    EXPECT_EQ(total(c), num_threads * per_thread + 1);
+  }
+  EXPECT_EQ(engine->late() + engine->dropped(), 0);
+}
+
+TEST(SpikeBinnerEngineTest, RejectsZeroWidthBins) {
+  std::unique_ptr<SpikeBinnerEngine> engine;
+  EXPECT_EQ(SpikeBinnerEngine::create(SpikeBinner(0), 4, &engine).code(), science::StatusCode::kInvalidArgument);
+  EXPECT_EQ(
+    SpikeBinnerEngine::create(SpikeBinner(10), 4, &engine, { 0 }).code(),
+    science::StatusCode::kInvalidArgument
+  );
+}
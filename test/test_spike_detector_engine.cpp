@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/dsp/spike_detector_engine.h>
+
+using synapse::SampleBlock;
+using synapse::SpikeDetector;
+using synapse::SpikeDetectorEngine;
+using synapse::SpikeEvent;
+
+namespace {
+
+const std::vector<uint32_t> kTemplate = { 0, 400, 0, 0, 200, 0, 300, 300 };
+
+auto make_noise(size_t num_channels, size_t num_samples) -> SampleBlock {
+  SampleBlock block;
+  block.resize(num_channels, num_samples);
+  block.sample_rate_hz = 30000;
+  uint32_t state = 12345;
+  for (auto& sample : block.samples) {
+    state = state * 1664525u + 1013904223u;
+    sample = static_cast<float>(state >> 24) - 128.0f;
+  }
+  return block;
+}
+
+// Feed a block through the engine a few rows at a time
+auto process_in_pieces(SpikeDetectorEngine* engine, const SampleBlock& block, size_t rows) -> std::vector<SpikeEvent> {
+  std::vector<SpikeEvent> events;
+  for (size_t start = 0; start < block.num_samples; start += rows) {
+    SampleBlock piece;
+    piece.resize(block.num_channels, std::min(rows, block.num_samples - start));
+    piece.sample_rate_hz = block.sample_rate_hz;
+    piece.start_timestamp_ns = block.start_timestamp_ns + static_cast<uint64_t>(start * 1e9 / block.sample_rate_hz);
+    std::copy(block.row(start), block.row(start) + piece.samples.size(), piece.samples.begin());
+    EXPECT_TRUE(engine->process(piece, &events).ok());
+  }
+  return events;
+}
+
+auto same_events(const std::vector<SpikeEvent>& a, const std::vector<SpikeEvent>& b) -> bool {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].channel != b[i].channel || a[i].sample != b[i].sample) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(SpikeDetectorEngineTest, ThresholderRespectsRefractoryPeriod) {
+  auto detector = SpikeDetector::create_thresholder(50, 30);
+  std::unique_ptr<SpikeDetectorEngine> engine;
+  ASSERT_TRUE(SpikeDetectorEngine::create(*detector, 3, &engine).ok());
+
+  SampleBlock block;
+  block.resize(3, 100);
+  for (size_t t : { 10, 11, 12, 20, 50 }) {
+    block.row(t)[1] = -80;
+  }
+  block.row(60)[2] = 49;
+
+  std::vector<SpikeEvent> events;
+  ASSERT_TRUE(engine->process(block, &events).ok());
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(events[0].channel, 1);
+  EXPECT_EQ(events[0].sample, 10);
+  EXPECT_EQ(events[0].score, -80);
+  EXPECT_EQ(events[1].sample, 50);
+
+  // Rerun at a lower threshold without recreating the engine
+  engine->reset();
+  engine->set_threshold_uv(40);
+  events.clear();
+  ASSERT_TRUE(engine->process(block, &events).ok());
+  EXPECT_EQ(events.size(), 3);
+}
+
+TEST(SpikeDetectorEngineTest, TemplateMatcherFindsTemplateAcrossBlocks) {
+  auto detector = SpikeDetector::create_template_matcher(kTemplate, 16);
+  std::unique_ptr<SpikeDetectorEngine> engine;
+  ASSERT_TRUE(SpikeDetectorEngine::create(*detector, 11, &engine).ok());
+
+  SampleBlock block;
+  block.resize(11, 200);
+  block.sample_rate_hz = 1000;
+  block.start_timestamp_ns = 5000000;
+  for (size_t k = 0; k < kTemplate.size(); ++k) {
+    block.row(100 + k)[5] = 1000.0f - 0.5f * kTemplate[k];
+  }
+
+  // Windows straddle the 7-row pieces, and the template is inverted and offset
+  engine->set_min_correlation(0.95f);
+  auto events = process_in_pieces(engine.get(), block, 7);
+  EXPECT_TRUE(events.empty());
+
+  for (size_t k = 0; k < kTemplate.size(); ++k) {
+    block.row(100 + k)[5] = 1000.0f + 0.5f * kTemplate[k];
+  }
+  engine->reset();
+  events = process_in_pieces(engine.get(), block, 7);
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0].channel, 5);
+  EXPECT_EQ(events[0].sample, 100 + kTemplate.size() - 1);
+  EXPECT_EQ(events[0].timestamp_ns, 5000000 + (100 + kTemplate.size() - 1) * 1000000);
+  EXPECT_NEAR(events[0].score, 1.0f, 1e-4);
+}
+
+TEST(SpikeDetectorEngineTest, SimdMatchesScalar) {
+  auto thresholder = SpikeDetector::create_thresholder(120, 5);
+  auto matcher = SpikeDetector::create_template_matcher(kTemplate, 5);
+  auto block = make_noise(37, 2000);
+
+  for (const auto& detector : { thresholder, matcher }) {
+    std::unique_ptr<SpikeDetectorEngine> scalar;
+    std::unique_ptr<SpikeDetectorEngine> simd;
+    ASSERT_TRUE(SpikeDetectorEngine::create(*detector, 37, &scalar).ok());
+    ASSERT_TRUE(SpikeDetectorEngine::create(*detector, 37, &simd).ok());
+    scalar->set_simd_level(synapse::SimdLevel::kScalar);
+    simd->set_simd_level(synapse::SimdLevel::kAvx2);
+    scalar->set_min_correlation(0.5f);
+    simd->set_min_correlation(0.5f);
+
+    auto expected = process_in_pieces(scalar.get(), block, 300);
+    auto actual = process_in_pieces(simd.get(), block, 300);
+    EXPECT_GT(expected.size(), 100);
+    EXPECT_TRUE(same_events(expected, actual));
+  }
+}
+
+TEST(SpikeDetectorEngineTest, RejectsUnusableTemplates) {
+  std::unique_ptr<SpikeDetectorEngine> engine;
+  auto constant = SpikeDetector::create_template_matcher({ 7, 7, 7 }, 10);
+  EXPECT_EQ(SpikeDetectorEngine::create(*constant, 4, &engine).code(), science::StatusCode::kInvalidArgument);
+  auto single = SpikeDetector::create_template_matcher({ 7 }, 10);
+  EXPECT_EQ(SpikeDetectorEngine::create(*single, 4, &engine).code(), science::StatusCode::kInvalidArgument);
+
+  auto detector = SpikeDetector::create_thresholder(10, 10);
+  ASSERT_TRUE(SpikeDetectorEngine::create(*detector, 4, &engine).ok());
+  std::vector<SpikeEvent> events;
+  EXPECT_FALSE(engine->process(make_noise(5, 10), &events).ok());
+}
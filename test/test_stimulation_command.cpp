@@ -0,0 +1,134 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/api/datatype.pb.h>
+#include <science/synapse/stimulation_command.h>
+
+using synapse::StimulationCommandBuilder;
+
+namespace {
+
+auto parse(const StimulationCommandBuilder::CommandPtr& command) -> synapse::BroadbandFrame {
+  synapse::BroadbandFrame frame;
+  EXPECT_TRUE(frame.ParseFromArray(command->data(), static_cast<int>(command->size())));
+  return frame;
+}
+
+}  // namespace
+
+TEST(StimulationCommandTest, PatchesElectricalPatternsInPlace) {
+  synapse::ElectricalStimulation node(1, { { 0, 10, 0 }, { 1, 11, 0 }, { 2, 12, 0 } }, 8, 20000, 5);
+  std::unique_ptr<StimulationCommandBuilder> builder;
+  ASSERT_TRUE(StimulationCommandBuilder::create(node, &builder, 2).ok());
+  EXPECT_EQ(builder->num_channels(), 3);
+  EXPECT_EQ(builder->min_code(), -128);
+  EXPECT_EQ(builder->max_code(), 127);
+  EXPECT_EQ(builder->to_code(52), 10);
+  EXPECT_EQ(builder->to_code(-1e6), -128);
+
+  size_t pattern;
+  EXPECT_EQ(builder->add_pattern({ 1, 2 }, &pattern).code(), science::StatusCode::kInvalidArgument);
+  EXPECT_EQ(builder->add_pattern({ 1, 2, 128 }, &pattern).code(), science::StatusCode::kOutOfRange);
+  ASSERT_TRUE(builder->add_pattern({ 20, -20, 0 }, &pattern).ok());
+
+  StimulationCommandBuilder::CommandPtr command;
+  ASSERT_TRUE(builder->acquire(pattern, &command).ok());
+  auto frame = parse(command);
+  EXPECT_EQ(frame.timestamp_ns(), 0);
+  EXPECT_EQ(frame.sample_rate_hz(), 20000);
+  ASSERT_EQ(frame.frame_data_size(), 3);
+  EXPECT_EQ(frame.frame_data(0), 20);
+  EXPECT_EQ(frame.frame_data(1), -20);
+
+  // Patching never changes the size
+  const size_t size = command->size();
+  command->set_timestamp_ns(UINT64_MAX);
+  command->set_sequence_number(7);
+  command->set_amplitude(2, -128);
+  command->set_amplitude(0, 1000);
+  EXPECT_EQ(command->size(), size);
+  frame = parse(command);
+  EXPECT_EQ(frame.timestamp_ns(), UINT64_MAX);
+  EXPECT_EQ(frame.sequence_number(), 7);
+  EXPECT_EQ(frame.frame_data(0), 127);
+  EXPECT_EQ(frame.frame_data(1), -20);
+  EXPECT_EQ(frame.frame_data(2), -128);
+
+  const int32_t codes[] = { -1, 0, 1 };
+  command->set_amplitudes(codes);
+  frame = parse(command);
+  EXPECT_EQ(frame.frame_data(0), -1);
+  EXPECT_EQ(frame.frame_data(2), 1);
+}
+
+TEST(StimulationCommandTest, PaddedFieldsParseAtEveryWidth) {
+  synapse::ElectricalStimulation node(1, { { 0, 10, 0 }, { 1, 11, 0 } }, 32, 30000, 1);
+  std::unique_ptr<StimulationCommandBuilder> builder;
+  ASSERT_TRUE(StimulationCommandBuilder::create(node, &builder, 1).ok());
+  size_t pattern;
+  ASSERT_TRUE(builder->add_pattern({ 0, 0 }, &pattern).ok());
+  StimulationCommandBuilder::CommandPtr command;
+  ASSERT_TRUE(builder->acquire(pattern, &command).ok());
+
+  // Tags, 10-byte timestamp and sequence number, length, 5 bytes per amplitude, then the sample rate
+  const size_t expected_size = (1 + 10) + (1 + 10) + (1 + 1 + 2 * 5) + (1 + 4);
+  ASSERT_EQ(command->size(), expected_size);
+
+  // Values from one encoded byte to the full width must all fill the same padded slots
+  const uint64_t values[] = { 0, 1, 127, 128, 1ull << 35, UINT64_MAX };
+  const int32_t codes[] = { 0, -1, 63, -64, INT32_MAX, INT32_MIN };
+  for (size_t i = 0; i < 6; ++i) {
+    command->set_timestamp_ns(values[i]);
+    command->set_sequence_number(values[5 - i]);
+    command->set_amplitude(0, codes[i]);
+    command->set_amplitude(1, codes[5 - i]);
+    ASSERT_EQ(command->size(), expected_size);
+
+    synapse::BroadbandFrame frame;
+    ASSERT_TRUE(frame.ParseFromArray(command->data(), static_cast<int>(command->size())));
+    EXPECT_EQ(frame.timestamp_ns(), values[i]);
+    EXPECT_EQ(frame.sequence_number(), values[5 - i]);
+    ASSERT_EQ(frame.frame_data_size(), 2);
+    EXPECT_EQ(frame.frame_data(0), codes[i]);
+    EXPECT_EQ(frame.frame_data(1), codes[5 - i]);
+    EXPECT_EQ(frame.sample_rate_hz(), 30000);
+  }
+}
+
+TEST(StimulationCommandTest, PoolsCommands) {
+  synapse::OpticalStimulation node(2, synapse::ChannelMask(std::vector<uint32_t>{ 3, 64, 100 }), 10, 1000, 1);
+  std::unique_ptr<StimulationCommandBuilder> builder;
+  ASSERT_TRUE(StimulationCommandBuilder::create(node, &builder, 2).ok());
+  EXPECT_EQ(builder->num_channels(), 3);
+  EXPECT_EQ(builder->min_code(), 0);
+  EXPECT_EQ(builder->max_code(), 1023);
+  EXPECT_EQ(builder->to_code(0.5), 512);
+
+  size_t pattern;
+  ASSERT_TRUE(builder->add_pattern({ 1023, 0, 512 }, &pattern).ok());
+
+  StimulationCommandBuilder::CommandPtr a;
+  StimulationCommandBuilder::CommandPtr b;
+  StimulationCommandBuilder::CommandPtr c;
+  EXPECT_EQ(builder->acquire(pattern + 1, &a).code(), science::StatusCode::kNotFound);
+  ASSERT_TRUE(builder->acquire(pattern, &a).ok());
+  ASSERT_TRUE(builder->acquire(pattern, &b).ok());
+  EXPECT_EQ(builder->available(), 0);
+  EXPECT_EQ(builder->acquire(pattern, &c).code(), science::StatusCode::kResourceExhausted);
+
+  // A released command comes back reset to its pattern
+  a->set_amplitude(0, -5);
+  EXPECT_EQ(parse(a).frame_data(0), 0);
+  a.reset();
+  EXPECT_EQ(builder->available(), 1);
+  ASSERT_TRUE(builder->acquire(pattern, &c).ok());
+  auto frame = parse(c);
+  EXPECT_EQ(frame.frame_data(0), 1023);
+  EXPECT_EQ(frame.frame_data(2), 512);
+  EXPECT_EQ(frame.sample_rate_hz(), 1000);
+
+  synapse::OpticalStimulation unmasked(2, std::nullopt, 10, 1000, 1);
+  EXPECT_EQ(StimulationCommandBuilder::create(unmasked, &builder).code(), science::StatusCode::kInvalidArgument);
+}
@@ -0,0 +1,97 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/stimulation_sequencer.h>
+#include "tap_test_util.h"
+
+using synapse::StimulationCommandBuilder;
+using synapse::StimulationSequencer;
+
+TEST(StimulationSequencerTest, RequiresConnectedConsumerTap) {
+  std::unique_ptr<StimulationSequencer> sequencer;
+  synapse::Tap tap("127.0.0.1");
+  EXPECT_EQ(StimulationSequencer::create(&tap, &sequencer).code(), science::StatusCode::kFailedPrecondition);
+
+  ASSERT_TRUE(tap.connect(tap_connection("tcp://127.0.0.1:5997", synapse::TapType::TAP_TYPE_PRODUCER, "stim")).ok());
+  EXPECT_EQ(StimulationSequencer::create(&tap, &sequencer).code(), science::StatusCode::kInvalidArgument);
+
+  ASSERT_TRUE(tap.connect(tap_connection("tcp://127.0.0.1:5997", synapse::TapType::TAP_TYPE_CONSUMER, "stim")).ok());
+  synapse::StimulationSequencerOptions options;
+  options.spin = std::chrono::microseconds(-1);
+  EXPECT_EQ(StimulationSequencer::create(&tap, &sequencer, options).code(), science::StatusCode::kInvalidArgument);
+  ASSERT_TRUE(StimulationSequencer::create(&tap, &sequencer).ok());
+  EXPECT_EQ(sequencer->add(std::chrono::milliseconds(1), nullptr).code(), science::StatusCode::kInvalidArgument);
+}
+
+TEST(StimulationSequencerTest, DispatchesOnSchedule) {
+  synapse::Tap tap("127.0.0.1");
+  ASSERT_TRUE(tap.connect(tap_connection("tcp://127.0.0.1:5996", synapse::TapType::TAP_TYPE_CONSUMER, "stim")).ok());
+
+  synapse::ElectricalStimulation node(1, { { 0, 1, 0 }, { 1, 2, 0 } }, 12, 20000, 1);
+  std::unique_ptr<StimulationCommandBuilder> builder;
+  ASSERT_TRUE(StimulationCommandBuilder::create(node, &builder, 8).ok());
+  size_t pulse;
+  ASSERT_TRUE(builder->add_pattern({ 100, -100 }, &pulse).ok());
+
+  std::unique_ptr<StimulationSequencer> sequencer;
+  ASSERT_TRUE(StimulationSequencer::create(&tap, &sequencer).ok());
+
+  // Added out of order, sent in order
+  for (int ms : { 8, 2, 0, 6, 4 }) {
+    StimulationCommandBuilder::CommandPtr command;
+    ASSERT_TRUE(builder->acquire(pulse, &command).ok());
+    ASSERT_TRUE(sequencer->add(std::chrono::milliseconds(ms), std::move(command)).ok());
+  }
+  EXPECT_EQ(sequencer->size(), 5);
+  EXPECT_EQ(builder->available(), 3);
+
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(sequencer->start().ok());
+  EXPECT_EQ(sequencer->add(std::chrono::milliseconds(10), nullptr).code(), science::StatusCode::kFailedPrecondition);
+  sequencer->wait();
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(8));
+  EXPECT_FALSE(sequencer->is_running());
+
+  EXPECT_TRUE(sequencer->status().ok());
+  EXPECT_EQ(sequencer->stats().commands_sent, 5);
+  EXPECT_EQ(sequencer->jitter().count(), 5);
+  EXPECT_LT(sequencer->jitter().max(), std::chrono::milliseconds(5));
+
+  // The timeline can be run again, and clearing it returns the commands
+  ASSERT_TRUE(sequencer->start().ok());
+  sequencer->stop();
+  EXPECT_LE(sequencer->stats().commands_sent, 5);
+  ASSERT_TRUE(sequencer->clear().ok());
+  EXPECT_EQ(builder->available(), 8);
+}
+
+TEST(StimulationSequencerTest, StopsWhileAnotherThreadWaits) {
+  synapse::Tap tap("127.0.0.1");
+  ASSERT_TRUE(tap.connect(tap_connection("tcp://127.0.0.1:5995", synapse::TapType::TAP_TYPE_CONSUMER, "stim")).ok());
+
+  synapse::ElectricalStimulation node(1, { { 0, 1, 0 } }, 12, 20000, 1);
+  std::unique_ptr<StimulationCommandBuilder> builder;
+  ASSERT_TRUE(StimulationCommandBuilder::create(node, &builder, 1).ok());
+  size_t pulse;
+  ASSERT_TRUE(builder->add_pattern({ 100 }, &pulse).ok());
+
+  std::unique_ptr<StimulationSequencer> sequencer;
+  ASSERT_TRUE(StimulationSequencer::create(&tap, &sequencer).ok());
+  StimulationCommandBuilder::CommandPtr command;
+  ASSERT_TRUE(builder->acquire(pulse, &command).ok());
+  ASSERT_TRUE(sequencer->add(std::chrono::seconds(10), std::move(command)).ok());
+
+  // One thread waits for the run while a controller stops it; only one of them may join
+  ASSERT_TRUE(sequencer->start().ok());
+  std::thread waiter([&sequencer]() { sequencer->wait(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  sequencer->stop();
+  waiter.join();
+
+  EXPECT_FALSE(sequencer->is_running());
+  EXPECT_EQ(sequencer->stats().commands_sent, 0);
+}
@@ -0,0 +1,140 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <zmq.hpp>
+#include <science/synapse/api/datatype.pb.h>
+#include <science/synapse/supervised_tap.h>
+#include "tap_test_util.h"
+
+using synapse::SupervisedTap;
+using synapse::TapGap;
+
+namespace {
+
+void publish(zmq::socket_t* socket, uint64_t sequence_number) {
+  synapse::BroadbandFrame frame;
+  frame.set_timestamp_ns(sequence_number * 1000);
+  frame.set_sequence_number(sequence_number);
+  frame.add_frame_data(1);
+  auto bytes = frame.SerializeAsString();
+  zmq::message_t message(bytes.data(), bytes.size());
+  socket->send(message, zmq::send_flags::none);
+}
+
+}  // namespace
+
+TEST(SupervisedTapTest, ReadsSequenceNumbers) {
+  synapse::BroadbandFrame frame;
+  frame.set_timestamp_ns(123);
+  frame.add_frame_data(-4);
+  frame.set_sample_rate_hz(30000);
+  auto bytes = frame.SerializeAsString();
+  auto data = reinterpret_cast<const uint8_t*>(bytes.data());
+  EXPECT_FALSE(synapse::broadband_sequence_number(data, bytes.size()).has_value());
+
+  frame.set_sequence_number(1ull << 40);
+  bytes = frame.SerializeAsString();
+  data = reinterpret_cast<const uint8_t*>(bytes.data());
+  EXPECT_EQ(synapse::broadband_sequence_number(data, bytes.size()), 1ull << 40);
+
+  // Truncated in the middle of the varint
+  EXPECT_FALSE(synapse::broadband_sequence_number(data, bytes.size() - 12).has_value());
+
+  TapGap gap;
+  EXPECT_FALSE(gap.lost().has_value());
+  gap.last_sequence_number = 10;
+  gap.next_sequence_number = 14;
+  EXPECT_EQ(gap.lost(), 3);
+  gap.next_sequence_number = 0;
+  EXPECT_FALSE(gap.lost().has_value());
+}
+
+TEST(SupervisedTapTest, RequiresConnectedProducerTap) {
+  auto on_message = [](const uint8_t*, size_t) {};
+  std::unique_ptr<SupervisedTap> supervised;
+
+  synapse::Tap tap("127.0.0.1");
+  EXPECT_EQ(tap.reconnect().code(), science::StatusCode::kFailedPrecondition);
+  EXPECT_EQ(SupervisedTap::create(&tap, on_message, &supervised).code(), science::StatusCode::kFailedPrecondition);
+
+  ASSERT_TRUE(tap.connect(tap_connection("tcp://127.0.0.1:5995")).ok());
+  EXPECT_EQ(SupervisedTap::create(&tap, nullptr, &supervised).code(), science::StatusCode::kInvalidArgument);
+  synapse::SupervisedTapOptions options;
+  options.max_backoff = std::chrono::milliseconds(1);
+  EXPECT_EQ(SupervisedTap::create(&tap, on_message, &supervised, options).code(),
+            science::StatusCode::kInvalidArgument);
+
+  ASSERT_TRUE(SupervisedTap::create(&tap, on_message, &supervised).ok());
+  ASSERT_TRUE(tap.reconnect().ok());
+  EXPECT_TRUE(tap.is_connected());
+}
+
+TEST(SupervisedTapTest, RecoversFromPublisherRestart) {
+  zmq::context_t context(1);
+  auto publisher = std::make_unique<zmq::socket_t>(context, zmq::socket_type::pub);
+  publisher->bind("tcp://127.0.0.1:*");
+  const std::string endpoint = publisher->get(zmq::sockopt::last_endpoint);
+
+  synapse::Tap tap("127.0.0.1");
+  ASSERT_TRUE(tap.connect(tap_connection(endpoint)).ok());
+
+  std::atomic<uint64_t> received{ 0 };
+  std::vector<TapGap> gaps;
+  std::mutex gaps_mutex;
+  synapse::SupervisedTapOptions options;
+  options.stall_timeout = std::chrono::milliseconds(200);
+  options.initial_backoff = std::chrono::milliseconds(50);
+  std::unique_ptr<SupervisedTap> supervised;
+  ASSERT_TRUE(SupervisedTap::create(
+    &tap, [&](const uint8_t*, size_t) { received++; }, &supervised, options,
+    [&](const TapGap& gap) {
+      std::lock_guard<std::mutex> lock(gaps_mutex);
+      gaps.push_back(gap);
+    }
+  ).ok());
+  ASSERT_TRUE(supervised->start().ok());
+
+  // Publish until the subscription is up, then skip two frames
+  uint64_t sequence = 0;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (received < 5 && std::chrono::steady_clock::now() < deadline) {
+    publish(publisher.get(), sequence++);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_GE(received, 5);
+  sequence += 2;
+  publish(publisher.get(), sequence++);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // Restart the publisher on the same endpoint, after the watchdog has noticed
+  publisher.reset();
+  std::this_thread::sleep_for(std::chrono::milliseconds(400));
+  EXPECT_TRUE(supervised->stats().stalled);
+  publisher = std::make_unique<zmq::socket_t>(context, zmq::socket_type::pub);
+  publisher->bind(endpoint);
+
+  const uint64_t before = received;
+  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (received == before && std::chrono::steady_clock::now() < deadline) {
+    publish(publisher.get(), 1000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  supervised->stop();
+
+  auto stats = supervised->stats();
+  EXPECT_FALSE(stats.stalled);
+  EXPECT_EQ(stats.stalls, 1);
+  EXPECT_GE(stats.reconnects, 1);
+  ASSERT_EQ(gaps.size(), 2);
+  EXPECT_EQ(gaps[0].lost(), 2);
+  EXPECT_EQ(gaps[0].reconnects, 0);
+  EXPECT_EQ(gaps[1].last_sequence_number, sequence - 1);
+  EXPECT_EQ(gaps[1].next_sequence_number, 1000);
+  EXPECT_GE(gaps[1].duration, std::chrono::milliseconds(400));
+  EXPECT_GE(gaps[1].reconnects, 1);
+}
@@ -0,0 +1,170 @@
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <zmq.hpp>
+#include <science/synapse/tap.h>
+#include "tap_test_util.h"
+
+using synapse::Tap;
+using synapse::TapReceiveOptions;
+
+TEST(TapTest, ValidatesReceiveOptions) {
+  Tap tap("127.0.0.1");
+  EXPECT_FALSE(tap.receive_options().busy_poll);
+
+  TapReceiveOptions options;
+  options.spin_budget = std::chrono::microseconds(-1);
+  EXPECT_EQ(tap.set_receive_options(options).code(), science::StatusCode::kInvalidArgument);
+  options.spin_budget = std::chrono::microseconds(0);
+  options.socket_busy_poll_us = -1;
+  EXPECT_EQ(tap.set_receive_options(options).code(), science::StatusCode::kInvalidArgument);
+
+  options.busy_poll = true;
+  options.spin_budget = std::chrono::microseconds(200);
+  options.socket_busy_poll_us = 0;
+  ASSERT_TRUE(tap.set_receive_options(options).ok());
+  EXPECT_TRUE(tap.receive_options().busy_poll);
+  EXPECT_EQ(tap.receive_options().spin_budget, std::chrono::microseconds(200));
+
+  std::vector<uint8_t> data;
+  EXPECT_EQ(tap.read(&data, 10).code(), science::StatusCode::kFailedPrecondition);
+}
+
+TEST(TapTest, SocketBusyPollNeedsDraftApi) {
+  Tap tap("127.0.0.1");
+  TapReceiveOptions options;
+  options.socket_busy_poll_us = 50;
+  ASSERT_TRUE(tap.set_receive_options(options).ok());
+
+  auto status = tap.connect(tap_connection("tcp://127.0.0.1:5992"));
+#ifdef ZMQ_BUSY_POLL
+  EXPECT_TRUE(status.ok());
+#else
+  EXPECT_EQ(status.code(), science::StatusCode::kUnimplemented);
+  EXPECT_FALSE(tap.is_connected());
+#endif
+}
+
+TEST(TapTest, BusyPollReadsAndTimesOut) {
+  zmq::context_t context(1);
+  zmq::socket_t publisher(context, zmq::socket_type::pub);
+  publisher.bind("tcp://127.0.0.1:*");
+
+  Tap tap("127.0.0.1");
+  TapReceiveOptions options;
+  options.busy_poll = true;
+  options.spin_budget = std::chrono::microseconds(500);
+  ASSERT_TRUE(tap.set_receive_options(options).ok());
+  ASSERT_TRUE(tap.connect(tap_connection(publisher.get(zmq::sockopt::last_endpoint))).ok());
+
+  // Nothing published: spins, then blocks out the rest of the timeout
+  std::vector<uint8_t> data;
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(tap.read(&data, 20).code(), science::StatusCode::kDeadlineExceeded);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(19));
+
+  // Publish until the subscription is up
+  const uint32_t value = 42;
+  science::Status s;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  do {
+    zmq::message_t message(&value, sizeof(value));
+    publisher.send(message, zmq::send_flags::none);
+    s = tap.read(&data, 10);
+  } while (!s.ok() && std::chrono::steady_clock::now() < deadline);
+
+  ASSERT_TRUE(s.ok()) << s.message();
+  ASSERT_EQ(data.size(), sizeof(value));
+  EXPECT_EQ(data[0], 42);
+}
+
+TEST(TapTest, ConnectionStatsFollowConnect) {
+  Tap tap("127.0.0.1");
+  EXPECT_EQ(tap.connection_stats().state, synapse::TapConnectionState::kDisconnected);
+  TapReceiveOptions options;
+  options.monitor_connection = true;
+  ASSERT_TRUE(tap.set_receive_options(options).ok());
+
+  // Nothing listening: connect() succeeds, but the socket never gets a connection
+  ASSERT_TRUE(tap.connect(tap_connection("tcp://127.0.0.1:5994")).ok());
+  auto stats = tap.connection_stats();
+  EXPECT_NE(stats.state, synapse::TapConnectionState::kConnected);
+  EXPECT_EQ(stats.connects, 0);
+  EXPECT_FALSE(stats.time_to_connect.has_value());
+  EXPECT_FALSE(stats.time_to_first_message.has_value());
+
+  tap.disconnect();
+  EXPECT_EQ(tap.connection_stats().state, synapse::TapConnectionState::kDisconnected);
+}
+
+TEST(TapTest, ConnectionStatsTrackStartup) {
+  zmq::context_t context(1);
+  zmq::socket_t publisher(context, zmq::socket_type::pub);
+  publisher.bind("tcp://127.0.0.1:*");
+
+  Tap tap("127.0.0.1");
+  TapReceiveOptions options;
+  options.monitor_connection = true;
+  ASSERT_TRUE(tap.set_receive_options(options).ok());
+  ASSERT_TRUE(tap.connect(tap_connection(publisher.get(zmq::sockopt::last_endpoint))).ok());
+
+  const uint32_t value = 7;
+  std::vector<uint8_t> data;
+  science::Status s;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  do {
+    zmq::message_t message(&value, sizeof(value));
+    publisher.send(message, zmq::send_flags::none);
+    s = tap.read(&data, 10);
+  } while (!s.ok() && std::chrono::steady_clock::now() < deadline);
+  ASSERT_TRUE(s.ok());
+
+  auto stats = tap.connection_stats();
+  EXPECT_EQ(stats.state, synapse::TapConnectionState::kConnected);
+  EXPECT_GE(stats.connects, 1);
+  EXPECT_EQ(stats.handshake_failures, 0);
+  ASSERT_TRUE(stats.time_to_connect.has_value());
+  ASSERT_TRUE(stats.time_to_first_message.has_value());
+  EXPECT_LE(*stats.time_to_connect, *stats.time_to_first_message);
+
+  // Reconnecting starts the clock again
+  ASSERT_TRUE(tap.reconnect().ok());
+  EXPECT_FALSE(tap.connection_stats().time_to_first_message.has_value());
+}
+
+TEST(TapTest, ConnectionStatsWithoutMonitor) {
+  zmq::context_t context(1);
+  zmq::socket_t publisher(context, zmq::socket_type::pub);
+  publisher.bind("tcp://127.0.0.1:*");
+
+  Tap tap("127.0.0.1");
+  ASSERT_TRUE(tap.connect(tap_connection(publisher.get(zmq::sockopt::last_endpoint))).ok());
+  EXPECT_EQ(tap.connection_stats().state, synapse::TapConnectionState::kConnecting);
+
+  const uint32_t value = 7;
+  std::vector<uint8_t> data;
+  science::Status s;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  do {
+    zmq::message_t message(&value, sizeof(value));
+    publisher.send(message, zmq::send_flags::none);
+    s = tap.read(&data, 10);
+  } while (!s.ok() && std::chrono::steady_clock::now() < deadline);
+  ASSERT_TRUE(s.ok());
+
+  // The first message shows the connection is up; the monitor's counts stay empty
+  auto stats = tap.connection_stats();
+  EXPECT_EQ(stats.state, synapse::TapConnectionState::kConnected);
+  EXPECT_EQ(stats.connects, 0);
+  EXPECT_FALSE(stats.time_to_connect.has_value());
+  EXPECT_TRUE(stats.time_to_first_message.has_value());
+
+  // Reconnecting without a monitor is cheap, and repeatable
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(tap.reconnect().ok());
+  }
+  EXPECT_EQ(tap.connection_stats().state, synapse::TapConnectionState::kConnecting);
+}
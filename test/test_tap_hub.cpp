@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <zmq.hpp>
+#include <science/synapse/tap_hub.h>
+#include "tap_test_util.h"
+
+using synapse::TapHub;
+using synapse::TapMessage;
+using synapse::TapSubscriber;
+
+namespace {
+
+auto message(uint32_t value) -> TapMessage {
+  return std::make_shared<const zmq::message_t>(&value, sizeof(value));
+}
+
+}  // namespace
+
+TEST(TapHubTest, SubscribersDropPerTheirPolicy) {
+  TapSubscriber oldest({ 2, synapse::DropPolicy::kDropOldest });
+  TapSubscriber newest({ 2, synapse::DropPolicy::kDropNewest });
+  std::vector<TapMessage> messages = { message(1), message(2), message(3) };
+  for (const auto& m : messages) {
+    EXPECT_TRUE(oldest.push(m));
+    EXPECT_TRUE(newest.push(m));
+  }
+  EXPECT_EQ(messages[0].use_count(), 2);  // still queued by newest only
+
+  TapMessage popped;
+  ASSERT_TRUE(oldest.try_pop(&popped).ok());
+  EXPECT_EQ(popped, messages[1]);
+  ASSERT_TRUE(newest.try_pop(&popped).ok());
+  EXPECT_EQ(popped, messages[0]);
+
+  auto stats = oldest.stats();
+  EXPECT_EQ(stats.received, 3);
+  EXPECT_EQ(stats.dropped, 1);
+  EXPECT_EQ(stats.queue_depth, 1);
+  EXPECT_EQ(stats.max_queue_depth, 2);
+  EXPECT_EQ(newest.stats().received, 2);
+
+  // Closed: refuses new messages, drains, then reports cancelled
+  oldest.close();
+  EXPECT_FALSE(oldest.push(message(4)));
+  ASSERT_TRUE(oldest.pop(&popped, std::chrono::milliseconds(10)).ok());
+  EXPECT_EQ(popped, messages[2]);
+  EXPECT_EQ(oldest.pop(&popped, std::chrono::milliseconds(10)).code(), science::StatusCode::kCancelled);
+  EXPECT_EQ(newest.try_pop(&popped).ok(), true);
+  EXPECT_EQ(newest.try_pop(&popped).code(), science::StatusCode::kDeadlineExceeded);
+}
+
+TEST(TapHubTest, RequiresConnectedProducerTap) {
+  std::unique_ptr<TapHub> hub;
+  synapse::Tap tap("127.0.0.1");
+  EXPECT_EQ(TapHub::create(&tap, &hub).code(), science::StatusCode::kFailedPrecondition);
+  ASSERT_TRUE(tap.connect(tap_connection("tcp://127.0.0.1:5993")).ok());
+  ASSERT_TRUE(TapHub::create(&tap, &hub).ok());
+
+  std::shared_ptr<TapSubscriber> subscriber;
+  EXPECT_EQ(hub->subscribe(&subscriber, { 0 }).code(), science::StatusCode::kInvalidArgument);
+  ASSERT_TRUE(hub->subscribe(&subscriber).ok());
+  EXPECT_EQ(hub->num_subscribers(), 1);
+  subscriber->close();
+  EXPECT_EQ(hub->num_subscribers(), 0);
+
+  std::shared_ptr<synapse::LatestFrame> latest;
+  EXPECT_EQ(hub->subscribe_latest(&latest, 0).code(), science::StatusCode::kInvalidArgument);
+  ASSERT_TRUE(hub->subscribe_latest(&latest).ok());
+  EXPECT_EQ(hub->num_subscribers(), 1);
+  latest.reset();
+  EXPECT_EQ(hub->num_subscribers(), 0);
+}
+
+TEST(TapHubTest, FansOutOneSubscription) {
+  zmq::context_t context(1);
+  zmq::socket_t publisher(context, zmq::socket_type::pub);
+  publisher.bind("tcp://127.0.0.1:*");
+
+  synapse::Tap tap("127.0.0.1");
+  ASSERT_TRUE(tap.connect(tap_connection(publisher.get(zmq::sockopt::last_endpoint))).ok());
+  std::unique_ptr<TapHub> hub;
+  ASSERT_TRUE(TapHub::create(&tap, &hub).ok());
+
+  // A fast subscriber, and a slow one that never pops
+  std::shared_ptr<TapSubscriber> fast;
+  std::shared_ptr<TapSubscriber> slow;
+  ASSERT_TRUE(hub->subscribe(&fast).ok());
+  ASSERT_TRUE(hub->subscribe(&slow, { 4, synapse::DropPolicy::kDropNewest }).ok());
+  ASSERT_TRUE(hub->start().ok());
+
+  uint32_t sent = 0;
+  uint64_t popped = 0;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (popped < 20 && std::chrono::steady_clock::now() < deadline) {
+    zmq::message_t out(&sent, sizeof(sent));
+    publisher.send(out, zmq::send_flags::none);
+    sent++;
+
+    TapMessage in;
+    while (fast->try_pop(&in).ok()) {
+      ASSERT_EQ(in->size(), sizeof(uint32_t));
+      popped++;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  hub->stop();
+
+  ASSERT_GE(popped, 20);
+  EXPECT_EQ(fast->stats().dropped, 0);
+  EXPECT_EQ(slow->stats().queue_depth, 4);
+  EXPECT_EQ(slow->stats().received + slow->stats().dropped, hub->messages_received());
+  EXPECT_TRUE(hub->status().ok());
+}
@@ -0,0 +1,122 @@
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/recording/tap_recorder.h>
+
+using synapse::TapRecorder;
+using synapse::TapRecorderOptions;
+using synapse::TapRecordingReader;
+
+namespace {
+
+auto make_frame(size_t size, uint8_t seed) -> std::vector<uint8_t> {
+  std::vector<uint8_t> frame(size);
+  for (size_t i = 0; i < size; ++i) {
+    frame[i] = static_cast<uint8_t>(seed + i * 31);
+  }
+  return frame;
+}
+
+auto file_size(const std::string& path) -> long {
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  std::fseek(file, 0, SEEK_END);
+  auto size = std::ftell(file);
+  std::fclose(file);
+  return size;
+}
+
+}  // namespace
+
+TEST(TapRecorderTest, RoundTripsFrames) {
+  const std::string path = ::testing::TempDir() + "tap_recorder_round_trip.rec";
+
+  for (bool direct_io : { true, false }) {
+    TapRecorderOptions options;
+    options.buffer_size = 16 * 1024;
+    options.max_buffers = 64;
+    options.preallocate_bytes = 64 * 1024;
+    options.direct_io = direct_io;
+    options.stream_name = "broadband";
+    options.message_type = "synapse.BroadbandFrame";
+
+    std::unique_ptr<TapRecorder> recorder;
+    ASSERT_TRUE(TapRecorder::create(path, &recorder, options).ok());
+
+    // Sizes that straddle buffer boundaries, including one larger than a buffer
+    std::vector<std::vector<uint8_t>> frames;
+    for (size_t i = 0; i < 200; ++i) {
+      frames.push_back(make_frame(i == 50 ? 40000 : (i * 97) % 1500, static_cast<uint8_t>(i)));
+      ASSERT_TRUE(recorder->record(frames.back().data(), frames.back().size(), 1000 + i).ok());
+    }
+    ASSERT_TRUE(recorder->stop().ok());
+
+    auto stats = recorder->stats();
+    EXPECT_EQ(stats.frames, frames.size());
+    EXPECT_EQ(stats.frames_dropped, 0);
+    EXPECT_EQ(stats.backlog_bytes, 0);
+    EXPECT_GT(stats.write_throughput(), 0);
+    EXPECT_EQ(static_cast<long>(stats.bytes_written), file_size(path));
+
+    std::unique_ptr<TapRecordingReader> reader;
+    ASSERT_TRUE(TapRecordingReader::open(path, &reader).ok());
+    EXPECT_EQ(reader->stream_name(), "broadband");
+    EXPECT_EQ(reader->message_type(), "synapse.BroadbandFrame");
+
+    std::vector<uint8_t> frame;
+    uint64_t timestamp_ns = 0;
+    for (size_t i = 0; i < frames.size(); ++i) {
+      ASSERT_TRUE(reader->next(&frame, &timestamp_ns).ok()) << i;
+      EXPECT_EQ(frame, frames[i]) << i;
+      EXPECT_EQ(timestamp_ns, 1000 + i);
+    }
+    EXPECT_EQ(reader->next(&frame).code(), science::StatusCode::kOutOfRange);
+  }
+
+  std::remove(path.c_str());
+}
+
+TEST(TapRecorderTest, DropsFramesWhenBuffersAreExhausted) {
+  const std::string path = ::testing::TempDir() + "tap_recorder_drop.rec";
+
+  TapRecorderOptions options;
+  options.buffer_size = 4096;
+  options.max_buffers = 2;
+
+  std::unique_ptr<TapRecorder> recorder;
+  ASSERT_TRUE(TapRecorder::create(path, &recorder, options).ok());
+
+  auto large = make_frame(3 * 4096, 1);
+  EXPECT_EQ(recorder->record(large.data(), large.size(), 0).code(), science::StatusCode::kResourceExhausted);
+  auto small = make_frame(100, 2);
+  EXPECT_TRUE(recorder->record(small.data(), small.size(), 1).ok());
+  ASSERT_TRUE(recorder->stop().ok());
+  EXPECT_EQ(recorder->stats().frames, 1);
+  EXPECT_EQ(recorder->stats().frames_dropped, 1);
+  EXPECT_EQ(recorder->record(small.data(), small.size(), 2).code(), science::StatusCode::kFailedPrecondition);
+
+  std::unique_ptr<TapRecordingReader> reader;
+  ASSERT_TRUE(TapRecordingReader::open(path, &reader).ok());
+  std::vector<uint8_t> frame;
+  ASSERT_TRUE(reader->next(&frame).ok());
+  EXPECT_EQ(frame, small);
+  EXPECT_EQ(reader->next(&frame).code(), science::StatusCode::kOutOfRange);
+
+  std::remove(path.c_str());
+}
+
+TEST(TapRecorderTest, RequiresConnectedTap) {
+  const std::string path = ::testing::TempDir() + "tap_recorder_tap.rec";
+
+  std::unique_ptr<TapRecorder> recorder;
+  ASSERT_TRUE(TapRecorder::create(path, &recorder).ok());
+  synapse::Tap tap("127.0.0.1:647");
+  EXPECT_EQ(recorder->start(nullptr).code(), science::StatusCode::kInvalidArgument);
+  EXPECT_EQ(recorder->start(&tap).code(), science::StatusCode::kFailedPrecondition);
+  ASSERT_TRUE(recorder->stop().ok());
+
+  std::remove(path.c_str());
+}
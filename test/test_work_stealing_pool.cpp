@@ -0,0 +1,113 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <science/synapse/dsp/spectral_filter_engine.h>
+#include <science/synapse/dsp/spike_detector_engine.h>
+#include <science/synapse/dsp/work_stealing_pool.h>
+
+using synapse::SampleBlock;
+using synapse::SpikeEvent;
+using synapse::WorkStealingPool;
+
+namespace {
+
+auto make_block(size_t num_channels, size_t num_samples, uint32_t seed) -> SampleBlock {
+  SampleBlock block;
+  block.resize(num_channels, num_samples);
+  block.sample_rate_hz = 30000;
+  uint32_t state = seed;
+  for (auto& sample : block.samples) {
+    state = state * 1664525u + 1013904223u;
+    sample = static_cast<float>(state >> 24) - 128.0f;
+  }
+  return block;
+}
+
+}  // namespace
+
+TEST(WorkStealingPoolTest, CoversRangeExactlyOnce) {
+  WorkStealingPool pool(4);
+  std::vector<std::atomic<int>> hits(1000);
+
+  pool.parallel_for(3, 1000, 7, [&hits](size_t begin, size_t end) {
+    EXPECT_LE(end - begin, 7);
+    for (size_t i = begin; i < end; ++i) {
+      hits[i]++;
+    }
+  });
+
+  for (size_t i = 0; i < hits.size(); ++i) {
+    EXPECT_EQ(hits[i].load(), i < 3 ? 0 : 1) << i;
+  }
+}
+
+TEST(WorkStealingPoolTest, ConcurrentCallers) {
+  WorkStealingPool pool(3);
+  std::atomic<size_t> total(0);
+
+  std::vector<std::thread> callers;
+  for (size_t i = 0; i < 4; ++i) {
+    callers.emplace_back([&pool, &total]() {
+      for (size_t j = 0; j < 50; ++j) {
+        pool.parallel_for(0, 256, 16, [&total](size_t begin, size_t end) { total += end - begin; });
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+
+  EXPECT_EQ(total.load(), 4 * 50 * 256);
+}
+
+TEST(WorkStealingPoolTest, ChannelGrainIsCacheLineAligned) {
+  WorkStealingPool pool(4);
+  EXPECT_EQ(pool.channel_grain(10), 16);
+  EXPECT_EQ(pool.channel_grain(1024), 64);
+  EXPECT_EQ(pool.channel_grain(1000) % 16, 0);
+}
+
+TEST(WorkStealingPoolTest, ParallelEnginesMatchSingleThreaded) {
+  const size_t num_channels = 203;
+  WorkStealingPool pool(4);
+
+  synapse::SpectralFilter filter(synapse::SpectralFilterMethod::kBandPass, 300, 6000);
+  std::unique_ptr<synapse::SpectralFilterEngine> serial_filter;
+  std::unique_ptr<synapse::SpectralFilterEngine> parallel_filter;
+  ASSERT_TRUE(synapse::SpectralFilterEngine::create(filter, 30000, num_channels, &serial_filter).ok());
+  ASSERT_TRUE(synapse::SpectralFilterEngine::create(filter, 30000, num_channels, &parallel_filter).ok());
+
+  for (const auto& detector : { synapse::SpikeDetector::create_thresholder(60, 10),
+                                synapse::SpikeDetector::create_template_matcher({ 0, 400, 0, 0, 200, 0 }, 10) }) {
+    std::unique_ptr<synapse::SpikeDetectorEngine> serial;
+    std::unique_ptr<synapse::SpikeDetectorEngine> parallel;
+    ASSERT_TRUE(synapse::SpikeDetectorEngine::create(*detector, num_channels, &serial).ok());
+    ASSERT_TRUE(synapse::SpikeDetectorEngine::create(*detector, num_channels, &parallel).ok());
+    serial->set_min_correlation(0.6f);
+    parallel->set_min_correlation(0.6f);
+
+    std::vector<SpikeEvent> expected;
+    std::vector<SpikeEvent> actual;
+    for (uint32_t i = 0; i < 10; ++i) {
+      auto a = make_block(num_channels, 150, i + 1);
+      auto b = a;
+      ASSERT_TRUE(serial_filter->process(&a).ok());
+      ASSERT_TRUE(parallel_filter->process(&b, &pool).ok());
+      ASSERT_EQ(a.samples, b.samples);
+
+      ASSERT_TRUE(serial->process(a, &expected).ok());
+      ASSERT_TRUE(parallel->process(b, &actual, &pool).ok());
+    }
+
+    EXPECT_GT(expected.size(), 100);
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(actual[i].channel, expected[i].channel);
+      EXPECT_EQ(actual[i].sample, expected[i].sample);
+      EXPECT_EQ(actual[i].score, expected[i].score);
+    }
+  }
+}